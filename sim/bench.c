@@ -0,0 +1,377 @@
+/*******************************************************************************
+* Name: bench.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Host benchmarks of firmware code that does not need the rest
+*              of the simulator. Times are host nanoseconds and host TSC
+*              cycles, so only compare numbers from the same machine.
+*
+* Benchmarks (-b NAME[,COUNT], COUNT overrides the number of iterations):
+*   map         Occupancy grid update of made up ultrasonic samples
+*   protocol    COBS encode and decode of full size frames
+*   format      Format_vprintf() against the C library's vsnprintf()
+*   encoder     TIM2 capture ISR before and after the speed math moved to
+*               the control task, in modeled Cortex-M4 cycles (see sim.c)
+*   all         All of the above with their default counts
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "sim.h"
+#include "../src/COBS.h"
+#include "../src/Encoder.h"
+#include "../src/Format.h"
+#include "../src/Map.h"
+#include "../src/Messages.h"
+#include "../src/Odometry.h"
+
+#define BENCH_FRAMES        200000              // Frames per payload kind
+#define BENCH_FORMAT_CALLS  200000              // Calls per format string
+#define BENCH_FORMAT_LEN    128
+#define BENCH_TIM2_WRAP_US  65536               // The old 16-bit TIM2 period
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    const char *name;
+    unsigned long count;                        // Default number of iterations
+    void (*run)(unsigned long count);
+} Benchmark;
+
+// Format string and the C one that prints the same thing, %q values are
+// printed with %f from a double by the C library
+typedef struct {
+    const char *fmt;
+    const char *cFmt;
+    uint8_t fixed;                              // Arguments are Q16.16
+    int32_t args[3];
+} BenchFormat;
+
+typedef struct {
+    char buff[BENCH_FORMAT_LEN];
+    uint16_t len;
+} BenchString;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+extern void TIM2_IRQHandler(void);
+
+// State of the TIM2 ISR as it was before the capture ring
+static volatile uint32_t oldLeftEncoder[2] = {0, 0};
+static volatile uint32_t oldRightEncoder[2] = {0, 0};
+static volatile uint8_t oldOverflows[2] = {0, 0};
+static volatile uint32_t oldSpeed[2] = {0, 0};
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Bench_Map() - Cast samples at every range and pan from a robot driving a
+*               50cm circle, one in eight finds nothing.
+*******************************************************************************/
+static void Bench_Map(unsigned long samples) {
+    UltraSample sample = {0};
+    unsigned long cells = 0, maxCells = 0;
+    double total = 0.0, longest = 0.0, ns;
+    struct timespec start;
+
+    Map_Init();
+    for (unsigned long i = 0; i < samples; i++) {
+        G_OdometryPose.heading = (uint32_t)(i * 0x01000000UL);
+        G_OdometryPose.x = (int32_t)(((int64_t)Odometry_Cos(G_OdometryPose.heading) * 500000) >> 30);
+        G_OdometryPose.y = (int32_t)(((int64_t)Odometry_Sin(G_OdometryPose.heading) * 500000) >> 30);
+        sample.pan = (int16_t)((i * 16) % 400) - 200;
+        sample.status = ((i % 8) == 7) ? ULTRA_NO_ECHO : ULTRA_OK;
+        sample.echo = (uint16_t)((10 + (i * 37) % 390) * ULTRA_US_PER_CM);
+
+        Bench_Start(&start);
+        Map_AddSample(&sample);
+        ns = Bench_Ns(&start);
+
+        total += ns;
+        longest = (ns > longest) ? ns : longest;
+        cells += G_MapStats.lastCells;
+        maxCells = (G_MapStats.lastCells > maxCells) ? G_MapStats.lastCells : maxCells;
+    }
+
+    printf("[Bench] map: %lu samples, %.0f cells/sample (max %lu), %.0fns/sample (max %.0fns), %.1fns/cell\n",
+           samples, (double)cells / samples, maxCells, total / samples, longest, total / cells);
+}
+
+/*******************************************************************************
+* Bench_Protocol() - Encode and decode full size raw frames (type, payload and
+*                    CRC) with no zeros, all zeros and random bytes. The CRC
+*                    unit is an emulated peripheral here, so it is left out.
+*******************************************************************************/
+static void Bench_Protocol(unsigned long frames) {
+    static const char *kinds[] = {"no zeros", "all zeros", "random"};
+    uint8_t raw[PROTOCOL_MAX_RAW];
+    uint8_t encoded[COBS_MAX_ENCODED(PROTOCOL_MAX_RAW)];
+    uint8_t decoded[COBS_MAX_ENCODED(PROTOCOL_MAX_RAW)];
+    volatile uint16_t sink = 0;
+
+    srand(1);
+    for (uint8_t kind = 0; kind < 3; kind++) {
+        uint64_t encodeCycles = 0, decodeCycles = 0, t;
+        double encodeNs = 0.0, decodeNs = 0.0;
+        unsigned long encodedBytes = 0;
+        struct timespec start;
+
+        for (unsigned long i = 0; i < frames; i++) {
+            uint16_t len;
+
+            // A new frame every time so the branches are not learned
+            for (uint16_t j = 0; j < PROTOCOL_MAX_RAW; j++) {
+                raw[j] = (kind == 0) ? (uint8_t)(1 + (i + j) % 255) : (kind == 1) ? 0 : (uint8_t)rand();
+            }
+
+            Bench_Start(&start);
+            t = __rdtsc();
+            len = COBS_Encode(raw, PROTOCOL_MAX_RAW, encoded);
+            encodeCycles += __rdtsc() - t;
+            encodeNs += Bench_Ns(&start);
+
+            Bench_Start(&start);
+            t = __rdtsc();
+            sink += (uint16_t)COBS_Decode(encoded, len, decoded);
+            decodeCycles += __rdtsc() - t;
+            decodeNs += Bench_Ns(&start);
+
+            encodedBytes += len;
+        }
+
+        printf("[Bench] protocol %-9s: %lu frames of %u bytes (%.1f encoded), encode %.0fns %.0f cycles %.0fMB/s, "
+               "decode %.0fns %.0f cycles %.0fMB/s\n",
+               kinds[kind], frames, PROTOCOL_MAX_RAW, (double)encodedBytes / frames,
+               encodeNs / frames, (double)encodeCycles / frames, frames * PROTOCOL_MAX_RAW * 1e3 / encodeNs,
+               decodeNs / frames, (double)decodeCycles / frames, frames * PROTOCOL_MAX_RAW * 1e3 / decodeNs);
+    }
+}
+
+/*******************************************************************************
+* Bench_FormatWrite() - Formatter output function, appends to a BenchString.
+*******************************************************************************/
+static void Bench_FormatWrite(void *ctx, const char *data, uint16_t len) {
+    BenchString *out = (BenchString *)ctx;
+
+    if (out->len + len < BENCH_FORMAT_LEN) {
+        memcpy(&out->buff[out->len], data, len);
+        out->len += len;
+    }
+}
+
+/*******************************************************************************
+* Bench_FormatRun() - Format with the in-tree formatter.
+*******************************************************************************/
+static uint64_t Bench_FormatRun(BenchString *out, const char *fmt, ...) {
+    va_list args;
+    uint64_t t;
+
+    out->len = 0;
+    va_start(args, fmt);
+    t = __rdtsc();
+    Format_vprintf(Bench_FormatWrite, out, fmt, args);
+    t = __rdtsc() - t;
+    va_end(args);
+    out->buff[out->len] = '\0';
+
+    return t;
+}
+
+/*******************************************************************************
+* Bench_VsnprintfRun() - Format with the C library.
+*******************************************************************************/
+static uint64_t Bench_VsnprintfRun(BenchString *out, const char *fmt, ...) {
+    va_list args;
+    uint64_t t;
+
+    va_start(args, fmt);
+    t = __rdtsc();
+    vsnprintf(out->buff, BENCH_FORMAT_LEN, fmt, args);
+    t = __rdtsc() - t;
+    va_end(args);
+
+    return t;
+}
+
+/*******************************************************************************
+* Bench_Format() - Time typical log and console lines with both formatters,
+*                  checking they print the same thing. The code size is
+*                  compared by make bench.
+*******************************************************************************/
+static void Bench_Format(unsigned long calls) {
+    static const BenchFormat formats[] = {
+        {"L=%d R=%d\r\n", "L=%d R=%d\r\n", 0, {12, -34, 0}},
+        {"speed %5d cm/s, err %-6d duty %3u%%\n", "speed %5d cm/s, err %-6d duty %3u%%\n", 0, {-25, 1234, 87}},
+        {"%08X %u %d\n", "%08X %u %d\n", 0, {(int32_t)0xDEADBEEF, 4000000000U, -2147483647}},
+        {"%s: %d\n", "%s: %d\n", 0, {0, 42, 0}},
+        {"x=%.2q y=%.2q th=%.3q\n", "x=%.2f y=%.2f th=%.3f\n", 1, {1638400, -3276800, 205887}},
+    };
+    BenchString ours, theirs;
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        const BenchFormat *bf = &formats[f];
+        uint64_t oursCycles = 0, theirsCycles = 0, oursMin = UINT64_MAX, theirsMin = UINT64_MAX, t;
+
+        for (unsigned long i = 0; i < calls; i++) {
+            if (bf->fixed) {
+                t = Bench_FormatRun(&ours, bf->fmt, bf->args[0], bf->args[1], bf->args[2]);
+            }
+            else if (strstr(bf->fmt, "%s") != NULL) {
+                t = Bench_FormatRun(&ours, bf->fmt, "left wheel", bf->args[1]);
+            }
+            else {
+                t = Bench_FormatRun(&ours, bf->fmt, bf->args[0], bf->args[1], bf->args[2]);
+            }
+            oursCycles += t;
+            oursMin = (t < oursMin) ? t : oursMin;
+
+            if (bf->fixed) {
+                t = Bench_VsnprintfRun(&theirs, bf->cFmt, bf->args[0] / 65536.0, bf->args[1] / 65536.0,
+                                       bf->args[2] / 65536.0);
+            }
+            else if (strstr(bf->fmt, "%s") != NULL) {
+                t = Bench_VsnprintfRun(&theirs, bf->cFmt, "left wheel", bf->args[1]);
+            }
+            else {
+                t = Bench_VsnprintfRun(&theirs, bf->cFmt, bf->args[0], bf->args[1], bf->args[2]);
+            }
+            theirsCycles += t;
+            theirsMin = (t < theirsMin) ? t : theirsMin;
+        }
+
+        if (strcmp(ours.buff, theirs.buff) != 0) {
+            printf("[Bench] format: \"%s\" printed \"%s\", vsnprintf printed \"%s\"\n",
+                   bf->fmt, ours.buff, theirs.buff);
+        }
+        printf("[Bench] format %-38.*s: Format %4.0f cycles (min %3lu), vsnprintf %4.0f cycles (min %4lu)\n",
+               (int)strcspn(bf->fmt, "\r\n"), bf->fmt,
+               (double)oursCycles / calls, (unsigned long)oursMin,
+               (double)theirsCycles / calls, (unsigned long)theirsMin);
+    }
+}
+
+/*******************************************************************************
+* Bench_OldEncoderIsr() - The TIM2 ISR before the capture ring, which worked
+*                         out the period and speed of every edge.
+*******************************************************************************/
+static void Bench_OldEncoderIsr(void) {
+    if (IS_BIT_SET(TIM2->SR, TIM_SR_CC1IF)) {
+        oldLeftEncoder[1] = oldLeftEncoder[0];
+        oldLeftEncoder[0] = TIM2->CCR1;
+        G_EncoderPeriod[LEFT] = oldLeftEncoder[0] - oldLeftEncoder[1] + (oldOverflows[LEFT] * BENCH_TIM2_WRAP_US);
+        oldSpeed[LEFT] = (UM_PER_VANE * 100) / G_EncoderPeriod[LEFT];
+        oldOverflows[0] = 0;
+    }
+
+    if (IS_BIT_SET(TIM2->SR, TIM_SR_CC2IF)) {
+        oldRightEncoder[1] = oldRightEncoder[0];
+        oldRightEncoder[0] = TIM2->CCR2;
+        G_EncoderPeriod[RIGHT] = oldRightEncoder[0] - oldRightEncoder[1] + (oldOverflows[RIGHT] * BENCH_TIM2_WRAP_US);
+        oldSpeed[RIGHT] = (UM_PER_VANE * 100) / G_EncoderPeriod[RIGHT];
+        oldOverflows[1] = 0;
+    }
+
+    if (IS_BIT_SET(TIM2->SR, TIM_SR_UIF)) {
+        oldOverflows[0]++;
+        oldOverflows[1]++;
+        CLEAR_BITS(TIM2->SR, TIM_SR_UIF);
+    }
+}
+
+/*******************************************************************************
+* Bench_Encoder() - Model the old and new TIM2 ISR on one edge, both edges
+*                   and both edges with a timer update. The new ISR's own DWT
+*                   measurement (what telemetry sends as encoderIsrMax) is
+*                   shown next to the whole handler.
+*******************************************************************************/
+static void Bench_Encoder(unsigned long edges) {
+    static const struct {
+        const char *name;
+        uint32_t flags;
+    } cases[] = {
+        {"one edge", TIM_SR_CC1IF},
+        {"two edges", TIM_SR_CC1IF | TIM_SR_CC2IF},
+        {"two edges and update", TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_UIF},
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint32_t oldMax = 0, newMax = 0, ownMax = 0;
+        uint64_t oldTotal = 0, newTotal = 0;
+
+        for (unsigned long i = 0; i < edges; i++) {
+            uint32_t cycles;
+
+            // Edges 1 to 4000us apart
+            TIM2->CCR1 = (uint32_t)((i + 1) * 4001 % 65536);
+            TIM2->CCR2 = (uint32_t)((i + 1) * 3989 % 65536);
+
+            TIM2->SR = cases[c].flags;
+            cycles = Sim_Cycles(Bench_OldEncoderIsr);
+            oldTotal += cycles;
+            oldMax = (cycles > oldMax) ? cycles : oldMax;
+
+            // The new ISR leaves TIM_SR_UIF alone, its update interrupt is off
+            TIM2->SR = cases[c].flags & ~TIM_SR_UIF;
+            cycles = Sim_Cycles(TIM2_IRQHandler);
+            newTotal += cycles;
+            newMax = (cycles > newMax) ? cycles : newMax;
+            ownMax = (G_EncoderStats.isrLastCycles > ownMax) ? G_EncoderStats.isrLastCycles : ownMax;
+        }
+
+        printf("[Bench] encoder ISR %-20s: before %5.1f cycles (max %3u), after %5.1f cycles (max %3u, %u measured by the ISR)\n",
+               cases[c].name, (double)oldTotal / edges, oldMax, (double)newTotal / edges, newMax, ownMax);
+    }
+    TIM2->SR = 0;
+}
+
+static const Benchmark benchmarks[] = {
+    {"map", 100000, Bench_Map},
+    {"protocol", BENCH_FRAMES, Bench_Protocol},
+    {"format", BENCH_FORMAT_CALLS, Bench_Format},
+    {"encoder", 1000, Bench_Encoder},
+};
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Bench_Start() - Start timing.
+*******************************************************************************/
+void Bench_Start(struct timespec *start) {
+    clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+/*******************************************************************************
+* Bench_Ns() - Nanoseconds since Bench_Start().
+*******************************************************************************/
+double Bench_Ns(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+/*******************************************************************************
+* Bench_Run() - Run a benchmark, or all of them.
+* Returns 0, or 1 if there is no benchmark called name.
+*******************************************************************************/
+int Bench_Run(const char *name, unsigned long count) {
+    uint8_t found = 0;
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        if ((strcmp(name, "all") == 0) || (strcmp(name, benchmarks[i].name) == 0)) {
+            benchmarks[i].run((count != 0) ? count : benchmarks[i].count);
+            found = 1;
+        }
+    }
+
+    return found ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+* Name: cmsis_host.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: CMSIS compiler layer for the host simulator build. Force
+*              included (-include) ahead of every firmware source so the
+*              Cortex-M inline assembly in cmsis_gcc.h is replaced by calls
+*              into the simulator, and the NVIC functions in core_cm4.h are
+*              routed to the simulated interrupt controller (sim_nvic.h).
+*******************************************************************************/
+
+#ifndef CMSIS_HOST_H
+#define CMSIS_HOST_H
+
+#include <stdint.h>
+
+// Stop cmsis_gcc.h from being included, everything it provides is below
+#define __CMSIS_GCC_H
+
+/*******************************************************************************
+*                               COMPILER MACROS                                *
+*******************************************************************************/
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    __attribute__((always_inline)) static inline
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT         struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION          union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+#define __COMPILER_BARRIER()    __asm volatile("" ::: "memory")
+
+/*******************************************************************************
+*                               CORE INTRINSICS                                *
+*******************************************************************************/
+uint32_t Sim_GetPrimask(void);
+void Sim_SetPrimask(uint32_t primask);
+void Sim_Yield(void);
+void Sim_Breakpoint(uint32_t value);
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void) { return Sim_GetPrimask(); }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask) { Sim_SetPrimask(priMask); }
+__STATIC_FORCEINLINE void __disable_irq(void) { Sim_SetPrimask(1); }
+__STATIC_FORCEINLINE void __enable_irq(void) { Sim_SetPrimask(0); }
+
+#define __NOP()                 __COMPILER_BARRIER()
+#define __ISB()                 __COMPILER_BARRIER()
+#define __DSB()                 __COMPILER_BARRIER()
+#define __DMB()                 __COMPILER_BARRIER()
+#define __WFI()                 Sim_Yield()
+#define __WFE()                 Sim_Yield()
+#define __SEV()                 ((void)0)
+#define __BKPT(value)           Sim_Breakpoint(value)
+#define __REV(value)            __builtin_bswap32(value)
+#define __REV16(value)          __builtin_bswap16(value)
+#define __CLZ(value)            ((uint8_t)(((value) == 0) ? 32 : __builtin_clz(value)))
+
+/*******************************************************************************
+*                               VIRTUAL NVIC                                   *
+*******************************************************************************/
+#define CMSIS_NVIC_VIRTUAL
+#define CMSIS_NVIC_VIRTUAL_HEADER_FILE  "sim_nvic.h"
+
+#endif
@@ -0,0 +1,346 @@
+/*******************************************************************************
+* Name: host.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: The far end of the simulated robot link. Decodes USART3 with
+*              the server's decoders (tcpip/) and plays scheduled host
+*              commands using the server's command words. USART2 is printed
+*              as a console.
+*
+* Commands:
+*   telemetry RATE                      Set the telemetry rate (Hz)
+*   drive LEFT RIGHT SERVO STEPPER      Send a drive frame
+*   move LINEAR ANGULAR                 Drive at cm/s and rad/s, repeated like
+*                                       the client until the next command
+*   status                              Ask for the link status
+*   tasks [reset]                       Ask for the scheduler task statistics
+*   tune [SETPOINT [AMPLITUDE]]         Auto-tune the wheel controllers
+*   scan [SPACING|off]                  Start or stop the range scanner
+*   map [all]                           Download the changed occupancy grid tiles
+*   anything else                       One command frame per character
+*
+* Simulator only, these change the world rather than sending anything:
+*   battery MV                          Set the battery's open circuit voltage
+*   current MA|off                      Make the current sense read MA (a short)
+*   jam left|right|off                  Hold a wheel still
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "../src/Utility.h"
+#include "../tcpip/protocol.h"
+#include "../tcpip/telemetry.h"
+#include "../tcpip/log.h"
+#include "../tcpip/link.h"
+#include "../tcpip/tasks.h"
+#include "../tcpip/tune.h"
+#include "../tcpip/scan.h"
+#include "../tcpip/map.h"
+
+#define HOST_MAX_EVENTS     64
+#define HOST_MOVE_REPEAT_MS 100                 // The client's keepalive period
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    SimTime time;
+    char *command;
+} HostEvent;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+// Log format strings, straight from the firmware image (see src/Log.h)
+extern char __start_logstr[];
+extern char __stop_logstr[];
+
+static HostEvent events[HOST_MAX_EVENTS];       // Sorted by time
+static uint8_t eventCount = 0;
+static uint8_t eventNext = 0;
+
+static MsgVelocity moveMsg;
+static SimTime moveNext = SIM_NEVER;            // Time of the next repeat
+
+static ProtocolDecoder decoder;
+static TelemetryDecoder telemetry;
+static LogDecoder logDecoder;
+static MapDecoder mapDecoder;
+static uint32_t telemetryPrintMs = 0;
+static unsigned long consoleBytes = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Host_Send() - Frame a message and put it on the robot's receive line.
+*******************************************************************************/
+static void Host_Send(uint8_t type, const void *payload, size_t len) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+
+    Periph_UsartReceive(USART3, frame, Protocol_Encode(type, payload, len, frame));
+}
+
+/*******************************************************************************
+* Host_Command() - Run one host command.
+*******************************************************************************/
+static void Host_Command(const char *command) {
+    Sim_Printf("[Host] %s\n", command);
+    moveNext = SIM_NEVER;
+
+    if (strncmp("telemetry ", command, 10) == 0) {
+        MsgTelemetryRate msg = {(uint16_t)atoi(&command[10])};
+
+        Host_Send(MSG_TELEMETRY_RATE, &msg, sizeof(msg));
+    }
+    else if (strncmp("drive ", command, 6) == 0) {
+        MsgDrive msg;
+        int left, right, servo, stepper;
+
+        if (sscanf(&command[6], "%d %d %d %d", &left, &right, &servo, &stepper) != 4) {
+            Sim_Printf("[Host] Usage: drive LEFT RIGHT SERVO STEPPER\n");
+            return;
+        }
+        msg.flags = DRIVE_SET_WHEELS | DRIVE_SET_SERVO | DRIVE_SET_STEPPER;
+        msg.leftSpeed = (int16_t)left;
+        msg.rightSpeed = (int16_t)right;
+        msg.servoAngle = (int8_t)servo;
+        msg.stepperTarget = (int16_t)stepper;
+        Host_Send(MSG_DRIVE, &msg, sizeof(msg));
+    }
+    else if (strncmp("move ", command, 5) == 0) {
+        float linear, angular;
+
+        if (sscanf(&command[5], "%f %f", &linear, &angular) != 2) {
+            Sim_Printf("[Host] Usage: move LINEAR ANGULAR\n");
+            return;
+        }
+        moveMsg.linear = (int16_t)(linear * 10.0f);
+        moveMsg.angular = (int16_t)(angular * 1000.0f);
+        Host_Send(MSG_VELOCITY, &moveMsg, sizeof(moveMsg));
+        if ((moveMsg.linear != 0) || (moveMsg.angular != 0)) {
+            moveNext = Sim_Now() + SIM_MS(HOST_MOVE_REPEAT_MS);
+        }
+    }
+    else if (strcmp("status", command) == 0) {
+        Host_Send(MSG_LINK_QUERY, NULL, 0);
+    }
+    else if (strncmp("tasks", command, 5) == 0) {
+        MsgTaskQuery msg = {(strstr(command, "reset") != NULL) ? 1 : 0};
+
+        Host_Send(MSG_TASK_QUERY, &msg, sizeof(msg));
+    }
+    else if (strncmp("tune", command, 4) == 0) {
+        MsgTuneStart msg = {0, 0};
+        int setpoint = 0, amplitude = 0;
+
+        sscanf(&command[4], "%d %d", &setpoint, &amplitude);
+        msg.setpoint = (uint8_t)setpoint;
+        msg.amplitude = (uint8_t)amplitude;
+        Host_Send(MSG_TUNE_START, &msg, sizeof(msg));
+    }
+    else if (strncmp("scan", command, 4) == 0) {
+        MsgScanControl msg = {SCAN_DEFAULT_SPACING};
+        int spacing;
+
+        if (strstr(command, "off") != NULL) {
+            msg.spacing = 0;
+        }
+        else if (sscanf(&command[4], "%d", &spacing) == 1) {
+            msg.spacing = (uint8_t)spacing;
+        }
+        Host_Send(MSG_SCAN_CONTROL, &msg, sizeof(msg));
+    }
+    else if (strncmp("map", command, 3) == 0) {
+        MsgMapQuery msg = {(strstr(command, "all") != NULL) ? 1 : 0};
+
+        Host_Send(MSG_MAP_QUERY, &msg, sizeof(msg));
+    }
+    else if (strncmp("battery ", command, 8) == 0) {
+        World_SetBattery(atof(&command[8]));
+    }
+    else if (strncmp("current ", command, 8) == 0) {
+        World_InjectCurrent((strstr(command, "off") != NULL) ? -1.0 : atof(&command[8]));
+    }
+    else if (strncmp("jam ", command, 4) == 0) {
+        if (strstr(command, "left") != NULL) {
+            World_Jam(LEFT);
+        }
+        else if (strstr(command, "right") != NULL) {
+            World_Jam(RIGHT);
+        }
+        else {
+            World_Jam(-1);
+        }
+    }
+    else {
+        for (; *command != '\0'; command++) {
+            MsgCommand msg = {(uint8_t)*command};
+
+            Host_Send(MSG_COMMAND, &msg, sizeof(msg));
+        }
+    }
+}
+
+/*******************************************************************************
+* Host_Frame() - Handle a frame from the robot, as the server would.
+*******************************************************************************/
+static void Host_Frame(const ProtocolFrame *frame) {
+    switch (frame->type) {
+        case MSG_RANGE: {
+            Sim_Printf("[Host] Ultrasonic: %dcm\n", ((const MsgRange *)frame->payload)->distance);
+            break;
+        }
+        case MSG_LINK_STATUS: {
+            Sim_Printf("[Host] Link status\n");
+            Link_PrintStatus((const MsgLinkStatus *)frame->payload);
+            break;
+        }
+        case MSG_LOG: {
+            Log_PrintFrame(&logDecoder, frame);
+            break;
+        }
+        case MSG_TASK_STATUS: {
+            if (frame->len == sizeof(MsgTaskStatus)) {
+                Tasks_PrintStatus((const MsgTaskStatus *)frame->payload);
+            }
+            break;
+        }
+        case MSG_TUNE_RESULT: {
+            if (frame->len == sizeof(MsgTuneResult)) {
+                Tune_PrintResult((const MsgTuneResult *)frame->payload);
+            }
+            break;
+        }
+        case MSG_SCAN: {
+            Scan_PrintFrame(frame);
+            break;
+        }
+        case MSG_MAP_TILE: {
+            if (Map_Decode(&mapDecoder, frame)) {
+                Map_Print(&mapDecoder);
+            }
+            break;
+        }
+        case MSG_TELEMETRY: {
+            if (Telemetry_Decode(&telemetry, frame) && (telemetryPrintMs != 0)
+                && (telemetry.last.time - telemetry.lastPrint >= telemetryPrintMs)) {
+                telemetry.lastPrint = telemetry.last.time;
+                Sim_Printf("[Host] Telemetry\n");
+                Telemetry_Print(&telemetry);
+            }
+            break;
+        }
+        default: {
+            Sim_Printf("[Host] Frame type 0x%02X, %u bytes\n", frame->type, frame->len);
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Host_Init() - Reset the link decoders.
+* printMs   - Robot time between telemetry printouts, 0 for none.
+* No return value.
+*******************************************************************************/
+void Host_Init(uint32_t printMs) {
+    Protocol_DecoderInit(&decoder);
+    Telemetry_DecoderInit(&telemetry);
+    Map_DecoderInit(&mapDecoder);
+
+    memset(&logDecoder, 0, sizeof(logDecoder));
+    logDecoder.strings = __start_logstr;
+    logDecoder.size = __stop_logstr - __start_logstr;
+
+    telemetryPrintMs = printMs;
+}
+
+/*******************************************************************************
+* Host_Schedule() - Schedule a host command.
+* t         - Virtual time to send it at.
+* command   - Command (copied).
+* Returns 1 if it was scheduled.
+*******************************************************************************/
+uint8_t Host_Schedule(SimTime t, const char *command) {
+    uint8_t i;
+
+    if (eventCount >= HOST_MAX_EVENTS) {
+        return 0;
+    }
+
+    // Keep the list sorted, commands at the same time stay in order
+    for (i = eventCount; (i > 0) && (events[i - 1].time > t); i--) {
+        events[i] = events[i - 1];
+    }
+    events[i].time = t;
+    events[i].command = strdup(command);
+    eventCount++;
+
+    return 1;
+}
+
+/*******************************************************************************
+* Host_NextEvent() - Time of the next host command.
+* No inputs.
+* Returns the time, SIM_NEVER if there are none left.
+*******************************************************************************/
+SimTime Host_NextEvent(void) {
+    SimTime next = (eventNext < eventCount) ? events[eventNext].time : SIM_NEVER;
+
+    return (moveNext < next) ? moveNext : next;
+}
+
+/*******************************************************************************
+* Host_Advance() - Send the commands that are due by time t.
+* t         - New virtual time.
+* No return value.
+*******************************************************************************/
+void Host_Advance(SimTime t) {
+    while (moveNext <= t) {
+        Host_Send(MSG_VELOCITY, &moveMsg, sizeof(moveMsg));
+        moveNext += SIM_MS(HOST_MOVE_REPEAT_MS);
+    }
+
+    while ((eventNext < eventCount) && (events[eventNext].time <= t)) {
+        Host_Command(events[eventNext].command);
+        eventNext++;
+    }
+}
+
+/*******************************************************************************
+* Host_UsartOutput() - A byte finished sending on a USART.
+* regs      - USART registers.
+* byte      - Byte sent.
+* No return value.
+*******************************************************************************/
+void Host_UsartOutput(USART_TypeDef *regs, uint8_t byte) {
+    ProtocolFrame frame;
+
+    if (regs != USART3) {
+        putchar(byte);
+        consoleBytes++;
+        return;
+    }
+
+    if (Protocol_Feed(&decoder, byte, &frame)) {
+        Host_Frame(&frame);
+    }
+}
+
+/*******************************************************************************
+* Host_Print() - Print the link totals.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Host_Print(void) {
+    printf("[Host] %lu frames, %lu crc errors, %lu framing errors, %lu console bytes\n",
+           decoder.frames, decoder.crcErrors, decoder.framingErrors, consoleBytes);
+    printf("[Host] %lu telemetry frames (%lu lost), %lu log entries (%lu dropped)\n",
+           telemetry.frames, telemetry.lost, logDecoder.entries, logDecoder.dropped);
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+* Name: main.c (simulator)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Runs the robot firmware on the host in virtual time. The
+*              firmware's main() is built as Firmware_Main().
+*
+* Usage: ./bin/sim [-t SECONDS] [-p MS] [-o X,Y,R]... [-c TIME:COMMAND]... [-m HANDLER]...
+*        ./bin/sim [-p MS] -s SCENARIO
+*        ./bin/sim -T TEST
+*        ./bin/sim -b BENCHMARK[,COUNT]
+*   -t SECONDS      Virtual time to run for (default 10)
+*   -p MS           Print telemetry every MS of robot time (default 1000, 0 off)
+*   -o X,Y,R        Add a round obstacle (cm), the arena is 400x300 and the
+*                   robot starts in the middle facing +x
+*   -c TIME:CMD     Send a host command at TIME seconds (see host.c)
+*   -m HANDLER      Run an interrupt handler under the cycle model (see
+*                   sim.c), e.g. TIM2_IRQHandler
+*   -s SCENARIO     Run the firmware through a scripted scenario (see
+*                   scenario.c), exits with 1 if a check failed
+*   -T TEST         Run a unit test (see test.c) or all of them instead of
+*                   the firmware, exits with 1 if a check failed
+*   -b NAME[,COUNT] Run a benchmark (see bench.c) or all of them instead of
+*                   the firmware
+*
+* Example: ./bin/sim -t 5 -o 300,150,20 -c 1.5:0 -c 4:I
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define SIM_DEFAULT_SECONDS     10.0
+#define SIM_DEFAULT_PRINT_MS    1000
+
+extern void SystemInit(void);
+extern int Firmware_Main(void);
+
+static void Usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-t SECONDS] [-p MS] [-o X,Y,R]... [-c TIME:COMMAND]... [-m HANDLER]...\n"
+                    "       %s [-p MS] -s SCENARIO\n"
+                    "       %s -T TEST\n"
+                    "       %s -b BENCHMARK[,COUNT]\n", name, name, name, name);
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    double seconds = SIM_DEFAULT_SECONDS;
+    uint32_t printMs = SIM_DEFAULT_PRINT_MS;
+    const char *scenario = NULL;
+    const char *test = NULL;
+    const char *benchmark = NULL;
+    unsigned long count = 0;
+    int opt;
+
+    // Obstacles and commands are added as they are parsed
+    World_Init();
+
+    while ((opt = getopt(argc, argv, "t:p:o:c:m:s:T:b:")) != -1) {
+        switch (opt) {
+            case 't': {
+                seconds = atof(optarg);
+                break;
+            }
+            case 'p': {
+                printMs = (uint32_t)atoi(optarg);
+                break;
+            }
+            case 'o': {
+                double x, y, r;
+
+                if ((sscanf(optarg, "%lf,%lf,%lf", &x, &y, &r) != 3) || !World_AddObstacle(x, y, r)) {
+                    Usage(argv[0]);
+                }
+                break;
+            }
+            case 'c': {
+                char *colon = strchr(optarg, ':');
+
+                if ((colon == NULL) || !Host_Schedule((SimTime)(atof(optarg) * SIM_CLOCK_HZ), colon + 1)) {
+                    Usage(argv[0]);
+                }
+                break;
+            }
+            case 'm': {
+                if (!Sim_ModelCycles(optarg)) {
+                    Usage(argv[0]);
+                }
+                break;
+            }
+            case 's': {
+                scenario = optarg;
+                break;
+            }
+            case 'T': {
+                test = optarg;
+                break;
+            }
+            case 'b': {
+                char *comma = strchr(optarg, ',');
+
+                if (comma != NULL) {
+                    *comma = '\0';
+                    count = strtoul(comma + 1, NULL, 10);
+                }
+                benchmark = optarg;
+                break;
+            }
+            default: {
+                Usage(argv[0]);
+            }
+        }
+    }
+
+    // The scenario sets the length of the run
+    if (scenario != NULL) {
+        seconds = Scenario_Init(scenario);
+        if (seconds <= 0) {
+            Usage(argv[0]);
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    Host_Init(printMs);
+    Sim_Init((SimTime)(seconds * SIM_CLOCK_HZ));
+
+    if (test != NULL) {
+        return Test_Run(test);
+    }
+
+    if (benchmark != NULL) {
+        if (Bench_Run(benchmark, count) != 0) {
+            Usage(argv[0]);
+        }
+        return 0;
+    }
+
+    // What the startup code does before main()
+    SystemInit();
+    Firmware_Main();
+
+    Sim_Printf("sim: firmware main() returned\n");
+    Sim_Exit(1);
+}
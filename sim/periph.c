@@ -0,0 +1,1240 @@
+/*******************************************************************************
+* Name: periph.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Register models for the peripherals the firmware uses. Each
+*              model keeps the registers in the mapped memory up to date with
+*              virtual time and picks up firmware writes when it syncs.
+*
+* Limitations:
+*   - Timers count up only, ARR/PSC/CCR preload is ignored (writes take
+*     effect straight away) and input filters are not modelled.
+*   - Reading TIMx->CCRx or USARTx->RDR can't be seen, so input capture and
+*     RXNE flags are cleared when the handler of their interrupt returns.
+*   - USART transmit only works through DMA, the TDR is not polled.
+*   - The CRC unit supports all polynomial sizes but no bit reversal.
+*   - ADC1/2 only convert the regular sequence, 12-bit right aligned, in no
+*     time, started by ADSTART or a timer TRGO. Continuous mode and the
+*     injected group are not modelled. TRGO from OCxREF is taken as the CCx
+*     match (the rising edge in PWM mode 2), calibration and the voltage
+*     regulator are ready straight away.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "sim.h"
+#include "../src/Utility.h"
+
+#define TIM_CHANNELS        4
+#define DMA1_CHANNELS       7
+#define DMA2_CHANNELS       5
+#define DMA_CHANNELS        (DMA1_CHANNELS + DMA2_CHANNELS)
+#define DMA2_CH(n)          (DMA1_CHANNELS + (n))   // Model channel number of DMA2 channel n
+#define ADC_FULL_SCALE      4095
+#define ADC_VREF_MV         3300.0
+#define GPIO_PORTS          6
+#define USART_RX_SIZE       1024
+#define CRC_SENTINEL        0xA5A5A500UL    // Upper bytes show how wide the trapped write was
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    TIM_TypeDef *regs;
+    uint32_t max;               // Counter mask, TIM2 is 32 bits
+    IRQn_Type upIrq;            // Update
+    IRQn_Type ccIrq;            // Capture/compare
+    IRQn_Type trgIrq;           // Trigger and commutation
+    IRQn_Type brkIrq;           // Break
+    uint8_t running;            // CEN as last seen
+    uint32_t cnt;               // CNT as last written by the model
+    SimTime last;               // Time of the tick cnt was reached on
+    uint8_t inputs;             // TI1..TI4 levels
+} SimTimer;
+
+typedef struct {
+    uint8_t enabled;            // EN as last seen
+    uint32_t total;             // CNDTR when enabled
+    uint32_t remaining;
+    uintptr_t mem;
+    uintptr_t periph;
+} SimDma;
+
+typedef struct {
+    USART_TypeDef *regs;
+    IRQn_Type irq;
+    uint8_t txDma;              // DMA1 channel numbers
+    uint8_t rxDma;
+    SimTime txDone;             // End of the byte being sent
+    uint8_t txByte;
+    SimTime rxDone;             // End of the byte being received
+    SimTime idleAt;             // Line seen idle after the last byte
+    uint8_t rx[USART_RX_SIZE];  // Bytes from the host waiting to go on the wire
+    uint16_t rxHead;
+    uint16_t rxTail;
+} SimUsart;
+
+typedef struct {
+    uint16_t driven;            // Input pins driven by the world
+    uint16_t levels;            // Levels of the driven pins
+} SimGpio;
+
+typedef struct {
+    ADC_TypeDef *regs;
+    uint8_t dma;                // Model DMA channel number
+    uint8_t enabled;            // ADEN as last seen
+} SimAdc;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static SimTime now = 0;
+
+static SimTimer timers[] = {
+    {TIM1,  0xFFFFUL,     TIM1_UP_TIM16_IRQn,  TIM1_CC_IRQn,        TIM1_TRG_COM_TIM17_IRQn, TIM1_BRK_TIM15_IRQn, 0, 0, 0, 0},
+    {TIM2,  0xFFFFFFFFUL, TIM2_IRQn,           TIM2_IRQn,           TIM2_IRQn,               TIM2_IRQn,           0, 0, 0, 0},
+    {TIM3,  0xFFFFUL,     TIM3_IRQn,           TIM3_IRQn,           TIM3_IRQn,               TIM3_IRQn,           0, 0, 0, 0},
+    {TIM4,  0xFFFFUL,     TIM4_IRQn,           TIM4_IRQn,           TIM4_IRQn,               TIM4_IRQn,           0, 0, 0, 0},
+    {TIM6,  0xFFFFUL,     TIM6_DAC_IRQn,       TIM6_DAC_IRQn,       TIM6_DAC_IRQn,           TIM6_DAC_IRQn,       0, 0, 0, 0},
+    {TIM7,  0xFFFFUL,     TIM7_IRQn,           TIM7_IRQn,           TIM7_IRQn,               TIM7_IRQn,           0, 0, 0, 0},
+    {TIM8,  0xFFFFUL,     TIM8_UP_IRQn,        TIM8_CC_IRQn,        TIM8_TRG_COM_IRQn,       TIM8_BRK_IRQn,       0, 0, 0, 0},
+    {TIM15, 0xFFFFUL,     TIM1_BRK_TIM15_IRQn, TIM1_BRK_TIM15_IRQn, TIM1_BRK_TIM15_IRQn,     TIM1_BRK_TIM15_IRQn, 0, 0, 0, 0},
+    {TIM16, 0xFFFFUL,     TIM1_UP_TIM16_IRQn,  TIM1_UP_TIM16_IRQn,  TIM1_UP_TIM16_IRQn,      TIM1_UP_TIM16_IRQn,  0, 0, 0, 0},
+    {TIM17, 0xFFFFUL,     TIM1_TRG_COM_TIM17_IRQn, TIM1_TRG_COM_TIM17_IRQn, TIM1_TRG_COM_TIM17_IRQn, TIM1_TRG_COM_TIM17_IRQn, 0, 0, 0, 0},
+};
+#define TIMER_COUNT (sizeof(timers) / sizeof(timers[0]))
+
+static SimDma dmas[DMA_CHANNELS];
+
+static SimUsart usarts[] = {
+    {USART2, USART2_IRQn, 7, 6, SIM_NEVER, 0, SIM_NEVER, SIM_NEVER, {0}, 0, 0},
+    {USART3, USART3_IRQn, 2, 3, SIM_NEVER, 0, SIM_NEVER, SIM_NEVER, {0}, 0, 0},
+};
+#define USART_COUNT (sizeof(usarts) / sizeof(usarts[0]))
+
+static SimGpio gpios[GPIO_PORTS];
+
+static SimAdc adcs[] = {
+    {ADC1, 1, 0},
+    {ADC2, DMA2_CH(1), 0},
+};
+#define ADC_COUNT (sizeof(adcs) / sizeof(adcs[0]))
+
+// ADC1/2 regular external trigger (EXTSEL) of each timer's TRGO
+static const struct {
+    TIM_TypeDef *regs;
+    uint8_t extsel;
+} adcTriggers[] = {
+    {TIM3, 4}, {TIM8, 7}, {TIM1, 9}, {TIM2, 11}, {TIM4, 12}, {TIM6, 13}, {TIM15, 14},
+};
+#define ADC_TRIGGER_COUNT (sizeof(adcTriggers) / sizeof(adcTriggers[0]))
+
+// SysTick
+static uint8_t sysTickEnabled = 0;
+static SimTime sysTickZero = SIM_NEVER;     // Next time the counter reaches 0
+static uint32_t sysTickVal = 0;             // VAL as last written by the model
+
+// DWT cycle counter
+static uint8_t cycleRunning = 0;
+static SimTime cycleBase = 0;               // Virtual time CYCCNT was 0
+static uint32_t cycleVal = 0;               // CYCCNT as last written by the model
+
+// CRC unit, DR holds the sentinel while a write is trapped
+static uint32_t crcValue = 0;
+
+// Timers start ADC conversions
+static void Adc_Trigger(TIM_TypeDef *regs);
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Timer_Find() - Find the model of a timer.
+* regs      - Timer registers.
+* Returns the model, or NULL if the timer is not modelled.
+*******************************************************************************/
+static SimTimer *Timer_Find(TIM_TypeDef *regs) {
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        if (timers[i].regs == regs) {
+            return &timers[i];
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Timer_CCR() - Capture/compare register of a channel.
+*******************************************************************************/
+static volatile uint32_t *Timer_CCR(TIM_TypeDef *regs, uint8_t ch) {
+    volatile uint32_t *ccr[TIM_CHANNELS] = {&regs->CCR1, &regs->CCR2, &regs->CCR3, &regs->CCR4};
+
+    return ccr[ch];
+}
+
+/*******************************************************************************
+* Timer_CCS() - Capture/compare selection (CCxS) of a channel, 0 is output.
+*******************************************************************************/
+static uint8_t Timer_CCS(TIM_TypeDef *regs, uint8_t ch) {
+    uint32_t ccmr = (ch < 2) ? regs->CCMR1 : regs->CCMR2;
+
+    return (ccmr >> ((ch & 1) * 8)) & 3;
+}
+
+/*******************************************************************************
+* Timer_Ticks() - Counter ticks until the counter next equals a value.
+* tim       - Timer model.
+* target    - Counter value.
+* Returns the ticks, one full period if the counter is already there.
+*******************************************************************************/
+static uint64_t Timer_Ticks(const SimTimer *tim, uint32_t target) {
+    uint64_t period = (uint64_t)(tim->regs->ARR & tim->max) + 1;
+
+    if (target > tim->cnt) {
+        return target - tim->cnt;
+    }
+    return period - tim->cnt + target;
+}
+
+/*******************************************************************************
+* Timer_Start() - The counter was enabled or restarted at the current time.
+*******************************************************************************/
+static void Timer_Start(SimTimer *tim) {
+    tim->running = 1;
+    tim->last = now;
+    World_TimerUpdate(tim->regs);
+}
+
+/*******************************************************************************
+* Timer_Advance() - Count up to time t, setting the update and output compare
+*                   flags that were passed.
+* tim       - Timer model.
+* t         - Time to count to.
+* No return value.
+*******************************************************************************/
+static void Timer_Advance(SimTimer *tim, SimTime t) {
+    TIM_TypeDef *regs = tim->regs;
+    uint64_t prescale = (uint64_t)regs->PSC + 1;
+    uint64_t arr = regs->ARR & tim->max;
+    uint32_t mms = (regs->CR2 & TIM_CR2_MMS) >> TIM_CR2_MMS_Pos;
+    uint64_t ticks;
+    uint64_t toUpdate;
+
+    if (!tim->running || (arr == 0)) {
+        tim->last = t;
+        return;
+    }
+
+    ticks = (t - tim->last) / prescale;
+    if (ticks == 0) {
+        return;
+    }
+    tim->last += ticks * prescale;
+
+    // Output compare matches
+    for (uint8_t ch = 0; ch < TIM_CHANNELS; ch++) {
+        uint32_t ccr = *Timer_CCR(regs, ch) & tim->max;
+
+        if ((Timer_CCS(regs, ch) == 0) && (ccr <= arr) && (ticks >= Timer_Ticks(tim, ccr))) {
+            regs->SR |= TIM_SR_CC1IF << ch;
+
+            // TRGO on the compare pulse or OCxREF
+            if (((mms == 3) && (ch == 0)) || (mms == 4UL + ch)) {
+                Adc_Trigger(regs);
+            }
+        }
+    }
+
+    // Update event
+    toUpdate = arr + 1 - tim->cnt;
+    if (ticks < toUpdate) {
+        tim->cnt += (uint32_t)ticks;
+    }
+    else {
+        if (!(regs->CR1 & TIM_CR1_UDIS)) {
+            regs->SR |= TIM_SR_UIF;
+        }
+        if (mms == 2) {
+            Adc_Trigger(regs);
+        }
+
+        if (regs->CR1 & TIM_CR1_OPM) {
+            regs->CR1 &= ~TIM_CR1_CEN;
+            tim->running = 0;
+            tim->cnt = 0;
+        }
+        else {
+            tim->cnt = (uint32_t)((ticks - toUpdate) % (arr + 1));
+            World_TimerUpdate(regs);
+        }
+    }
+    regs->CNT = tim->cnt;
+}
+
+/*******************************************************************************
+* Timer_NextEvent() - Time of the next update or output compare match.
+*******************************************************************************/
+static SimTime Timer_NextEvent(const SimTimer *tim) {
+    TIM_TypeDef *regs = tim->regs;
+    uint64_t arr = regs->ARR & tim->max;
+    uint64_t ticks;
+
+    if (!tim->running || (arr == 0)) {
+        return SIM_NEVER;
+    }
+
+    ticks = arr + 1 - tim->cnt;
+    for (uint8_t ch = 0; ch < TIM_CHANNELS; ch++) {
+        uint32_t ccr = *Timer_CCR(regs, ch) & tim->max;
+
+        if ((Timer_CCS(regs, ch) == 0) && (ccr <= arr) && (Timer_Ticks(tim, ccr) < ticks)) {
+            ticks = Timer_Ticks(tim, ccr);
+        }
+    }
+
+    return tim->last + ticks * ((uint64_t)regs->PSC + 1);
+}
+
+/*******************************************************************************
+* Timer_Sync() - Pick up firmware writes to CNT, EGR and CEN.
+*******************************************************************************/
+static void Timer_Sync(SimTimer *tim) {
+    TIM_TypeDef *regs = tim->regs;
+
+    if ((regs->CNT & tim->max) != tim->cnt) {
+        tim->cnt = regs->CNT & tim->max;
+        tim->last = now;
+    }
+
+    if (regs->EGR != 0) {
+        if (regs->EGR & TIM_EGR_UG) {
+            tim->cnt = 0;
+            tim->last = now;
+            regs->CNT = 0;
+            if (!(regs->CR1 & TIM_CR1_URS)) {
+                regs->SR |= TIM_SR_UIF;
+            }
+        }
+        regs->SR |= regs->EGR & (TIM_EGR_CC1G | TIM_EGR_CC2G | TIM_EGR_CC3G | TIM_EGR_CC4G | TIM_EGR_TG);
+        regs->EGR = 0;
+    }
+
+    if ((regs->CR1 & TIM_CR1_CEN) && !tim->running) {
+        Timer_Start(tim);
+    }
+    else if (!(regs->CR1 & TIM_CR1_CEN) && tim->running) {
+        tim->running = 0;
+    }
+}
+
+/*******************************************************************************
+* Timer_EdgeMatches() - Check an input edge against a CCxP/CCxNP polarity.
+*******************************************************************************/
+static uint8_t Timer_EdgeMatches(TIM_TypeDef *regs, uint8_t ch, uint8_t rising) {
+    uint8_t p = (regs->CCER >> (ch * 4 + 1)) & 1;
+    uint8_t np = (regs->CCER >> (ch * 4 + 3)) & 1;
+
+    if (p && np) {
+        return 1;
+    }
+    return rising ? !p : p;
+}
+
+/*******************************************************************************
+* Dma_Controller() - DMA controller of a model channel number.
+*******************************************************************************/
+static DMA_TypeDef *Dma_Controller(uint8_t ch) {
+    return (ch > DMA1_CHANNELS) ? DMA2 : DMA1;
+}
+
+/*******************************************************************************
+* Dma_Index() - Channel index (0 based) within its controller.
+*******************************************************************************/
+static uint8_t Dma_Index(uint8_t ch) {
+    return (ch > DMA1_CHANNELS) ? (ch - DMA1_CHANNELS - 1) : (ch - 1);
+}
+
+/*******************************************************************************
+* Dma_Channel() - Registers of a model channel number.
+*******************************************************************************/
+static DMA_Channel_TypeDef *Dma_Channel(uint8_t ch) {
+    uintptr_t base = (ch > DMA1_CHANNELS) ? DMA2_Channel1_BASE : DMA1_Channel1_BASE;
+
+    return (DMA_Channel_TypeDef *)(base + Dma_Index(ch) * 0x14UL);
+}
+
+/*******************************************************************************
+* Dma_Request() - A peripheral requests one DMA transfer.
+* ch        - DMA1 channel number (1..7), or DMA2_CH(1..5).
+* Returns 1 if an item was transferred.
+*******************************************************************************/
+static uint8_t Dma_Request(uint8_t ch) {
+    DMA_TypeDef *ctrl = Dma_Controller(ch);
+    DMA_Channel_TypeDef *regs = Dma_Channel(ch);
+    SimDma *dma = &dmas[ch - 1];
+    uint32_t ccr = regs->CCR;
+    uint8_t psize = 1 << ((ccr & DMA_CCR_PSIZE) >> DMA_CCR_PSIZE_Pos);
+    uint8_t msize = 1 << ((ccr & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos);
+    uintptr_t src, dst;
+    uint8_t srcSize, dstSize;
+    uint32_t value = 0;
+    uint32_t shift = Dma_Index(ch) * 4;
+
+    if (!dma->enabled || (dma->remaining == 0)) {
+        return 0;
+    }
+
+    if (ccr & DMA_CCR_DIR) {
+        src = dma->mem;
+        srcSize = msize;
+        dst = dma->periph;
+        dstSize = psize;
+    }
+    else {
+        src = dma->periph;
+        srcSize = psize;
+        dst = dma->mem;
+        dstSize = msize;
+    }
+
+    memcpy(&value, (const void *)src, srcSize);
+    memcpy((void *)dst, &value, dstSize);
+
+    if (ccr & DMA_CCR_MINC) {
+        dma->mem += msize;
+    }
+    if (ccr & DMA_CCR_PINC) {
+        dma->periph += psize;
+    }
+
+    dma->remaining--;
+    if (dma->remaining == dma->total / 2) {
+        ctrl->ISR |= (DMA_ISR_GIF1 | DMA_ISR_HTIF1) << shift;
+    }
+    if (dma->remaining == 0) {
+        ctrl->ISR |= (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << shift;
+
+        if (ccr & DMA_CCR_CIRC) {
+            dma->remaining = dma->total;
+            dma->mem = regs->CMAR;
+            dma->periph = regs->CPAR;
+        }
+    }
+    regs->CNDTR = dma->remaining;
+
+    return 1;
+}
+
+/*******************************************************************************
+* Dma_Clear() - Pick up interrupt flag clears on one controller.
+*******************************************************************************/
+static void Dma_Clear(DMA_TypeDef *ctrl, uint8_t channels) {
+    uint32_t ifcr = ctrl->IFCR;
+
+    // Clearing the global flag clears all of the channel's flags
+    if (ifcr != 0) {
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            if (ifcr & (DMA_IFCR_CGIF1 << (ch * 4))) {
+                ifcr |= 0xFUL << (ch * 4);
+            }
+        }
+        ctrl->ISR &= ~ifcr;
+        ctrl->IFCR = 0;
+    }
+}
+
+/*******************************************************************************
+* Dma_Sync() - Pick up channel enables and interrupt flag clears.
+*******************************************************************************/
+static void Dma_Sync(void) {
+    Dma_Clear(DMA1, DMA1_CHANNELS);
+    Dma_Clear(DMA2, DMA2_CHANNELS);
+
+    for (uint8_t ch = 1; ch <= DMA_CHANNELS; ch++) {
+        DMA_Channel_TypeDef *regs = Dma_Channel(ch);
+        SimDma *dma = &dmas[ch - 1];
+
+        // A new count while enabled means the channel was disabled and
+        // re-armed between two syncs
+        if ((regs->CCR & DMA_CCR_EN) && (!dma->enabled || ((regs->CNDTR & 0xFFFF) != dma->remaining))) {
+            dma->enabled = 1;
+            dma->total = regs->CNDTR & 0xFFFF;
+            dma->remaining = dma->total;
+            dma->mem = regs->CMAR;
+            dma->periph = regs->CPAR;
+        }
+        else if (!(regs->CCR & DMA_CCR_EN) && dma->enabled) {
+            dma->enabled = 0;
+        }
+    }
+}
+
+/*******************************************************************************
+* Adc_Sequence() - Channel of one conversion of the regular sequence.
+* regs      - ADC registers.
+* i         - Conversion number, 0 is SQ1.
+* Returns the channel number.
+*******************************************************************************/
+static uint8_t Adc_Sequence(ADC_TypeDef *regs, uint8_t i) {
+    volatile uint32_t *sqr[] = {&regs->SQR1, &regs->SQR2, &regs->SQR3, &regs->SQR4};
+    uint8_t n = i + 1;
+
+    // SQ1-SQ4 follow L in SQR1, the rest are five to a register
+    if (n < 5) {
+        return (*sqr[0] >> (n * 6)) & 0x1F;
+    }
+    return (*sqr[1 + (n - 5) / 5] >> (((n - 5) % 5) * 6)) & 0x1F;
+}
+
+/*******************************************************************************
+* Adc_Convert() - Convert the regular sequence, each result going to the DMA
+*                 if it is enabled.
+*******************************************************************************/
+static void Adc_Convert(SimAdc *adc) {
+    ADC_TypeDef *regs = adc->regs;
+    uint8_t len = ((regs->SQR1 & ADC_SQR1_L) >> ADC_SQR1_L_Pos) + 1;
+
+    for (uint8_t i = 0; i < len; i++) {
+        double mv = World_AnalogInput(regs, Adc_Sequence(regs, i));
+        double code = mv * (ADC_FULL_SCALE + 1) / ADC_VREF_MV;
+
+        if ((regs->ISR & ADC_ISR_EOC) && !(regs->CFGR & ADC_CFGR_OVRMOD)) {
+            regs->ISR |= ADC_ISR_OVR;
+            continue;
+        }
+        regs->DR = (code <= 0) ? 0 : (code >= ADC_FULL_SCALE) ? ADC_FULL_SCALE : (uint32_t)code;
+        regs->ISR |= ADC_ISR_EOC;
+
+        // The DMA reading DR clears EOC
+        if (regs->CFGR & ADC_CFGR_DMAEN) {
+            if (Dma_Request(adc->dma)) {
+                regs->ISR &= ~ADC_ISR_EOC;
+            }
+            else {
+                regs->ISR |= ADC_ISR_OVR;
+            }
+        }
+    }
+    regs->ISR |= ADC_ISR_EOS;
+}
+
+/*******************************************************************************
+* Adc_Trigger() - A timer's TRGO rose, start the ADCs waiting for it.
+*******************************************************************************/
+static void Adc_Trigger(TIM_TypeDef *regs) {
+    for (size_t i = 0; i < ADC_TRIGGER_COUNT; i++) {
+        if (adcTriggers[i].regs != regs) {
+            continue;
+        }
+
+        for (size_t j = 0; j < ADC_COUNT; j++) {
+            ADC_TypeDef *adc = adcs[j].regs;
+            uint32_t extsel = (adc->CFGR & ADC_CFGR_EXTSEL) >> ADC_CFGR_EXTSEL_Pos;
+
+            // Rising or both edges
+            if ((adc->CR & ADC_CR_ADSTART) && (adc->CFGR & ADC_CFGR_EXTEN_0) && (extsel == adcTriggers[i].extsel)) {
+                Adc_Convert(&adcs[j]);
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Adc_Sync() - Pick up calibration, enable, start and stop requests.
+*******************************************************************************/
+static void Adc_Sync(SimAdc *adc) {
+    ADC_TypeDef *regs = adc->regs;
+    uint32_t cr = regs->CR;
+
+    cr &= ~ADC_CR_ADCAL;
+    if (cr & ADC_CR_ADDIS) {
+        cr &= ~(ADC_CR_ADDIS | ADC_CR_ADEN | ADC_CR_ADSTART);
+        regs->ISR &= ~ADC_ISR_ADRDY;
+    }
+    if (cr & ADC_CR_ADSTP) {
+        cr &= ~(ADC_CR_ADSTP | ADC_CR_ADSTART);
+    }
+
+    if ((cr & ADC_CR_ADEN) && !adc->enabled) {
+        regs->ISR |= ADC_ISR_ADRDY;
+    }
+    adc->enabled = (cr & ADC_CR_ADEN) != 0;
+
+    // Software start converts the sequence once
+    if ((cr & ADC_CR_ADSTART) && !(regs->CFGR & ADC_CFGR_EXTEN)) {
+        regs->CR = cr;
+        Adc_Convert(adc);
+        cr &= ~ADC_CR_ADSTART;
+    }
+    regs->CR = cr;
+}
+
+/*******************************************************************************
+* Usart_ByteTime() - Time to send one 8N1 character at the programmed rate.
+*******************************************************************************/
+static SimTime Usart_ByteTime(const SimUsart *usart) {
+    uint32_t brr = usart->regs->BRR & 0xFFFF;
+
+    return (SimTime)((brr != 0) ? brr : 1) * 10;
+}
+
+/*******************************************************************************
+* Usart_StartTx() - Start sending the next byte if the DMA has one.
+*******************************************************************************/
+static void Usart_StartTx(SimUsart *usart) {
+    USART_TypeDef *regs = usart->regs;
+
+    if ((usart->txDone != SIM_NEVER) || !(regs->CR1 & USART_CR1_UE) || !(regs->CR1 & USART_CR1_TE)
+        || !(regs->CR3 & USART_CR3_DMAT)) {
+        return;
+    }
+
+    if (Dma_Request(usart->txDma)) {
+        usart->txByte = (uint8_t)regs->TDR;
+        usart->txDone = now + Usart_ByteTime(usart);
+        regs->ISR &= ~USART_ISR_TC;
+    }
+}
+
+/*******************************************************************************
+* Usart_StartRx() - Put the next host byte on the wire.
+*******************************************************************************/
+static void Usart_StartRx(SimUsart *usart) {
+    USART_TypeDef *regs = usart->regs;
+
+    if ((usart->rxDone == SIM_NEVER) && (usart->rxHead != usart->rxTail)
+        && (regs->CR1 & USART_CR1_UE) && (regs->CR1 & USART_CR1_RE)) {
+        usart->rxDone = now + Usart_ByteTime(usart);
+        usart->idleAt = SIM_NEVER;
+    }
+}
+
+/*******************************************************************************
+* Usart_Advance() - Finish the bytes being sent and received by time t.
+*******************************************************************************/
+static void Usart_Advance(SimUsart *usart, SimTime t) {
+    USART_TypeDef *regs = usart->regs;
+
+    if (usart->txDone <= t) {
+        usart->txDone = SIM_NEVER;
+        Host_UsartOutput(regs, usart->txByte);
+        Usart_StartTx(usart);
+        if (usart->txDone == SIM_NEVER) {
+            regs->ISR |= USART_ISR_TC;
+        }
+    }
+
+    if (usart->rxDone <= t) {
+        uint8_t byte = usart->rx[usart->rxTail];
+
+        usart->rxTail = (usart->rxTail + 1) % USART_RX_SIZE;
+        usart->rxDone = SIM_NEVER;
+
+        if (regs->ISR & USART_ISR_RXNE) {
+            regs->ISR |= USART_ISR_ORE;
+        }
+        else {
+            regs->RDR = byte;
+            regs->ISR |= USART_ISR_RXNE;
+
+            // The DMA reading RDR clears RXNE
+            if ((regs->CR3 & USART_CR3_DMAR) && Dma_Request(usart->rxDma)) {
+                regs->ISR &= ~USART_ISR_RXNE;
+            }
+        }
+
+        Usart_StartRx(usart);
+        if (usart->rxDone == SIM_NEVER) {
+            usart->idleAt = t + Usart_ByteTime(usart);
+        }
+    }
+
+    if (usart->idleAt <= t) {
+        usart->idleAt = SIM_NEVER;
+        regs->ISR |= USART_ISR_IDLE;
+    }
+}
+
+/*******************************************************************************
+* Usart_Sync() - Pick up flag clears, enables and DMA transmit requests.
+*******************************************************************************/
+static void Usart_Sync(SimUsart *usart) {
+    USART_TypeDef *regs = usart->regs;
+    uint32_t cr1 = regs->CR1;
+
+    if (regs->ICR != 0) {
+        regs->ISR &= ~(regs->ICR & (USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_ORECF
+                                    | USART_ICR_IDLECF | USART_ICR_TCCF));
+        regs->ICR = 0;
+    }
+    if (regs->RQR & USART_RQR_RXFRQ) {
+        regs->ISR &= ~USART_ISR_RXNE;
+    }
+    regs->RQR = 0;
+
+    // Transmit and receive enable acknowledge, the transmit data register is always free
+    regs->ISR &= ~(USART_ISR_TEACK | USART_ISR_REACK);
+    if (cr1 & USART_CR1_UE) {
+        if (cr1 & USART_CR1_TE) {
+            regs->ISR |= USART_ISR_TEACK;
+        }
+        if (cr1 & USART_CR1_RE) {
+            regs->ISR |= USART_ISR_REACK;
+        }
+    }
+    regs->ISR |= USART_ISR_TXE;
+
+    Usart_StartTx(usart);
+    Usart_StartRx(usart);
+}
+
+/*******************************************************************************
+* Usart_IrqLevel() - USART interrupt request line.
+*******************************************************************************/
+static uint8_t Usart_IrqLevel(const SimUsart *usart) {
+    USART_TypeDef *regs = usart->regs;
+    uint32_t isr = regs->ISR;
+    uint32_t cr1 = regs->CR1;
+    uint8_t eie = (regs->CR3 & USART_CR3_EIE) != 0;
+
+    return ((isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE))
+        || ((isr & USART_ISR_RXNE) && (cr1 & USART_CR1_RXNEIE))
+        || ((isr & USART_ISR_ORE) && ((cr1 & USART_CR1_RXNEIE) || eie))
+        || ((isr & (USART_ISR_FE | USART_ISR_NE)) && eie)
+        || ((isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE))
+        || ((isr & USART_ISR_TXE) && (cr1 & USART_CR1_TXEIE));
+}
+
+/*******************************************************************************
+* Gpio_Sync() - Rebuild the input data registers from the outputs, pull-ups
+*               and the pins the world drives.
+*******************************************************************************/
+static void Gpio_Sync(void) {
+    for (uint8_t port = 0; port < GPIO_PORTS; port++) {
+        GPIO_TypeDef *regs = (GPIO_TypeDef *)(GPIOA_BASE + port * 0x400UL);
+        uint32_t idr = 0;
+
+        // Write-only set/reset registers
+        if ((regs->BSRR != 0) || (regs->BRR != 0)) {
+            regs->ODR = (regs->ODR & ~(regs->BRR | (regs->BSRR >> 16))) | (regs->BSRR & 0xFFFF);
+            regs->BSRR = 0;
+            regs->BRR = 0;
+        }
+
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            uint32_t bit = 1UL << pin;
+            uint32_t mode = (regs->MODER >> (pin * 2)) & 3;
+            uint32_t pupd = (regs->PUPDR >> (pin * 2)) & 3;
+
+            if (gpios[port].driven & bit) {
+                idr |= gpios[port].levels & bit;
+            }
+            else if (mode == GPIO_MODE_OUT) {
+                idr |= regs->ODR & bit;
+            }
+            else if (pupd == GPIO_PUPD_PU) {
+                idr |= bit;
+            }
+        }
+        regs->IDR = idr;
+    }
+}
+
+/*******************************************************************************
+* Exti_IrqLevel() - EXTI interrupt request line for a range of lines.
+*******************************************************************************/
+static uint8_t Exti_IrqLevel(uint8_t first, uint8_t last) {
+    uint32_t mask = ((2UL << last) - 1) & ~((1UL << first) - 1);
+
+    return (EXTI->PR & EXTI->IMR & mask) != 0;
+}
+
+/*******************************************************************************
+* SysTick_Sync() - Pick up enables and writes to VAL.
+*******************************************************************************/
+static void SysTick_Sync(void) {
+    uint32_t ctrl = SysTick->CTRL;
+    uint32_t div = (ctrl & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 8;
+    uint32_t reload = (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1;
+
+    if (!(ctrl & SysTick_CTRL_ENABLE_Msk)) {
+        sysTickEnabled = 0;
+        sysTickZero = SIM_NEVER;
+        sysTickVal = SysTick->VAL;
+        return;
+    }
+
+    // Writing VAL clears it, the counter then reloads on the next clock
+    if (!sysTickEnabled || (SysTick->VAL != sysTickVal)) {
+        uint32_t count = (sysTickEnabled || (SysTick->VAL == 0)) ? reload : SysTick->VAL;
+
+        if (sysTickEnabled) {
+            SysTick->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+        }
+        sysTickEnabled = 1;
+        sysTickZero = now + (SimTime)count * div;
+    }
+}
+
+/*******************************************************************************
+* SysTick_Advance() - Count down to time t.
+*******************************************************************************/
+static void SysTick_Advance(SimTime t) {
+    uint32_t div = (SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 8;
+    uint32_t load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+
+    if (!sysTickEnabled) {
+        return;
+    }
+
+    if (sysTickZero <= t) {
+        SysTick->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) {
+            NVIC_SetPendingIRQ(SysTick_IRQn);
+        }
+        sysTickZero = (load != 0) ? sysTickZero + (SimTime)(load + 1) * div : SIM_NEVER;
+    }
+
+    sysTickVal = (sysTickZero == SIM_NEVER) ? 0 : (uint32_t)((sysTickZero - t) / div);
+    if (sysTickVal > load) {
+        sysTickVal = 0;
+    }
+    SysTick->VAL = sysTickVal;
+}
+
+/*******************************************************************************
+* Cycle_Sync() - Pick up DWT cycle counter enables and writes.
+*******************************************************************************/
+static void Cycle_Sync(void) {
+    uint8_t run = (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+
+    if ((run && !cycleRunning) || (DWT->CYCCNT != cycleVal)) {
+        cycleBase = now - DWT->CYCCNT;
+        cycleVal = DWT->CYCCNT;
+    }
+    cycleRunning = run;
+}
+
+/*******************************************************************************
+* Rcc_Sync() - Oscillators and the PLL are ready as soon as they are enabled.
+*******************************************************************************/
+static void Rcc_Sync(void) {
+    uint32_t cr = RCC->CR & ~(RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY);
+
+    if (cr & RCC_CR_HSION) {
+        cr |= RCC_CR_HSIRDY;
+    }
+    if (cr & RCC_CR_HSEON) {
+        cr |= RCC_CR_HSERDY;
+    }
+    if (cr & RCC_CR_PLLON) {
+        cr |= RCC_CR_PLLRDY;
+    }
+    RCC->CR = cr;
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SWS) | ((RCC->CFGR & RCC_CFGR_SW) << 2);
+}
+
+/*******************************************************************************
+* Crc_Feed() - Shift data through the CRC unit, most significant bit first.
+* data      - Data written to DR.
+* bits      - Width of the write.
+*******************************************************************************/
+static void Crc_Feed(uint32_t data, uint8_t bits) {
+    static const uint8_t polySizes[] = {32, 16, 8, 7};
+    uint8_t size = polySizes[(CRC->CR & CRC_CR_POLYSIZE) >> CRC_CR_POLYSIZE_Pos];
+    uint32_t mask = (size == 32) ? 0xFFFFFFFFUL : ((1UL << size) - 1);
+    uint32_t poly = CRC->POL & mask;
+    uint32_t crc = crcValue & mask;
+
+    for (int8_t i = bits - 1; i >= 0; i--) {
+        uint8_t feedback = ((crc >> (size - 1)) ^ (data >> i)) & 1;
+
+        crc = (crc << 1) & mask;
+        if (feedback) {
+            crc ^= poly;
+        }
+    }
+    crcValue = crc;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Periph_Init() - Load the register reset values the firmware relies on and
+*                 trap the pages with write side effects.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Periph_Init(void) {
+    RCC->CR = RCC_CR_HSION | RCC_CR_HSIRDY;
+    FLASH->ACR = 0x30;
+
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        timers[i].regs->ARR = timers[i].max;
+    }
+
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        usarts[i].regs->ISR = USART_ISR_TXE | USART_ISR_TC;
+    }
+
+    for (size_t i = 0; i < ADC_COUNT; i++) {
+        adcs[i].regs->CR = ADC_CR_ADVREGEN_1;
+    }
+
+    GPIOA->MODER = 0xA8000000UL;    // Debug pins
+    GPIOA->PUPDR = 0x64000000UL;
+    GPIOB->MODER = 0x00000280UL;
+    GPIOB->PUPDR = 0x00000100UL;
+
+    CRC->DR = 0xFFFFFFFFUL;
+    CRC->INIT = 0xFFFFFFFFUL;
+    CRC->POL = 0x04C11DB7UL;
+    crcValue = CRC->DR;
+
+    Sim_TrapPage(CRC_BASE);
+    Sim_TrapPage(EXTI_BASE);
+}
+
+/*******************************************************************************
+* Periph_Sync() - Pick up firmware register writes. Called on every yield and
+*                 after every handler.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Periph_Sync(void) {
+    now = Sim_Now();
+
+    Rcc_Sync();
+    Gpio_Sync();
+    Dma_Sync();
+    SysTick_Sync();
+    Cycle_Sync();
+
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        Timer_Sync(&timers[i]);
+    }
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        Usart_Sync(&usarts[i]);
+    }
+    for (size_t i = 0; i < ADC_COUNT; i++) {
+        Adc_Sync(&adcs[i]);
+    }
+}
+
+/*******************************************************************************
+* Periph_NextEvent() - Time of the next peripheral event.
+* No inputs.
+* Returns the time, SIM_NEVER if nothing is scheduled.
+*******************************************************************************/
+SimTime Periph_NextEvent(void) {
+    SimTime next = sysTickZero;
+
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        SimTime t = Timer_NextEvent(&timers[i]);
+
+        if (t < next) {
+            next = t;
+        }
+    }
+
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        if (usarts[i].txDone < next) {
+            next = usarts[i].txDone;
+        }
+        if (usarts[i].rxDone < next) {
+            next = usarts[i].rxDone;
+        }
+        if (usarts[i].idleAt < next) {
+            next = usarts[i].idleAt;
+        }
+    }
+
+    return next;
+}
+
+/*******************************************************************************
+* Periph_Advance() - Bring every model up to time t.
+* t         - New virtual time.
+* No return value.
+*******************************************************************************/
+void Periph_Advance(SimTime t) {
+    now = t;
+
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        Timer_Advance(&timers[i], t);
+    }
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        Usart_Advance(&usarts[i], t);
+    }
+    SysTick_Advance(t);
+
+    if (cycleRunning) {
+        cycleVal = (uint32_t)(t - cycleBase);
+        DWT->CYCCNT = cycleVal;
+    }
+}
+
+/*******************************************************************************
+* Periph_IrqLevel() - Level of a peripheral interrupt request line.
+* irq       - IRQ number.
+* Returns 1 if the line is asserted.
+*******************************************************************************/
+uint8_t Periph_IrqLevel(IRQn_Type irq) {
+    uint8_t level = 0;
+
+    switch (irq) {
+        case EXTI0_IRQn:        return Exti_IrqLevel(0, 0);
+        case EXTI1_IRQn:        return Exti_IrqLevel(1, 1);
+        case EXTI2_TSC_IRQn:    return Exti_IrqLevel(2, 2);
+        case EXTI3_IRQn:        return Exti_IrqLevel(3, 3);
+        case EXTI4_IRQn:        return Exti_IrqLevel(4, 4);
+        case EXTI9_5_IRQn:      return Exti_IrqLevel(5, 9);
+        case EXTI15_10_IRQn:    return Exti_IrqLevel(10, 15);
+        case ADC1_2_IRQn:       return ((ADC1->ISR & ADC1->IER) | (ADC2->ISR & ADC2->IER)) != 0;
+        default:                break;
+    }
+
+    if (((irq >= DMA1_Channel1_IRQn) && (irq <= DMA1_Channel7_IRQn))
+        || ((irq >= DMA2_Channel1_IRQn) && (irq <= DMA2_Channel5_IRQn))) {
+        uint8_t ch = (irq >= DMA2_Channel1_IRQn) ? DMA2_CH(irq - DMA2_Channel1_IRQn + 1) : (irq - DMA1_Channel1_IRQn + 1);
+        DMA_Channel_TypeDef *regs = Dma_Channel(ch);
+
+        return ((Dma_Controller(ch)->ISR >> (Dma_Index(ch) * 4)) & regs->CCR
+                & (DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE)) != 0;
+    }
+
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        if (usarts[i].irq == irq) {
+            level |= Usart_IrqLevel(&usarts[i]);
+        }
+    }
+
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        const SimTimer *tim = &timers[i];
+        uint32_t active = tim->regs->SR & tim->regs->DIER;
+
+        if ((tim->upIrq == irq) && (active & TIM_SR_UIF)) {
+            level = 1;
+        }
+        if ((tim->ccIrq == irq) && (active & (TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF))) {
+            level = 1;
+        }
+        if ((tim->trgIrq == irq) && (active & (TIM_SR_TIF | TIM_SR_COMIF))) {
+            level = 1;
+        }
+        if ((tim->brkIrq == irq) && (active & TIM_SR_BIF)) {
+            level = 1;
+        }
+    }
+
+    return level;
+}
+
+/*******************************************************************************
+* Periph_IrqReturn() - A handler returned. Clears the flags that hardware
+*                      clears when the handler reads a data register.
+* irq       - IRQ number of the handler.
+* No return value.
+*******************************************************************************/
+void Periph_IrqReturn(IRQn_Type irq) {
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        TIM_TypeDef *regs = timers[i].regs;
+
+        if (timers[i].ccIrq != irq) {
+            continue;
+        }
+        for (uint8_t ch = 0; ch < TIM_CHANNELS; ch++) {
+            if (Timer_CCS(regs, ch) != 0) {
+                regs->SR &= ~(TIM_SR_CC1IF << ch);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        USART_TypeDef *regs = usarts[i].regs;
+
+        if ((usarts[i].irq == irq) && (regs->CR1 & USART_CR1_RXNEIE)) {
+            regs->ISR &= ~USART_ISR_RXNE;
+        }
+    }
+}
+
+/*******************************************************************************
+* Periph_TrapPrepare() - A firmware write to a trapped page is about to run.
+* addr      - Register address (word aligned).
+* No return value.
+*******************************************************************************/
+void Periph_TrapPrepare(uintptr_t addr) {
+    // Tells a byte or half word write from a word write and catches rewrites of the same value
+    if (addr == (uintptr_t)&CRC->DR) {
+        CRC->DR = CRC_SENTINEL;
+    }
+}
+
+/*******************************************************************************
+* Periph_TrapWrite() - A firmware write to a trapped page has run.
+* addr      - Register address (word aligned).
+* before    - Register value before the write.
+* No return value.
+*******************************************************************************/
+void Periph_TrapWrite(uintptr_t addr, uint32_t before) {
+    if (addr == (uintptr_t)&CRC->DR) {
+        uint32_t value = CRC->DR;
+
+        if ((value >> 8) == (CRC_SENTINEL >> 8)) {
+            Crc_Feed(value & 0xFF, 8);
+        }
+        else if ((value >> 16) == (CRC_SENTINEL >> 16)) {
+            Crc_Feed(value & 0xFFFF, 16);
+        }
+        else {
+            Crc_Feed(value, 32);
+        }
+        CRC->DR = crcValue;
+    }
+    else if (addr == (uintptr_t)&CRC->CR) {
+        if (CRC->CR & CRC_CR_RESET) {
+            crcValue = CRC->INIT;
+            CRC->DR = crcValue;
+            CRC->CR &= ~CRC_CR_RESET;
+        }
+    }
+    else if (addr == (uintptr_t)&EXTI->PR) {
+        EXTI->PR = before & ~EXTI->PR;
+    }
+    else if (addr == (uintptr_t)&EXTI->SWIER) {
+        EXTI->PR |= EXTI->SWIER & EXTI->IMR;
+        EXTI->SWIER = 0;
+    }
+}
+
+/*******************************************************************************
+* Periph_TimerInput() - Drive a timer input (TIx) from the world.
+* regs      - Timer registers.
+* input     - Input number (1..4).
+* level     - New input level.
+* No return value.
+*******************************************************************************/
+void Periph_TimerInput(TIM_TypeDef *regs, uint8_t input, uint8_t level) {
+    static const uint8_t pairs[TIM_CHANNELS] = {2, 1, 4, 3};
+    SimTimer *tim = Timer_Find(regs);
+    uint8_t bit = 1 << (input - 1);
+    uint8_t rising = level != 0;
+    uint32_t sms = (regs->SMCR & TIM_SMCR_SMS) >> TIM_SMCR_SMS_Pos;
+    uint32_t ts = (regs->SMCR & TIM_SMCR_TS) >> TIM_SMCR_TS_Pos;
+    uint8_t trigger = 0;
+
+    if ((tim == NULL) || (((tim->inputs & bit) != 0) == rising)) {
+        return;
+    }
+    tim->inputs ^= bit;
+    Timer_Advance(tim, now);
+
+    // Input captures mapped to this input
+    for (uint8_t ch = 0; ch < TIM_CHANNELS; ch++) {
+        uint8_t ccs = Timer_CCS(regs, ch);
+        uint8_t source = (ccs == 1) ? ch + 1 : (ccs == 2) ? pairs[ch] : 0;
+
+        if ((source != input) || !(regs->CCER & (TIM_CCER_CC1E << (ch * 4))) || !Timer_EdgeMatches(regs, ch, rising)) {
+            continue;
+        }
+
+        *Timer_CCR(regs, ch) = tim->cnt;
+        if (regs->SR & (TIM_SR_CC1IF << ch)) {
+            regs->SR |= TIM_SR_CC1OF << ch;
+        }
+        regs->SR |= TIM_SR_CC1IF << ch;
+    }
+
+    // Slave mode trigger (TI1F_ED, TI1FP1 or TI2FP2)
+    if ((ts == 4) && (input == 1)) {
+        trigger = 1;
+    }
+    else if (((ts == 5) && (input == 1)) || ((ts == 6) && (input == 2))) {
+        trigger = Timer_EdgeMatches(regs, input - 1, rising);
+    }
+
+    if (trigger && (sms != 0)) {
+        regs->SR |= TIM_SR_TIF;
+
+        // Reset mode
+        if (sms == 4) {
+            tim->cnt = 0;
+            tim->last = now;
+            regs->CNT = 0;
+            if (!(regs->CR1 & TIM_CR1_URS)) {
+                regs->SR |= TIM_SR_UIF;
+            }
+        }
+        // Trigger mode
+        else if ((sms == 6) && !tim->running) {
+            regs->CR1 |= TIM_CR1_CEN;
+            Timer_Start(tim);
+        }
+    }
+}
+
+/*******************************************************************************
+* Periph_GpioInput() - Drive an input pin from the world. Edges go to the EXTI
+*                      line of the pin if it is mapped to this port.
+* regs      - GPIO port registers.
+* pin       - Pin number.
+* level     - New pin level.
+* No return value.
+*******************************************************************************/
+void Periph_GpioInput(GPIO_TypeDef *regs, uint8_t pin, uint8_t level) {
+    uint8_t port = ((uintptr_t)regs - GPIOA_BASE) / 0x400UL;
+    uint16_t bit = 1 << pin;
+    uint8_t old = (gpios[port].levels & bit) != 0;
+    uint8_t rising = level != 0;
+
+    gpios[port].driven |= bit;
+    if (rising) {
+        gpios[port].levels |= bit;
+    }
+    else {
+        gpios[port].levels &= ~bit;
+    }
+    Gpio_Sync();
+
+    if (old == rising) {
+        return;
+    }
+
+    if (((SYSCFG->EXTICR[pin / 4] >> ((pin % 4) * 4)) & 0xF) == port) {
+        uint32_t edges = rising ? EXTI->RTSR : EXTI->FTSR;
+
+        if (edges & bit) {
+            Sim_Poke(&EXTI->PR, EXTI->PR | bit);
+        }
+    }
+}
+
+/*******************************************************************************
+* Periph_UsartReceive() - Queue bytes from the host on a USART's receive line.
+* regs      - USART registers.
+* data      - Bytes to send.
+* len       - Length of data.
+* No return value.
+*******************************************************************************/
+void Periph_UsartReceive(USART_TypeDef *regs, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < USART_COUNT; i++) {
+        SimUsart *usart = &usarts[i];
+
+        if (usart->regs != regs) {
+            continue;
+        }
+
+        for (size_t j = 0; j < len; j++) {
+            uint16_t next = (usart->rxHead + 1) % USART_RX_SIZE;
+
+            if (next == usart->rxTail) {
+                Sim_Printf("sim: receive line overflow, host bytes dropped\n");
+                break;
+            }
+            usart->rx[usart->rxHead] = data[j];
+            usart->rxHead = next;
+        }
+        Usart_StartRx(usart);
+    }
+}
@@ -0,0 +1,671 @@
+/*******************************************************************************
+* Name: scenario.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Scripted runs of the whole firmware. A scenario schedules host
+*              commands, samples the world and the firmware every
+*              SCENARIO_SAMPLE_MS of virtual time and checks the results
+*              when the run ends, which then exits with 1 if a check failed.
+*
+* Scenarios (-s NAME):
+*   step        Left wheel step response to 10, -20 and 40 cm/s with the
+*               profile opened up to a step: 90% rise time, overshoot and
+*               2% settling time, and the cycles per PID_Update() on the
+*               same setpoints and measurements
+*   profile     Left wheel from 0 to 20 and from 20 to -20 cm/s as a step,
+*               a trapezoid and an S-curve: overshoot, time to settle within
+*               0.4 cm/s and the peak duty cycle
+*   crawl       Left wheel speed estimate against the true speed from 0.5 to
+*               20 cm/s, then the estimate's decay when the wheel jams: never
+*               above one vane over the time since the last edge, and 0 by
+*               the stall timeout
+*   approach    Straight at an obstacle 80 cm ahead of the sensor at 10, 20,
+*               30 and 40 cm/s, carried back to the start after each: the
+*               robot must stop about the collision margin short of it
+*   power       Spinning in place on a sagged battery, a jammed left wheel and
+*               a shorted current sense: the duty scale against the battery
+*               voltage, the jammed wheel cut off within the stall window
+*               and both wheels cut off on the over-current
+*******************************************************************************/
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "../src/Collision.h"
+#include "../src/DCMotor.h"
+#include "../src/Encoder.h"
+#include "../src/PID.h"
+#include "../src/Power.h"
+#include "../src/Profile.h"
+
+#define SCENARIO_SAMPLE_MS      1
+#define SCENARIO_SETUP          2.4             // s, the firmware has started by then
+#define SCENARIO_START          2.5             // s, first host command
+
+#define SCENARIO_STEP_ACCEL     Q16(30000.0)    // cm/s^2, reaches any speed in one control step
+#define SCENARIO_STEP_RUN       1.5             // s at each speed, then stopped until the next
+#define SCENARIO_STEP_RISE      0.150           // s, longest 90% rise time
+#define SCENARIO_STEP_OVERSHOOT 0.20            // Largest overshoot, of the step
+#define SCENARIO_STEP_SETTLE    1.0             // s, longest time to stay within 2%
+#define SCENARIO_PID_TAU        Q16(0.02)       // As the wheel controllers (see PID.c)
+#define SCENARIO_PID_KT         Q16(10.0)
+#define SCENARIO_PID_MAX_CYCLES 300             // Longest PID_Update()
+
+#define SCENARIO_PROFILE_SPEED  20.0            // cm/s
+#define SCENARIO_PROFILE_RUN    1.5             // s at each speed
+#define SCENARIO_PROFILE_GAP    4.0             // s between the starts of the profiles
+#define SCENARIO_PROFILE_BAND   0.4             // cm/s either side of the speed
+#define SCENARIO_PROFILE_SETTLE 0.7             // s, longest time to settle with a profile
+
+#define SCENARIO_CRAWL_RUN      6.0             // s at each speed
+#define SCENARIO_CRAWL_FROM     3.5             // s into each speed, the error is measured from
+#define SCENARIO_CRAWL_TO       5.5
+#define SCENARIO_CRAWL_STALL    5.0             // cm/s, speed the wheel jams at
+#define SCENARIO_CRAWL_JAM      1.0             // s into the stall run, the wheel jams
+#define SCENARIO_CRAWL_LATENCY  0.010           // s, a control step plus a sample
+
+#define SCENARIO_HOME_X         200.0           // cm, where the robot starts
+#define SCENARIO_HOME_Y         150.0
+#define SCENARIO_OBSTACLE_X     298.0           // cm, 80 cm from the sensor
+#define SCENARIO_OBSTACLE_R     10.0
+#define SCENARIO_APPROACH_RUN   10.0            // s from one approach to the next
+#define SCENARIO_APPROACH_DRIVE 9.0             // s driving, long enough to stop at 10 cm/s
+#define SCENARIO_APPROACH_SHORT 2.0             // cm, closest inside the margin
+#define SCENARIO_APPROACH_LONG  3.0             // cm, furthest outside the margin
+
+#define SCENARIO_POWER_SPIN     1.5             // rad/s, spinning keeps the robot clear of the walls
+#define SCENARIO_POWER_BATTERY  6000.0          // mV open circuit, sags further under load
+#define SCENARIO_POWER_FROM     1.0             // s after the start, the scale is measured from
+#define SCENARIO_POWER_TO       2.0
+#define SCENARIO_POWER_SCALE    0.02            // Largest error of the scale, of the right scale
+#define SCENARIO_POWER_JAM      3.0             // s after the start, the left wheel jams
+#define SCENARIO_POWER_FREE     4.5             // s after the start, stopped and freed
+#define SCENARIO_POWER_SHORT    6.0             // s after the start, the current sense reads a short
+#define SCENARIO_POWER_SHORT_MA 6000.0
+#define SCENARIO_POWER_END      7.0             // s after the start, stopped and the short cleared
+#define SCENARIO_POWER_LATENCY  0.040           // s, two 16ms readings and a control step
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    const char *name;
+    double seconds;                             // Length of the run
+    void (*start)(void);                        // Schedule the host commands
+    void (*sample)(double t);                   // Every SCENARIO_SAMPLE_MS, t in s
+    void (*finish)(void);                       // Check the results
+} Scenario;
+
+// A time at one commanded speed, measured on the left wheel
+typedef struct {
+    double start;                               // s
+    double length;                              // s
+    double speed;                               // cm/s, negative is backwards
+    double band;                                // cm/s either side of the speed that counts as settled
+    double rise;                                // s to 90%, 0 until reached
+    double peak;                                // cm/s, furthest in the direction of the speed
+    double settle;                              // s to the last time outside the band
+    uint16_t duty;                              // Highest % duty requested
+} ScenarioSegment;
+
+typedef struct {
+    const char *name;
+    q16_t accel;                                // Profile_SetLimits()
+    q16_t jerk;
+} ScenarioProfile;
+
+typedef struct {
+    double speed;                               // cm/s, negative is backwards
+    double limit;                               // cm/s, largest rms error
+    double sumSquares;                          // Of the error, cm^2/s^2
+    unsigned long samples;
+} ScenarioCrawl;
+
+typedef struct {
+    double speed;                               // cm/s
+    double closest;                             // cm, sensor to obstacle, 0 until measured
+    double stop;                                // cm, where it came to rest
+} ScenarioApproach;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static const Scenario *scenario = NULL;
+static SimTime nextSample = SIM_NEVER;
+static uint8_t setUp = 0;                       // Firmware settings changed for the scenario
+static unsigned long checks = 0;
+static unsigned long failures = 0;
+
+static ScenarioSegment steps[] = {
+    {SCENARIO_START, SCENARIO_STEP_RUN, 10.0, 0.2, 0, 0, 0, 0},
+    {5.0, SCENARIO_STEP_RUN, -20.0, 0.4, 0, 0, 0, 0},
+    {7.5, SCENARIO_STEP_RUN, 40.0, 0.8, 0, 0, 0, 0},
+};
+
+// Runs PID_Update() on the same inputs as the left wheel controller, under
+// the cycle model
+static PIDGains pidGains[2];
+static PIDController pid = {pidGains, 2, SCENARIO_PID_TAU, SCENARIO_PID_KT, Q16_FROM_INT(MIN_DUTY_CYCLE),
+                            Q16_FROM_INT(MAX_DUTY_CYCLE), NULL, 0, 0, 0, 0, 0};
+static double pidNext = 0.0;
+static unsigned long pidUpdates = 0;
+static unsigned long pidTotal = 0;
+static uint32_t pidMax = 0;
+
+// The step first, as the wheels were driven before there were profiles
+static const ScenarioProfile profiles[] = {
+    {"step", SCENARIO_STEP_ACCEL, 0},
+    {"trapezoid", PROFILE_ACCEL, 0},
+    {"S-curve", PROFILE_ACCEL, PROFILE_JERK},
+};
+#define SCENARIO_PROFILES       (sizeof(profiles) / sizeof(profiles[0]))
+
+static ScenarioSegment profileSegments[SCENARIO_PROFILES][2];  // Speeding up, then reversing
+static uint8_t profileNext = 0;                 // Next profile to set the limits for
+
+// Alternating directions so the robot stays clear of the walls
+static ScenarioCrawl crawls[] = {
+    {0.5, 0.15, 0, 0},
+    {-1.0, 0.10, 0, 0},
+    {2.0, 0.07, 0, 0},
+    {5.0, 0.04, 0, 0},
+    {-20.0, 0.03, 0, 0},
+};
+#define SCENARIO_CRAWLS         (sizeof(crawls) / sizeof(crawls[0]))
+
+static double stallStart = 0.0;                 // s, the stall run
+static double stallEdge = 0.0;                  // s, last left wheel edge
+static unsigned long stallEdges = 0;
+static double stallZero = 0.0;                  // s, estimate reached 0 after the jam, 0 until then
+static double stallOver = 0.0;                  // cm/s, furthest above the one vane bound
+
+static ScenarioApproach approaches[] = {
+    {10.0, 0, 0},
+    {20.0, 0, 0},
+    {30.0, 0, 0},
+    {40.0, 0, 0},
+};
+#define SCENARIO_APPROACHES     (sizeof(approaches) / sizeof(approaches[0]))
+static uint8_t approachNext = 0;                // Next approach to carry the robot back for
+
+static double powerScaleError = 0.0;            // Largest, of the right scale
+static double powerScale = 0.0;                 // Last measured, and what it should be
+static double powerExpected = 0.0;
+static unsigned long powerSamples = 0;
+static double powerStall = 0.0;                 // s, left wheel cut off for the stall, 0 until then
+static uint8_t powerStallRight = 0;             // Right wheel cut off during the jam
+static double powerTrip[2] = {0.0, 0.0};        // s, wheels cut off for the over-current, 0 until then
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Scenario_Check() - Count a check and report it if it failed.
+*******************************************************************************/
+static __attribute__((format(printf, 2, 3))) uint8_t Scenario_Check(int ok, const char *fmt, ...) {
+    va_list args;
+
+    checks++;
+    if (ok) {
+        return 1;
+    }
+
+    failures++;
+    printf("[Scenario] %s: FAIL ", scenario->name);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    return 0;
+}
+
+/*******************************************************************************
+* Scenario_Command() - Schedule a host command at t seconds.
+*******************************************************************************/
+static __attribute__((format(printf, 2, 3))) void Scenario_Command(double t, const char *fmt, ...) {
+    char command[64];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(command, sizeof(command), fmt, args);
+    va_end(args);
+    Host_Schedule((SimTime)(t * SIM_CLOCK_HZ), command);
+}
+
+/*******************************************************************************
+* Scenario_Follow() - Measure the left wheel during a segment.
+*******************************************************************************/
+static void Scenario_Follow(ScenarioSegment *segment, double t) {
+    double target = fabs(segment->speed);
+    double magnitude = World_WheelSpeed(LEFT) * ((segment->speed < 0) ? -1 : 1);
+    uint16_t duty = DCMotor_GetPWM(DCMOTOR_LEFT);
+
+    if ((t < segment->start) || (t >= segment->start + segment->length)) {
+        return;
+    }
+
+    if ((segment->rise <= 0) && (magnitude >= 0.9 * target)) {
+        segment->rise = t - segment->start;
+    }
+    if ((segment->peak == 0) || (magnitude > segment->peak)) {
+        segment->peak = magnitude;
+    }
+    if (fabs(magnitude - target) > segment->band) {
+        segment->settle = t - segment->start;
+    }
+    segment->duty = (duty > segment->duty) ? duty : segment->duty;
+}
+
+/*******************************************************************************
+* Scenario_PidUpdate() - One update of the shadow controller on the left
+*                        wheel's current inputs.
+*******************************************************************************/
+static void Scenario_PidUpdate(void) {
+    PID_Update(&pid, Profile_GetSpeed(LEFT), Profile_GetSpeedRate(LEFT), G_EncoderSpeedQ16[LEFT],
+               1000000UL / PID_RATE_HZ);
+}
+
+/*******************************************************************************
+* Scenario_StepStart() - Drive straight at each speed in turn, stopping in
+*                        between.
+*******************************************************************************/
+static void Scenario_StepStart(void) {
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        Scenario_Command(steps[i].start, "move %.1f 0", steps[i].speed);
+        Scenario_Command(steps[i].start + SCENARIO_STEP_RUN, "move 0 0");
+    }
+}
+
+/*******************************************************************************
+* Scenario_StepSample() - Open the profile up once the firmware has started,
+*                         follow the left wheel through each step and time
+*                         the shadow controller every control period.
+*******************************************************************************/
+static void Scenario_StepSample(double t) {
+    uint32_t cycles;
+
+    if (!setUp && (t >= SCENARIO_SETUP)) {
+        setUp = 1;
+        Profile_SetLimits(SCENARIO_STEP_ACCEL, 0);
+        pidGains[0] = *PID_GetGains(LEFT, 0);
+        pidGains[1] = *PID_GetGains(LEFT, Q16(1000.0));
+    }
+
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        Scenario_Follow(&steps[i], t);
+    }
+
+    if ((t >= steps[0].start) && (t >= pidNext) && (Profile_GetDir(LEFT) != DCMOTOR_STOP)) {
+        pidNext = t + 1.0 / PID_RATE_HZ;
+        cycles = Sim_Cycles(Scenario_PidUpdate);
+        pidTotal += cycles;
+        pidMax = (cycles > pidMax) ? cycles : pidMax;
+        pidUpdates++;
+    }
+}
+
+/*******************************************************************************
+* Scenario_StepFinish() - Report and check each step and the controller's
+*                         cycles.
+*******************************************************************************/
+static void Scenario_StepFinish(void) {
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        const ScenarioSegment *step = &steps[i];
+        double overshoot = (step->peak - fabs(step->speed)) / fabs(step->speed);
+
+        printf("[Scenario] step %5.1fcm/s: 90%% rise %3.0fms, overshoot %4.1f%%, 2%% settle %4.0fms\n",
+               step->speed, step->rise * 1000, fmax(overshoot, 0) * 100, step->settle * 1000);
+        Scenario_Check((step->rise > 0) && (step->rise <= SCENARIO_STEP_RISE), "%.1fcm/s: rise %.0fms",
+                       step->speed, step->rise * 1000);
+        Scenario_Check(overshoot <= SCENARIO_STEP_OVERSHOOT, "%.1fcm/s: overshoot %.1f%%",
+                       step->speed, overshoot * 100);
+        Scenario_Check(step->settle <= SCENARIO_STEP_SETTLE, "%.1fcm/s: settled after %.0fms",
+                       step->speed, step->settle * 1000);
+    }
+
+    printf("[Scenario] step: PID_Update() %.1f cycles (max %u) over %lu updates\n",
+           pidUpdates ? (double)pidTotal / pidUpdates : 0.0, pidMax, pidUpdates);
+    Scenario_Check((pidUpdates != 0) && (pidMax <= SCENARIO_PID_MAX_CYCLES), "PID_Update() took up to %u cycles",
+                   pidMax);
+}
+
+/*******************************************************************************
+* Scenario_ProfileStart() - Speed up, reverse and stop with each profile.
+*******************************************************************************/
+static void Scenario_ProfileStart(void) {
+    for (size_t i = 0; i < SCENARIO_PROFILES; i++) {
+        double start = SCENARIO_START + i * SCENARIO_PROFILE_GAP;
+
+        for (uint8_t j = 0; j < 2; j++) {
+            ScenarioSegment *segment = &profileSegments[i][j];
+
+            segment->start = start + j * SCENARIO_PROFILE_RUN;
+            segment->length = SCENARIO_PROFILE_RUN;
+            segment->speed = (j == 0) ? SCENARIO_PROFILE_SPEED : -SCENARIO_PROFILE_SPEED;
+            segment->band = SCENARIO_PROFILE_BAND;
+            Scenario_Command(segment->start, "move %.1f 0", segment->speed);
+        }
+        Scenario_Command(start + 2 * SCENARIO_PROFILE_RUN, "move 0 0");
+    }
+}
+
+/*******************************************************************************
+* Scenario_ProfileSample() - Set each profile's limits while the robot is
+*                            stopped before it, and follow the left wheel.
+*******************************************************************************/
+static void Scenario_ProfileSample(double t) {
+    if ((profileNext < SCENARIO_PROFILES)
+        && (t >= profileSegments[profileNext][0].start - (SCENARIO_PROFILE_GAP - 2 * SCENARIO_PROFILE_RUN) / 2)) {
+        Profile_SetLimits(profiles[profileNext].accel, profiles[profileNext].jerk);
+        profileNext++;
+    }
+
+    for (size_t i = 0; i < SCENARIO_PROFILES; i++) {
+        Scenario_Follow(&profileSegments[i][0], t);
+        Scenario_Follow(&profileSegments[i][1], t);
+    }
+}
+
+/*******************************************************************************
+* Scenario_ProfileFinish() - Report each profile and check the profiles
+*                            overshoot less, settle and ask for less duty than
+*                            the step.
+*******************************************************************************/
+static void Scenario_ProfileFinish(void) {
+    for (size_t i = 0; i < SCENARIO_PROFILES; i++) {
+        const ScenarioProfile *profile = &profiles[i];
+
+        for (uint8_t j = 0; j < 2; j++) {
+            const ScenarioSegment *segment = &profileSegments[i][j];
+            const ScenarioSegment *step = &profileSegments[0][j];
+            double overshoot = fmax(segment->peak - fabs(segment->speed), 0);
+
+            printf("[Scenario] profile %-9s %3.0f->%3.0fcm/s: overshoot %.1fcm/s, within %.1fcm/s after %3.0fms, peak duty %u%%\n",
+                   profile->name, (j == 0) ? 0.0 : -segment->speed, segment->speed, overshoot, segment->band,
+                   segment->settle * 1000, segment->duty);
+            if (i == 0) {
+                continue;
+            }
+
+            Scenario_Check(overshoot < fmax(step->peak - fabs(step->speed), 0) / 2,
+                           "%s %.0fcm/s: overshoot %.1fcm/s, not under half the step's", profile->name,
+                           segment->speed, overshoot);
+            Scenario_Check(segment->duty < step->duty, "%s %.0fcm/s: peak duty %u%%, the step's %u%%",
+                           profile->name, segment->speed, segment->duty, step->duty);
+            Scenario_Check(segment->settle <= SCENARIO_PROFILE_SETTLE, "%s %.0fcm/s: settled after %.0fms",
+                           profile->name, segment->speed, segment->settle * 1000);
+        }
+    }
+}
+
+/*******************************************************************************
+* Scenario_CrawlStart() - Crawl at each speed, then jam the left wheel.
+*******************************************************************************/
+static void Scenario_CrawlStart(void) {
+    for (size_t i = 0; i < SCENARIO_CRAWLS; i++) {
+        Scenario_Command(SCENARIO_START + i * SCENARIO_CRAWL_RUN, "move %.1f 0", crawls[i].speed);
+    }
+
+    stallStart = SCENARIO_START + SCENARIO_CRAWLS * SCENARIO_CRAWL_RUN;
+    Scenario_Command(stallStart, "move %.1f 0", SCENARIO_CRAWL_STALL);
+    Scenario_Command(stallStart + SCENARIO_CRAWL_JAM, "jam left");
+    Scenario_Command(stallStart + 2 * SCENARIO_CRAWL_JAM, "move 0 0");
+    Scenario_Command(stallStart + 2 * SCENARIO_CRAWL_JAM, "jam off");
+}
+
+/*******************************************************************************
+* Scenario_CrawlSample() - Add up the estimate's error while crawling, then
+*                          follow its decay after the jam.
+*******************************************************************************/
+static void Scenario_CrawlSample(double t) {
+    double estimate = G_EncoderSpeedQ16[LEFT] / 65536.0;
+    double jam = stallStart + SCENARIO_CRAWL_JAM;
+
+    for (size_t i = 0; i < SCENARIO_CRAWLS; i++) {
+        double start = SCENARIO_START + i * SCENARIO_CRAWL_RUN;
+
+        if ((t >= start + SCENARIO_CRAWL_FROM) && (t < start + SCENARIO_CRAWL_TO)) {
+            double error = estimate - fabs(World_WheelSpeed(LEFT));
+
+            crawls[i].sumSquares += error * error;
+            crawls[i].samples++;
+        }
+    }
+
+    if (World_WheelEdges(LEFT) != stallEdges) {
+        stallEdges = World_WheelEdges(LEFT);
+        stallEdge = t;
+    }
+
+    // The estimate is as old as the last control step, so the bound is too
+    if ((t >= jam) && (t < stallStart + 2 * SCENARIO_CRAWL_JAM)) {
+        double span = t - stallEdge - SCENARIO_CRAWL_LATENCY;
+
+        if (span > 0) {
+            stallOver = fmax(stallOver, estimate - UM_PER_VANE / 1e4 / span);
+        }
+        if ((stallZero == 0) && (estimate == 0)) {
+            stallZero = t;
+        }
+    }
+}
+
+/*******************************************************************************
+* Scenario_CrawlFinish() - Report and check the error at each speed and the
+*                          decay.
+*******************************************************************************/
+static void Scenario_CrawlFinish(void) {
+    double zeroed = stallZero - stallEdge;
+
+    for (size_t i = 0; i < SCENARIO_CRAWLS; i++) {
+        double rms = crawls[i].samples ? sqrt(crawls[i].sumSquares / crawls[i].samples) : INFINITY;
+
+        printf("[Scenario] crawl %5.1fcm/s: rms error %.3fcm/s\n", crawls[i].speed, rms);
+        Scenario_Check(rms <= crawls[i].limit, "%.1fcm/s: rms error %.3fcm/s", crawls[i].speed, rms);
+    }
+
+    printf("[Scenario] crawl stall at %.1fcm/s: at most %.3fcm/s over one vane per time since the edge, 0 after %.0fms\n",
+           SCENARIO_CRAWL_STALL, stallOver, zeroed * 1000);
+    Scenario_Check(stallOver <= 0, "stall: estimate %.3fcm/s over one vane per time since the edge", stallOver);
+    Scenario_Check((stallZero != 0) && (zeroed <= ENCODER_STALL_US / 1e6 + SCENARIO_CRAWL_LATENCY),
+                   "stall: estimate reached 0 %.0fms after the last edge", zeroed * 1000);
+}
+
+/*******************************************************************************
+* Scenario_ApproachStart() - Put the obstacle ahead and drive at it at each
+*                            speed.
+*******************************************************************************/
+static void Scenario_ApproachStart(void) {
+    World_AddObstacle(SCENARIO_OBSTACLE_X, SCENARIO_HOME_Y, SCENARIO_OBSTACLE_R);
+
+    for (size_t i = 0; i < SCENARIO_APPROACHES; i++) {
+        double start = SCENARIO_START + i * SCENARIO_APPROACH_RUN;
+
+        Scenario_Command(start, "move %.1f 0", approaches[i].speed);
+        Scenario_Command(start + SCENARIO_APPROACH_DRIVE, "move 0 0");
+    }
+}
+
+/*******************************************************************************
+* Scenario_ApproachSample() - Carry the robot back to the start before each
+*                             approach and follow the gap to the obstacle.
+*******************************************************************************/
+static void Scenario_ApproachSample(double t) {
+    double gap = World_ObstacleGap();
+
+    if ((approachNext < SCENARIO_APPROACHES)
+        && (t >= SCENARIO_START + approachNext * SCENARIO_APPROACH_RUN - SCENARIO_SAMPLE_MS / 1000.0)) {
+        World_SetPose(SCENARIO_HOME_X, SCENARIO_HOME_Y, 0.0);
+        approachNext++;
+    }
+
+    for (size_t i = 0; i < SCENARIO_APPROACHES; i++) {
+        double start = SCENARIO_START + i * SCENARIO_APPROACH_RUN;
+
+        if ((t < start) || (t >= start + SCENARIO_APPROACH_DRIVE)) {
+            continue;
+        }
+        if ((approaches[i].closest == 0) || (gap < approaches[i].closest)) {
+            approaches[i].closest = gap;
+        }
+        approaches[i].stop = gap;
+    }
+}
+
+/*******************************************************************************
+* Scenario_ApproachFinish() - Report and check how far short of the obstacle
+*                             each approach stopped.
+*******************************************************************************/
+static void Scenario_ApproachFinish(void) {
+    double margin = COLLISION_MARGIN / 65536.0;
+
+    for (size_t i = 0; i < SCENARIO_APPROACHES; i++) {
+        const ScenarioApproach *approach = &approaches[i];
+
+        printf("[Scenario] approach %4.1fcm/s: stopped %.1fcm short (closest %.1fcm), margin %.0fcm\n",
+               approach->speed, approach->stop, approach->closest, margin);
+        Scenario_Check(approach->closest >= margin - SCENARIO_APPROACH_SHORT, "%.0fcm/s: came within %.1fcm",
+                       approach->speed, approach->closest);
+        Scenario_Check(approach->stop <= margin + SCENARIO_APPROACH_LONG, "%.0fcm/s: stopped %.1fcm short",
+                       approach->speed, approach->stop);
+    }
+}
+
+/*******************************************************************************
+* Scenario_PowerStart() - Spin on a sagged battery, jam the left wheel, then
+*                         short the current sense.
+*******************************************************************************/
+static void Scenario_PowerStart(void) {
+    Scenario_Command(SCENARIO_START, "battery %.0f", SCENARIO_POWER_BATTERY);
+    Scenario_Command(SCENARIO_START, "move 0 %.1f", SCENARIO_POWER_SPIN);
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_JAM, "jam left");
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_FREE, "move 0 0");
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_FREE, "jam off");
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_FREE + 0.5, "move 0 %.1f", SCENARIO_POWER_SPIN);
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_SHORT, "current %.0f", SCENARIO_POWER_SHORT_MA);
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_END, "move 0 0");
+    Scenario_Command(SCENARIO_START + SCENARIO_POWER_END, "current off");
+}
+
+/*******************************************************************************
+* Scenario_PowerSample() - Compare the duty scale with the battery voltage,
+*                          then note when each wheel is cut off.
+*******************************************************************************/
+static void Scenario_PowerSample(double t) {
+    double since = t - SCENARIO_START;
+
+    if ((since >= SCENARIO_POWER_FROM) && (since < SCENARIO_POWER_TO)) {
+        powerScale = G_Power.scale / 65536.0;
+        powerExpected = POWER_NOMINAL_MV / World_Battery();
+        powerScaleError = fmax(powerScaleError, fabs(powerScale - powerExpected) / powerExpected);
+        powerSamples++;
+    }
+
+    if ((since >= SCENARIO_POWER_JAM) && (since < SCENARIO_POWER_FREE)) {
+        if ((powerStall == 0) && (G_Power.cutoff[LEFT] == CUTOFF_STALL)) {
+            powerStall = since - SCENARIO_POWER_JAM;
+        }
+        powerStallRight |= (G_Power.cutoff[RIGHT] != CUTOFF_NONE);
+    }
+
+    if ((since >= SCENARIO_POWER_SHORT) && (since < SCENARIO_POWER_END)) {
+        for (uint8_t i = 0; i < 2; i++) {
+            if ((powerTrip[i] == 0) && (G_Power.cutoff[i] == CUTOFF_OVERCURRENT)) {
+                powerTrip[i] = since - SCENARIO_POWER_SHORT;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Scenario_PowerFinish() - Report and check the scale and the cutoffs.
+*******************************************************************************/
+static void Scenario_PowerFinish(void) {
+    // The estimate decays to 0 over the stall timeout, then the stall is timed
+    double window = ENCODER_STALL_US / 1e6 + POWER_STALL_MS / 1000.0 + SCENARIO_POWER_LATENCY;
+
+    printf("[Scenario] power battery %.0fmV open circuit: scale %.3f for %.0fmV, %.1f%% off at most\n",
+           SCENARIO_POWER_BATTERY, powerScale, POWER_NOMINAL_MV / powerExpected, powerScaleError * 100);
+    Scenario_Check((powerSamples != 0) && (powerScaleError <= SCENARIO_POWER_SCALE), "scale %.1f%% off",
+                   powerScaleError * 100);
+
+    printf("[Scenario] power jam: left wheel cut off after %.0fms, window %.0fms\n", powerStall * 1000,
+           window * 1000);
+    Scenario_Check((powerStall > 0) && (powerStall <= window), "jam: cut off after %.0fms", powerStall * 1000);
+    Scenario_Check(!powerStallRight, "jam: right wheel cut off too");
+
+    printf("[Scenario] power short: wheels cut off after %.0f and %.0fms\n", powerTrip[LEFT] * 1000,
+           powerTrip[RIGHT] * 1000);
+    for (uint8_t i = 0; i < 2; i++) {
+        Scenario_Check((powerTrip[i] > 0) && (powerTrip[i] <= SCENARIO_POWER_LATENCY),
+                       "short: %s wheel cut off after %.0fms", (i == LEFT) ? "left" : "right", powerTrip[i] * 1000);
+    }
+}
+
+static const Scenario scenarios[] = {
+    {"step", 10.0, Scenario_StepStart, Scenario_StepSample, Scenario_StepFinish},
+    {"profile", 13.0, Scenario_ProfileStart, Scenario_ProfileSample, Scenario_ProfileFinish},
+    {"crawl", 36.0, Scenario_CrawlStart, Scenario_CrawlSample, Scenario_CrawlFinish},
+    {"approach", 42.0, Scenario_ApproachStart, Scenario_ApproachSample, Scenario_ApproachFinish},
+    {"power", 10.5, Scenario_PowerStart, Scenario_PowerSample, Scenario_PowerFinish},
+};
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Scenario_Init() - Pick a scenario and schedule its host commands.
+* name      - Scenario name.
+* Returns the length of the run in s, 0 if there is no such scenario.
+*******************************************************************************/
+double Scenario_Init(const char *name) {
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (strcmp(name, scenarios[i].name) == 0) {
+            scenario = &scenarios[i];
+            nextSample = SIM_MS(SCENARIO_SAMPLE_MS);
+            scenario->start();
+            return scenario->seconds;
+        }
+    }
+
+    return 0.0;
+}
+
+/*******************************************************************************
+* Scenario_NextEvent() - Time of the next sample.
+* No inputs.
+* Returns the time, SIM_NEVER without a scenario.
+*******************************************************************************/
+SimTime Scenario_NextEvent(void) {
+    return nextSample;
+}
+
+/*******************************************************************************
+* Scenario_Advance() - Take the samples that are due by time t.
+* t         - New virtual time.
+* No return value.
+*******************************************************************************/
+void Scenario_Advance(SimTime t) {
+    while (nextSample <= t) {
+        scenario->sample((double)nextSample / SIM_CLOCK_HZ);
+        nextSample += SIM_MS(SCENARIO_SAMPLE_MS);
+    }
+}
+
+/*******************************************************************************
+* Scenario_Finish() - Check the results of the run.
+* No inputs.
+* Returns 0 if every check passed or there is no scenario, otherwise 1.
+*******************************************************************************/
+int Scenario_Finish(void) {
+    if (scenario == NULL) {
+        return 0;
+    }
+
+    scenario->finish();
+    printf("[Scenario] %s: %lu checks, %lu failed\n", scenario->name, checks, failures);
+    return (failures == 0) ? 0 : 1;
+}
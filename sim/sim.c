@@ -0,0 +1,645 @@
+/*******************************************************************************
+* Name: sim.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Simulator core. Maps the peripheral register blocks at their
+*              real addresses so the firmware's CMSIS register accesses work
+*              unchanged, keeps virtual time, and dispatches the firmware's
+*              interrupt handlers through a virtual NVIC.
+*
+* Registers are plain memory. Most writes are picked up when the models sync
+* (every yield and after every handler). Registers whose write has an effect
+* that can't be seen afterwards (CRC data register, EXTI write-1-to-clear) are
+* on read-only pages: the write faults, the page is opened for a single step
+* and the model sees the value before and after.
+*
+* Handlers picked with Sim_ModelCycles() are single stepped and each host
+* instruction advances DWT->CYCCNT by a Cortex-M4 estimate, one cycle or
+* SIM_CYCLES_DIVIDE for a divide, so the firmware's own cycle measurements
+* inside them read something. CYCCNT is put back when the handler returns,
+* the model doesn't move virtual time.
+*******************************************************************************/
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define SIM_IRQ_OFFSET      16                  // IRQn of the first core exception is -16
+#define SIM_IRQ_COUNT       (SIM_IRQ_OFFSET + 85)
+#define SIM_THREAD_PRIORITY 0x100               // Lower than any interrupt
+#define SIM_STORM_LIMIT     100000              // Handler runs at one instant before giving up
+#define SIM_PAGE_SIZE       0x1000UL
+#define SIM_MAX_TRAPS       4
+#define SIM_EFLAGS_TF       0x100               // x86 single step trap flag
+#define SIM_CYCLES_DIVIDE   12                  // UDIV/SDIV worst case on a Cortex-M4
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+// Register blocks mapped at their Cortex-M addresses
+static const struct {
+    uintptr_t base;
+    size_t size;
+} simRegions[] = {
+    {PERIPH_BASE,       0x30000},       // APB1, APB2, AHB1 (DMA, RCC, FLASH, CRC)
+    {AHB2PERIPH_BASE,   0x2000},        // GPIO
+    {AHB3PERIPH_BASE,   0x1000},        // ADC
+    {0xE0000000UL,      0x100000},      // Private peripheral bus (DWT, NVIC, SysTick, SCB)
+};
+
+// Interrupt handlers the firmware may define, unused ones stay NULL
+#define SIM_HANDLERS(X)                                     \
+    X(SysTick_IRQn, SysTick_Handler)                        \
+    X(PendSV_IRQn, PendSV_Handler)                          \
+    X(EXTI0_IRQn, EXTI0_IRQHandler)                         \
+    X(EXTI1_IRQn, EXTI1_IRQHandler)                         \
+    X(EXTI2_TSC_IRQn, EXTI2_TSC_IRQHandler)                 \
+    X(EXTI3_IRQn, EXTI3_IRQHandler)                         \
+    X(EXTI4_IRQn, EXTI4_IRQHandler)                         \
+    X(DMA1_Channel1_IRQn, DMA1_Channel1_IRQHandler)         \
+    X(DMA1_Channel2_IRQn, DMA1_Channel2_IRQHandler)         \
+    X(DMA1_Channel3_IRQn, DMA1_Channel3_IRQHandler)         \
+    X(DMA1_Channel4_IRQn, DMA1_Channel4_IRQHandler)         \
+    X(DMA1_Channel5_IRQn, DMA1_Channel5_IRQHandler)         \
+    X(DMA1_Channel6_IRQn, DMA1_Channel6_IRQHandler)         \
+    X(DMA1_Channel7_IRQn, DMA1_Channel7_IRQHandler)         \
+    X(ADC1_2_IRQn, ADC1_2_IRQHandler)                       \
+    X(EXTI9_5_IRQn, EXTI9_5_IRQHandler)                     \
+    X(TIM1_BRK_TIM15_IRQn, TIM1_BRK_TIM15_IRQHandler)       \
+    X(TIM1_UP_TIM16_IRQn, TIM1_UP_TIM16_IRQHandler)         \
+    X(TIM1_TRG_COM_TIM17_IRQn, TIM1_TRG_COM_TIM17_IRQHandler) \
+    X(TIM1_CC_IRQn, TIM1_CC_IRQHandler)                     \
+    X(TIM2_IRQn, TIM2_IRQHandler)                           \
+    X(TIM3_IRQn, TIM3_IRQHandler)                           \
+    X(TIM4_IRQn, TIM4_IRQHandler)                           \
+    X(USART1_IRQn, USART1_IRQHandler)                       \
+    X(USART2_IRQn, USART2_IRQHandler)                       \
+    X(USART3_IRQn, USART3_IRQHandler)                       \
+    X(EXTI15_10_IRQn, EXTI15_10_IRQHandler)                 \
+    X(TIM8_BRK_IRQn, TIM8_BRK_IRQHandler)                   \
+    X(TIM8_UP_IRQn, TIM8_UP_IRQHandler)                     \
+    X(TIM8_TRG_COM_IRQn, TIM8_TRG_COM_IRQHandler)           \
+    X(TIM8_CC_IRQn, TIM8_CC_IRQHandler)                     \
+    X(TIM6_DAC_IRQn, TIM6_DAC_IRQHandler)                   \
+    X(TIM7_IRQn, TIM7_IRQHandler)                           \
+    X(DMA2_Channel1_IRQn, DMA2_Channel1_IRQHandler)         \
+    X(DMA2_Channel2_IRQn, DMA2_Channel2_IRQHandler)         \
+    X(DMA2_Channel3_IRQn, DMA2_Channel3_IRQHandler)         \
+    X(DMA2_Channel4_IRQn, DMA2_Channel4_IRQHandler)         \
+    X(DMA2_Channel5_IRQn, DMA2_Channel5_IRQHandler)
+
+#define SIM_DECLARE_HANDLER(irq, handler)   extern void handler(void) __attribute__((weak));
+SIM_HANDLERS(SIM_DECLARE_HANDLER)
+
+typedef struct {
+    IRQn_Type irq;
+    void (*handler)(void);
+    const char *name;
+} SimHandler;
+
+#define SIM_HANDLER_ENTRY(irq, handler)     {irq, handler, #handler},
+static SimHandler simHandlers[] = {SIM_HANDLERS(SIM_HANDLER_ENTRY)};
+#define SIM_HANDLER_COUNT   (sizeof(simHandlers) / sizeof(simHandlers[0]))
+
+// Virtual NVIC, indexed by IRQn + SIM_IRQ_OFFSET
+static uint8_t irqEnabled[SIM_IRQ_COUNT];
+static uint8_t irqPending[SIM_IRQ_COUNT];       // Software or edge pended
+static uint8_t irqActive[SIM_IRQ_COUNT];
+static uint8_t irqPriority[SIM_IRQ_COUNT];
+static uint8_t irqModeled[SIM_IRQ_COUNT];       // Handler runs under the cycle model
+static unsigned long irqCount[SIM_IRQ_COUNT];
+static uint32_t primask = 0;
+static uint16_t activePriority = SIM_THREAD_PRIORITY;
+
+// Virtual time
+static SimTime now = 0;
+static SimTime endTime = SIM_NEVER;
+static SimTime stormTime = SIM_NEVER;
+static unsigned long stormCount = 0;
+static unsigned long steps = 0;
+static struct timespec wallStart;
+
+// Write traps
+static uintptr_t trapPages[SIM_MAX_TRAPS];
+static uint8_t trapCount = 0;
+static volatile uintptr_t trapPage = 0;         // Page opened for the current write, 0 if none
+static volatile uintptr_t trapAddr = 0;
+static volatile uint32_t trapBefore = 0;
+
+// Cycle model
+static volatile uint8_t modelRunning = 0;
+static volatile uint32_t modelCycles = 0;
+static volatile uintptr_t modelLast = 0;        // Address of the instruction just stepped
+static uint32_t modelOverhead = 0;              // Cycles of an empty function
+static uint8_t modelCalibrated = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Sim_IrqIndex() - Index of an IRQ in the virtual NVIC tables.
+* irq       - IRQ number (negative for core exceptions).
+* Returns the index, exits on an invalid IRQ.
+*******************************************************************************/
+static int Sim_IrqIndex(IRQn_Type irq) {
+    int index = (int)irq + SIM_IRQ_OFFSET;
+
+    if ((index < 0) || (index >= SIM_IRQ_COUNT)) {
+        Sim_Printf("sim: invalid IRQ %d\n", (int)irq);
+        Sim_Exit(1);
+    }
+    return index;
+}
+
+/*******************************************************************************
+* Sim_InstructionCycles() - Cortex-M4 cycles for a host instruction, a divide
+*                           or one cycle for anything else.
+* addr      - Instruction address.
+* Returns the cycles.
+*******************************************************************************/
+static uint32_t Sim_InstructionCycles(uintptr_t addr) {
+    const uint8_t *op = (const uint8_t *)addr;
+
+    // Operand size and REX prefixes
+    while ((*op == 0x66) || ((*op & 0xF0) == 0x40)) {
+        op++;
+    }
+
+    // DIV and IDIV are F6/F7 with ModRM reg 6 or 7
+    if (((op[0] == 0xF6) || (op[0] == 0xF7)) && (((op[1] >> 3) & 0x6) == 0x6)) {
+        return SIM_CYCLES_DIVIDE;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* Sim_Model() - Run a function single stepped under the cycle model.
+* fn        - Function to run.
+* Returns the modeled cycles.
+*******************************************************************************/
+static uint32_t Sim_Model(void (*fn)(void)) {
+    uint32_t cycles = DWT->CYCCNT;
+
+    modelCycles = 0;
+    modelLast = 0;
+    modelRunning = 1;
+    __asm__ volatile("pushfq; orq %0, (%%rsp); popfq" : : "i"(SIM_EFLAGS_TF) : "memory", "cc");
+    fn();
+    __asm__ volatile("pushfq; andq %0, (%%rsp); popfq" : : "i"(~SIM_EFLAGS_TF) : "memory", "cc");
+    modelRunning = 0;
+
+    // The model only shows inside the function
+    DWT->CYCCNT = cycles;
+    return modelCycles;
+}
+
+/*******************************************************************************
+* Sim_Empty() - Calibrates the cycle model's own overhead.
+*******************************************************************************/
+static void __attribute__((noinline)) Sim_Empty(void) {
+    __asm__ volatile("" ::: "memory");
+}
+
+/*******************************************************************************
+* Sim_Dispatch() - Run the highest priority interrupt that can preempt the
+*                  current priority, until there are none left. Handlers may
+*                  themselves be preempted through Sim_Interrupts().
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Sim_Dispatch(void) {
+    while (primask == 0) {
+        SimHandler *best = NULL;
+        uint16_t bestPriority = activePriority;
+
+        for (size_t i = 0; i < SIM_HANDLER_COUNT; i++) {
+            SimHandler *handler = &simHandlers[i];
+            int index = handler->irq + SIM_IRQ_OFFSET;
+
+            // Equal priority doesn't preempt, ties go to the lower IRQ number (table order)
+            if ((handler->handler == NULL) || irqActive[index] || (irqPriority[index] >= bestPriority)) {
+                continue;
+            }
+            if ((handler->irq >= 0) && !irqEnabled[index]) {
+                continue;
+            }
+            if (irqPending[index] || Periph_IrqLevel(handler->irq)) {
+                best = handler;
+                bestPriority = irqPriority[index];
+            }
+        }
+
+        if (best == NULL) {
+            return;
+        }
+
+        // A handler that never clears its flag would hang virtual time
+        if (stormTime != now) {
+            stormTime = now;
+            stormCount = 0;
+        }
+        if (++stormCount > SIM_STORM_LIMIT) {
+            Sim_Printf("sim: %s keeps firing, is its flag cleared?\n", best->name);
+            Sim_Exit(1);
+        }
+
+        int index = best->irq + SIM_IRQ_OFFSET;
+        uint16_t savedPriority = activePriority;
+
+        irqPending[index] = 0;
+        irqActive[index] = 1;
+        irqCount[index]++;
+        activePriority = irqPriority[index];
+
+        // Preempting handlers are counted in the modeled one, as on the target
+        if (irqModeled[index] && !modelRunning) {
+            Sim_Model(best->handler);
+        }
+        else {
+            best->handler();
+        }
+
+        Periph_IrqReturn(best->irq);
+        Periph_Sync();
+        activePriority = savedPriority;
+        irqActive[index] = 0;
+    }
+}
+
+/*******************************************************************************
+* Sim_Step() - Advance virtual time to the next peripheral, world or host
+*              event and process it.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Sim_Step(void) {
+    SimTime next = now + SIM_MAX_STEP;
+    SimTime event;
+
+    event = Periph_NextEvent();
+    if (event < next) {
+        next = event;
+    }
+    event = World_NextEvent();
+    if (event < next) {
+        next = event;
+    }
+    event = Host_NextEvent();
+    if (event < next) {
+        next = event;
+    }
+    event = Scenario_NextEvent();
+    if (event < next) {
+        next = event;
+    }
+    if (next <= now) {
+        next = now + 1;
+    }
+
+    if (next > endTime) {
+        now = endTime;
+        Sim_Exit(0);
+    }
+
+    now = next;
+    steps++;
+    Periph_Advance(now);
+    World_Advance(now);
+    Host_Advance(now);
+    Scenario_Advance(now);
+    Periph_Sync();
+}
+
+/*******************************************************************************
+* Sim_FindTrap() - Find the trapped page an address is in.
+* addr      - Faulting address.
+* Returns the page address, or 0 if the address is not trapped.
+*******************************************************************************/
+static uintptr_t Sim_FindTrap(uintptr_t addr) {
+    for (uint8_t i = 0; i < trapCount; i++) {
+        if ((addr & ~(SIM_PAGE_SIZE - 1)) == trapPages[i]) {
+            return trapPages[i];
+        }
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* Sim_SegvHandler() - Write to a trapped page. Opens the page and single
+*                     steps the faulting instruction.
+*******************************************************************************/
+static void Sim_SegvHandler(int sig, siginfo_t *info, void *context) {
+    ucontext_t *uc = context;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    uintptr_t page = Sim_FindTrap(addr);
+
+    (void)sig;
+
+    // A real crash, let it happen again without the handler
+    if ((page == 0) || (trapPage != 0)) {
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    mprotect((void *)page, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    trapPage = page;
+    trapAddr = addr & ~3UL;
+    Periph_TrapPrepare(trapAddr);
+    trapBefore = *(volatile uint32_t *)trapAddr;
+    uc->uc_mcontext.gregs[REG_EFL] |= SIM_EFLAGS_TF;
+}
+
+/*******************************************************************************
+* Sim_TrapHandler() - The trapped write has executed. Let the model see it and
+*                     close the page again.
+*******************************************************************************/
+static void Sim_TrapHandler(int sig, siginfo_t *info, void *context) {
+    ucontext_t *uc = context;
+    uintptr_t page = trapPage;
+
+    (void)sig;
+    (void)info;
+
+    if ((page == 0) && !modelRunning) {
+        signal(SIGTRAP, SIG_DFL);
+        return;
+    }
+
+    if (modelRunning) {
+        uint32_t cycles = (modelLast != 0) ? Sim_InstructionCycles(modelLast) : 1;
+
+        modelCycles += cycles;
+        DWT->CYCCNT += cycles;
+        modelLast = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    }
+    else {
+        uc->uc_mcontext.gregs[REG_EFL] &= ~SIM_EFLAGS_TF;
+    }
+
+    if (page != 0) {
+        Periph_TrapWrite(trapAddr, trapBefore);
+        mprotect((void *)page, SIM_PAGE_SIZE, PROT_READ);
+        trapPage = 0;
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Sim_Init() - Map the register blocks, install the write traps and reset the
+*              peripheral models.
+* end       - Virtual time to stop at.
+* No return value.
+*******************************************************************************/
+void Sim_Init(SimTime end) {
+    struct sigaction action;
+
+    for (size_t i = 0; i < sizeof(simRegions) / sizeof(simRegions[0]); i++) {
+        void *mapped = mmap((void *)simRegions[i].base, simRegions[i].size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (mapped != (void *)simRegions[i].base) {
+            fprintf(stderr, "sim: can't map registers at 0x%08lX\n", (unsigned long)simRegions[i].base);
+            exit(1);
+        }
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    action.sa_sigaction = Sim_SegvHandler;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = Sim_TrapHandler;
+    sigaction(SIGTRAP, &action, NULL);
+
+    for (int i = 0; i < SIM_IRQ_COUNT; i++) {
+        irqEnabled[i] = (i < SIM_IRQ_OFFSET);   // Core exceptions can't be disabled
+    }
+
+    endTime = end;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    Periph_Init();
+}
+
+/*******************************************************************************
+* Sim_Now() - Current virtual time.
+* No inputs.
+* Returns SYSCLK cycles since reset.
+*******************************************************************************/
+SimTime Sim_Now(void) {
+    return now;
+}
+
+/*******************************************************************************
+* Sim_Yield() - Called from firmware busy-waits (SIM_YIELD(), __WFI()). Takes
+*               pending interrupts, then moves time on to the next event.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Sim_Yield(void) {
+    Periph_Sync();
+    Sim_Dispatch();
+    Sim_Step();
+    Sim_Dispatch();
+}
+
+/*******************************************************************************
+* Sim_Interrupts() - Take any interrupts that became possible without time
+*                    passing (interrupts unmasked or enabled).
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Sim_Interrupts(void) {
+    Periph_Sync();
+    Sim_Dispatch();
+}
+
+/*******************************************************************************
+* Sim_Poke() - Write a register on a trapped page from the simulator.
+* reg       - Register to write.
+* value     - Value to write.
+* No return value.
+*******************************************************************************/
+void Sim_Poke(volatile uint32_t *reg, uint32_t value) {
+    uintptr_t page = Sim_FindTrap((uintptr_t)reg);
+
+    if (page == 0) {
+        *reg = value;
+        return;
+    }
+
+    mprotect((void *)page, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    *reg = value;
+    mprotect((void *)page, SIM_PAGE_SIZE, PROT_READ);
+}
+
+/*******************************************************************************
+* Sim_TrapPage() - Make firmware writes to a register page call
+*                  Periph_TrapPrepare() and Periph_TrapWrite().
+* addr      - Any address in the page.
+* No return value.
+*******************************************************************************/
+void Sim_TrapPage(uintptr_t addr) {
+    if (trapCount >= SIM_MAX_TRAPS) {
+        fprintf(stderr, "sim: too many trapped pages\n");
+        exit(1);
+    }
+
+    trapPages[trapCount] = addr & ~(SIM_PAGE_SIZE - 1);
+    mprotect((void *)trapPages[trapCount], SIM_PAGE_SIZE, PROT_READ);
+    trapCount++;
+}
+
+/*******************************************************************************
+* Sim_ModelCycles() - Run an interrupt handler under the cycle model.
+* handler   - Handler name, e.g. TIM2_IRQHandler.
+* Returns 1, or 0 if there is no such handler.
+*******************************************************************************/
+uint8_t Sim_ModelCycles(const char *handler) {
+    for (size_t i = 0; i < SIM_HANDLER_COUNT; i++) {
+        if (strcmp(simHandlers[i].name, handler) == 0) {
+            irqModeled[simHandlers[i].irq + SIM_IRQ_OFFSET] = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* Sim_Cycles() - Modeled Cortex-M4 cycles of one call of a function.
+* fn        - Function to run.
+* Returns the cycles, not counting the model's own call overhead.
+*******************************************************************************/
+uint32_t Sim_Cycles(void (*fn)(void)) {
+    uint32_t cycles;
+
+    if (!modelCalibrated) {
+        modelOverhead = Sim_Model(Sim_Empty);
+        modelCalibrated = 1;
+    }
+
+    cycles = Sim_Model(fn);
+    return (cycles > modelOverhead) ? (cycles - modelOverhead) : 0;
+}
+
+/*******************************************************************************
+* Sim_Printf() - printf() with the virtual time in front.
+* fmt       - Format string.
+* No return value.
+*******************************************************************************/
+void Sim_Printf(const char *fmt, ...) {
+    va_list args;
+
+    printf("[%11.6f] ", (double)now / SIM_CLOCK_HZ);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+/*******************************************************************************
+* Sim_Exit() - Print the run summary and exit.
+* status    - Process exit status.
+* No return value.
+*******************************************************************************/
+void Sim_Exit(int status) {
+    struct timespec wallEnd;
+    double wall;
+    double virtual = (double)now / SIM_CLOCK_HZ;
+
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    wall = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+    printf("\n[Sim] %.3fs virtual in %.3fs wall (%.0fx), %lu steps\n",
+           virtual, wall, (wall > 0) ? virtual / wall : 0.0, steps);
+    for (size_t i = 0; i < SIM_HANDLER_COUNT; i++) {
+        unsigned long count = irqCount[simHandlers[i].irq + SIM_IRQ_OFFSET];
+
+        if (count != 0) {
+            printf("[Sim]   %-30s %lu\n", simHandlers[i].name, count);
+        }
+    }
+    World_Print();
+    Host_Print();
+    if (Scenario_Finish() != 0) {
+        status = 1;
+    }
+
+    fflush(stdout);
+    exit(status);
+}
+
+/*******************************************************************************
+*                               CORE INTRINSICS                                *
+*******************************************************************************/
+uint32_t Sim_GetPrimask(void) {
+    return primask;
+}
+
+void Sim_SetPrimask(uint32_t value) {
+    primask = value & 1;
+
+    // Interrupts that pended while masked are taken straight away
+    if (primask == 0) {
+        Sim_Interrupts();
+    }
+}
+
+void Sim_Breakpoint(uint32_t value) {
+    Sim_Printf("sim: breakpoint %u\n", value);
+    Sim_Exit(1);
+}
+
+/*******************************************************************************
+*                               VIRTUAL NVIC                                   *
+*******************************************************************************/
+void Sim_NVIC_EnableIRQ(IRQn_Type irq) {
+    irqEnabled[Sim_IrqIndex(irq)] = 1;
+    Sim_Interrupts();
+}
+
+void Sim_NVIC_DisableIRQ(IRQn_Type irq) {
+    irqEnabled[Sim_IrqIndex(irq)] = (irq < 0);
+}
+
+uint32_t Sim_NVIC_GetEnableIRQ(IRQn_Type irq) {
+    return irqEnabled[Sim_IrqIndex(irq)];
+}
+
+void Sim_NVIC_SetPendingIRQ(IRQn_Type irq) {
+    irqPending[Sim_IrqIndex(irq)] = 1;
+}
+
+void Sim_NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    irqPending[Sim_IrqIndex(irq)] = 0;
+}
+
+uint32_t Sim_NVIC_GetPendingIRQ(IRQn_Type irq) {
+    int index = Sim_IrqIndex(irq);
+
+    return irqPending[index] || ((irq >= 0) && Periph_IrqLevel(irq));
+}
+
+uint32_t Sim_NVIC_GetActive(IRQn_Type irq) {
+    return irqActive[Sim_IrqIndex(irq)];
+}
+
+void Sim_NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+    irqPriority[Sim_IrqIndex(irq)] = (uint8_t)(priority & ((1UL << __NVIC_PRIO_BITS) - 1));
+}
+
+uint32_t Sim_NVIC_GetPriority(IRQn_Type irq) {
+    return irqPriority[Sim_IrqIndex(irq)];
+}
+
+void Sim_NVIC_SystemReset(void) {
+    Sim_Printf("sim: system reset requested\n");
+    Sim_Exit(0);
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+* Name: sim.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Host (x86-64 Linux) simulator for the robot firmware. The
+*              firmware is compiled for the host with -DSIM and runs against
+*              emulated peripherals in virtual time:
+*                sim.c      - Register memory, virtual NVIC, time and dispatch
+*                periph.c   - Timers, SysTick, DWT, RCC, GPIO/EXTI, DMA,
+*                             USART, ADC and CRC register models
+*                world.c    - Motors, encoders, pose, ultrasonic sensor,
+*                             stepper, limit switches, battery and current
+*                             sense
+*                host.c     - Decodes the robot link and plays host commands
+*                test.c     - Unit tests of firmware modules
+*                bench.c    - Benchmarks of firmware modules
+*                scenario.c - Scripted runs of the whole firmware checked
+*                             against the world
+*              Virtual time only advances when the firmware busy-waits
+*              (SIM_YIELD() in src/Utility.h), firmware code takes no time.
+*******************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+
+/*******************************************************************************
+*                                   TIME                                       *
+*******************************************************************************/
+typedef uint64_t SimTime;                   // SYSCLK cycles since reset
+
+#define SIM_CLOCK_HZ        72000000ULL
+#define SIM_US(us)          ((SimTime)(us) * (SIM_CLOCK_HZ / 1000000ULL))
+#define SIM_MS(ms)          ((SimTime)(ms) * (SIM_CLOCK_HZ / 1000ULL))
+#define SIM_NEVER           UINT64_MAX
+#define SIM_MAX_STEP        SIM_MS(1)       // Longest jump when nothing is scheduled
+
+/*******************************************************************************
+*                               CORE (sim.c)                                   *
+*******************************************************************************/
+void Sim_Init(SimTime end);
+SimTime Sim_Now(void);
+void Sim_Yield(void);
+void Sim_Interrupts(void);
+void Sim_Poke(volatile uint32_t *reg, uint32_t value);
+void Sim_TrapPage(uintptr_t addr);
+uint8_t Sim_ModelCycles(const char *handler);
+uint32_t Sim_Cycles(void (*fn)(void));
+void Sim_Printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void Sim_Exit(int status) __attribute__((noreturn));
+
+/*******************************************************************************
+*                           PERIPHERALS (periph.c)                             *
+*******************************************************************************/
+void Periph_Init(void);
+void Periph_Sync(void);
+SimTime Periph_NextEvent(void);
+void Periph_Advance(SimTime t);
+uint8_t Periph_IrqLevel(IRQn_Type irq);
+void Periph_IrqReturn(IRQn_Type irq);
+void Periph_TrapPrepare(uintptr_t addr);
+void Periph_TrapWrite(uintptr_t addr, uint32_t before);
+void Periph_TimerInput(TIM_TypeDef *regs, uint8_t input, uint8_t level);
+void Periph_GpioInput(GPIO_TypeDef *regs, uint8_t pin, uint8_t level);
+void Periph_UsartReceive(USART_TypeDef *regs, const uint8_t *data, size_t len);
+
+/*******************************************************************************
+*                               WORLD (world.c)                                *
+*******************************************************************************/
+void World_Init(void);
+uint8_t World_AddObstacle(double x, double y, double radius);
+SimTime World_NextEvent(void);
+void World_Advance(SimTime t);
+void World_TimerUpdate(TIM_TypeDef *regs);
+double World_AnalogInput(ADC_TypeDef *regs, uint8_t channel);
+void World_SetBattery(double mv);
+void World_InjectCurrent(double ma);
+void World_Jam(int8_t wheel);
+double World_WheelSpeed(uint8_t wheel);
+unsigned long World_WheelEdges(uint8_t wheel);
+double World_Battery(void);
+void World_SetPose(double x, double y, double heading);
+double World_ObstacleGap(void);
+void World_Print(void);
+
+/*******************************************************************************
+*                               HOST (host.c)                                  *
+*******************************************************************************/
+void Host_Init(uint32_t printMs);
+uint8_t Host_Schedule(SimTime t, const char *command);
+SimTime Host_NextEvent(void);
+void Host_Advance(SimTime t);
+void Host_UsartOutput(USART_TypeDef *regs, uint8_t byte);
+void Host_Print(void);
+
+/*******************************************************************************
+*                           TESTS (test.c, bench.c)                            *
+*******************************************************************************/
+int Test_Run(const char *name);
+int Bench_Run(const char *name, unsigned long count);
+void Bench_Start(struct timespec *start);
+double Bench_Ns(const struct timespec *start);
+
+/*******************************************************************************
+*                           SCENARIOS (scenario.c)                             *
+*******************************************************************************/
+double Scenario_Init(const char *name);
+SimTime Scenario_NextEvent(void);
+void Scenario_Advance(SimTime t);
+int Scenario_Finish(void);
+
+#endif
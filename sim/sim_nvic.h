@@ -0,0 +1,38 @@
+/*******************************************************************************
+* Name: sim_nvic.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Virtual NVIC for the host simulator build. Included by
+*              core_cm4.h when CMSIS_NVIC_VIRTUAL is defined (see
+*              cmsis_host.h), after IRQn_Type is declared.
+*******************************************************************************/
+
+#ifndef SIM_NVIC_H
+#define SIM_NVIC_H
+
+void Sim_NVIC_EnableIRQ(IRQn_Type irq);
+void Sim_NVIC_DisableIRQ(IRQn_Type irq);
+uint32_t Sim_NVIC_GetEnableIRQ(IRQn_Type irq);
+void Sim_NVIC_SetPendingIRQ(IRQn_Type irq);
+void Sim_NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t Sim_NVIC_GetPendingIRQ(IRQn_Type irq);
+uint32_t Sim_NVIC_GetActive(IRQn_Type irq);
+void Sim_NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+uint32_t Sim_NVIC_GetPriority(IRQn_Type irq);
+void Sim_NVIC_SystemReset(void) __attribute__((noreturn));
+
+// Priority grouping only touches SCB->AIRCR, which is plain memory in the simulator
+#define NVIC_SetPriorityGrouping    __NVIC_SetPriorityGrouping
+#define NVIC_GetPriorityGrouping    __NVIC_GetPriorityGrouping
+#define NVIC_EnableIRQ              Sim_NVIC_EnableIRQ
+#define NVIC_GetEnableIRQ           Sim_NVIC_GetEnableIRQ
+#define NVIC_DisableIRQ             Sim_NVIC_DisableIRQ
+#define NVIC_GetPendingIRQ          Sim_NVIC_GetPendingIRQ
+#define NVIC_SetPendingIRQ          Sim_NVIC_SetPendingIRQ
+#define NVIC_ClearPendingIRQ        Sim_NVIC_ClearPendingIRQ
+#define NVIC_GetActive              Sim_NVIC_GetActive
+#define NVIC_SetPriority            Sim_NVIC_SetPriority
+#define NVIC_GetPriority            Sim_NVIC_GetPriority
+#define NVIC_SystemReset            Sim_NVIC_SystemReset
+
+#endif
@@ -0,0 +1,699 @@
+/*******************************************************************************
+* Name: test.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Host unit tests of firmware modules, run against the emulated
+*              peripherals without starting the firmware.
+*
+* Tests (-T NAME):
+*   protocol    COBS round trips and block boundaries, CRC check value,
+*               truncated, corrupt and oversized frames
+*   format      Format conversions against expected strings and the host's
+*               snprintf, and printf into a nearly full transmit queue
+*   queue       A stream through a small queue from a producer thread and
+*               from a producer timer signal (an ISR), checking the consumer
+*               gets every byte once and in order
+*   odometry    Straight, spinning and arcing tick streams against the
+*               closed-form pose, and the cycles per update
+*   all         All of the above
+*******************************************************************************/
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "sim.h"
+#include "../src/COBS.h"
+#include "../src/Encoder.h"
+#include "../src/Format.h"
+#include "../src/Odometry.h"
+#include "../src/Protocol.h"
+
+#define TEST_COBS_MAX_LEN   1024
+#define TEST_FORMAT_MAX_LEN 128
+#define TEST_QUEUE_SIZE     64                  // Small so it wraps all the time
+#define TEST_QUEUE_BYTES    20000000UL          // Through the producer thread
+#define TEST_QUEUE_ISR_BYTES 2000000UL          // Through the producer timer signal
+#define TEST_QUEUE_TIMER_US 20
+#define TEST_QUEUE_WORK     1000                // Consumer loops per chunk against the timer signal
+#define TEST_ODOMETRY_UPDATES 1000              // 10 s of control task updates
+#define TEST_ODOMETRY_POS_UM  500               // Allowed position error per metre travelled
+#define TEST_ODOMETRY_HEADING 0.0005            // Allowed heading error, radians
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} Test;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+// The server's software CRC, built as Host_CRC16 so it can sit next to the
+// firmware's (see the Makefile)
+extern uint16_t Host_CRC16(const uint8_t *data, size_t len);
+
+// Queue test stream, the producer variables are only touched by the producer
+static Queue queue;
+static volatile uint8_t queueBuff[TEST_QUEUE_SIZE];
+static uint32_t queueTotal = 0;
+static uint32_t queueProduced = 0;
+static uint32_t queueSeed = 1;
+static volatile uint8_t queueDone = 0;
+
+static const char *testName = "";
+static unsigned long checks = 0;
+static unsigned long failures = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Test_Check() - Count a check and report it if it failed.
+*******************************************************************************/
+static __attribute__((format(printf, 2, 3))) uint8_t Test_Check(int ok, const char *fmt, ...) {
+    va_list args;
+
+    checks++;
+    if (ok) {
+        return 1;
+    }
+
+    failures++;
+    printf("[Test] %s: FAIL ", testName);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    return 0;
+}
+
+/*******************************************************************************
+* Test_CobsRoundTrip() - Encode and decode data, checking the encoding has no
+*                        zeros and fits the worst case length.
+*******************************************************************************/
+static void Test_CobsRoundTrip(const char *what, const uint8_t *data, uint16_t len) {
+    static uint8_t encoded[COBS_MAX_ENCODED(TEST_COBS_MAX_LEN)];
+    static uint8_t decoded[COBS_MAX_ENCODED(TEST_COBS_MAX_LEN)];
+    uint16_t encodedLen = COBS_Encode(data, len, encoded);
+    int16_t decodedLen;
+
+    if (!Test_Check(encodedLen <= COBS_MAX_ENCODED(len), "cobs %s %u bytes: encoded to %u", what, len, encodedLen)
+        || !Test_Check(memchr(encoded, 0, encodedLen) == NULL, "cobs %s %u bytes: zero in the encoding", what, len)) {
+        return;
+    }
+
+    decodedLen = COBS_Decode(encoded, encodedLen, decoded);
+    Test_Check((decodedLen == len) && (memcmp(decoded, data, len) == 0),
+               "cobs %s %u bytes: decoded to %d bytes that differ", what, len, decodedLen);
+}
+
+/*******************************************************************************
+* Test_CobsVector() - Check an encoding against a known one.
+*******************************************************************************/
+static void Test_CobsVector(const uint8_t *data, uint16_t len, const uint8_t *expected, uint16_t expectedLen) {
+    uint8_t encoded[COBS_MAX_ENCODED(256)];
+    uint16_t encodedLen = COBS_Encode(data, len, encoded);
+
+    Test_Check((encodedLen == expectedLen) && (memcmp(encoded, expected, expectedLen) == 0),
+               "cobs vector of %u bytes encoded to %u bytes, expected %u", len, encodedLen, expectedLen);
+    Test_CobsRoundTrip("vector", data, len);
+}
+
+/*******************************************************************************
+* Test_Feed() - Put bytes on the robot's receive queue and collect the frames
+*               the protocol decodes from them.
+*******************************************************************************/
+static uint8_t Test_Feed(const uint8_t *data, uint16_t len, ProtocolFrame *frame) {
+    static volatile uint8_t rxBuff[2048];
+    uint8_t frames = 0;
+
+    Queue_Init(&G_USART3.rx, rxBuff, sizeof(rxBuff));
+    Queue_Push(&G_USART3.rx, data, len);
+    while (Protocol_Receive(frame)) {
+        frames++;
+    }
+
+    return frames;
+}
+
+/*******************************************************************************
+* Test_Sent() - Take a frame sent with Protocol_Send() off the transmit queue.
+*******************************************************************************/
+static uint16_t Test_Sent(uint8_t *data, uint16_t size) {
+    return Queue_Pop(&G_USART3.tx, data, size);
+}
+
+/*******************************************************************************
+* Test_Protocol() - COBS, CRC and frame decoding.
+*******************************************************************************/
+static void Test_Protocol(void) {
+    static uint8_t data[TEST_COBS_MAX_LEN];
+    static volatile uint8_t txBuff[1024];
+    uint8_t frame[PROTOCOL_MAX_ENCODED * 2];
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+    ProtocolFrame rx;
+    ProtocolStats before;
+    uint16_t len;
+
+    // Known encodings, including a full block that ends the data and one
+    // that is followed by more
+    {
+        static const uint8_t zero[] = {0x00}, zeroEnc[] = {0x01, 0x01};
+        static const uint8_t zeros[] = {0x00, 0x00}, zerosEnc[] = {0x01, 0x01, 0x01};
+        static const uint8_t mid[] = {0x11, 0x22, 0x00, 0x33}, midEnc[] = {0x03, 0x11, 0x22, 0x02, 0x33};
+        static const uint8_t tail[] = {0x11, 0x00, 0x00, 0x00}, tailEnc[] = {0x02, 0x11, 0x01, 0x01, 0x01};
+        uint8_t block[255], blockEnc[258];
+
+        Test_CobsVector(zero, sizeof(zero), zeroEnc, sizeof(zeroEnc));
+        Test_CobsVector(zeros, sizeof(zeros), zerosEnc, sizeof(zerosEnc));
+        Test_CobsVector(mid, sizeof(mid), midEnc, sizeof(midEnc));
+        Test_CobsVector(tail, sizeof(tail), tailEnc, sizeof(tailEnc));
+
+        // 01..FF: FF 01..FE 02 FF
+        for (uint16_t i = 0; i < 255; i++) {
+            block[i] = (uint8_t)(i + 1);
+        }
+        blockEnc[0] = 0xFF;
+        memcpy(&blockEnc[1], block, 254);
+        blockEnc[255] = 0x02;
+        blockEnc[256] = 0xFF;
+        Test_CobsVector(block, 255, blockEnc, 257);
+
+        // 00 02..FF: 01 FF 02..FF, then an empty block
+        block[0] = 0x00;
+        blockEnc[0] = 0x01;
+        blockEnc[1] = 0xFF;
+        memcpy(&blockEnc[2], &block[1], 254);
+        blockEnc[256] = 0x01;
+        Test_CobsVector(block, 255, blockEnc, 257);
+    }
+
+    // Every length around the block boundaries, with no zeros, all zeros and
+    // a zero just before, at and after each boundary
+    for (len = 0; len <= 3 * 255; len++) {
+        for (uint16_t i = 0; i < len; i++) {
+            data[i] = (uint8_t)(1 + i % 255);
+        }
+        Test_CobsRoundTrip("no zeros", data, len);
+
+        for (uint16_t at = 253; at < len; at++) {
+            if (((at + 1) % 254) <= 2) {
+                data[at] = 0;
+                Test_CobsRoundTrip("zero at a block end", data, len);
+                data[at] = 1;
+            }
+        }
+
+        memset(data, 0, len);
+        Test_CobsRoundTrip("all zeros", data, len);
+    }
+
+    // Zero runs of every length in random data
+    srand(1);
+    for (uint16_t run = 1; run < 300; run++) {
+        len = (uint16_t)(run + rand() % (TEST_COBS_MAX_LEN - run));
+        for (uint16_t i = 0; i < len; i++) {
+            data[i] = (uint8_t)(1 + rand() % 255);
+        }
+        memset(&data[rand() % (len - run + 1)], 0, run);
+        Test_CobsRoundTrip("zero run", data, len);
+    }
+
+    // Truncated: a code byte that points past the end, and a zero code
+    {
+        uint8_t encoded[COBS_MAX_ENCODED(300)], decoded[COBS_MAX_ENCODED(300)];
+
+        for (uint16_t i = 0; i < 300; i++) {
+            data[i] = (uint8_t)(1 + i % 255);
+        }
+        len = COBS_Encode(data, 300, encoded);
+        for (uint16_t cut = 1; cut < len; cut++) {
+            if ((cut != 255) && (COBS_Decode(encoded, cut, decoded) != -1)) {
+                Test_Check(0, "cobs decoded %u of %u bytes of a block", cut, len);
+                break;
+            }
+        }
+        encoded[255] = 0x00;
+        Test_Check(COBS_Decode(encoded, len, decoded) == -1, "cobs decoded a zero code");
+    }
+
+    // CRC-16/CCITT-FALSE check value, from the CRC unit and the server
+    Protocol_Init();
+    Test_Check(Protocol_CRC16((const uint8_t *)"123456789", 9) == 0x29B1, "crc unit check value 0x%04X",
+               Protocol_CRC16((const uint8_t *)"123456789", 9));
+    Test_Check(Host_CRC16((const uint8_t *)"123456789", 9) == 0x29B1, "server crc check value 0x%04X",
+               Host_CRC16((const uint8_t *)"123456789", 9));
+
+    // Frames sent by the robot come back whole, largest with zeros and CRCs
+    // that happen to contain zeros
+    Queue_Init(&G_USART3.tx, txBuff, sizeof(txBuff));
+    G_USART3.txDMALen = 1;                      // No DMA transfers, the test reads the queue
+    for (uint16_t n = 0; n <= PROTOCOL_MAX_PAYLOAD; n++) {
+        for (uint16_t i = 0; i < n; i++) {
+            payload[i] = (i % 7 == 0) ? 0 : (uint8_t)(n * 31 + i);
+        }
+        Protocol_Send((uint8_t)n, payload, (uint8_t)n);
+        len = Test_Sent(frame, sizeof(frame));
+        if (!Test_Check(Test_Feed(frame, len, &rx) == 1, "frame of %u bytes was not received", n)) {
+            continue;
+        }
+        Test_Check((rx.type == n) && (rx.len == n) && (memcmp(rx.payload, payload, n) == 0),
+                   "frame of %u bytes came back as %u bytes of type %u", n, rx.len, rx.type);
+    }
+    Test_Check(!Protocol_Send(0, payload, PROTOCOL_MAX_PAYLOAD + 1), "oversized payload was sent");
+
+    // Every truncation of a frame is dropped, and the next frame still decodes
+    memset(payload, 0x5A, sizeof(payload));
+    Protocol_Send(MSG_DRIVE, payload, 40);
+    len = Test_Sent(frame, sizeof(frame));
+    for (uint16_t cut = 1; cut < len - 1; cut++) {
+        uint8_t buff[PROTOCOL_MAX_ENCODED * 2];
+
+        memcpy(buff, frame, cut);
+        buff[cut] = PROTOCOL_DELIMITER;
+        memcpy(&buff[cut + 1], frame, len);
+
+        before = G_ProtocolStats;
+        Test_Check((Test_Feed(buff, cut + 1 + len, &rx) == 1) && (rx.len == 40),
+                   "frame cut to %u bytes was not dropped cleanly", cut);
+        Test_Check(G_ProtocolStats.rxCrcErrors + G_ProtocolStats.rxFramingErrors
+                   == before.rxCrcErrors + before.rxFramingErrors + 1, "frame cut to %u bytes was not counted", cut);
+    }
+
+    // Every single bit error is caught
+    for (uint16_t bit = 0; bit < (len - 1) * 8; bit++) {
+        uint8_t buff[PROTOCOL_MAX_ENCODED];
+
+        memcpy(buff, frame, len);
+        buff[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        before = G_ProtocolStats;
+        Test_Check(Test_Feed(buff, len, &rx) == 0, "frame with bit %u flipped was accepted", bit);
+        Test_Check(G_ProtocolStats.rxCrcErrors + G_ProtocolStats.rxFramingErrors
+                   > before.rxCrcErrors + before.rxFramingErrors, "frame with bit %u flipped was not counted", bit);
+    }
+
+    // Too long to be a frame, then a good one
+    {
+        uint8_t buff[PROTOCOL_MAX_ENCODED * 3];
+
+        memset(buff, 0x11, PROTOCOL_MAX_ENCODED * 2);
+        buff[PROTOCOL_MAX_ENCODED * 2] = PROTOCOL_DELIMITER;
+        memcpy(&buff[PROTOCOL_MAX_ENCODED * 2 + 1], frame, len);
+        before = G_ProtocolStats;
+        Test_Check(Test_Feed(buff, PROTOCOL_MAX_ENCODED * 2 + 1 + len, &rx) == 1, "frame after an oversized one was lost");
+        Test_Check(G_ProtocolStats.rxFramingErrors == before.rxFramingErrors + 1, "oversized frame was not counted");
+    }
+}
+
+/*******************************************************************************
+* Test_FormatWrite() - Formatter output function, appends to a string.
+*******************************************************************************/
+static void Test_FormatWrite(void *ctx, const char *data, uint16_t len) {
+    char *out = (char *)ctx;
+    size_t used = strlen(out);
+
+    if (used + len < TEST_FORMAT_MAX_LEN) {
+        memcpy(&out[used], data, len);
+        out[used + len] = '\0';
+    }
+}
+
+/*******************************************************************************
+* Test_FormatExpect() - Format and compare with the expected string and count.
+*******************************************************************************/
+static void Test_FormatExpect(const char *expected, const char *fmt, ...) {
+    char out[TEST_FORMAT_MAX_LEN] = "";
+    va_list args;
+    uint16_t count;
+
+    va_start(args, fmt);
+    count = Format_vprintf(Test_FormatWrite, out, fmt, args);
+    va_end(args);
+
+    Test_Check((strcmp(out, expected) == 0) && (count == strlen(expected)),
+               "\"%s\" gave \"%s\" (%u), expected \"%s\"", fmt, out, count, expected);
+}
+
+/*******************************************************************************
+* Test_Format() - Formatter conversions, and USART2_printf() into a transmit
+*                 queue with only room for part of the message.
+*******************************************************************************/
+static void Test_Format(void) {
+    static const char *intFormats[] = {"%d", "%i", "%u", "%x", "%X", "%7d", "%-7d|", "%07d", "%-07d|",
+                                       "%1d", "%12u", "%08x", "%-10X|", "%ld", "%lu", "%lx"};
+    static const int32_t values[] = {0, 1, -1, 9, 10, -10, 255, 4096, 32767, -32768, 65535, 123456789,
+                                     -987654321, INT32_MAX, INT32_MIN, (int32_t)0xDEADBEEF};
+    static volatile uint8_t txBuff[32];
+    char out[TEST_FORMAT_MAX_LEN];
+    char expected[TEST_FORMAT_MAX_LEN];
+
+    // Integers, against the host's snprintf. int and long are 32 bits on
+    // the robot, so the long conversions are passed 32-bit values.
+    for (size_t f = 0; f < sizeof(intFormats) / sizeof(intFormats[0]); f++) {
+        for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+            uint8_t isLong = (strchr(intFormats[f], 'l') != NULL);
+            uint8_t isSigned = (strpbrk(intFormats[f], "di") != NULL);
+
+            if (isLong) {
+                snprintf(expected, sizeof(expected), intFormats[f],
+                         isSigned ? (long)values[v] : (long)(uint32_t)values[v]);
+            }
+            else {
+                snprintf(expected, sizeof(expected), intFormats[f], values[v]);
+            }
+            out[0] = '\0';
+            if (isLong) {
+                Format_printf(Test_FormatWrite, out, intFormats[f],
+                              isSigned ? (long)values[v] : (long)(uint32_t)values[v]);
+            }
+            else {
+                Format_printf(Test_FormatWrite, out, intFormats[f], values[v]);
+            }
+            Test_Check(strcmp(out, expected) == 0, "\"%s\" of %d gave \"%s\", expected \"%s\"",
+                       intFormats[f], values[v], out, expected);
+        }
+    }
+
+    // Characters, strings and widths from arguments
+    Test_FormatExpect("[a]", "[%c]", 'a');
+    Test_FormatExpect("[  a][a  ]", "[%3c][%-3c]", 'a', 'a');
+    Test_FormatExpect("[hello]", "[%s]", "hello");
+    Test_FormatExpect("[   hi][hi   ]", "[%5s][%-5s]", "hi", "hi");
+    Test_FormatExpect("[hel][he]", "[%.3s][%.*s]", "hello", 2, "hello");
+    Test_FormatExpect("[  hel]", "[%5.3s]", "hello");
+    Test_FormatExpect("[(null)]", "[%s]", (char *)NULL);
+    Test_FormatExpect("[   42][42   ]", "[%*d][%*d]", 5, 42, -5, 42);
+    Test_FormatExpect("[-0042]", "[%05d]", -42);
+    Test_FormatExpect("[                    12]", "[%22d]", 12);
+    Test_FormatExpect("100%", "100%%");
+    Test_FormatExpect("plain text", "plain text");
+    Test_FormatExpect("", "");
+
+    // Unknown conversions are printed as they are
+    Test_FormatExpect("[%y]", "[%y]");
+    Test_FormatExpect("[%-5y]", "[%-5y]");
+    Test_FormatExpect("end %", "end %");
+
+    // Fixed point, rounded to the requested decimals
+    Test_FormatExpect("1.500", "%q", 0x00018000);
+    Test_FormatExpect("-1.500", "%q", -0x00018000);
+    Test_FormatExpect("0.000", "%q", 0);
+    Test_FormatExpect("0.000", "%q", 1);
+    Test_FormatExpect("0.001", "%q", 33);
+    Test_FormatExpect("1.00", "%.2q", 0x0000FFFF);
+    Test_FormatExpect("3.14159", "%.5q", 205887);
+    Test_FormatExpect("-3", "%.0q", -196608);
+    Test_FormatExpect("32767.99998", "%.5q", INT32_MAX);
+    Test_FormatExpect("-32768.000", "%q", INT32_MIN);
+    Test_FormatExpect("2.50", "%.2q8", 640);
+    Test_FormatExpect("0.000001", "%.6q30", 1074);
+    Test_FormatExpect("12.00", "%.2q0", 12);
+    Test_FormatExpect("1.500000", "%.7q", 0x00018000);
+    Test_FormatExpect("[  -1.50][-1.50  ][-01.50]", "[%7.2q][%-7.2q][%06.2q]",
+                      -0x00018000, -0x00018000, -0x00018000);
+    Test_FormatExpect("[0.25]", "[%.2lq]", 0x4000L);
+
+    // A message that does not fit keeps its head and drops the rest, never
+    // a run in the middle. Fill the 31 byte queue to 11 free bytes.
+    Queue_Init(&G_USART2.tx, txBuff, sizeof(txBuff));
+    G_USART2.txDMALen = 1;                      // No DMA transfers, the test reads the queue
+    UART_Write(&G_USART2, (const uint8_t *)"xxxxxxxxxxxxxxxxxxxx", 20);
+    Queue_Pop(&G_USART2.tx, (uint8_t *)out, 20);
+    memset(out, 0, sizeof(out));
+    UART_Write(&G_USART2, (const uint8_t *)"xxxxxxxxxxxxxxxxxxxx", 20);
+    USART2_printf("L=%d R=%d long tail %d\n", 12, 34, 56);
+    Queue_Pop(&G_USART2.tx, (uint8_t *)out, 20);
+    memset(out, 0, sizeof(out));
+    Queue_Pop(&G_USART2.tx, (uint8_t *)out, sizeof(out) - 1);
+    Test_Check(strcmp(out, "L=12 R=34") == 0, "printf into a full queue left \"%s\"", out);
+}
+
+/*******************************************************************************
+* Test_QueueByte() - The byte at a position in the stream. Not periodic in any
+*                    small number of bytes, so a lost or repeated block shows.
+*******************************************************************************/
+static uint8_t Test_QueueByte(uint32_t n) {
+    n *= 0x9E3779B1UL;
+    return (uint8_t)((n >> 24) ^ (n >> 11));
+}
+
+/*******************************************************************************
+* Test_QueueProduce() - Push the next 1 to 16 bytes of the stream, either with
+*                       Queue_Push() or written straight into the buffer and
+*                       published like the receive DMA does.
+* Returns 0 if the queue is full or the stream has ended.
+*******************************************************************************/
+static uint8_t Test_QueueProduce(void) {
+    uint8_t chunk[16];
+    uint16_t len;
+
+    if (queueProduced == queueTotal) {
+        queueDone = 1;
+        return 0;
+    }
+
+    queueSeed = queueSeed * 1103515245UL + 12345;
+    len = 1 + ((queueSeed >> 16) % 16);
+    len = (len > queueTotal - queueProduced) ? (uint16_t)(queueTotal - queueProduced) : len;
+
+    if (Queue_Space(&queue) < len) {
+        return 0;
+    }
+
+    if (queueSeed & 0x100) {
+        for (uint16_t i = 0; i < len; i++) {
+            chunk[i] = Test_QueueByte(queueProduced + i);
+        }
+        Queue_Push(&queue, chunk, len);
+    }
+    else {
+        uint16_t head = queue.head;
+
+        for (uint16_t i = 0; i < len; i++) {
+            queue.buff[(head + i) & queue.mask] = Test_QueueByte(queueProduced + i);
+        }
+        Queue_Publish(&queue, head + len);
+    }
+
+    queueProduced += len;
+    return 1;
+}
+
+/*******************************************************************************
+* Test_QueueThread() - Producer thread, runs alongside the consumer.
+*******************************************************************************/
+static void *Test_QueueThread(void *arg) {
+    (void)arg;
+    while (!queueDone) {
+        if (!Test_QueueProduce()) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Test_QueueInterrupt() - Producer timer signal, interrupts the consumer at
+*                         any instruction like an ISR and fills the queue.
+*******************************************************************************/
+static void Test_QueueInterrupt(int signal) {
+    (void)signal;
+    while (Test_QueueProduce());
+}
+
+/*******************************************************************************
+* Test_QueueConsume() - Consume the stream until the producer is done,
+*                       alternating Queue_Pop() with reading in place and
+*                       releasing like the transmit DMA does. Against the
+*                       timer signal it works on each chunk for a while
+*                       instead of giving up the CPU, so the queue stays
+*                       nearly full and the signal lands in the queue code.
+*******************************************************************************/
+static void Test_QueueConsume(const char *producer, uint8_t interrupt) {
+    uint32_t n = 0;
+    uint32_t seed = 7;
+    unsigned long wrong = 0, empty = 0, countErrors = 0;
+
+    while (!queueDone || (Queue_Count(&queue) != 0)) {
+        uint8_t chunk[16];
+        uint16_t len;
+
+        countErrors += (Queue_Count(&queue) > queue.mask) ? 1 : 0;
+
+        seed = seed * 1103515245UL + 12345;
+        if (seed & 0x100) {
+            len = Queue_Pop(&queue, chunk, 1 + ((seed >> 16) % 16));
+        }
+        else {
+            uint16_t tail = queue.tail;
+
+            len = Queue_Contiguous(&queue);
+            len = (len > 16) ? 16 : len;
+            for (uint16_t i = 0; i < len; i++) {
+                chunk[i] = queue.buff[tail + i];
+            }
+            Queue_Release(&queue, len);
+        }
+
+        if (interrupt) {
+            for (volatile uint16_t i = 0; i < TEST_QUEUE_WORK; i++);
+        }
+        else if (len == 0) {
+            sched_yield();
+        }
+
+        empty += (len == 0) ? 1 : 0;
+        for (uint16_t i = 0; i < len; i++) {
+            if (chunk[i] != Test_QueueByte(n)) {
+                wrong++;
+            }
+            n++;
+        }
+    }
+
+    Test_Check(wrong == 0, "%s: %lu of %u bytes were out of order, lost or repeated", producer, wrong, n);
+    Test_Check(n == queueTotal, "%s: %u of %u bytes received", producer, n, queueTotal);
+    Test_Check(countErrors == 0, "%s: queue count over the size %lu times", producer, countErrors);
+    printf("[Test] queue: %s, %u bytes through a %u byte queue (%u wraps), found empty %lu times\n",
+           producer, n, TEST_QUEUE_SIZE, n / TEST_QUEUE_SIZE, empty);
+}
+
+/*******************************************************************************
+* Test_QueueStart() - Empty the queue and restart the stream.
+*******************************************************************************/
+static void Test_QueueStart(uint32_t total) {
+    Queue_Init(&queue, queueBuff, TEST_QUEUE_SIZE);
+    queueTotal = total;
+    queueProduced = 0;
+    queueSeed = 1;
+    queueDone = 0;
+}
+
+/*******************************************************************************
+* Test_Queue() - Stream through the queue from a second thread, which races
+*                the consumer on a multi-core host, then from a timer signal,
+*                which interrupts the consumer anywhere even on one core.
+*******************************************************************************/
+static void Test_Queue(void) {
+    struct itimerval timer = {{0, TEST_QUEUE_TIMER_US}, {0, TEST_QUEUE_TIMER_US}};
+    struct itimerval off = {{0, 0}, {0, 0}};
+    pthread_t thread;
+
+    Test_QueueStart(TEST_QUEUE_BYTES);
+    pthread_create(&thread, NULL, Test_QueueThread, NULL);
+    Test_QueueConsume("thread", 0);
+    pthread_join(thread, NULL);
+
+    Test_QueueStart(TEST_QUEUE_ISR_BYTES);
+    signal(SIGALRM, Test_QueueInterrupt);
+    setitimer(ITIMER_REAL, &timer, NULL);
+    Test_QueueConsume("interrupt", 1);
+    setitimer(ITIMER_REAL, &off, NULL);
+    signal(SIGALRM, SIG_DFL);
+}
+
+/*******************************************************************************
+* Test_OdometryRun() - Feed a constant number of ticks per update from each
+*                      wheel and compare the pose with the closed-form one,
+*                      a straight line or a circular arc.
+*******************************************************************************/
+static void Test_OdometryRun(const char *what, int32_t left, int32_t right) {
+    double leftUm = (double)left * UM_PER_VANE * TEST_ODOMETRY_UPDATES;
+    double rightUm = (double)right * UM_PER_VANE * TEST_ODOMETRY_UPDATES;
+    double turn = (rightUm - leftUm) / ODOMETRY_TRACK_UM;
+    double travel = (fabs(leftUm) + fabs(rightUm)) / 2;
+    double x, y, heading, posError, headingError;
+    unsigned long total = 0;
+    uint32_t cycles, maxCycles = 0;
+
+    if (left == right) {
+        x = leftUm;
+        y = 0;
+    }
+    else {
+        double radius = ODOMETRY_TRACK_UM * (leftUm + rightUm) / (2 * (rightUm - leftUm));
+
+        x = radius * sin(turn);
+        y = radius * (1 - cos(turn));
+    }
+
+    G_EncoderTicks[LEFT] = 0;
+    G_EncoderTicks[RIGHT] = 0;
+    Odometry_Init();
+    for (uint32_t i = 0; i < TEST_ODOMETRY_UPDATES; i++) {
+        G_EncoderTicks[LEFT] += left;
+        G_EncoderTicks[RIGHT] += right;
+        cycles = Sim_Cycles(Odometry_Update);
+        total += cycles;
+        maxCycles = (cycles > maxCycles) ? cycles : maxCycles;
+    }
+
+    heading = (double)G_OdometryPose.heading * 2 * M_PI / 4294967296.0;
+    headingError = remainder(heading - turn, 2 * M_PI);
+    posError = hypot(G_OdometryPose.x - x, G_OdometryPose.y - y);
+
+    Test_Check(posError <= TEST_ODOMETRY_POS_UM * (1 + travel / 1000000), "%s: ended at (%d, %d) um, expected (%.0f, %.0f)",
+               what, G_OdometryPose.x, G_OdometryPose.y, x, y);
+    Test_Check(fabs(headingError) <= TEST_ODOMETRY_HEADING, "%s: heading off by %.6f rad", what, headingError);
+    printf("[Test] odometry: %-8s %7.0f mm travelled, %6.1f turns, off by %5.2f mm and %8.6f rad, %5.1f cycles per update (max %u)\n",
+           what, travel / 1000, turn / (2 * M_PI), posError / 1000, headingError,
+           (double)total / TEST_ODOMETRY_UPDATES, maxCycles);
+}
+
+/*******************************************************************************
+* Test_Odometry() - Straight line, spin on the spot and constant arcs, in
+*                   both directions and around several turns so the heading
+*                   wraps.
+*******************************************************************************/
+static void Test_Odometry(void) {
+    Test_OdometryRun("straight", 7, 7);
+    Test_OdometryRun("reverse", -7, -7);
+    Test_OdometryRun("spin", -6, 6);
+    Test_OdometryRun("spin cw", 6, -6);
+    Test_OdometryRun("arc", 5, 9);
+    Test_OdometryRun("arc cw", 9, 5);
+    Test_OdometryRun("pivot", 0, 4);
+    Test_OdometryRun("crawl", 1, 1);
+}
+
+static const Test tests[] = {
+    {"protocol", Test_Protocol},
+    {"format", Test_Format},
+    {"queue", Test_Queue},
+    {"odometry", Test_Odometry},
+};
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Test_Run() - Run a test, or all of them.
+* Returns 0 if every check passed, otherwise 1.
+*******************************************************************************/
+int Test_Run(const char *name) {
+    uint8_t found = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if ((strcmp(name, "all") == 0) || (strcmp(name, tests[i].name) == 0)) {
+            unsigned long checksBefore = checks, failuresBefore = failures;
+
+            testName = tests[i].name;
+            tests[i].run();
+            printf("[Test] %s: %lu checks, %lu failed\n", testName,
+                   checks - checksBefore, failures - failuresBefore);
+            found = 1;
+        }
+    }
+
+    return (found && (failures == 0)) ? 0 : 1;
+}
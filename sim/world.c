@@ -0,0 +1,559 @@
+/*******************************************************************************
+* Name: world.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: The robot and its surroundings for the simulator. Reads the
+*              firmware's outputs from the registers (PWM duty, direction and
+*              stepper pins, trigger timer) and drives its inputs (encoder
+*              and echo timer inputs, limit switch pins, analog inputs).
+*
+* The robot is a differential drive in a rectangular arena with optional
+* round obstacles. Each wheel follows the voltage driven (duty cycle times
+* battery voltage) with a first order lag and produces an encoder edge every
+* UM_PER_VANE of travel. The ultrasonic sensor sits on the stepper, which has
+* a limit switch at either end. The motor current is the voltage driven less
+* the back EMF over the winding resistance and sags the battery through its
+* internal resistance. Both bridges return through one sense resistor, so the
+* current sense reads the sum of the motors that are on.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+
+#include "sim.h"
+#include "../src/Encoder.h"
+
+#define WORLD_STEP              SIM_US(1000)    // Motor and pose integration step
+#define WORLD_WHEEL_MAX_SPEED   60.0            // cm/s at 100% duty and WORLD_MOTOR_VOLTS
+#define WORLD_WHEEL_TAU         0.08            // s, motor time constant
+#define WORLD_WHEEL_BASE        15.0            // cm between the wheels
+#define WORLD_ROBOT_RADIUS      10.0            // cm
+#define WORLD_ARENA_WIDTH       400.0           // cm
+#define WORLD_ARENA_HEIGHT      300.0           // cm
+#define WORLD_MAX_OBSTACLES     16
+#define WORLD_SENSOR_OFFSET     8.0             // cm ahead of the axle
+#define WORLD_RANGE_MAX         400.0           // cm, no echo past this
+#define WORLD_US_PER_CM         58.0            // Echo pulse width per cm of range
+#define WORLD_ECHO_DELAY        SIM_US(250)     // End of trigger to start of echo (burst time)
+#define WORLD_NO_ECHO           SIM_US(38000)   // Echo pulse width when nothing is in range
+#define WORLD_LIMIT_HALF_STEPS  200             // Limit switches, half steps either side of centre
+#define WORLD_DEG_PER_HALF_STEP 0.45
+#define WORLD_BATTERY_MV        8000.0          // Open circuit
+#define WORLD_BATTERY_OHMS      0.2
+#define WORLD_MOTOR_VOLTS       7.2             // Wheels reach WORLD_WHEEL_MAX_SPEED at this voltage
+#define WORLD_MOTOR_OHMS        4.0
+#define WORLD_MOTOR_NO_LOAD     0.15            // A while turning
+#define WORLD_BATTERY_DIVIDER   3.0             // PA4 (ADC2_IN1)
+#define WORLD_SENSE_V_PER_A     0.5             // PC4 (ADC2_IN5)
+
+#define PI                      3.14159265358979323846
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    const char *name;
+    uint8_t fwdPin;             // GPIOC direction pins
+    uint8_t bwdPin;
+    uint8_t pwmChannel;         // TIM8 channel (complementary output)
+    uint8_t encoderInput;       // TIM2 input
+    double speed;               // cm/s, negative is backwards
+    double travel;              // um since the last vane
+    SimTime nextEdge;
+    unsigned long edges;
+    double duty;                // 0 to 1, 0 unless driven one way
+    double current;             // A while the PWM is on
+    uint8_t jammed;             // Held still
+} WorldWheel;
+
+typedef struct {
+    double x;
+    double y;
+    double radius;
+} WorldObstacle;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static WorldWheel wheels[2] = {
+    {"left",  12, 13, 1, 1, 0.0, 0.0, SIM_NEVER, 0, 0.0, 0.0, 0},
+    {"right",  8,  9, 2, 2, 0.0, 0.0, SIM_NEVER, 0, 0.0, 0.0, 0},
+};
+
+static WorldObstacle obstacles[WORLD_MAX_OBSTACLES];
+static uint8_t obstacleCount = 0;
+
+// Pose, cm and radians, heading 0 is along +x
+static double poseX = WORLD_ARENA_WIDTH / 2;
+static double poseY = WORLD_ARENA_HEIGHT / 2;
+static double poseTheta = 0.0;
+static unsigned long bumps = 0;
+
+static SimTime last = 0;                        // Time the pose was integrated to
+static SimTime nextStep = 0;
+
+// Ultrasonic sensor
+static SimTime echoRise = SIM_NEVER;
+static SimTime echoFall = SIM_NEVER;
+static double lastRange = 0.0;
+static unsigned long pings = 0;
+
+// Stepper
+static const uint8_t stepPatterns[8] = {0x8, 0xA, 0x2, 0x6, 0x4, 0x5, 0x1, 0x9};
+static int8_t stepIndex = -1;                   // Last pattern seen, -1 if none
+static int32_t stepPosition = 0;                // Half steps, clockwise is positive
+
+// Battery and current sense, V and A
+static double batteryOpen = WORLD_BATTERY_MV / 1000.0;
+static double batteryVolts = WORLD_BATTERY_MV / 1000.0;
+static double injectedCurrent = -1.0;           // Negative if the sense reads the motors
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* World_Blocked() - Check if the robot would hit a wall or obstacle at (x, y).
+*******************************************************************************/
+static uint8_t World_Blocked(double x, double y) {
+    if ((x < WORLD_ROBOT_RADIUS) || (x > WORLD_ARENA_WIDTH - WORLD_ROBOT_RADIUS)
+        || (y < WORLD_ROBOT_RADIUS) || (y > WORLD_ARENA_HEIGHT - WORLD_ROBOT_RADIUS)) {
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < obstacleCount; i++) {
+        if (hypot(x - obstacles[i].x, y - obstacles[i].y) < obstacles[i].radius + WORLD_ROBOT_RADIUS) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* World_Range() - Distance from the sensor to the nearest surface ahead of it.
+* Returns the range in cm.
+*******************************************************************************/
+static double World_Range(void) {
+    double angle = poseTheta - stepPosition * WORLD_DEG_PER_HALF_STEP * PI / 180.0;
+    double dx = cos(angle);
+    double dy = sin(angle);
+    double sx = poseX + WORLD_SENSOR_OFFSET * cos(poseTheta);
+    double sy = poseY + WORLD_SENSOR_OFFSET * sin(poseTheta);
+    double range = WORLD_RANGE_MAX + 1.0;
+
+    // Arena walls
+    if (dx > 0) {
+        range = fmin(range, (WORLD_ARENA_WIDTH - sx) / dx);
+    }
+    else if (dx < 0) {
+        range = fmin(range, -sx / dx);
+    }
+    if (dy > 0) {
+        range = fmin(range, (WORLD_ARENA_HEIGHT - sy) / dy);
+    }
+    else if (dy < 0) {
+        range = fmin(range, -sy / dy);
+    }
+
+    // Obstacles, nearest ray/circle intersection in front of the sensor
+    for (uint8_t i = 0; i < obstacleCount; i++) {
+        double ox = obstacles[i].x - sx;
+        double oy = obstacles[i].y - sy;
+        double along = ox * dx + oy * dy;
+        double miss = ox * ox + oy * oy - along * along;
+        double r2 = obstacles[i].radius * obstacles[i].radius;
+
+        if ((along > 0) && (miss < r2)) {
+            range = fmin(range, along - sqrt(r2 - miss));
+        }
+    }
+
+    return (range < 0) ? 0 : range;
+}
+
+/*******************************************************************************
+* World_Move() - Integrate wheel travel and pose from the last update to t.
+*******************************************************************************/
+static void World_Move(SimTime t) {
+    double dt = (double)(t - last) / SIM_CLOCK_HZ;
+    double v = (wheels[LEFT].speed + wheels[RIGHT].speed) / 2;
+    double w = (wheels[RIGHT].speed - wheels[LEFT].speed) / WORLD_WHEEL_BASE;
+    double x = poseX + v * cos(poseTheta) * dt;
+    double y = poseY + v * sin(poseTheta) * dt;
+
+    if (t <= last) {
+        return;
+    }
+
+    // Wheels keep turning against a wall, the robot just doesn't get anywhere
+    for (uint8_t i = 0; i < 2; i++) {
+        wheels[i].travel += fabs(wheels[i].speed) * dt * 1e4;
+    }
+
+    if (!World_Blocked(x, y)) {
+        poseX = x;
+        poseY = y;
+    }
+    else if (v != 0) {
+        bumps++;
+    }
+    poseTheta = fmod(poseTheta + w * dt, 2 * PI);
+    last = t;
+}
+
+/*******************************************************************************
+* World_Motors() - Move the wheel speeds toward the driven voltages, then work
+*                  out the motor currents and the battery voltage under load.
+*******************************************************************************/
+static void World_Motors(void) {
+    double alpha = 1.0 - exp(-(double)WORLD_STEP / SIM_CLOCK_HZ / WORLD_WHEEL_TAU);
+    uint8_t pwmOn = (TIM8->CR1 & TIM_CR1_CEN) && (TIM8->BDTR & TIM_BDTR_MOE);
+    double period = (double)TIM8->ARR + 1;
+    double drawn = 0.0;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        WorldWheel *wheel = &wheels[i];
+        uint8_t fwd = (GPIOC->ODR >> wheel->fwdPin) & 1;
+        uint8_t bwd = (GPIOC->ODR >> wheel->bwdPin) & 1;
+        uint32_t ccr = (wheel->pwmChannel == 1) ? TIM8->CCR1 : TIM8->CCR2;
+        double duty = pwmOn ? fmin(ccr / period, 1.0) : 0.0;
+        double volts = 0.0;
+        double emf;
+
+        // Both pins high brakes, same as both low
+        if (fwd && !bwd) {
+            volts = batteryVolts;
+        }
+        else if (bwd && !fwd) {
+            volts = -batteryVolts;
+        }
+        else {
+            duty = 0.0;
+        }
+
+        wheel->speed += (duty * volts / WORLD_MOTOR_VOLTS * WORLD_WHEEL_MAX_SPEED - wheel->speed) * alpha;
+        if ((fabs(wheel->speed) < 0.01) || wheel->jammed) {
+            wheel->speed = 0.0;
+        }
+
+        // Only the current while the PWM is on goes through the sense
+        // resistor, a wheel overrunning its voltage doesn't show up
+        emf = wheel->speed / WORLD_WHEEL_MAX_SPEED * WORLD_MOTOR_VOLTS;
+        wheel->duty = duty;
+        wheel->current = 0.0;
+        if (duty > 0.0) {
+            wheel->current = fmax(fabs(volts) - ((volts < 0) ? -emf : emf), 0.0) / WORLD_MOTOR_OHMS;
+            if (wheel->speed != 0.0) {
+                wheel->current += WORLD_MOTOR_NO_LOAD;
+            }
+        }
+        drawn += duty * wheel->current;
+    }
+
+    batteryVolts = fmax(batteryOpen - drawn * WORLD_BATTERY_OHMS, 0.0);
+}
+
+/*******************************************************************************
+* World_Stepper() - Follow the stepper coil pattern on PC0-PC3 and press the
+*                   limit switches (PC5 left, PC6 right, high when pressed).
+*******************************************************************************/
+static void World_Stepper(void) {
+    uint32_t odr = GPIOC->ODR;
+    uint8_t pattern = ((odr & 1) << 3) | (((odr >> 1) & 1) << 2) | (((odr >> 2) & 1) << 1) | ((odr >> 3) & 1);
+
+    for (int8_t i = 0; i < 8; i++) {
+        if (stepPatterns[i] != pattern) {
+            continue;
+        }
+
+        if (stepIndex >= 0) {
+            int8_t delta = (i - stepIndex + 8) % 8;
+
+            stepPosition += (delta <= 4) ? delta : delta - 8;
+        }
+        stepIndex = i;
+        break;
+    }
+
+    Periph_GpioInput(GPIOC, 5, stepPosition <= -WORLD_LIMIT_HALF_STEPS);
+    Periph_GpioInput(GPIOC, 6, stepPosition >= WORLD_LIMIT_HALF_STEPS);
+}
+
+/*******************************************************************************
+* World_Schedule() - Work out when each wheel reaches its next vane.
+*******************************************************************************/
+static void World_Schedule(SimTime t) {
+    for (uint8_t i = 0; i < 2; i++) {
+        WorldWheel *wheel = &wheels[i];
+        double umPerCycle = fabs(wheel->speed) * 1e4 / SIM_CLOCK_HZ;
+
+        if (umPerCycle <= 0) {
+            wheel->nextEdge = SIM_NEVER;
+        }
+        else {
+            double cycles = ceil((UM_PER_VANE - wheel->travel) / umPerCycle);
+
+            wheel->nextEdge = t + ((cycles < 1) ? 1 : (SimTime)cycles);
+        }
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* World_Init() - Start the robot in the middle of the arena facing +x.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void World_Init(void) {
+    last = 0;
+    nextStep = WORLD_STEP;
+}
+
+/*******************************************************************************
+* World_AddObstacle() - Put a round obstacle in the arena.
+* x, y      - Centre in cm.
+* radius    - Radius in cm.
+* Returns 1 if it was added.
+*******************************************************************************/
+uint8_t World_AddObstacle(double x, double y, double radius) {
+    if (obstacleCount >= WORLD_MAX_OBSTACLES) {
+        return 0;
+    }
+
+    obstacles[obstacleCount].x = x;
+    obstacles[obstacleCount].y = y;
+    obstacles[obstacleCount].radius = radius;
+    obstacleCount++;
+    return 1;
+}
+
+/*******************************************************************************
+* World_NextEvent() - Time of the next world event.
+* No inputs.
+* Returns the time.
+*******************************************************************************/
+SimTime World_NextEvent(void) {
+    SimTime next = nextStep;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (wheels[i].nextEdge < next) {
+            next = wheels[i].nextEdge;
+        }
+    }
+    if (echoRise < next) {
+        next = echoRise;
+    }
+    if (echoFall < next) {
+        next = echoFall;
+    }
+
+    return next;
+}
+
+/*******************************************************************************
+* World_Advance() - Bring the world up to time t. Called on every step so the
+*                   stepper pins are seen as soon as they change.
+* t         - New virtual time.
+* No return value.
+*******************************************************************************/
+void World_Advance(SimTime t) {
+    World_Move(t);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        WorldWheel *wheel = &wheels[i];
+
+        // One short pulse per vane, captured on the rising edge
+        if (wheel->nextEdge <= t) {
+            wheel->travel = 0.0;
+            wheel->edges++;
+            Periph_TimerInput(TIM2, wheel->encoderInput, 1);
+            Periph_TimerInput(TIM2, wheel->encoderInput, 0);
+        }
+    }
+
+    if (echoRise <= t) {
+        echoRise = SIM_NEVER;
+        Periph_TimerInput(TIM3, 2, 1);
+    }
+    if (echoFall <= t) {
+        echoFall = SIM_NEVER;
+        Periph_TimerInput(TIM3, 2, 0);
+    }
+
+    if (nextStep <= t) {
+        nextStep += WORLD_STEP;
+        World_Motors();
+    }
+
+    World_Stepper();
+    World_Schedule(t);
+}
+
+/*******************************************************************************
+* World_TimerUpdate() - A timer started a new period. For the trigger timer
+*                       this is the start of a trigger pulse.
+* regs      - Timer registers.
+* No return value.
+*******************************************************************************/
+void World_TimerUpdate(TIM_TypeDef *regs) {
+    SimTime pulse;
+
+    // The sensor ignores triggers while it is measuring
+    if ((regs != TIM16) || !(TIM16->CCER & TIM_CCER_CC1E) || (echoRise != SIM_NEVER) || (echoFall != SIM_NEVER)) {
+        return;
+    }
+
+    pulse = (SimTime)TIM16->CCR1 * ((SimTime)TIM16->PSC + 1);
+    lastRange = World_Range();
+    pings++;
+
+    echoRise = Sim_Now() + pulse + WORLD_ECHO_DELAY;
+    if (lastRange > WORLD_RANGE_MAX) {
+        echoFall = echoRise + WORLD_NO_ECHO;
+    }
+    else {
+        echoFall = echoRise + (SimTime)(lastRange * WORLD_US_PER_CM * SIM_CLOCK_HZ / 1e6);
+    }
+}
+
+/*******************************************************************************
+* World_AnalogInput() - Voltage on an ADC input. Only ADC2 is wired, to the
+*                       battery divider and the drive current sense.
+* regs      - ADC registers.
+* channel   - Input channel.
+* Returns the voltage in mV.
+*******************************************************************************/
+double World_AnalogInput(ADC_TypeDef *regs, uint8_t channel) {
+    double amps = 0.0;
+
+    if (regs != ADC2) {
+        return 0.0;
+    }
+
+    switch (channel) {
+        case 1:
+            return batteryVolts / WORLD_BATTERY_DIVIDER * 1000.0;
+
+        case 5:
+            // Sampled in the middle of the PWM pulses, both on unless one is off
+            if (injectedCurrent >= 0.0) {
+                amps = injectedCurrent;
+            }
+            else {
+                for (uint8_t i = 0; i < 2; i++) {
+                    amps += (wheels[i].duty > 0.0) ? wheels[i].current : 0.0;
+                }
+            }
+            return amps * WORLD_SENSE_V_PER_A * 1000.0;
+
+        default:
+            return 0.0;
+    }
+}
+
+/*******************************************************************************
+* World_SetBattery() - Change the battery's open circuit voltage.
+* mv        - Voltage in mV.
+* No return value.
+*******************************************************************************/
+void World_SetBattery(double mv) {
+    batteryOpen = fmax(mv, 0.0) / 1000.0;
+    batteryVolts = batteryOpen;
+}
+
+/*******************************************************************************
+* World_InjectCurrent() - Make the current sense read a fixed current, as a
+*                         short would.
+* ma        - Current in mA, negative to go back to the motor current.
+* No return value.
+*******************************************************************************/
+void World_InjectCurrent(double ma) {
+    injectedCurrent = (ma < 0.0) ? -1.0 : ma / 1000.0;
+}
+
+/*******************************************************************************
+* World_Jam() - Hold a wheel still, as if something were caught in it.
+* wheel     - LEFT or RIGHT, -1 to free both.
+* No return value.
+*******************************************************************************/
+void World_Jam(int8_t wheel) {
+    for (uint8_t i = 0; i < 2; i++) {
+        wheels[i].jammed = (wheel == i);
+    }
+}
+
+/*******************************************************************************
+* World_WheelSpeed() - True speed of a wheel, what the encoder estimates.
+* wheel     - LEFT or RIGHT.
+* Returns the speed in cm/s, negative is backwards.
+*******************************************************************************/
+double World_WheelSpeed(uint8_t wheel) {
+    return (wheel <= RIGHT) ? wheels[wheel].speed : 0.0;
+}
+
+/*******************************************************************************
+* World_WheelEdges() - Encoder edges a wheel has made.
+* wheel     - LEFT or RIGHT.
+* Returns the number of edges since reset.
+*******************************************************************************/
+unsigned long World_WheelEdges(uint8_t wheel) {
+    return (wheel <= RIGHT) ? wheels[wheel].edges : 0;
+}
+
+/*******************************************************************************
+* World_Battery() - Battery voltage under the load of the motors, what the
+*                   divider reads.
+* No inputs.
+* Returns the voltage in mV.
+*******************************************************************************/
+double World_Battery(void) {
+    return batteryVolts * 1000.0;
+}
+
+/*******************************************************************************
+* World_SetPose() - Put the robot somewhere else, as if it had been carried.
+* x, y      - Centre in cm.
+* heading   - Heading in degrees, 0 is along +x.
+* No return value.
+*******************************************************************************/
+void World_SetPose(double x, double y, double heading) {
+    poseX = x;
+    poseY = y;
+    poseTheta = heading * PI / 180.0;
+}
+
+/*******************************************************************************
+* World_ObstacleGap() - Distance from the sensor to the nearest obstacle, the
+*                       walls don't count.
+* No inputs.
+* Returns the distance in cm, WORLD_RANGE_MAX + 1 if there are no obstacles.
+*******************************************************************************/
+double World_ObstacleGap(void) {
+    double sx = poseX + WORLD_SENSOR_OFFSET * cos(poseTheta);
+    double sy = poseY + WORLD_SENSOR_OFFSET * sin(poseTheta);
+    double gap = WORLD_RANGE_MAX + 1.0;
+
+    for (uint8_t i = 0; i < obstacleCount; i++) {
+        gap = fmin(gap, hypot(obstacles[i].x - sx, obstacles[i].y - sy) - obstacles[i].radius);
+    }
+
+    return gap;
+}
+
+/*******************************************************************************
+* World_Print() - Print the final state of the world.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void World_Print(void) {
+    printf("[World] pose (%.1f, %.1f) cm, heading %.1f deg, %lu bumps\n",
+           poseX, poseY, poseTheta * 180.0 / PI, bumps);
+    for (uint8_t i = 0; i < 2; i++) {
+        printf("[World] %-5s wheel %.1f cm/s, %lu vanes, %.2fA%s\n", wheels[i].name, wheels[i].speed,
+               wheels[i].edges, wheels[i].current, wheels[i].jammed ? " (jammed)" : "");
+    }
+    printf("[World] battery %.2fV (%.2fV open circuit)\n", batteryVolts, batteryOpen);
+    printf("[World] stepper at %d half steps, servo pulse %uus, %lu pings (last %.0fcm)\n",
+           stepPosition, (unsigned)TIM15->CCR2, pings, lastRange);
+}
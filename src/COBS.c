@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Name: COBS.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Consistent overhead byte stuffing. Each block starts with a code
+*              byte giving the distance to the next zero, a code of 0xFF marks
+*              a full 254 byte block that is not followed by a zero.
+*******************************************************************************/
+
+#include "COBS.h"
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* COBS_Encode() - Consistent overhead byte stuffing encode.
+* src       - Data to encode.
+* len       - Length of src.
+* dst       - Encoded data (at least COBS_MAX_ENCODED(len) bytes). No delimiter.
+* Returns the encoded length.
+*******************************************************************************/
+uint16_t COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint16_t read = 0;
+    uint16_t write = 1;
+    uint16_t codeIndex = 0;
+    uint8_t code = 1;
+
+    while (read < len) {
+        if (src[read] == 0) {
+            dst[codeIndex] = code;
+            code = 1;
+            codeIndex = write++;
+            read++;
+        }
+        else {
+            dst[write++] = src[read++];
+            code++;
+
+            // Block is full, start a new one
+            if (code == 0xFF) {
+                dst[codeIndex] = code;
+                code = 1;
+                codeIndex = write++;
+            }
+        }
+    }
+    dst[codeIndex] = code;
+
+    return write;
+}
+
+/*******************************************************************************
+* COBS_Decode() - Consistent overhead byte stuffing decode.
+* src       - Encoded data without the delimiter.
+* len       - Length of src.
+* dst       - Decoded data (at least len bytes).
+* Returns the decoded length, or -1 if the data is not valid COBS.
+*******************************************************************************/
+int16_t COBS_Decode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint16_t read = 0;
+    uint16_t write = 0;
+
+    while (read < len) {
+        uint8_t code = src[read++];
+
+        if ((code == 0) || ((read + code - 1) > len)) {
+            return -1;
+        }
+
+        for (uint8_t i = 1; i < code; i++) {
+            dst[write++] = src[read++];
+        }
+
+        // A block shorter than 254 bytes stands for a zero, unless it is the last one
+        if ((code != 0xFF) && (read < len)) {
+            dst[write++] = 0;
+        }
+    }
+
+    return write;
+}
@@ -0,0 +1,21 @@
+/*******************************************************************************
+* Name: COBS.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Consistent overhead byte stuffing, removes every zero from a
+*              block of data so a zero can delimit frames. Only depends on
+*              standard C headers so it can be built on the host.
+*******************************************************************************/
+
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+
+// Worst case encoded length of len bytes, without the delimiter
+#define COBS_MAX_ENCODED(len)   ((len) + ((len) / 254) + 1)
+
+uint16_t COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+int16_t COBS_Decode(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+#endif
@@ -0,0 +1,308 @@
+/*******************************************************************************
+* Name: Collision.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Speed aware collision avoidance. The ultrasonic samples taken
+*              while the sensor looks ahead give the range to the nearest
+*              obstacle and how fast it is closing. Each control step the
+*              range is brought up to date with the distance closed since
+*              it was taken, at the closing speed (the measured forward
+*              speed of the robot, or the range rate if the obstacle is
+*              coming faster), and gives:
+*
+*              - the time to collision, range / closing speed.
+*              - the fastest the robot can go and still stop short of it,
+*                braking at the deceleration limit after the latency:
+*                v = sqrt((a*t)^2 + 2*a*d) - a*t, less the obstacle's own
+*                approach.
+*
+*              Forward wheel targets above that speed are scaled down
+*              (keeping the curvature) before they are profiled, so the
+*              robot slows continuously as it closes in and only brakes
+*              when it has to. Reversing and turning on the spot are never
+*              limited.
+*******************************************************************************/
+
+#include "Collision.h"
+#include "Ultrasonic.h"
+#include "Stepper.h"
+#include "Encoder.h"
+#include "Profile.h"
+#include "Timebase.h"
+#include "Log.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define COLLISION_HYSTERESIS    Q16(2.0)    // cm/s under the limit before braking is logged again
+#define COLLISION_PASS_US       (2 * ULTRA_MIN_CYCLE_MS * 1000UL)  // Sweeping readings further apart are another pass
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static q16_t collisionDecel = COLLISION_DECEL;
+static q16_t collisionLatency = COLLISION_LATENCY;
+static q16_t collisionMargin = COLLISION_MARGIN;
+
+static uint32_t collisionSeen = 0;      // Ultrasonic samples looked at
+static int16_t collisionPan = 0;        // Pan of the last sample looked at
+static uint32_t collisionPassTime = 0;  // Timebase (us) of the last sweeping sample ahead
+static uint8_t collisionValid = 0;      // A range ahead is known
+static q16_t collisionRange = 0;        // cm at collisionTime
+static uint32_t collisionTime = 0;      // Timebase (us) of the range
+static q16_t collisionClosed = 0;       // cm closed since the range
+static uint32_t collisionUpdateTime = 0;    // Timebase (us) of the last update
+static q16_t collisionRate = 0;         // cm/s, negative while closing
+static q16_t collisionLimit = COLLISION_NO_LIMIT;
+static q16_t collisionTTC = COLLISION_NO_TTC;
+static uint8_t collisionBraking = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Collision_Sqrt() - Integer square root.
+* x         - Value.
+* Returns floor(sqrt(x)).
+*******************************************************************************/
+static uint32_t Collision_Sqrt(uint64_t x) {
+    uint64_t bit = 1ULL << 62;
+    uint64_t root = 0;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+/*******************************************************************************
+* Collision_Sample() - Take in one ultrasonic sample if it looked ahead.
+* sample    - Ultrasonic sample.
+* No return value.
+*******************************************************************************/
+static void Collision_Sample(const UltraSample *sample) {
+    q16_t range, dt, rate;
+    uint8_t sweeping = (sample->pan != collisionPan);
+
+    collisionPan = sample->pan;
+    if ((sample->pan < -COLLISION_AHEAD_STEPS) || (sample->pan > COLLISION_AHEAD_STEPS)) {
+        return;
+    }
+
+    // While the sensor sweeps the median mixes bearings and the range changes
+    // with the bearing. Keep the nearest reading of each pass ahead and the
+    // rate from when the sensor was still.
+    if (sweeping) {
+        uint8_t newPass = (sample->time - collisionPassTime > COLLISION_PASS_US);
+
+        collisionPassTime = sample->time;
+        if (sample->status != ULTRA_OK) {
+            return;
+        }
+        range = Q16_FROM_INT(sample->echo / ULTRA_US_PER_CM);
+        if (!collisionValid || newPass || (range < collisionRange)) {
+            collisionRange = range;
+            collisionTime = sample->time;
+            collisionClosed = 0;
+            collisionValid = 1;
+        }
+        return;
+    }
+
+    if (sample->distance == ULTRA_NO_RANGE) {
+        collisionValid = 0;
+        return;
+    }
+
+    range = Q16_FROM_INT(sample->distance);
+    if (collisionValid && (sample->time - collisionTime < COLLISION_STALE_US)) {
+        // Average the rate over two samples, the ranges are whole cm
+        dt = TIMEBASE_US_TO_Q16_S(sample->time - collisionTime);
+        if (dt > 0) {
+            rate = (q16_t)(((int64_t)(range - collisionRange) << 16) / dt);
+            collisionRate += (rate - collisionRate) / 2;
+        }
+    }
+    else {
+        collisionRate = 0;
+    }
+
+    collisionRange = range;
+    collisionTime = sample->time;
+    collisionClosed = 0;
+    collisionValid = 1;
+}
+
+/*******************************************************************************
+* Collision_Forward() - Measured forward speed of the robot.
+* No inputs.
+* Returns the speed in cm/s, negative when reversing.
+*******************************************************************************/
+static q16_t Collision_Forward(void) {
+    q16_t left = (Profile_GetVelocity(LEFT) < 0) ? -G_EncoderSpeedQ16[LEFT] : G_EncoderSpeedQ16[LEFT];
+    q16_t right = (Profile_GetVelocity(RIGHT) < 0) ? -G_EncoderSpeedQ16[RIGHT] : G_EncoderSpeedQ16[RIGHT];
+
+    return (left + right) / 2;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Collision_Init() - Forget any obstacle and use the default limits.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Collision_Init(void) {
+    Collision_SetLimits(COLLISION_DECEL, COLLISION_LATENCY, COLLISION_MARGIN);
+    collisionSeen = Ultra_GetCount();
+    collisionValid = 0;
+    collisionRate = 0;
+    collisionLimit = COLLISION_NO_LIMIT;
+    collisionTTC = COLLISION_NO_TTC;
+    collisionBraking = 0;
+}
+
+/*******************************************************************************
+* Collision_SetLimits() - Set how the robot brakes for obstacles.
+* decel     - Deceleration limit, cm/s^2, must be above 0.
+* latency   - Time before braking starts, s.
+* margin    - Distance to stop short of an obstacle, cm.
+* No return value.
+*******************************************************************************/
+void Collision_SetLimits(q16_t decel, q16_t latency, q16_t margin) {
+    if (decel > 0) {
+        collisionDecel = decel;
+    }
+    collisionLatency = (latency > 0) ? latency : 0;
+    collisionMargin = (margin > 0) ? margin : 0;
+}
+
+/*******************************************************************************
+* Collision_Update() - Take in the new ultrasonic samples and work out the
+*                      time to collision and the forward speed limit. Call
+*                      from the control task after Encoder_Update() and
+*                      before Profile_Update().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Collision_Update(void) {
+    uint32_t count = Ultra_GetCount();
+    uint32_t now = Timebase_Us();
+    UltraSample sample;
+    q16_t forward, closing, approach, range, at, stop;
+    uint32_t age, since, ttcMs;
+    int64_t ttc;
+
+    // Anything the ring has already dropped is too old to matter
+    if (count - collisionSeen > ULTRA_RING_SIZE) {
+        collisionSeen = count - ULTRA_RING_SIZE;
+    }
+    for (; collisionSeen != count; collisionSeen++) {
+        if (Ultra_GetSample(collisionSeen, &sample)) {
+            Collision_Sample(&sample);
+        }
+    }
+
+    // Time to add to the distance closed, from the range if it is newer
+    since = ((int32_t)(collisionTime - collisionUpdateTime) > 0) ? (now - collisionTime) : (now - collisionUpdateTime);
+    collisionUpdateTime = now;
+
+    age = now - collisionTime;
+    if (collisionValid && (age > COLLISION_STALE_US)) {
+        collisionValid = 0;
+    }
+    if (!collisionValid) {
+        collisionLimit = COLLISION_NO_LIMIT;
+        collisionTTC = COLLISION_NO_TTC;
+        collisionBraking = 0;
+        return;
+    }
+
+    // Closing at the robot's speed, or faster if the obstacle is coming too
+    forward = Collision_Forward();
+    closing = (-collisionRate > forward) ? -collisionRate : forward;
+    approach = closing - forward;
+
+    // Bring the range up to date with the distance closed since, step by step
+    // as the speed changes (the range can be a whole sweep old while scanning)
+    if (closing > 0) {
+        collisionClosed += Q16_MUL(closing, TIMEBASE_US_TO_Q16_S(since));
+    }
+    range = collisionRange - collisionMargin - collisionClosed;
+    if (range < 0) {
+        range = 0;
+    }
+
+    // Crawling or spinning closes at next to nothing, as good as not closing
+    collisionTTC = COLLISION_NO_TTC;
+    if (closing > 0) {
+        ttc = ((int64_t)range << 16) / closing;
+        if (ttc < COLLISION_NO_TTC) {
+            collisionTTC = (q16_t)ttc;
+        }
+    }
+
+    // Fastest closing speed that stops within range, Q32 under the root
+    at = Q16_MUL(collisionDecel, collisionLatency);
+    stop = (q16_t)Collision_Sqrt((uint64_t)((int64_t)at * at + 2 * (int64_t)collisionDecel * range)) - at;
+    collisionLimit = (stop > approach) ? (stop - approach) : 0;
+
+    if (!collisionBraking && (forward > collisionLimit)) {
+        ttcMs = (uint32_t)(((int64_t)collisionTTC * 1000) >> 16);
+        LOG("collision: braking %ucm ahead, %ums to impact", Q16_TO_INT(collisionRange), ttcMs);
+    }
+    if (forward > collisionLimit) {
+        collisionBraking = 1;
+    }
+    else if (forward + COLLISION_HYSTERESIS < collisionLimit) {
+        collisionBraking = 0;
+    }
+}
+
+/*******************************************************************************
+* Collision_Limit() - Scale down forward wheel targets over the speed limit,
+*                     keeping the curvature.
+* left      - Left wheel target, cm/s.
+* right     - Right wheel target, cm/s.
+* No return value.
+*******************************************************************************/
+void Collision_Limit(q16_t *left, q16_t *right) {
+    q16_t forward = (*left + *right) / 2;
+
+    if ((forward <= 0) || (forward <= collisionLimit)) {
+        return;
+    }
+
+    *left = (q16_t)(((int64_t)*left * collisionLimit) / forward);
+    *right = (q16_t)(((int64_t)*right * collisionLimit) / forward);
+}
+
+/*******************************************************************************
+* Collision_GetSpeedLimit() - Get the forward speed limit.
+* No inputs.
+* Returns the limit in cm/s, COLLISION_NO_LIMIT if nothing is ahead.
+*******************************************************************************/
+q16_t Collision_GetSpeedLimit(void) {
+    return collisionLimit;
+}
+
+/*******************************************************************************
+* Collision_GetTTC() - Get the time to collision.
+* No inputs.
+* Returns the time in s, COLLISION_NO_TTC if nothing is closing.
+*******************************************************************************/
+q16_t Collision_GetTTC(void) {
+    return collisionTTC;
+}
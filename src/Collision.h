@@ -0,0 +1,38 @@
+/*******************************************************************************
+* Name: Collision.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Speed aware collision avoidance from the ultrasonic range
+*              ahead of the robot.
+*******************************************************************************/
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "PID.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define COLLISION_DECEL         Q16(100.0)  // cm/s^2, at most PROFILE_ACCEL so the profile can follow
+#define COLLISION_LATENCY       Q16(0.15)   // s, a range sample and the jerk limited start of braking
+#define COLLISION_MARGIN        Q16(8.0)    // cm, distance to stop short of an obstacle
+#define COLLISION_AHEAD_STEPS   22          // Half steps either side of centre the sensor looks ahead (~10 deg)
+#define COLLISION_STALE_US      2000000UL   // Forget a range this old, long enough to last a scan sweep
+#define COLLISION_NO_LIMIT      INT32_MAX   // Speed limit when nothing is ahead
+#define COLLISION_NO_TTC        INT32_MAX   // Time to collision when not closing
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Collision_Init(void);
+void Collision_SetLimits(q16_t decel, q16_t latency, q16_t margin);
+void Collision_Update(void);
+void Collision_Limit(q16_t *left, q16_t *right);
+q16_t Collision_GetSpeedLimit(void);
+q16_t Collision_GetTTC(void);
+
+#endif
@@ -6,6 +6,7 @@
 *******************************************************************************/
 
 #include "DCMotor.h"
+#include "Timebase.h"
 
 // Drive Motor Configuration Parameters
 // - Motor Speed Control Pins:
@@ -28,10 +29,115 @@
 uint8_t G_DCMotorLeftDir = DCMOTOR_STOP;
 uint8_t G_DCMotorRightDir = DCMOTOR_STOP;
 
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define DCMOTOR_DEAD_TIME_US    5000UL      // Both inputs low before a new direction
+
+#define DCMOTOR_STATE_RUN       0           // Inputs match the applied direction
+#define DCMOTOR_STATE_DEAD_TIME 1           // Inputs low and PWM held at 0
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    uint32_t pinA;              // Forward input (ODR bit)
+    uint32_t pinB;              // Reverse input (ODR bit)
+    volatile uint32_t *ccr;     // PWM compare register
+    volatile uint8_t state;     // DCMOTOR_STATE_x, read by DCMotor_SetPWM() from the control task
+    uint8_t dir;                // Direction on the inputs
+    uint8_t target;             // Direction to apply after the dead time
+    volatile uint16_t pwm;      // Last requested PWM, applied after the dead time
+    uint32_t requestUs;         // When the current target was requested
+    uint32_t deadline;          // End of the dead time (Timebase us)
+    uint16_t reversalUs;        // Request to new direction of the last reversal
+    uint8_t cutoff;             // PWM held at 0 by DCMotor_Cutoff()
+} DCMotorChannel;
+
 /*******************************************************************************
 *                           LOCAL VARIABLES                                    *
 *******************************************************************************/
-static uint8_t DCMotorLastDir[2] = {DCMOTOR_STOP, DCMOTOR_STOP};
+static DCMotorChannel DCMotors[2] = {
+    {GPIO_ODR_12, GPIO_ODR_13, &TIM8->CCR1, DCMOTOR_STATE_RUN, DCMOTOR_STOP, DCMOTOR_STOP, 0, 0, 0, 0, 0},
+    {GPIO_ODR_8,  GPIO_ODR_9,  &TIM8->CCR2, DCMOTOR_STATE_RUN, DCMOTOR_STOP, DCMOTOR_STOP, 0, 0, 0, 0, 0},
+};
+
+static uint32_t dcMotorScale = DCMOTOR_SCALE_ONE;  // Battery compensation, Q16
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* DCMotor_SamplePoint() - Move the ADC trigger (CH4) to the middle of the
+*                         shorter of the two PWM pulses. Both pulses start at
+*                         the update event, so both motors are on there. With
+*                         both motors off it is the middle of the period.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void DCMotor_SamplePoint(void) {
+    uint32_t shortest = DCMOTOR_PERIOD_US;
+
+    for (uint8_t motor = DCMOTOR_LEFT; motor <= DCMOTOR_RIGHT; motor++) {
+        uint32_t onTime = *DCMotors[motor].ccr & 0xFFFFUL;
+
+        if ((onTime != 0) && (onTime < shortest)) {
+            shortest = onTime;
+        }
+    }
+
+    // Never 0, OC4REF would stay high and not trigger
+    FORCE_BITS(TIM8->CCR4, 0xFFFFUL, (shortest + 1) / 2);
+}
+
+/*******************************************************************************
+* DCMotor_Output() - Write a motor's PWM compare register: the requested
+*                    ON-time times the battery compensation, 0 during the
+*                    reversal dead time or while cut off.
+* motor     - Motor channel.
+* No return value.
+*******************************************************************************/
+static void DCMotor_Output(DCMotorChannel *motor) {
+    uint32_t onTime = 0;
+
+    if ((motor->state == DCMOTOR_STATE_RUN) && !motor->cutoff) {
+        onTime = ((uint32_t)motor->pwm * dcMotorScale + DCMOTOR_SCALE_ONE / 2) >> 16;
+        if (onTime > DCMOTOR_PERIOD_US) {
+            onTime = DCMOTOR_PERIOD_US;
+        }
+    }
+
+    FORCE_BITS(*motor->ccr, 0xFFFFUL, onTime);
+    DCMotor_SamplePoint();
+}
+
+/*******************************************************************************
+* DCMotor_Apply() - Drive the inputs for the target direction and restore the
+*                   requested PWM.
+* motor     - Motor channel.
+* No return value.
+*******************************************************************************/
+static void DCMotor_Apply(DCMotorChannel *motor) {
+    // - Direction Control Truth Table
+    //     STOP   FWD   RWD   UNDEFINED
+    // (A)  0      1     0      1
+    // (B)  0      0     1      1
+    if (motor->target == DCMOTOR_FWD) {
+        CLEAR_BITS(GPIOC->ODR, motor->pinB);
+        SET_BITS(GPIOC->ODR, motor->pinA);
+    }
+    else if (motor->target == DCMOTOR_BWD) {
+        CLEAR_BITS(GPIOC->ODR, motor->pinA);
+        SET_BITS(GPIOC->ODR, motor->pinB);
+    }
+    else {
+        CLEAR_BITS(GPIOC->ODR, motor->pinA | motor->pinB);
+    }
+
+    motor->dir = motor->target;
+    motor->state = DCMOTOR_STATE_RUN;
+    DCMotor_Output(motor);
+}
 
 /*******************************************************************************
 *                               PUBLIC FUNCTIONS                               *
@@ -95,7 +201,7 @@ void DCMotor_Init(void){
         // (Prescaler + 1) = 72
         // Prescaler = 71
     CLEAR_BITS(TIM8->CR1, TIM_CR1_DIR);             // Set TIM8 counting direction to upcounting
-    FORCE_BITS(TIM8->ARR, 0xFFFFUL, 999UL);         // Set ARR to 999us
+    FORCE_BITS(TIM8->ARR, 0xFFFFUL, DCMOTOR_PERIOD_US - 1);     // Set ARR to 999us
         // ARR = Repeating Counter Period - 1
         // ARR = 1000us - 1
         // ARR = 999us
@@ -119,83 +225,114 @@ void DCMotor_Init(void){
     CLEAR_BITS(TIM8->CCR1, TIM_CCR1_CCR1);                                          // Set the CH2N initial PWM ON-time to 0us
 
 
+    // Configure CH4 of TIM8 (no output) as the ADC trigger, TRGO follows OC4REF
+    // which rises at CCR4, the middle of the PWM pulses (see Power.c)
+    FORCE_BITS(TIM8->CCMR2, TIM_CCMR2_OC4M_Msk, 0x7UL << TIM_CCMR2_OC4M_Pos);       // Set TIM8 CH4 to PWM mode 2
+    SET_BITS(TIM8->CCMR2, TIM_CCMR2_OC4PE);                                         // Enable output compare preload on channel 4
+    FORCE_BITS(TIM8->CCR4, 0xFFFFUL, DCMOTOR_PERIOD_US / 2);                        // Middle of the period until a motor runs
+    FORCE_BITS(TIM8->CR2, TIM_CR2_MMS, 0x7UL << TIM_CR2_MMS_Pos);                   // Set TRGO to OC4REF
+
+
     // Start TIM8 CH1N and CH2N Outputs
     SET_BITS(TIM8->EGR, TIM_EGR_UG);                // Force an update event to preload all the registers
     SET_BITS(TIM8->CR1, TIM_CR1_CEN);               // Enable TIM8 to start counting
 }
 
 /*******************************************************************************
-* DCMotor_SetDir()  - Sets the direction of a DC motor.
+* DCMotor_SetDir()  - Request a new direction for a DC motor. Changing between
+*                     forward and backward first drives both inputs low with
+*                     the PWM at 0 for the dead time, DCMotor_Update() finishes
+*                     the change. Returns straight away.
 * motor             - The motor to set the direction of.
 * dir               - The direction the DC motor should spin.
 * No return value.
 *******************************************************************************/
 void DCMotor_SetDir(uint8_t motor, uint8_t dir){
-    // - Motor Direction Control Pins:
-    //  Left Motor Forward (A)  PC12
-    //  Left Motor Reverse (B)  PC13
-    //  Right Motor Forward (A) PC8
-    //  Right Motor Reverse (B) PC9
-    // - Direction Control Truth Table
-    //     STOP   FWD   RWD   UNDEFINED
-    // (A)  0      1     0      1
-    // (B)  0      0     1      1
+    DCMotorChannel *channel;
 
-    // POSSIBLE INPUTS
-    // motor:   0 - left
-    //          1 - right
-    //
-    // dir:     0 - stop
-    //          1 - forward
-    //          2 - backwards
-
-    // Left motor
-    if((motor == DCMOTOR_LEFT) && (DCMotorLastDir[LEFT] != dir)){
-        // Left motor stop
-        CLEAR_BITS(GPIOC->ODR, GPIO_ODR_12);
-        CLEAR_BITS(GPIOC->ODR, GPIO_ODR_13);
-        Delay_ms(5);
-
-        // Left motor fwd
-        if(dir == DCMOTOR_FWD){
-            SET_BITS(GPIOC->ODR, GPIO_ODR_12);
-            CLEAR_BITS(GPIOC->ODR, GPIO_ODR_13);
-        }
-        // Left motor bwd
-        else if(dir == DCMOTOR_BWD){
-            CLEAR_BITS(GPIOC->ODR, GPIO_ODR_12);
-            SET_BITS(GPIOC->ODR, GPIO_ODR_13);
-        }
-        DCMotorLastDir[LEFT] = dir;
+    if ((motor > DCMOTOR_RIGHT) || (dir > DCMOTOR_BWD)) {
+        return;
     }
-    // Right motor
-    else if ((motor == DCMOTOR_RIGHT) && (DCMotorLastDir[RIGHT] != dir)){
-        // Right motor stop
-        CLEAR_BITS(GPIOC->ODR, GPIO_ODR_8);
-        CLEAR_BITS(GPIOC->ODR, GPIO_ODR_9);
-        Delay_ms(5);
-
-        // Right motor fwd
-        if(dir == DCMOTOR_FWD){
-            SET_BITS(GPIOC->ODR, GPIO_ODR_8);
-            CLEAR_BITS(GPIOC->ODR, GPIO_ODR_9);
-        }
-        // Right motor bwd
-        else if(dir == DCMOTOR_BWD){
-            CLEAR_BITS(GPIOC->ODR, GPIO_ODR_8);
-            SET_BITS(GPIOC->ODR, GPIO_ODR_9);
-        }
-        DCMotorLastDir[RIGHT] = dir;
+
+    channel = &DCMotors[motor];
+    if (dir == channel->target) {
+        return;
+    }
+
+    channel->target = dir;
+    channel->requestUs = Timebase_Us();
+
+    // Already waiting, the new target is applied when the dead time ends
+    if (channel->state == DCMOTOR_STATE_DEAD_TIME) {
+        return;
     }
+
+    // Starting or stopping can't short the bridge, reversing needs the dead time
+    if ((channel->dir == DCMOTOR_STOP) || (dir == DCMOTOR_STOP)) {
+        DCMotor_Apply(channel);
+        return;
+    }
+
+    channel->state = DCMOTOR_STATE_DEAD_TIME;
+    DCMotor_Output(channel);
+    CLEAR_BITS(GPIOC->ODR, channel->pinA | channel->pinB);
+    channel->dir = DCMOTOR_STOP;
+    channel->deadline = Timebase_DeadlineUs(DCMOTOR_DEAD_TIME_US);
 }
 
+/*******************************************************************************
+* DCMotor_SetDirs() - Request new directions for both DC motors.
+* leftDir           - Left motor direction.
+* rightDir          - Right motor direction.
+* No return value.
+*******************************************************************************/
 void DCMotor_SetDirs(uint8_t leftDir, uint8_t rightDir) {
     DCMotor_SetDir(DCMOTOR_LEFT, leftDir);
     DCMotor_SetDir(DCMOTOR_RIGHT, rightDir);
 }
 
 /*******************************************************************************
-* DCMotor_SetPWM()  - Sets the pwm for a DC motor.
+* DCMotor_Update() - Finish direction changes whose dead time has passed. Call
+*                    every scheduler tick or so, the dead time is extended by
+*                    up to the call period.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void DCMotor_Update(void) {
+    for (uint8_t motor = DCMOTOR_LEFT; motor <= DCMOTOR_RIGHT; motor++) {
+        DCMotorChannel *channel = &DCMotors[motor];
+
+        if ((channel->state == DCMOTOR_STATE_DEAD_TIME) && Timebase_ExpiredUs(channel->deadline)) {
+            uint32_t latency = Timebase_Us() - channel->requestUs;
+
+            DCMotor_Apply(channel);
+            channel->reversalUs = (latency > 0xFFFF) ? 0xFFFF : latency;
+        }
+    }
+}
+
+/*******************************************************************************
+* DCMotor_GetReversalUs() - Time from the last reversal request to the new
+*                           direction being driven, including the dead time.
+* motor             - The motor to check.
+* Returns the latency in us, saturated to 0xFFFF.
+*******************************************************************************/
+uint16_t DCMotor_GetReversalUs(uint8_t motor) {
+    return (motor <= DCMOTOR_RIGHT) ? DCMotors[motor].reversalUs : 0;
+}
+
+/*******************************************************************************
+* DCMotor_GetDir()  - Direction currently driven on a motor's inputs.
+* motor             - The motor to check.
+* Returns DCMOTOR_x, DCMOTOR_STOP during the reversal dead time.
+*******************************************************************************/
+uint8_t DCMotor_GetDir(uint8_t motor) {
+    return (motor <= DCMOTOR_RIGHT) ? DCMotors[motor].dir : DCMOTOR_STOP;
+}
+
+/*******************************************************************************
+* DCMotor_SetPWM()  - Sets the pwm for a DC motor. The duty cycle applied is
+*                     scaled for the battery voltage (DCMotor_SetScale()).
 * motor             - The motor to set the pwm for.
 * dutyCycle         - The desired % of duty cycle for ON-time.
 * No return value.
@@ -205,15 +342,55 @@ void DCMotor_SetPWM(uint8_t motor, uint16_t pwm) {
         pwm = MAX_DUTY_CYCLE;
     }
 
+    if (motor > DCMOTOR_RIGHT) {
+        return;
+    }
+
     // Convert to ms ON-time
     pwm *= 10;        // dutyCycle = (pwm * 1000) / 100
 
-    if(motor == DCMOTOR_LEFT){
-        FORCE_BITS(TIM8->CCR1, 0xFFFFUL, pwm);
-    }
-    else if(motor == DCMOTOR_RIGHT){
-        FORCE_BITS(TIM8->CCR2, 0xFFFFUL, pwm);
+    // Held at 0 until a direction change is finished
+    DCMotors[motor].pwm = pwm;
+    DCMotor_Output(&DCMotors[motor]);
+}
+
+/*******************************************************************************
+* DCMotor_GetPWM()  - Duty cycle last requested for a DC motor, before the
+*                     battery compensation.
+* motor             - The motor to check.
+* Returns the % duty cycle.
+*******************************************************************************/
+uint16_t DCMotor_GetPWM(uint8_t motor) {
+    return (motor <= DCMOTOR_RIGHT) ? DCMotors[motor].pwm / 10 : 0;
+}
+
+/*******************************************************************************
+* DCMotor_SetScale() - Set the factor every requested duty cycle is multiplied
+*                      by, so the motors see the same average voltage as the
+*                      battery sags. Applied to both motors straight away.
+* scale             - Q16 factor, DCMOTOR_SCALE_ONE for none.
+* No return value.
+*******************************************************************************/
+void DCMotor_SetScale(uint32_t scale) {
+    dcMotorScale = scale;
+    DCMotor_Output(&DCMotors[DCMOTOR_LEFT]);
+    DCMotor_Output(&DCMotors[DCMOTOR_RIGHT]);
+}
+
+/*******************************************************************************
+* DCMotor_Cutoff()  - Hold a motor's PWM at 0 whatever is requested, or
+*                     release it. The direction inputs are left alone.
+* motor             - The motor to cut off.
+* cutoff            - 1 to cut off, 0 to release.
+* No return value.
+*******************************************************************************/
+void DCMotor_Cutoff(uint8_t motor, uint8_t cutoff) {
+    if (motor > DCMOTOR_RIGHT) {
+        return;
     }
+
+    DCMotors[motor].cutoff = cutoff;
+    DCMotor_Output(&DCMotors[motor]);
 }
 
 /*******************************************************************************
@@ -20,6 +20,9 @@
 #define MAX_DUTY_CYCLE  100
 #define MIN_DUTY_CYCLE  0
 
+#define DCMOTOR_PERIOD_US   1000UL      // TIM8 PWM period, 1kHz
+#define DCMOTOR_SCALE_ONE   (1UL << 16) // Duty cycle scale of 1, Q16
+
 #define DCMOTOR_SPEED_MAX   40
 #define DCMOTOR_SPEED_MIN   0
 #define DCMOTOR_SPEED_BASE  20
@@ -31,7 +34,13 @@ extern uint8_t G_DCMotorRightDir;
 
 void DCMotor_SetDir(uint8_t motor, uint8_t dir);
 void DCMotor_SetDirs(uint8_t leftDir, uint8_t rightDir);
+void DCMotor_Update(void);
+uint16_t DCMotor_GetReversalUs(uint8_t motor);
+uint8_t DCMotor_GetDir(uint8_t motor);
 void DCMotor_SetPWM(uint8_t motor, uint16_t pwm);
+uint16_t DCMotor_GetPWM(uint8_t motor);
+void DCMotor_SetScale(uint32_t scale);
+void DCMotor_Cutoff(uint8_t motor, uint8_t cutoff);
 
 void DCMotor_Init(void);
 void DCMotor_SetMotor(uint8_t motor, uint8_t dir, uint16_t pwm);
@@ -2,26 +2,161 @@
 * Name: Encoder.c (implementation)
 * Author(s): Noah Grant, Wyatt Richard
 * Date: April 14, 2023
-* Description: Encoder functions for mobile robot.
+* Description: Encoder functions for mobile robot. TIM2 runs free at its full
+*              32-bit width in us and captures every vane edge. The ISR only
+*              pushes the raw capture into a per-wheel ring, Encoder_Update()
+*              turns the newest edges into speeds from the control task.
+*
+*              Speeds use the M/T method: the M edges that arrived since the
+*              last update over the time T from the edge before them to the
+*              newest one. Fast wheels average every edge of the control
+*              period, slow ones measure the whole time between their edges
+*              however many periods that takes. With no new edge the wheel
+*              has moved less than a vane since the newest one, so the speed
+*              can't be more than a vane over that time and decays toward
+*              zero as it grows, reaching it at the stall timeout.
 *******************************************************************************/
 
 #include "Encoder.h"
 
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define ENCODER_RING_SIZE   64          // Must be a power of 2, holds > 1 control period of edges
+#define ENCODER_RING_MASK   (ENCODER_RING_SIZE - 1)
+#define ENCODER_IC_FILTER   0xFUL       // ICxF: fDTS/32, N=8, ignores pulses under ~3.6us
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    volatile uint32_t stamps[ENCODER_RING_SIZE];    // TIM2 capture (us) of each edge
+    volatile uint32_t head;     // Edges pushed, only written by the ISR
+    uint32_t tail;              // Edges seen by Encoder_Update()
+    uint32_t valid;             // Newest edges since the wheel was last stopped
+    uint32_t last;              // Capture of the newest edge at the last estimate
+    int32_t speed;              // Last estimate, cm/s in Q16.16
+    int8_t sign;                // Direction the wheel was last driven, +1 or -1
+} EncoderRing;
+
 /*******************************************************************************
 *                               GLOBAL VARIABLES                               *
 *******************************************************************************/
 volatile uint32_t G_EncoderPeriod[2] = {0, 0};     // [0] = left, [1] = right
 volatile uint32_t G_leftEncoderSpeed = 0;
 volatile uint32_t G_rightEncoderSpeed = 0;
+volatile int32_t G_EncoderSpeedQ16[2] = {0, 0};    // cm/s in Q16.16
+volatile int32_t G_EncoderTicks[2] = {0, 0};       // Signed vane count, forward is positive
+volatile EncoderStats G_EncoderStats = {0, 0, 0};
+
 int G_leftEncoderSetpoint = DCMOTOR_SPEED_BASE;
 int G_rightEncoderSetpoint = DCMOTOR_SPEED_BASE;
 
 /*******************************************************************************
 *                               LOCAL VARIABLES                                *
 *******************************************************************************/
-static volatile uint32_t leftEncoder[2] = {0, 0};       // [0] = current, [1] = previous
-static volatile uint32_t rightEncoder[2] = {0, 0};      // [0] = current, [1] = previous
-static volatile uint8_t overFlowCounter[2] = {0, 0};           // [0] = left, [1] = right
+static EncoderRing encoderRings[2];     // [0] = left, [1] = right
+static uint32_t encoderStallUs = ENCODER_STALL_US;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Encoder_Count() - Add the new edges of one wheel to its signed tick count.
+*                   The encoder can't tell direction, so the edges take the
+*                   sign of the direction on the motor inputs. A stopped wheel
+*                   (or one in the reversal dead time) keeps the last sign
+*                   while it coasts down.
+* ring      - Wheel edge ring.
+* head      - Edges pushed so far.
+* dir       - Driven direction, DCMOTOR_x.
+* ticks     - Signed tick count to add to.
+* No return value.
+*******************************************************************************/
+static void Encoder_Count(EncoderRing *ring, uint32_t head, uint8_t dir, volatile int32_t *ticks) {
+    if (dir == DCMOTOR_FWD) {
+        ring->sign = 1;
+    }
+    else if (dir == DCMOTOR_BWD) {
+        ring->sign = -1;
+    }
+
+    *ticks += (ring->sign < 0) ? -(int32_t)(head - ring->tail) : (int32_t)(head - ring->tail);
+}
+
+/*******************************************************************************
+* Encoder_Speed() - Speed of a wheel that travelled some vanes in some time.
+* vanes     - Vanes travelled, at most ENCODER_RING_SIZE.
+* us        - Time taken, not 0.
+* Returns the speed in cm/s, Q16.16.
+*******************************************************************************/
+static int32_t Encoder_Speed(uint32_t vanes, uint32_t us) {
+    // um/us = m/s -> *100 = cm/s, divided in Q8 so the numerator fits 32 bits
+    return (int32_t)(((vanes * UM_PER_VANE * 100) << 8) / us) << 8;
+}
+
+/*******************************************************************************
+* Encoder_Estimate() - Estimate the speed of one wheel from its new edges
+*                      (M/T method), or decay the last estimate without any.
+* ring      - Wheel edge ring.
+* head      - Edges pushed so far.
+* now       - TIM2 count (us).
+* period    - Average us between edges, 0 when stopped.
+* Returns the speed in cm/s, Q16.16.
+*******************************************************************************/
+static int32_t Encoder_Estimate(EncoderRing *ring, uint32_t head, uint32_t now, volatile uint32_t *period) {
+    uint32_t edges = head - ring->tail;
+    uint32_t newest, first, span, bound;
+
+    // The ISR only writes ahead of head, so the newest edges can be read
+    // while it runs unless it laps the whole ring
+    ring->valid += edges;
+    if (ring->valid > ENCODER_RING_SIZE) {
+        ring->valid = ENCODER_RING_SIZE;
+    }
+    ring->tail = head;
+
+    newest = ring->stamps[(head - 1) & ENCODER_RING_MASK];
+    if ((ring->valid == 0) || (now - newest > encoderStallUs)) {
+        // Start over so the gap isn't measured when it moves again
+        ring->valid = 0;
+        ring->speed = 0;
+        *period = 0;
+        return 0;
+    }
+
+    if (edges > 0) {
+        if (edges >= ring->valid) {
+            // The first edge after a stop (or the oldest one left if the
+            // ring was lapped) only starts the clock
+            edges = ring->valid - 1;
+            first = ring->stamps[(head - 1 - edges) & ENCODER_RING_MASK];
+        }
+        else {
+            first = ring->last;
+        }
+        ring->last = newest;
+
+        span = newest - first;
+        if ((edges == 0) || (span == 0)) {
+            return ring->speed;
+        }
+        ring->speed = Encoder_Speed(edges, span);
+        *period = span / edges;
+        return ring->speed;
+    }
+
+    // Less than a vane since the newest edge
+    span = now - newest;
+    if (span > 0) {
+        bound = Encoder_Speed(1, span);
+        if (ring->speed > (int32_t)bound) {
+            ring->speed = (int32_t)bound;
+        }
+    }
+
+    return ring->speed;
+}
 
 /*******************************************************************************
 *                               PUBLIC FUNCTIONS                               *
@@ -35,7 +170,6 @@ void Encoder_Init(void){
     // PA0 for Input Capture on Left Wheel
     // PA1 for Input Capture on Right Wheel
 
-
     // Configure GPIOA P0 and P1
     ENABLE_GPIO_CLOCK(A);                           // Enable GPIO Port A
     GPIO_MODER_SET(A, 0, GPIO_MODE_AF);
@@ -45,40 +179,36 @@ void Encoder_Init(void){
     GPIO_AFR_SET(A, 0, 1);                          // TIM2 CH1
     GPIO_AFR_SET(A, 1, 1);                          // TIM2 CH2
 
-
     // Configure TIM2 for Both CH1 and CH2 inputs
     SET_BITS(RCC->APB1ENR, RCC_APB1ENR_TIM2EN);     // Enable TIM2 on APB1
-    SET_BITS(TIM2->PSC, 71UL);                      // Set prescaler to count in 1us
+    FORCE_BITS(TIM2->PSC, 0xFFFFUL, 71UL);          // Set prescaler to count in 1us
         // Timer Period = (Prescaler + 1) / SystemClockFreq
         // 1us = (Prescaler + 1) / 72MHz
         // (Prescaler + 1) = 72
         // Prescaler = 71
-    SET_BITS(TIM2->ARR, 0xFFFFUL);
-
+    TIM2->ARR = 0xFFFFFFFFUL;                       // Run free over the full 32 bits (~71 minutes)
     CLEAR_BITS(TIM2->CR1, TIM_CR1_DIR);             // Set counting direction to upcounting
-    CLEAR_BITS(TIM2->CR1, TIM_CR1_URS);             // Enable update
-    CLEAR_BITS(TIM2->CR1, TIM_CR1_UDIS);            // Set update request source
+    CLEAR_BITS(TIM2->CR1, TIM_CR1_CKD);             // fDTS = fCK_INT for the input filters
 
     // Configure TIM2 CH1 for input capture on Left Encoder
     SET_BITS(TIM2->CCMR1, TIM_CCMR1_CC1S_0);                        // Input capture mode for CH1 (normal mode  0%01)
+    FORCE_BITS(TIM2->CCMR1, TIM_CCMR1_IC1F, ENCODER_IC_FILTER << TIM_CCMR1_IC1F_Pos);   // Filter out glitches
     SET_BITS(TIM2->CCER, TIM_CCER_CC1E);                            // ENABLE_GPIO_CLOCK input capture for CH1
-    CLEAR_BITS(TIM2->CCER, TIM_CCER_CC1P & TIM_CCER_CC1NP);         // Detect rising edges (by clearing both input capture mode bits)
-    CLEAR_BITS(TIM2->CCR1, TIM_CCR1_CCR1);                          // Clear garbage values from CCR1
-
+    CLEAR_BITS(TIM2->CCER, TIM_CCER_CC1P | TIM_CCER_CC1NP);         // Detect rising edges (by clearing both input capture mode bits)
 
     // Configure TIM2 CH2 for input capture on Right Encoder
     SET_BITS(TIM2->CCMR1, TIM_CCMR1_CC2S_0);                        // Input capture mode for CH2 (normal mode  0%01)
+    FORCE_BITS(TIM2->CCMR1, TIM_CCMR1_IC2F, ENCODER_IC_FILTER << TIM_CCMR1_IC2F_Pos);   // Filter out glitches
     SET_BITS(TIM2->CCER, TIM_CCER_CC2E);                            // ENABLE_GPIO_CLOCK input capture for CH2
-    CLEAR_BITS(TIM2->CCER, TIM_CCER_CC2P & TIM_CCER_CC2NP);         // Detect rising edges (by clearing both input capture mode bits)
-    CLEAR_BITS(TIM2->CCR2, TIM_CCR2_CCR2);                          // Clear garbage values from CCR2
-
+    CLEAR_BITS(TIM2->CCER, TIM_CCER_CC2P | TIM_CCER_CC2NP);         // Detect rising edges (by clearing both input capture mode bits)
 
-    // Configure TIM2 to generate interrupts and configure NVIC to respond
+    // Configure TIM2 to generate interrupts on captures only, a 32-bit count
+    // doesn't need overflow counting
     SET_BITS(TIM2->DIER, TIM_DIER_CC1IE);                           // Enable encoder CH1 to trigger IRQ
     SET_BITS(TIM2->DIER, TIM_DIER_CC2IE);                           // Enable encoder CH2 to trigger IRQ
-    SET_BITS(TIM2->DIER, TIM_DIER_UIE);                             // Enable timer overflow to trigger IRQ
-    NVIC_EnableIRQ(TIM2_IRQn);                                // Enable TIM2 IRQ (TIM2_IRQn) in NVIC
-    NVIC_SetPriority(TIM2_IRQn, ENCODER_PRIORITY);     // Set NVIC priority
+    CLEAR_BITS(TIM2->DIER, TIM_DIER_UIE);
+    NVIC_EnableIRQ(TIM2_IRQn);                                      // Enable TIM2 IRQ (TIM2_IRQn) in NVIC
+    NVIC_SetPriority(TIM2_IRQn, ENCODER_PRIORITY);                  // Set NVIC priority
 
     // Start TIM2 CH1 and CH2 Input Captures
     SET_BITS(TIM2->EGR, TIM_EGR_UG);                                // Force an update event to preload all the registers
@@ -86,34 +216,66 @@ void Encoder_Init(void){
 }
 
 /*******************************************************************************
-* Encoder_IRQHandler() - Interrupt handler for encoders.
+* Encoder_SetStallTimeout() - Set how long a wheel can go without an edge
+*                             before it is stopped. It can't measure anything
+*                             slower than one vane per timeout.
+* us        - Stall timeout, us.
+* No return value.
+*******************************************************************************/
+void Encoder_SetStallTimeout(uint32_t us) {
+    encoderStallUs = (us > 0) ? us : ENCODER_STALL_US;
+}
+
+/*******************************************************************************
+* Encoder_Update() - Count the captured edges and estimate the wheel speeds.
+*                    Call from the control task.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Encoder_Update(void) {
+    uint32_t leftHead = encoderRings[LEFT].head;
+    uint32_t rightHead = encoderRings[RIGHT].head;
+    uint32_t now = TIM2->CNT;
+
+    Encoder_Count(&encoderRings[LEFT], leftHead, DCMotor_GetDir(DCMOTOR_LEFT), &G_EncoderTicks[LEFT]);
+    Encoder_Count(&encoderRings[RIGHT], rightHead, DCMotor_GetDir(DCMOTOR_RIGHT), &G_EncoderTicks[RIGHT]);
+
+    G_EncoderSpeedQ16[LEFT] = Encoder_Estimate(&encoderRings[LEFT], leftHead, now, &G_EncoderPeriod[LEFT]);
+    G_EncoderSpeedQ16[RIGHT] = Encoder_Estimate(&encoderRings[RIGHT], rightHead, now, &G_EncoderPeriod[RIGHT]);
+    G_leftEncoderSpeed = G_EncoderSpeedQ16[LEFT] >> 16;
+    G_rightEncoderSpeed = G_EncoderSpeedQ16[RIGHT] >> 16;
+}
+
+/*******************************************************************************
+* Encoder_IRQHandler() - Interrupt handler for encoders. Reading CCRx clears
+*                        its flag.
 * No inputs.
 * No return value.
 *******************************************************************************/
 void TIM2_IRQHandler(void){
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles;
+
     // Left wheel interrupt
-    if(IS_BIT_SET(TIM2->SR, TIM_SR_CC1IF)) {
-        leftEncoder[1] = leftEncoder[0];        // Timer count (us) at last interrupt
-        leftEncoder[0] = TIM2->CCR1;            // Timer count (us) at current interrupt
-        G_EncoderPeriod[LEFT] = leftEncoder[0] - leftEncoder[1] + (overFlowCounter[LEFT] * MAX_TIME_US);
-        G_leftEncoderSpeed = (UM_PER_VANE * 100) / G_EncoderPeriod[LEFT]; // um/us = m/s -> *100 = cm/s
-        overFlowCounter[0] = 0;                 // left overflow counter
+    if (IS_BIT_SET(TIM2->SR, TIM_SR_CC1IF)) {
+        EncoderRing *ring = &encoderRings[LEFT];
+
+        ring->stamps[ring->head & ENCODER_RING_MASK] = TIM2->CCR1;
+        ring->head++;
     }
 
     // Right wheel interrupt
-    if(IS_BIT_SET(TIM2->SR, TIM_SR_CC2IF)){
-        rightEncoder[1] = rightEncoder[0];
-        rightEncoder[0] = TIM2->CCR2;
-        G_EncoderPeriod[RIGHT] = rightEncoder[0] - rightEncoder[1] + (overFlowCounter[RIGHT] * MAX_TIME_US);
-        G_rightEncoderSpeed = (UM_PER_VANE * 100) / G_EncoderPeriod[RIGHT]; // um/us = m/s -> *100 = cm/s 
-        overFlowCounter[1] = 0;       // right overflow counter
+    if (IS_BIT_SET(TIM2->SR, TIM_SR_CC2IF)) {
+        EncoderRing *ring = &encoderRings[RIGHT];
+
+        ring->stamps[ring->head & ENCODER_RING_MASK] = TIM2->CCR2;
+        ring->head++;
     }
 
-    // Timer overflow
-    if(IS_BIT_SET(TIM2->SR, TIM_SR_UIF)){
-        overFlowCounter[0]++;       // left overflow counter
-        overFlowCounter[1]++;       // right overflow counter
-        CLEAR_BITS(TIM2->SR, TIM_SR_UIF);
+    cycles = DWT->CYCCNT - start;
+    G_EncoderStats.isrCount++;
+    G_EncoderStats.isrLastCycles = cycles;
+    if (cycles > G_EncoderStats.isrMaxCycles) {
+        G_EncoderStats.isrMaxCycles = cycles;
     }
 }
-
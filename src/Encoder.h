@@ -13,15 +13,25 @@
 #include "DCMotor.h"
 
 #define ENCODER_PRIORITY    9
-#define MAX_TIME_US         65536   // 2^16 us
 #define UM_PER_VANE         274     // um/encoder vane 
+#define ENCODER_STALL_US    200000UL    // Default stall timeout, 0.14cm/s is the slowest speed
+
+typedef struct {
+    uint32_t isrCount;
+    uint32_t isrLastCycles;     // TIM2 ISR execution time, entry to exit
+    uint32_t isrMaxCycles;
+} EncoderStats;
 
 void Encoder_Init(void);
-void Encoder_CalculateSpeed(void);
+void Encoder_SetStallTimeout(uint32_t us);
+void Encoder_Update(void);
 
+extern volatile EncoderStats G_EncoderStats;
 extern volatile uint32_t G_EncoderPeriod[2];
+extern volatile int32_t G_EncoderTicks[2];
 extern volatile uint32_t G_leftEncoderSpeed;
 extern volatile uint32_t G_rightEncoderSpeed;
+extern volatile int32_t G_EncoderSpeedQ16[2];
 extern int G_leftEncoderSetpoint;
 extern int G_rightEncoderSetpoint;
 
@@ -0,0 +1,353 @@
+/*******************************************************************************
+* Name: Format.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Integer-only printf style formatter. Literal text is passed to
+*              the write function in runs straight from the format string and
+*              numbers are converted in a small digit buffer, so there is no
+*              line buffer and no heap use. Safe to call from an ISR as long as
+*              the write function is.
+*******************************************************************************/
+
+#include "Format.h"
+
+/*******************************************************************************
+*                        LOCAL CONSTANTS AND VARIABLES                         *
+*******************************************************************************/
+
+#define FORMAT_LEFT     0x01    // '-' flag, pad on the right
+#define FORMAT_ZERO     0x02    // '0' flag, pad numbers with zeros
+#define FORMAT_DIGITS   24      // Longest number: sign, 10 integer digits, point and decimals
+
+#define FORMAT_PAD_LEN  8
+static const char spaces[FORMAT_PAD_LEN] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+static const char zeros[FORMAT_PAD_LEN] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+
+static const char hexLower[16] = "0123456789abcdef";
+static const char hexUpper[16] = "0123456789ABCDEF";
+
+static const uint32_t pow10[FORMAT_Q_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Format_Pad() - Write padding characters.
+* write     - Output function.
+* ctx       - Output function context.
+* pad       - spaces or zeros.
+* count     - Number of characters.
+* No return value.
+*******************************************************************************/
+static void Format_Pad(Format_Write write, void *ctx, const char *pad, int16_t count) {
+    while (count > 0) {
+        uint16_t len = (count > FORMAT_PAD_LEN) ? FORMAT_PAD_LEN : count;
+
+        write(ctx, pad, len);
+        count -= len;
+    }
+}
+
+/*******************************************************************************
+* Format_Digits() - Convert an unsigned number to digits, least significant
+*                   digit last.
+* value     - Number to convert.
+* base      - 10 or 16.
+* digits    - Digit characters for the base.
+* end       - One past the last character of the digit buffer.
+* Returns a pointer to the first digit.
+*******************************************************************************/
+static char *Format_Digits(uint32_t value, uint8_t base, const char *digits, char *end) {
+    do {
+        *--end = digits[value % base];
+        value /= base;
+    } while (value != 0);
+
+    return end;
+}
+
+/*******************************************************************************
+* Format_Fixed() - Convert a fixed-point number to digits, rounded to the
+*                  requested number of decimals.
+* value     - Magnitude of the number.
+* bits      - Number of fractional bits (0 to 31).
+* decimals  - Number of decimals (0 to FORMAT_Q_MAX_DECIMALS).
+* end       - One past the last character of the digit buffer.
+* Returns a pointer to the first digit.
+*******************************************************************************/
+static char *Format_Fixed(uint32_t value, uint8_t bits, uint8_t decimals, char *end) {
+    uint32_t whole = (bits < 32) ? (value >> bits) : 0;
+    uint32_t frac = value & ((1UL << bits) - 1);
+    uint32_t scaled = 0;
+
+    if (bits != 0) {
+        scaled = (uint32_t)((((uint64_t)frac * pow10[decimals]) + (1ULL << (bits - 1))) >> bits);
+    }
+
+    // Rounding carried into the integer part
+    if (scaled >= pow10[decimals]) {
+        scaled -= pow10[decimals];
+        whole++;
+    }
+
+    if (decimals != 0) {
+        for (uint8_t i = 0; i < decimals; i++) {
+            *--end = '0' + (scaled % 10);
+            scaled /= 10;
+        }
+        *--end = '.';
+    }
+
+    return Format_Digits(whole, 10, hexLower, end);
+}
+
+/*******************************************************************************
+* Format_Field() - Write a field padded to its width.
+* write     - Output function.
+* ctx       - Output function context.
+* sign      - Sign character, or 0 for none.
+* str       - Field text.
+* len       - Length of str.
+* width     - Minimum field width.
+* flags     - FORMAT_LEFT, FORMAT_ZERO.
+* Returns the number of characters written.
+*******************************************************************************/
+static uint16_t Format_Field(Format_Write write, void *ctx, char sign, const char *str,
+                             uint16_t len, int16_t width, uint8_t flags) {
+    int16_t pad = width - len - (sign ? 1 : 0);
+
+    if (pad < 0) {
+        pad = 0;
+    }
+
+    if (flags & FORMAT_LEFT) {
+        if (sign) {
+            write(ctx, &sign, 1);
+        }
+        write(ctx, str, len);
+        Format_Pad(write, ctx, spaces, pad);
+    }
+    else if (flags & FORMAT_ZERO) {
+        // Zeros go between the sign and the digits
+        if (sign) {
+            write(ctx, &sign, 1);
+        }
+        Format_Pad(write, ctx, zeros, pad);
+        write(ctx, str, len);
+    }
+    else {
+        Format_Pad(write, ctx, spaces, pad);
+        if (sign) {
+            write(ctx, &sign, 1);
+        }
+        write(ctx, str, len);
+    }
+
+    return len + pad + (sign ? 1 : 0);
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Format_vprintf() - Format a string (see Format.h for the conversions).
+* write     - Output function.
+* ctx       - Output function context.
+* fmt       - Format string.
+* args      - Format arguments.
+* Returns the number of characters written.
+*******************************************************************************/
+uint16_t Format_vprintf(Format_Write write, void *ctx, const char *fmt, va_list args) {
+    char digits[FORMAT_DIGITS];
+    char *end = digits + FORMAT_DIGITS;
+    uint16_t count = 0;
+
+    while (*fmt != '\0') {
+        const char *run = fmt;
+        uint8_t flags = 0;
+        int16_t width = 0;
+        int16_t precision = -1;
+        uint8_t isLong = 0;
+        char sign = 0;
+        char *str;
+
+        // Literal text up to the next conversion
+        while ((*fmt != '\0') && (*fmt != '%')) {
+            fmt++;
+        }
+        if (fmt != run) {
+            write(ctx, run, fmt - run);
+            count += fmt - run;
+        }
+        if (*fmt == '\0') {
+            break;
+        }
+        run = fmt++;
+
+        // Flags
+        for (;; fmt++) {
+            if (*fmt == '-') {
+                flags |= FORMAT_LEFT;
+            }
+            else if (*fmt == '0') {
+                flags |= FORMAT_ZERO;
+            }
+            else {
+                break;
+            }
+        }
+
+        // Width
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= FORMAT_LEFT;
+                width = -width;
+            }
+            fmt++;
+        }
+        while ((*fmt >= '0') && (*fmt <= '9')) {
+            width = width * 10 + (*fmt++ - '0');
+        }
+
+        // Precision
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(args, int);
+                fmt++;
+            }
+            while ((*fmt >= '0') && (*fmt <= '9')) {
+                precision = precision * 10 + (*fmt++ - '0');
+            }
+        }
+
+        // int and long are both 32 bits on the robot, but not on the host
+        if (*fmt == 'l') {
+            isLong = 1;
+            fmt++;
+        }
+
+        switch (*fmt) {
+            case 'd':
+            case 'i': {
+                int32_t value = isLong ? (int32_t)va_arg(args, long) : va_arg(args, int);
+                uint32_t magnitude = (uint32_t)value;
+
+                if (value < 0) {
+                    sign = '-';
+                    magnitude = -magnitude;
+                }
+                str = Format_Digits(magnitude, 10, hexLower, end);
+                count += Format_Field(write, ctx, sign, str, end - str, width, flags);
+                break;
+            }
+
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint32_t value = isLong ? (uint32_t)va_arg(args, unsigned long) : va_arg(args, unsigned int);
+
+                if (*fmt == 'u') {
+                    str = Format_Digits(value, 10, hexLower, end);
+                }
+                else {
+                    str = Format_Digits(value, 16, (*fmt == 'x') ? hexLower : hexUpper, end);
+                }
+                count += Format_Field(write, ctx, 0, str, end - str, width, flags);
+                break;
+            }
+
+            case 'q': {
+                int32_t value = isLong ? (int32_t)va_arg(args, long) : va_arg(args, int);
+                uint32_t magnitude = (uint32_t)value;
+                uint8_t bits = 0;
+
+                // Optional number of fractional bits
+                if ((fmt[1] >= '0') && (fmt[1] <= '9')) {
+                    while ((fmt[1] >= '0') && (fmt[1] <= '9')) {
+                        bits = bits * 10 + (*++fmt - '0');
+                    }
+                }
+                else {
+                    bits = FORMAT_Q_BITS;
+                }
+                if (bits > 31) {
+                    bits = 31;
+                }
+
+                if (precision < 0) {
+                    precision = FORMAT_Q_DECIMALS;
+                }
+                else if (precision > FORMAT_Q_MAX_DECIMALS) {
+                    precision = FORMAT_Q_MAX_DECIMALS;
+                }
+
+                if (value < 0) {
+                    sign = '-';
+                    magnitude = -magnitude;
+                }
+                str = Format_Fixed(magnitude, bits, precision, end);
+                count += Format_Field(write, ctx, sign, str, end - str, width, flags);
+                break;
+            }
+
+            case 'c': {
+                char c = (char)va_arg(args, int);
+
+                count += Format_Field(write, ctx, 0, &c, 1, width, flags & FORMAT_LEFT);
+                break;
+            }
+
+            case 's': {
+                const char *s = va_arg(args, const char *);
+                uint16_t len = 0;
+
+                if (s == 0) {
+                    s = "(null)";
+                }
+                while ((s[len] != '\0') && ((precision < 0) || (len < precision))) {
+                    len++;
+                }
+                count += Format_Field(write, ctx, 0, s, len, width, flags & FORMAT_LEFT);
+                break;
+            }
+
+            case '%':
+                write(ctx, fmt, 1);
+                count++;
+                break;
+
+            default:
+                // Unknown conversion, print it as is
+                if (*fmt == '\0') {
+                    fmt--;
+                }
+                write(ctx, run, fmt - run + 1);
+                count += fmt - run + 1;
+                break;
+        }
+        fmt++;
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+* Format_printf() - Format a string (see Format.h for the conversions).
+* write     - Output function.
+* ctx       - Output function context.
+* fmt       - Format string.
+* Returns the number of characters written.
+*******************************************************************************/
+uint16_t Format_printf(Format_Write write, void *ctx, const char *fmt, ...) {
+    va_list args;
+    uint16_t count;
+
+    va_start(args, fmt);
+    count = Format_vprintf(write, ctx, fmt, args);
+    va_end(args);
+
+    return count;
+}
@@ -0,0 +1,38 @@
+/*******************************************************************************
+* Name: Format.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Integer-only printf style formatter. Output goes straight to a
+*              write function instead of a line buffer, so it does not allocate
+*              and its run time only depends on the length of the output.
+*              Only depends on standard C headers so it can be built on the host.
+*
+* Conversions: %[-][0][width|*][.precision|.*][l]conversion
+*   %d %i   signed decimal
+*   %u      unsigned decimal
+*   %x %X   unsigned hexadecimal
+*   %c      character
+*   %s      string (precision limits the number of characters)
+*   %q      signed fixed-point (int32_t). Precision is the number of decimals
+*           (default 3) and optional digits after the q give the number of
+*           fractional bits (default 16), e.g. %.2q8 prints a Q24.8 value
+*   %%      percent sign
+*******************************************************************************/
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#define FORMAT_Q_BITS           16      // Default %q fractional bits (Q16.16)
+#define FORMAT_Q_DECIMALS       3       // Default %q decimals
+#define FORMAT_Q_MAX_DECIMALS   6
+
+// Output function, called with each run of formatted characters
+typedef void (*Format_Write)(void *ctx, const char *data, uint16_t len);
+
+uint16_t Format_vprintf(Format_Write write, void *ctx, const char *fmt, va_list args);
+uint16_t Format_printf(Format_Write write, void *ctx, const char *fmt, ...);
+
+#endif
@@ -0,0 +1,133 @@
+/*******************************************************************************
+* Name: Kinematics.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Differential drive kinematics. A (v, w) command gives the wheel
+*              velocities v -/+ w * track / 2. When the faster wheel would
+*              pass DCMOTOR_SPEED_MAX both are scaled down together, which
+*              keeps the ratio between them and so the curvature of the arc.
+*              The wheel targets stay in Q16.16 so slow arcs keep their shape.
+*
+*              The direction and speed globals the one character commands
+*              use are still the wheel targets unless a velocity command is
+*              in control. Velocity commands update them (rounded) so the
+*              telemetry and the speed up/down commands carry on from there.
+*              Any other wheel command takes control back.
+*******************************************************************************/
+
+#include "Kinematics.h"
+#include "Odometry.h"
+#include "Timebase.h"
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint8_t kinematicsActive = 0;
+static q16_t kinematicsTargets[2] = {0, 0};     // cm/s, negative is backwards
+static uint32_t kinematicsDeadline = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Kinematics_SetCommand() - Mirror a wheel target in the command globals.
+* dir       - Wheel direction to set.
+* setpoint  - Wheel speed setpoint to set.
+* target    - Wheel velocity, cm/s.
+* No return value.
+*******************************************************************************/
+static void Kinematics_SetCommand(uint8_t *dir, int *setpoint, q16_t target) {
+    int speed = Q16_TO_INT(Q16_ABS(target));
+
+    if (target == 0) {
+        *dir = DCMOTOR_STOP;
+        return;                 // Keep the last setpoint, like the drive command
+    }
+
+    *dir = (target > 0) ? DCMOTOR_FWD : DCMOTOR_BWD;
+    *setpoint = (speed > 0) ? speed : 1;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Kinematics_SetVelocity() - Drive at a linear and angular velocity. Has to be
+*                            repeated within KINEMATICS_TIMEOUT_MS.
+* linear    - cm/s, negative is backwards.
+* angular   - rad/s, counter-clockwise is positive.
+* No return value.
+*******************************************************************************/
+void Kinematics_SetVelocity(q16_t linear, q16_t angular) {
+    // w * track / 2 in cm/s, the track is in um
+    q16_t turn = (q16_t)(((int64_t)angular * ODOMETRY_TRACK_UM) / 20000);
+    q16_t left = linear - turn;
+    q16_t right = linear + turn;
+    q16_t fastest = (Q16_ABS(left) > Q16_ABS(right)) ? Q16_ABS(left) : Q16_ABS(right);
+
+    // Saturate both wheels by the same factor to keep the curvature
+    if (fastest > Q16_FROM_INT(DCMOTOR_SPEED_MAX)) {
+        left = (q16_t)(((int64_t)left * Q16_FROM_INT(DCMOTOR_SPEED_MAX)) / fastest);
+        right = (q16_t)(((int64_t)right * Q16_FROM_INT(DCMOTOR_SPEED_MAX)) / fastest);
+    }
+
+    kinematicsTargets[LEFT] = left;
+    kinematicsTargets[RIGHT] = right;
+    kinematicsDeadline = Timebase_DeadlineMs(KINEMATICS_TIMEOUT_MS);
+    kinematicsActive = 1;
+
+    Kinematics_SetCommand(&G_DCMotorLeftDir, &G_leftEncoderSetpoint, left);
+    Kinematics_SetCommand(&G_DCMotorRightDir, &G_rightEncoderSetpoint, right);
+}
+
+/*******************************************************************************
+* Kinematics_Release() - Hand the wheels back to the direction and speed
+*                        commands.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Kinematics_Release(void) {
+    kinematicsActive = 0;
+}
+
+/*******************************************************************************
+* Kinematics_Update() - Stop the robot if the velocity commands have stopped.
+*                       Call from the control task before Profile_Update().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Kinematics_Update(void) {
+    if (kinematicsActive && Timebase_ExpiredMs(kinematicsDeadline)) {
+        Kinematics_SetVelocity(0, 0);
+        kinematicsActive = 0;
+    }
+}
+
+/*******************************************************************************
+* Kinematics_GetTarget() - Get the target velocity of a wheel.
+* wheel     - LEFT or RIGHT.
+* Returns the velocity in cm/s, negative is backwards.
+*******************************************************************************/
+q16_t Kinematics_GetTarget(uint8_t wheel) {
+    uint8_t dir;
+    int setpoint;
+
+    if (wheel > RIGHT) {
+        return 0;
+    }
+
+    if (kinematicsActive) {
+        return kinematicsTargets[wheel];
+    }
+
+    dir = (wheel == LEFT) ? G_DCMotorLeftDir : G_DCMotorRightDir;
+    setpoint = (wheel == LEFT) ? G_leftEncoderSetpoint : G_rightEncoderSetpoint;
+    if (dir == DCMOTOR_FWD) {
+        return Q16_FROM_INT(setpoint);
+    }
+    else if (dir == DCMOTOR_BWD) {
+        return -Q16_FROM_INT(setpoint);
+    }
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+/*******************************************************************************
+* Name: Kinematics.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Differential drive kinematics, linear and angular velocity
+*              commands to wheel velocity targets.
+*******************************************************************************/
+
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "PID.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define KINEMATICS_TIMEOUT_MS   500     // Stop if velocity commands stop arriving
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Kinematics_SetVelocity(q16_t linear, q16_t angular);
+void Kinematics_Release(void);
+void Kinematics_Update(void);
+q16_t Kinematics_GetTarget(uint8_t wheel);
+
+#endif
@@ -5,9 +5,9 @@
 * Description: LCD functions for mobile robot.
 *******************************************************************************/
 
-#include <stdio.h>
 #include <stdarg.h>
 #include "LCD.h"
+#include "Format.h"
 #include "Utility.h"
 
 
@@ -38,6 +38,21 @@ static void LCD_GPIO_Init(void){
 }
 
 
+/*******************************************************************************
+* LCD_FormatWrite() - Formatter output function, sends the formatted text.
+* ctx       - Unused.
+* data      - Formatted characters.
+* len       - Number of characters.
+* No return value.
+*******************************************************************************/
+static void LCD_FormatWrite(void *ctx, const char *data, uint16_t len){
+    (void)ctx;
+    while(len--){
+        LCD_putc(*data++);
+    }
+}
+
+
 /*******************************************************************************
 *                                               PUBLIC FUNCTIONS               	*
 *******************************************************************************/
@@ -216,12 +231,10 @@ void LCD_puts(char* str){
 *******************************************************************************/
 void LCD_printf(char* str, ... ){
     va_list args;
-    char buffer[MAX_LCD_BUFSIZE];
 
     va_start(args, str);
-    (void)vsnprintf(buffer, MAX_LCD_BUFSIZE, str, args);
+    (void)Format_vprintf(LCD_FormatWrite, 0, str, args);
     va_end(args);
-    LCD_puts(buffer);
 }
 
 /*******************************************************************************
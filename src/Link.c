@@ -0,0 +1,276 @@
+/*******************************************************************************
+* Name: Link.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link baud rate negotiation and status reporting. See
+*              Messages.h for the handshake.
+*******************************************************************************/
+
+#include "Link.h"
+#include "Log.h"
+#include "Timebase.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define LINK_MAX_BAUD           1000000     // USART3 runs from the 72MHz SYSCLK
+#define LINK_MIN_BAUD           LINK_DEFAULT_BAUD
+#define LINK_TEST_TIMEOUT       1000        // ms to receive the verification burst
+#define LINK_COMMIT_TIMEOUT     1000        // ms to receive the commit
+#define LINK_WATCHDOG_ERRORS    16          // Receive errors without a valid frame before falling back
+
+#define LINK_IDLE               0
+#define LINK_SWITCH             1           // Waiting for the ack to be sent
+#define LINK_TEST               2           // Receiving the verification burst
+#define LINK_COMMIT             3           // Waiting for the host to commit
+#define LINK_REVERT             4           // Waiting for the result to be sent
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint8_t linkState = LINK_IDLE;
+static uint32_t linkBaud = LINK_DEFAULT_BAUD;       // Last committed baud rate
+static uint32_t linkTestBaud = LINK_DEFAULT_BAUD;   // Baud rate being tested
+static uint32_t linkDeadline = 0;                   // Timebase ms
+static uint16_t linkGood = 0;
+static uint16_t linkBad = 0;
+static uint32_t linkErrorSnapshot = 0;              // Error count when the test started
+
+static uint32_t watchdogFrames = 0;
+static uint32_t watchdogErrors = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Link_ErrorCount() - Total receive errors seen by the protocol and the UART.
+* No inputs.
+* Returns the error count.
+*******************************************************************************/
+static uint32_t Link_ErrorCount(void) {
+    return G_ProtocolStats.rxCrcErrors + G_ProtocolStats.rxFramingErrors
+         + G_USART3.rxErrors.overrun + G_USART3.rxErrors.framing + G_USART3.rxErrors.noise
+         + G_USART3.rxErrors.overflow;
+}
+
+/*******************************************************************************
+* Link_FinishTest() - Report the verification burst result.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Link_FinishTest(void) {
+    MsgBaudResult result;
+    uint32_t errors = linkBad + (Link_ErrorCount() - linkErrorSnapshot);
+
+    result.baud = linkTestBaud;
+    result.good = linkGood;
+    result.errors = (errors > 0xFFFF) ? 0xFFFF : errors;
+    result.pass = ((linkGood >= LINK_TEST_FRAMES - LINK_TEST_MAX_ERRORS)
+                && (errors <= LINK_TEST_MAX_ERRORS)) ? 1 : 0;
+    Protocol_Send(MSG_BAUD_RESULT, &result, sizeof(result));
+
+    if (result.pass) {
+        linkDeadline = Timebase_DeadlineMs(LINK_COMMIT_TIMEOUT);
+        linkState = LINK_COMMIT;
+    }
+    else {
+        linkState = LINK_REVERT;
+    }
+}
+
+/*******************************************************************************
+* Link_TestFrame() - Check a verification burst frame.
+* frame     - Received MSG_BAUD_TEST frame.
+* No return value.
+*******************************************************************************/
+static void Link_TestFrame(const ProtocolFrame *frame) {
+    const MsgBaudTest *test = (const MsgBaudTest *)frame->payload;
+    uint8_t i;
+
+    if (frame->len != sizeof(MsgBaudTest)) {
+        linkBad++;
+        return;
+    }
+
+    for (i = 0; i < LINK_TEST_LEN; i++) {
+        if (test->pattern[i] != LINK_TEST_BYTE(test->seq, i)) {
+            break;
+        }
+    }
+
+    if (i == LINK_TEST_LEN) {
+        linkGood++;
+    }
+    else {
+        linkBad++;
+    }
+
+    if (linkGood + linkBad >= LINK_TEST_FRAMES) {
+        Link_FinishTest();
+    }
+}
+
+/*******************************************************************************
+* Link_Watchdog() - Fall back to the default baud rate if only errors are
+*                   received, e.g. because the host fell back on its own.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Link_Watchdog(void) {
+    uint32_t errors = Link_ErrorCount();
+
+    if (G_ProtocolStats.rxFrames != watchdogFrames) {
+        watchdogFrames = G_ProtocolStats.rxFrames;
+        watchdogErrors = errors;
+    }
+    else if ((errors - watchdogErrors) >= LINK_WATCHDOG_ERRORS) {
+        watchdogErrors = errors;
+
+        if (linkBaud != LINK_DEFAULT_BAUD) {
+            LOG("link: only errors received at %u baud, falling back", linkBaud);
+            linkBaud = LINK_DEFAULT_BAUD;
+            UART_SetBaud(&G_USART3, linkBaud);
+        }
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Link_Update() - Run the negotiation state machine. Call periodically.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Link_Update(void) {
+    switch (linkState) {
+        case LINK_IDLE: {
+            Link_Watchdog();
+            break;
+        }
+        case LINK_SWITCH: {
+            // Switch once the ack has left at the old rate
+            if (UART_TxIdle(&G_USART3)) {
+                UART_SetBaud(&G_USART3, linkTestBaud);
+                linkGood = 0;
+                linkBad = 0;
+                linkErrorSnapshot = Link_ErrorCount();
+                linkDeadline = Timebase_DeadlineMs(LINK_TEST_TIMEOUT);
+                linkState = LINK_TEST;
+            }
+            break;
+        }
+        case LINK_TEST: {
+            if (Timebase_ExpiredMs(linkDeadline)) {
+                Link_FinishTest();
+            }
+            break;
+        }
+        case LINK_COMMIT: {
+            if (Timebase_ExpiredMs(linkDeadline)) {
+                linkState = LINK_REVERT;
+            }
+            break;
+        }
+        case LINK_REVERT: {
+            // Fall back once the result has left at the tested rate
+            if (UART_TxIdle(&G_USART3)) {
+                UART_SetBaud(&G_USART3, linkBaud);
+                linkState = LINK_IDLE;
+            }
+            break;
+        }
+        default: {
+            linkState = LINK_IDLE;
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+* Link_Receive() - Handle a link message.
+* frame     - Received frame.
+* Returns 1 if the frame was a link message, otherwise 0.
+*******************************************************************************/
+uint8_t Link_Receive(const ProtocolFrame *frame) {
+    switch (frame->type) {
+        case MSG_BAUD_PROPOSE: {
+            MsgBaud ack = {0};
+
+            if ((frame->len == sizeof(MsgBaud)) && (linkState == LINK_IDLE)) {
+                uint32_t baud = ((const MsgBaud *)frame->payload)->baud;
+
+                if ((baud >= LINK_MIN_BAUD) && (baud <= LINK_MAX_BAUD)) {
+                    ack.baud = baud;
+                    linkTestBaud = baud;
+                    linkState = LINK_SWITCH;
+                }
+            }
+
+            Protocol_Send(MSG_BAUD_ACK, &ack, sizeof(ack));
+            return 1;
+        }
+        case MSG_BAUD_TEST: {
+            if (linkState == LINK_TEST) {
+                Link_TestFrame(frame);
+            }
+            return 1;
+        }
+        case MSG_BAUD_COMMIT: {
+            if (linkState == LINK_COMMIT) {
+                linkBaud = linkTestBaud;
+                linkState = LINK_IDLE;
+                Link_SendStatus();
+            }
+            return 1;
+        }
+        case MSG_LINK_QUERY: {
+            Link_SendStatus();
+            return 1;
+        }
+        default: {
+            return 0;
+        }
+    }
+}
+
+/*******************************************************************************
+* Link_SendStatus() - Report the baud rate and error counters.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Link_SendStatus(void) {
+    MsgLinkStatus status;
+
+    status.baud = G_USART3.baud;
+    status.rxFrames = G_ProtocolStats.rxFrames;
+    status.rxCrcErrors = G_ProtocolStats.rxCrcErrors;
+    status.rxFramingErrors = G_ProtocolStats.rxFramingErrors;
+    status.txDropped = G_USART3.txStats.dropped;
+    status.uartOverrun = G_USART3.rxErrors.overrun;
+    status.uartFraming = G_USART3.rxErrors.framing;
+    status.uartNoise = G_USART3.rxErrors.noise;
+    status.uartOverflow = G_USART3.rxErrors.overflow;
+
+    Protocol_Send(MSG_LINK_STATUS, &status, sizeof(status));
+}
+
+/*******************************************************************************
+* Link_Busy() - Check if a baud rate negotiation is in progress.
+* No inputs.
+* Returns 1 while negotiating, otherwise 0.
+*******************************************************************************/
+uint8_t Link_Busy(void) {
+    return (linkState != LINK_IDLE) ? 1 : 0;
+}
+
+/*******************************************************************************
+* Link_CanSend() - Check if a frame can be queued without disturbing the link.
+*                  Nothing is sent while the baud rate is being negotiated, and
+*                  as much again as the frame is left for the link messages.
+* size      - Encoded size of the frame, at most PROTOCOL_MAX_ENCODED.
+* Returns 1 if the frame can be sent, otherwise 0.
+*******************************************************************************/
+uint8_t Link_CanSend(uint16_t size) {
+    return (!Link_Busy() && (Queue_Space(&G_USART3.tx) >= size * 2)) ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+/*******************************************************************************
+* Name: Link.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link baud rate negotiation and status reporting.
+*******************************************************************************/
+
+#ifndef LINK_H
+#define LINK_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "UART.h"
+#include "Protocol.h"
+
+void Link_Update(void);
+uint8_t Link_Receive(const ProtocolFrame *frame);
+void Link_SendStatus(void);
+uint8_t Link_Busy(void);
+uint8_t Link_CanSend(uint16_t size);
+
+#endif
@@ -0,0 +1,138 @@
+/*******************************************************************************
+* Name: Log.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Tokenized deferred logging. Entries are recorded into a word
+*              ring buffer from anywhere (main loop or ISRs) and drained over
+*              the robot link from the main loop as MSG_LOG frames.
+*******************************************************************************/
+
+#include "Log.h"
+#include "Protocol.h"
+#include "Link.h"
+#include "Timebase.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define LOG_BUFF_WORDS          256         // Must be a power of 2
+#define LOG_MASK                (LOG_BUFF_WORDS - 1)
+#define LOG_HEADER_WORDS        2           // Id/nargs and timestamp
+#define LOG_FRAMES_PER_UPDATE   2           // Limit the link bandwidth taken per update
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+volatile LogStats G_LogStats = {0, 0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static volatile uint32_t logBuff[LOG_BUFF_WORDS];
+static volatile uint16_t logHead = 0;           // Written by Log_Write() with interrupts disabled
+static volatile uint16_t logTail = 0;           // Only written by Log_Update()
+static uint32_t logReported = 0;                // Dropped count at the last frame
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Log_SendFrame() - Pack as many entries as fit into a MSG_LOG frame and send it.
+* No inputs.
+* Returns 1 if a frame was sent, otherwise 0.
+*******************************************************************************/
+static uint8_t Log_SendFrame(void) {
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+    uint16_t len = sizeof(MsgLogHeader);
+    uint16_t tail = logTail;
+    uint32_t dropped = G_LogStats.dropped;
+    MsgLogHeader *header = (MsgLogHeader *)payload;
+
+    while (tail != logHead) {
+        uint8_t nargs = (logBuff[tail] >> 16) & 0xFF;
+        uint16_t words = LOG_HEADER_WORDS + nargs;
+
+        if (len + (words * 4) > PROTOCOL_MAX_PAYLOAD) {
+            break;
+        }
+
+        // Entry words are little endian, so they match MsgLogEntry
+        for (uint16_t i = 0; i < words; i++) {
+            uint32_t word = logBuff[tail];
+
+            payload[len++] = word;
+            payload[len++] = word >> 8;
+            payload[len++] = word >> 16;
+            payload[len++] = word >> 24;
+            tail = (tail + 1) & LOG_MASK;
+        }
+    }
+
+    if ((len == sizeof(MsgLogHeader)) && (dropped == logReported)) {
+        return 0;
+    }
+
+    header->dropped = ((dropped - logReported) > 0xFFFF) ? 0xFFFF : (dropped - logReported);
+    if (!Protocol_Send(MSG_LOG, payload, len)) {
+        return 0;
+    }
+
+    // Free the entries only once they are queued
+    logTail = tail;
+    logReported = dropped;
+    G_LogStats.frames++;
+    return 1;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Log_Write() - Record a log entry, use LOG() instead of calling this directly.
+*               Safe to call from ISRs.
+* id        - Log ID (format string offset).
+* nargs     - Number of arguments.
+* args      - Arguments.
+* No return value.
+*******************************************************************************/
+void Log_Write(uint16_t id, uint8_t nargs, const uint32_t *args) {
+    uint16_t words = LOG_HEADER_WORDS + nargs;
+    uint16_t head;
+
+    // Only a few stores, so writers just take turns with interrupts disabled
+    CRITICAL_ENTER();
+
+    head = logHead;
+    if (((logTail - head - 1) & LOG_MASK) < words) {
+        G_LogStats.dropped++;
+        CRITICAL_EXIT();
+        return;
+    }
+
+    logBuff[head] = id | ((uint32_t)nargs << 16);
+    head = (head + 1) & LOG_MASK;
+    logBuff[head] = Timebase_Cycles();
+    head = (head + 1) & LOG_MASK;
+    for (uint8_t i = 0; i < nargs; i++) {
+        logBuff[head] = args[i];
+        head = (head + 1) & LOG_MASK;
+    }
+
+    logHead = head;
+    G_LogStats.written++;
+
+    CRITICAL_EXIT();
+}
+
+/*******************************************************************************
+* Log_Update() - Send recorded entries. Call periodically.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Log_Update(void) {
+    for (uint8_t i = 0; i < LOG_FRAMES_PER_UPDATE; i++) {
+        if (!Link_CanSend(PROTOCOL_MAX_ENCODED) || !Log_SendFrame()) {
+            return;
+        }
+    }
+}
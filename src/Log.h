@@ -0,0 +1,49 @@
+/*******************************************************************************
+* Name: Log.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Tokenized deferred logging. LOG() stores the format string in
+*              the logstr section, which is not loaded on the robot, and only
+*              records its offset (the log ID), a timestamp and up to
+*              LOG_MAX_ARGS integer arguments. The server formats the entries
+*              with the strings extracted from the ELF (bin/log_strings.bin).
+*
+* Usage: LOG("left %d right %d", left, right);
+*   Arguments are stored as 32-bit integers, so only integer conversions
+*   (%d %i %u %x %X %c %q) can be used. Safe to call from ISRs.
+*******************************************************************************/
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+#include "Messages.h"
+
+// Start of the format string section, defined by the linker script
+extern const char __start_logstr[];
+
+// Number of arguments after the format string (0 to LOG_MAX_ARGS)
+#define LOG_NARGS(...)                      LOG_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, n, ...)  n
+
+#define LOG(fmt, ...) do {                                                      \
+    static const char logFmt[] __attribute__((section("logstr"), used)) = fmt;  \
+    const uint32_t logArgs[LOG_MAX_ARGS + 1] = {0, ##__VA_ARGS__};             \
+    Log_Write((uint16_t)(logFmt - __start_logstr), LOG_NARGS(__VA_ARGS__), &logArgs[1]); \
+} while (0)
+
+typedef struct {
+    uint32_t written;           // Entries recorded
+    uint32_t dropped;           // Entries lost because the buffer was full
+    uint32_t frames;            // MSG_LOG frames sent
+} LogStats;
+
+extern volatile LogStats G_LogStats;
+
+void Log_Write(uint16_t id, uint8_t nargs, const uint32_t *args);
+void Log_Update(void);
+
+#endif
@@ -0,0 +1,443 @@
+/*******************************************************************************
+* Name: Map.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Occupancy grid around the robot. MAP_SIZE square cells of
+*              MAP_CELL_MM in the odometry frame, each a 4-bit saturating
+*              log-odds of being occupied packed two to a byte (8KB).
+*
+*              The grid wraps: a cell's place in memory is its odometry frame
+*              cell number modulo MAP_SIZE. It covers the MAP_TILES square
+*              of tiles with the robot's tile near the middle, and as the
+*              robot moves on a whole tile the row or column of tiles left
+*              behind is cleared for the one coming into view. Nothing else
+*              moves.
+*
+*              Each ultrasonic sample is cast as a cone of MAP_CONE_HALF_DEG
+*              either side of the bearing it was taken at. Arcs of the cone a
+*              cell apart lose MAP_MISS up to the range, the arc at the range
+*              gains MAP_HIT. The arcs widen with the distance, so they take
+*              rays a cell apart out of a fan worked out once per sample, and
+*              all of it is in fixed point.
+*
+*              Tiles that change are marked, and a MSG_MAP_QUERY sends the
+*              marked tiles as the link has room.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "Map.h"
+#include "Odometry.h"
+#include "PID.h"
+#include "Timebase.h"
+#include "Link.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define MAP_MASK                (MAP_SIZE - 1)
+#define MAP_TILE_SHIFT          3           // log2(MAP_TILE_CELLS)
+#define MAP_DEG_ANGLE           11930465UL  // 2^32 / 360, binary angle of a degree
+#define MAP_HALF_STEP_ANGLE     5368709UL   // Binary angle of a stepper half step, 0.45 deg
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+MapStats G_MapStats = {0, 0, 0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint8_t mapCells[MAP_SIZE * MAP_SIZE / 2];
+static uint16_t mapDirty[MAP_TILES];    // Bit x of word y marks tile slot (x, y) as changed
+static uint16_t mapPending[MAP_TILES];  // Marks the tiles a query still has to send
+static int32_t mapOriginX = 0;          // Lowest tile covered
+static int32_t mapOriginY = 0;
+static q16_t mapConeTan = 0;            // tan(MAP_CONE_HALF_DEG)
+static uint32_t mapSeen = 0;            // Ultrasonic samples looked at
+static uint16_t mapRemaining = 0;       // Tiles marked pending
+
+// Fan of the current sample, Q14 cells per cell of radius
+static int32_t mapRayX[MAP_MAX_RAYS];
+static int32_t mapRayY[MAP_MAX_RAYS];
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Map_Covered() - Check whether a tile is in the grid.
+* tx        - Tile x in the odometry frame.
+* ty        - Tile y.
+* Returns 1 if it is covered, otherwise 0.
+*******************************************************************************/
+static inline uint8_t Map_Covered(int32_t tx, int32_t ty) {
+    return ((uint32_t)(tx - mapOriginX) < MAP_TILES) && ((uint32_t)(ty - mapOriginY) < MAP_TILES);
+}
+
+/*******************************************************************************
+* Map_Change() - Add to the log-odds of a cell, saturating.
+* x         - Cell x in the odometry frame.
+* y         - Cell y.
+* delta     - Log-odds to add.
+* Returns 1 if the cell is covered, otherwise 0.
+*******************************************************************************/
+static uint8_t Map_Change(int32_t x, int32_t y, int8_t delta) {
+    uint32_t index;
+    uint8_t shift;
+    int8_t value, updated;
+
+    if (!Map_Covered(x >> MAP_TILE_SHIFT, y >> MAP_TILE_SHIFT)) {
+        return 0;
+    }
+
+    index = ((uint32_t)(y & MAP_MASK) * MAP_SIZE) + (x & MAP_MASK);
+    shift = (index & 1) ? 4 : 0;
+
+    // Sign extend the nibble
+    value = (int8_t)((uint8_t)(mapCells[index >> 1] >> shift) << 4) >> 4;
+    updated = value + delta;
+    if (updated > MAP_LOGODDS_MAX) {
+        updated = MAP_LOGODDS_MAX;
+    }
+    else if (updated < -MAP_LOGODDS_MAX) {
+        updated = -MAP_LOGODDS_MAX;
+    }
+
+    if (updated != value) {
+        FORCE_BITS(mapCells[index >> 1], 0x0FU << shift, ((uint8_t)updated & 0x0FU) << shift);
+        SET_BITS(mapDirty[(y >> MAP_TILE_SHIFT) & (MAP_TILES - 1)], 1U << ((x >> MAP_TILE_SHIFT) & (MAP_TILES - 1)));
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+* Map_Arc() - Change the cells along an arc of the cone.
+* ox        - Sensor x, Q16 cells.
+* oy        - Sensor y, Q16 cells.
+* radius    - Arc radius, Q16 cells.
+* rays      - Rays in the fan.
+* delta     - Log-odds to add.
+* Returns the number of cells changed.
+*******************************************************************************/
+static uint32_t Map_Arc(int32_t ox, int32_t oy, q16_t radius, uint8_t rays, int8_t delta) {
+    // Enough rays to leave no cell out, as many as cells across the arc
+    int32_t across = (int32_t)(((int64_t)radius * mapConeTan + 0xFFFFFFFFLL) >> 32);
+    uint8_t count = (uint8_t)((across * 2 + 1 < rays) ? (across * 2 + 1) : rays);
+    int32_t r = radius >> 8;            // Q8 keeps radius * ray in 32 bits
+    uint32_t ray = (count > 1) ? 0x8000UL : ((uint32_t)(rays / 2) << 16);
+    uint32_t step = (count > 1) ? (((uint32_t)(rays - 1) << 16) / (count - 1)) : 0;
+    int32_t x, y, lastX = 0, lastY = 0;
+    uint32_t cells = 0;
+
+    for (uint8_t i = 0; i < count; i++, ray += step) {
+        x = (ox + ((r * mapRayX[ray >> 16]) >> 6)) >> 16;
+        y = (oy + ((r * mapRayY[ray >> 16]) >> 6)) >> 16;
+
+        // Neighbouring rays can round to the same cell
+        if ((i > 0) && (x == lastX) && (y == lastY)) {
+            continue;
+        }
+        lastX = x;
+        lastY = y;
+
+        cells += Map_Change(x, y, delta);
+    }
+
+    return cells;
+}
+
+/*******************************************************************************
+* Map_Seen() - Check whether a tile slot has anything in it.
+* slotX     - Tile slot x.
+* slotY     - Tile slot y.
+* Returns 1 if any cell is known, otherwise 0.
+*******************************************************************************/
+static uint8_t Map_Seen(uint32_t slotX, uint32_t slotY) {
+    const uint8_t *cells = &mapCells[(slotY * MAP_TILE_CELLS * MAP_SIZE + slotX * MAP_TILE_CELLS) / 2];
+
+    for (uint32_t row = 0; row < MAP_TILE_CELLS; row++, cells += MAP_SIZE / 2) {
+        for (uint32_t i = 0; i < MAP_TILE_CELLS / 2; i++) {
+            if (cells[i] != 0) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+* Map_Marked() - Count the marked tiles.
+* marks     - Tile marks, a word per row of slots.
+* Returns the number of tiles marked.
+*******************************************************************************/
+static uint16_t Map_Marked(const uint16_t *marks) {
+    uint16_t count = 0;
+
+    for (uint32_t y = 0; y < MAP_TILES; y++) {
+        for (uint16_t bits = marks[y]; bits != 0; bits &= bits - 1) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+* Map_Scroll() - Keep the robot's tile in the middle of the grid, clearing
+*                the tiles that come into view.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Map_Scroll(void) {
+    int32_t originX = (int32_t)(((int64_t)G_OdometryPose.x * 65536 / MAP_CELL_UM) >> 16) >> MAP_TILE_SHIFT;
+    int32_t originY = (int32_t)(((int64_t)G_OdometryPose.y * 65536 / MAP_CELL_UM) >> 16) >> MAP_TILE_SHIFT;
+    int32_t tile;
+
+    originX -= MAP_TILES / 2;
+    originY -= MAP_TILES / 2;
+
+    if ((originX - mapOriginX >= MAP_TILES) || (mapOriginX - originX >= MAP_TILES)
+        || (originY - mapOriginY >= MAP_TILES) || (mapOriginY - originY >= MAP_TILES)) {
+        Map_Clear();
+        mapOriginX = originX;
+        mapOriginY = originY;
+        return;
+    }
+
+    // Tile columns, MAP_TILE_CELLS / 2 bytes a row
+    for (; mapOriginX != originX; mapOriginX += (originX > mapOriginX) ? 1 : -1) {
+        tile = (originX > mapOriginX) ? (mapOriginX + MAP_TILES) : (mapOriginX - 1);
+        tile &= MAP_TILES - 1;
+        for (uint32_t row = 0; row < MAP_SIZE; row++) {
+            memset(&mapCells[(row * MAP_SIZE + tile * MAP_TILE_CELLS) / 2], 0, MAP_TILE_CELLS / 2);
+        }
+        for (uint32_t i = 0; i < MAP_TILES; i++) {
+            CLEAR_BITS(mapDirty[i], 1U << tile);
+            CLEAR_BITS(mapPending[i], 1U << tile);
+        }
+    }
+
+    // Tile rows, contiguous
+    for (; mapOriginY != originY; mapOriginY += (originY > mapOriginY) ? 1 : -1) {
+        tile = (originY > mapOriginY) ? (mapOriginY + MAP_TILES) : (mapOriginY - 1);
+        tile &= MAP_TILES - 1;
+        memset(&mapCells[(tile * MAP_TILE_CELLS * MAP_SIZE) / 2], 0, MAP_TILE_CELLS * MAP_SIZE / 2);
+        mapDirty[tile] = 0;
+        mapPending[tile] = 0;
+    }
+    mapRemaining = Map_Marked(mapPending);
+}
+
+/*******************************************************************************
+* Map_SendTile() - Send the next pending tile.
+* No inputs.
+* Returns 1 if a tile was sent, otherwise 0.
+*******************************************************************************/
+static uint8_t Map_SendTile(void) {
+    MsgMapTile msg;
+    int32_t slotX, slotY, row;
+
+    for (slotY = 0; slotY < MAP_TILES; slotY++) {
+        if (mapPending[slotY] != 0) {
+            break;
+        }
+    }
+    if (slotY == MAP_TILES) {
+        mapRemaining = 0;
+        return 0;
+    }
+    for (slotX = 0; !(mapPending[slotY] & (1U << slotX)); slotX++) {
+    }
+
+    msg.tileX = (int16_t)(mapOriginX + ((slotX - mapOriginX) & (MAP_TILES - 1)));
+    msg.tileY = (int16_t)(mapOriginY + ((slotY - mapOriginY) & (MAP_TILES - 1)));
+    msg.remaining = (mapRemaining > 0) ? (mapRemaining - 1) : 0;
+    for (row = 0; row < MAP_TILE_CELLS; row++) {
+        memcpy(&msg.cells[row * MAP_TILE_CELLS / 2],
+               &mapCells[((slotY * MAP_TILE_CELLS + row) * MAP_SIZE + slotX * MAP_TILE_CELLS) / 2],
+               MAP_TILE_CELLS / 2);
+    }
+
+    if (!Protocol_Send(MSG_MAP_TILE, &msg, sizeof(msg))) {
+        return 0;
+    }
+
+    // What was sent is up to date
+    CLEAR_BITS(mapPending[slotY], 1U << slotX);
+    CLEAR_BITS(mapDirty[slotY], 1U << slotX);
+    mapRemaining = msg.remaining;
+    return 1;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Map_Init() - Start with an empty grid around the robot.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Map_Init(void) {
+    uint32_t half = MAP_CONE_HALF_DEG * MAP_DEG_ANGLE;
+
+    mapConeTan = (q16_t)(((int64_t)Odometry_Sin(half) << 16) / Odometry_Cos(half));
+    mapSeen = Ultra_GetCount();
+    mapRemaining = 0;
+    Map_Clear();
+    mapOriginX = 0x40000000L;      // Far away, the first update moves the grid
+    mapOriginY = 0x40000000L;
+    Map_Scroll();
+}
+
+/*******************************************************************************
+* Map_Clear() - Forget everything in the grid.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Map_Clear(void) {
+    memset(mapCells, 0, sizeof(mapCells));
+    memset(mapDirty, 0, sizeof(mapDirty));
+    memset(mapPending, 0, sizeof(mapPending));
+    mapRemaining = 0;
+}
+
+/*******************************************************************************
+* Map_Update() - Move the grid with the robot, add the new ultrasonic samples
+*                and send the tiles a query asked for. Call periodically.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Map_Update(void) {
+    uint32_t count = Ultra_GetCount();
+    UltraSample sample;
+
+    Map_Scroll();
+
+    if (count - mapSeen > ULTRA_RING_SIZE) {
+        mapSeen = count - ULTRA_RING_SIZE;
+    }
+    for (; mapSeen != count; mapSeen++) {
+        if (Ultra_GetSample(mapSeen, &sample)) {
+            Map_AddSample(&sample);
+        }
+    }
+
+    for (uint8_t i = 0; (i < MAP_TILES_PER_UPDATE) && (mapRemaining > 0); i++) {
+        if (!Link_CanSend(PROTOCOL_MAX_ENCODED) || !Map_SendTile()) {
+            return;
+        }
+    }
+}
+
+/*******************************************************************************
+* Map_AddSample() - Cast an ultrasonic sample into the grid from where the
+*                   robot is now. The sample is at most a map update old, a
+*                   fraction of a cell at driving speeds.
+* sample    - Ultrasonic sample.
+* No return value.
+*******************************************************************************/
+void Map_AddSample(const UltraSample *sample) {
+    uint32_t start = Timebase_Cycles();
+    uint32_t bearing, angle, step;
+    int32_t ox, oy, reach, maxCells;
+    q16_t range;
+    uint8_t rays, hit;
+    uint32_t cells = 0, cycles;
+
+    if (sample->status == ULTRA_MISSED) {
+        return;
+    }
+
+    // Nothing in range clears the cone as far as it is trusted
+    range = Q16_FROM_INT(MAP_MAX_RANGE_CM) / (MAP_CELL_MM / 10);
+    hit = 0;
+    if ((sample->status == ULTRA_OK) && (sample->echo / ULTRA_US_PER_CM < MAP_MAX_RANGE_CM)) {
+        range = (q16_t)(((int32_t)sample->echo << 16) / (ULTRA_US_PER_CM * (MAP_CELL_MM / 10)));
+        hit = 1;
+    }
+
+    // Clockwise pans look to the right, bearings are counter-clockwise
+    bearing = G_OdometryPose.heading - (uint32_t)((int32_t)sample->pan * (int32_t)MAP_HALF_STEP_ANGLE);
+    ox = (int32_t)((int64_t)G_OdometryPose.x * 65536 / MAP_CELL_UM);
+    oy = (int32_t)((int64_t)G_OdometryPose.y * 65536 / MAP_CELL_UM);
+
+    // The fan across the widest arc
+    maxCells = (int32_t)(((int64_t)range * mapConeTan + 0xFFFFFFFFLL) >> 32);
+    rays = (uint8_t)((maxCells * 2 + 1 < MAP_MAX_RAYS) ? (maxCells * 2 + 1) : MAP_MAX_RAYS);
+    angle = bearing - MAP_CONE_HALF_DEG * MAP_DEG_ANGLE;
+    step = (rays > 1) ? ((2 * MAP_CONE_HALF_DEG * MAP_DEG_ANGLE) / (rays - 1)) : 0;
+    if (rays == 1) {
+        angle = bearing;
+    }
+    for (uint8_t i = 0; i < rays; i++, angle += step) {
+        mapRayX[i] = Odometry_Cos(angle) >> 16;
+        mapRayY[i] = Odometry_Sin(angle) >> 16;
+    }
+
+    // Free up to the cell before the echo, then the echo
+    reach = hit ? (Q16_TO_INT(range + Q16(0.5)) - 1) : Q16_TO_INT(range);
+    for (int32_t k = 1; k <= reach; k++) {
+        cells += Map_Arc(ox, oy, Q16_FROM_INT(k), rays, -MAP_MISS);
+    }
+    if (hit) {
+        cells += Map_Arc(ox, oy, range, rays, MAP_HIT);
+    }
+
+    cycles = Timebase_Cycles() - start;
+    G_MapStats.samples++;
+    G_MapStats.lastCells = cells;
+    G_MapStats.lastCycles = cycles;
+    if (cycles > G_MapStats.maxCycles) {
+        G_MapStats.maxCycles = cycles;
+    }
+}
+
+/*******************************************************************************
+* Map_GetCell() - Get the log-odds of a cell.
+* x         - Cell x in the odometry frame.
+* y         - Cell y.
+* Returns the log-odds, positive is occupied, 0 if unknown or not covered.
+*******************************************************************************/
+int8_t Map_GetCell(int32_t x, int32_t y) {
+    uint32_t index;
+
+    if (!Map_Covered(x >> MAP_TILE_SHIFT, y >> MAP_TILE_SHIFT)) {
+        return 0;
+    }
+
+    index = ((uint32_t)(y & MAP_MASK) * MAP_SIZE) + (x & MAP_MASK);
+    return (int8_t)((uint8_t)(mapCells[index >> 1] >> ((index & 1) ? 4 : 0)) << 4) >> 4;
+}
+
+/*******************************************************************************
+* Map_Receive() - Handle a map message.
+* frame     - Received frame.
+* Returns 1 if the frame was a map message, otherwise 0.
+*******************************************************************************/
+uint8_t Map_Receive(const ProtocolFrame *frame) {
+    if ((frame->type == MSG_MAP_QUERY) && (frame->len == sizeof(MsgMapQuery))) {
+        const MsgMapQuery *query = (const MsgMapQuery *)frame->payload;
+
+        if (query->all) {
+            // Every tile that has been seen, unknown ones have nothing to send
+            for (uint32_t slotY = 0; slotY < MAP_TILES; slotY++) {
+                for (uint32_t slotX = 0; slotX < MAP_TILES; slotX++) {
+                    if (Map_Seen(slotX, slotY)) {
+                        SET_BITS(mapDirty[slotY], 1U << slotX);
+                    }
+                }
+            }
+        }
+        // Changes from here on are for the next query
+        for (uint32_t slotY = 0; slotY < MAP_TILES; slotY++) {
+            SET_BITS(mapPending[slotY], mapDirty[slotY]);
+            mapDirty[slotY] = 0;
+        }
+        mapRemaining = Map_Marked(mapPending);
+        return 1;
+    }
+
+    return 0;
+}
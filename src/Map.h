@@ -0,0 +1,50 @@
+/*******************************************************************************
+* Name: Map.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Occupancy grid around the robot from the ultrasonic samples.
+*******************************************************************************/
+
+#ifndef MAP_H
+#define MAP_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Protocol.h"
+#include "Ultrasonic.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define MAP_SIZE                128         // Cells per side, a power of 2
+#define MAP_TILES               (MAP_SIZE / MAP_TILE_CELLS)     // Tiles per side
+#define MAP_CELL_UM             (MAP_CELL_MM * 1000L)
+#define MAP_MAX_RANGE_CM        300         // Readings are only trusted this far
+#define MAP_CONE_HALF_DEG       15          // Half the beam width
+#define MAP_MAX_RAYS            40          // At least 2 * MAX_RANGE / CELL * tan(CONE_HALF) + 3
+#define MAP_HIT                 2           // Log-odds added where the echo came from
+#define MAP_MISS                1           // Log-odds taken off in front of it
+#define MAP_LOGODDS_MAX         7           // Cells saturate at +-7
+#define MAP_TILES_PER_UPDATE    2
+
+typedef struct {
+    uint32_t samples;           // Ultrasonic samples added
+    uint32_t lastCells;         // Cells updated by the last sample
+    uint32_t lastCycles;        // Map_AddSample() execution time
+    uint32_t maxCycles;
+} MapStats;
+
+extern MapStats G_MapStats;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Map_Init(void);
+void Map_Clear(void);
+void Map_Update(void);
+void Map_AddSample(const UltraSample *sample);
+int8_t Map_GetCell(int32_t x, int32_t y);
+uint8_t Map_Receive(const ProtocolFrame *frame);
+
+#endif
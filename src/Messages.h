@@ -0,0 +1,331 @@
+/*******************************************************************************
+* Name: Messages.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link message definitions. Shared by the robot firmware
+*              and the raspberry pi server (tcpip/), so it must only depend on
+*              standard C headers.
+*
+* Frame format (before COBS encoding):
+*   [type:1][payload:0..PROTOCOL_MAX_PAYLOAD][crc16:2 little endian]
+* The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over type and
+* payload. Each frame is COBS encoded and terminated with a 0x00 delimiter.
+* All multi-byte fields are little endian.
+*******************************************************************************/
+
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+*                               FRAMING                                        *
+*******************************************************************************/
+#define PROTOCOL_DELIMITER      0x00
+#define PROTOCOL_MAX_PAYLOAD    128
+#define PROTOCOL_MAX_RAW        (PROTOCOL_MAX_PAYLOAD + 3)                          // type + payload + crc
+#define PROTOCOL_MAX_ENCODED    (PROTOCOL_MAX_RAW + (PROTOCOL_MAX_RAW / 254) + 2)   // COBS overhead + delimiter
+
+#define PROTOCOL_CRC_POLY       0x1021
+#define PROTOCOL_CRC_INIT       0xFFFF
+
+/*******************************************************************************
+*                               MESSAGE TYPES                                  *
+*******************************************************************************/
+// Host -> robot
+#define MSG_COMMAND             0x01    // Legacy one character command
+#define MSG_DRIVE               0x02    // Set wheel speeds, servo angle and stepper target
+#define MSG_BAUD_PROPOSE        0x03    // Propose a new baud rate
+#define MSG_BAUD_TEST           0x04    // Verification burst frame at the proposed baud rate
+#define MSG_BAUD_COMMIT         0x05    // Keep the proposed baud rate
+#define MSG_LINK_QUERY          0x06    // Request a MSG_LINK_STATUS
+#define MSG_TELEMETRY_RATE      0x07    // Set the telemetry rate
+#define MSG_TASK_QUERY          0x08    // Request a MSG_TASK_STATUS per scheduler task
+#define MSG_TUNE_START          0x09    // Relay auto-tune the wheel controllers
+#define MSG_VELOCITY            0x0A    // Set linear and angular velocity
+#define MSG_SCAN_CONTROL        0x0B    // Start or stop the range scanner
+#define MSG_MAP_QUERY           0x0C    // Download the changed occupancy grid tiles
+
+// Robot -> host
+#define MSG_RANGE               0x81    // Ultrasonic range reading
+#define MSG_BAUD_ACK            0x82    // Proposed baud rate accepted (switching) or rejected
+#define MSG_BAUD_RESULT         0x83    // Verification burst result at the proposed baud rate
+#define MSG_LINK_STATUS         0x84    // Baud rate and error counters
+#define MSG_TELEMETRY           0x85    // Periodic robot state
+#define MSG_LOG                 0x86    // Tokenized log entries
+#define MSG_TASK_STATUS         0x87    // Scheduler task timing statistics
+#define MSG_TUNE_RESULT         0x88    // Auto-tune result, one per wheel
+#define MSG_SCAN                0x89    // Range scan points, a burst per sweep
+#define MSG_MAP_TILE            0x8A    // Occupancy grid tile
+
+/*******************************************************************************
+*                               PAYLOADS                                       *
+*******************************************************************************/
+// MSG_COMMAND
+typedef struct __attribute__((packed)) {
+    uint8_t cmd;                // '0'..'9', 'A'..'I', 'S'
+} MsgCommand;
+
+// MSG_DRIVE
+#define DRIVE_SET_WHEELS        0x01
+#define DRIVE_SET_SERVO         0x02
+#define DRIVE_SET_STEPPER       0x04
+
+typedef struct __attribute__((packed)) {
+    uint8_t flags;              // DRIVE_SET_x, fields without a flag are ignored
+    int16_t leftSpeed;          // cm/s, negative is backwards
+    int16_t rightSpeed;         // cm/s, negative is backwards
+    int8_t servoAngle;          // degrees
+    int16_t stepperTarget;      // half steps from centre, clockwise is positive
+} MsgDrive;
+
+// MSG_VELOCITY
+// Both wheels are scaled down together to keep the curvature if either would
+// pass the top speed. The robot stops if no velocity frame arrives for 500ms,
+// so send them continuously while moving. A MSG_DRIVE or wheel MSG_COMMAND
+// takes over again.
+typedef struct __attribute__((packed)) {
+    int16_t linear;             // mm/s, negative is backwards
+    int16_t angular;            // mrad/s, counter-clockwise is positive
+} MsgVelocity;
+
+// MSG_RANGE
+typedef struct __attribute__((packed)) {
+    uint16_t distance;          // cm, median filtered, 0xFFFF if nothing is in range
+} MsgRange;
+
+// Link speed negotiation
+// Both ends start at LINK_DEFAULT_BAUD. The host proposes a rate and the robot
+// acks at the old rate, then both switch. The host sends LINK_TEST_FRAMES test
+// frames and the robot replies with the result at the new rate. If the result
+// passes the host commits, otherwise (or on any timeout) both ends fall back.
+#define LINK_DEFAULT_BAUD       9600
+#define LINK_TEST_FRAMES        32
+#define LINK_TEST_LEN           64
+#define LINK_TEST_MAX_ERRORS    1
+#define LINK_TEST_BYTE(seq, i)  ((uint8_t)((seq) * 31 + (i) * 37))     // Includes zeros to exercise COBS
+
+// MSG_BAUD_PROPOSE, MSG_BAUD_ACK
+typedef struct __attribute__((packed)) {
+    uint32_t baud;              // Rejected if 0 in MSG_BAUD_ACK
+} MsgBaud;
+
+// MSG_BAUD_TEST
+typedef struct __attribute__((packed)) {
+    uint16_t seq;
+    uint8_t pattern[LINK_TEST_LEN];     // LINK_TEST_BYTE(seq, i)
+} MsgBaudTest;
+
+// MSG_BAUD_RESULT
+typedef struct __attribute__((packed)) {
+    uint32_t baud;
+    uint16_t good;              // Test frames received intact
+    uint16_t errors;            // Bad test frames, CRC, framing and UART errors
+    uint8_t pass;               // 1 if the robot will keep the rate once committed
+} MsgBaudResult;
+
+// MSG_LINK_STATUS
+typedef struct __attribute__((packed)) {
+    uint32_t baud;
+    uint32_t rxFrames;
+    uint32_t rxCrcErrors;
+    uint32_t rxFramingErrors;
+    uint32_t txDropped;         // Bytes dropped because the transmit buffer was full
+    uint32_t uartOverrun;
+    uint32_t uartFraming;
+    uint32_t uartNoise;
+    uint32_t uartOverflow;      // Receive buffer laps, unread bytes were dropped
+} MsgLinkStatus;
+
+// MSG_TELEMETRY_RATE
+// The robot limits the rate to half of the link bandwidth
+#define TELEMETRY_DEFAULT_RATE  50
+#define TELEMETRY_MAX_RATE      200
+
+typedef struct __attribute__((packed)) {
+    uint16_t rate;              // Hz, 0 turns telemetry off
+} MsgTelemetryRate;
+
+// MSG_TELEMETRY
+// Motor cutoff reasons, the wheel runs again once it is commanded to stop
+#define CUTOFF_NONE             0
+#define CUTOFF_OVERCURRENT      1       // Drive current over the limit
+#define CUTOFF_STALL            2       // Driven hard without turning
+
+typedef struct __attribute__((packed)) {
+    uint16_t seq;               // Increments every frame, gaps are lost frames
+    uint32_t time;              // ms since reset
+    uint16_t leftSpeed;         // cm/s
+    uint16_t rightSpeed;        // cm/s
+    int16_t leftSetpoint;       // cm/s
+    int16_t rightSetpoint;      // cm/s
+    uint32_t leftPeriod;        // us between encoder vanes
+    uint32_t rightPeriod;       // us between encoder vanes
+    int16_t leftOutput;         // PID output, % duty cycle
+    int16_t rightOutput;        // PID output, % duty cycle
+    uint8_t leftDir;            // DCMOTOR_x
+    uint8_t rightDir;           // DCMOTOR_x
+    uint16_t range;             // cm, as MsgRange
+    int8_t servoAngle;          // degrees
+    uint8_t stepperStep;        // STEPPER_x
+    int16_t stepperPosition;    // half steps from centre, clockwise is positive
+    uint16_t loopPeriod;        // us, average telemetry task period since the last frame
+    uint16_t loopMax;           // us, longest telemetry task period since the last frame
+    uint16_t leftReversal;      // us from the last reversal request to the new direction
+    uint16_t rightReversal;     // us, including the dead time
+    uint16_t encoderIsrMax;     // cycles, longest encoder ISR since reset
+    int32_t poseX;              // mm from the start, +x is the starting heading
+    int32_t poseY;              // mm, +y is to the left of the starting heading
+    uint16_t poseHeading;       // 2^16 per turn, counter-clockwise from +x
+    uint16_t pidMax;            // cycles, longest wheel PID update (both wheels) since reset
+    int16_t leftProfile;        // mm/s, profiled setpoint, negative is backwards
+    int16_t rightProfile;       // mm/s
+    uint16_t speedLimit;        // mm/s, forward limit for the obstacle ahead, 0xFFFF if none
+    uint16_t ttc;               // ms to collision with the obstacle ahead, 0xFFFF if not closing
+    uint16_t mapMax;            // us, longest occupancy grid update of one ultrasonic sample since reset
+    uint16_t batteryMv;         // mV, 0 without a battery
+    uint16_t driveCurrent;      // mA, both motors, sampled in the middle of the PWM pulses
+    uint16_t pwmScale;          // Duty cycle battery compensation, 1000 is none
+    uint8_t leftCutoff;         // CUTOFF_x
+    uint8_t rightCutoff;        // CUTOFF_x
+} MsgTelemetry;
+
+// MSG_TASK_QUERY
+typedef struct __attribute__((packed)) {
+    uint8_t reset;              // 1 to clear the statistics once they are sent
+} MsgTaskQuery;
+
+// MSG_TASK_STATUS
+// One frame per task. Times are saturated to 0xFFFF.
+#define TASK_NAME_LEN           8
+
+typedef struct __attribute__((packed)) {
+    uint8_t id;
+    uint8_t count;              // Number of tasks
+    char name[TASK_NAME_LEN];   // Not null terminated if it fills the field
+    uint8_t priority;           // 0 is the highest
+    uint16_t period;            // ms
+    uint16_t deadline;          // ms after each release
+    uint32_t runs;
+    uint32_t overruns;          // Runs that finished after their deadline
+    uint32_t skipped;           // Releases dropped because the task was still late
+    uint16_t lastUs;            // Execution time of the last run
+    uint16_t wcetUs;            // Longest execution time
+    uint16_t jitterUs;          // Longest delay from release to start
+    uint32_t time;              // ms since reset
+} MsgTaskStatus;
+
+// MSG_TUNE_START
+// The robot drives forward while a relay around the setpoint makes each wheel
+// oscillate. The new gains are applied to the gain schedule entry for the
+// setpoint. Any other drive command aborts the tune.
+#define TUNE_DEFAULT_SETPOINT   20      // cm/s
+#define TUNE_DEFAULT_AMPLITUDE  20      // % duty
+
+typedef struct __attribute__((packed)) {
+    uint8_t setpoint;           // cm/s, 0 for TUNE_DEFAULT_SETPOINT
+    uint8_t amplitude;          // % duty either side of the bias, 0 for TUNE_DEFAULT_AMPLITUDE
+} MsgTuneStart;
+
+// MSG_TUNE_RESULT
+// Gains are Q16.16 in the PID units: kp % duty per cm/s, ki % duty per cm,
+// kd % duty per cm/s^2 and kff % duty per cm/s of setpoint.
+#define TUNE_OK                 0
+#define TUNE_TIMEOUT            1       // The wheel didn't oscillate, gains unchanged
+#define TUNE_ABORTED            2       // Stopped by another drive command, gains unchanged
+
+typedef struct __attribute__((packed)) {
+    uint8_t wheel;              // 0 = left, 1 = right
+    uint8_t status;             // TUNE_x
+    uint8_t setpoint;           // cm/s
+    uint8_t cycles;             // Relay cycles averaged
+    int32_t ku;                 // Ultimate gain, Q16.16 % duty per cm/s
+    uint32_t tuUs;              // Ultimate period
+    int32_t amplitude;          // Speed oscillation amplitude, Q16.16 cm/s
+    int32_t kp;
+    int32_t ki;
+    int32_t kd;
+    int32_t kff;
+    uint32_t time;              // ms since reset
+} MsgTuneResult;
+
+// MSG_SCAN_CONTROL
+// The stepper sweeps the sensor between its limits, ranging at the fastest
+// rate the sensor allows and stepping spacing half steps between readings.
+// Any other stepper command stops the scan.
+#define SCAN_DEFAULT_SPACING    16      // Half steps, 7.2 degrees
+
+typedef struct __attribute__((packed)) {
+    uint8_t spacing;            // Half steps between readings, 0 to stop scanning
+} MsgScanControl;
+
+// MSG_SCAN
+// Points are sent in the order they were taken, a frame every
+// SCAN_FRAME_POINTS and the rest when the sweep turns around. Pans are stepper
+// half steps of SCAN_MDEG_PER_HALF_STEP, clockwise (to the right of the robot)
+// is positive.
+#define SCAN_MDEG_PER_HALF_STEP 450
+#define SCAN_FRAME_POINTS       16
+#define SCAN_CLOCKWISE          0x01    // Sweep direction
+#define SCAN_LAST               0x02    // Last frame of the sweep
+
+typedef struct __attribute__((packed)) {
+    int16_t pan;                // Half steps from centre at the reflection
+    uint16_t range;             // cm, raw (not median filtered), 0xFFFF if nothing in range
+    int16_t dt;                 // ms from the frame time, negative is before
+} ScanPoint;
+
+typedef struct __attribute__((packed)) {
+    uint16_t sweep;             // Sweep number
+    uint8_t index;              // Number of the first point in the sweep
+    uint8_t count;              // Points in this frame
+    uint8_t flags;              // SCAN_x
+    uint32_t time;              // ms since reset, when the frame was sent
+    int32_t poseX;              // mm, pose at time as MsgTelemetry
+    int32_t poseY;              // mm
+    uint16_t poseHeading;       // 2^16 per turn
+    ScanPoint points[SCAN_FRAME_POINTS];
+} MsgScan;
+
+// MSG_MAP_QUERY
+// The robot keeps an occupancy grid of MAP_CELL_MM cells around itself, in
+// the odometry frame, and marks the tiles that change. A query sends a
+// MSG_MAP_TILE for each marked tile as the link has room and clears the
+// marks, so repeated queries download only what changed since the last.
+typedef struct __attribute__((packed)) {
+    uint8_t all;                // 1 to send every tile with something in it
+} MsgMapQuery;
+
+// MSG_MAP_TILE
+// Cells are 4-bit two's complement log-odds of being occupied, 0 is unknown,
+// positive is occupied. Rows run along +x, from the tile's lowest y, two
+// cells per byte with the lower x in the low nibble.
+#define MAP_CELL_MM             50
+#define MAP_TILE_CELLS          8       // Tiles are MAP_TILE_CELLS square
+
+typedef struct __attribute__((packed)) {
+    int16_t tileX;              // Tile of the odometry frame, cell x / MAP_TILE_CELLS (floored)
+    int16_t tileY;
+    uint16_t remaining;         // Tiles still to send for this query
+    uint8_t cells[MAP_TILE_CELLS * MAP_TILE_CELLS / 2];
+} MsgMapTile;
+
+// MSG_LOG
+// A MsgLogHeader followed by as many entries as fit. Each entry is a
+// MsgLogEntry followed by nargs 32-bit arguments. The id is the offset of the
+// format string in the logstr section of the firmware ELF.
+#define LOG_MAX_ARGS            4
+#define LOG_CLOCK_HZ            72000000        // Entry timestamps are SYSCLK cycles
+
+typedef struct __attribute__((packed)) {
+    uint16_t dropped;           // Entries lost because the log buffer was full
+} MsgLogHeader;
+
+typedef struct __attribute__((packed)) {
+    uint16_t id;
+    uint8_t nargs;
+    uint8_t reserved;
+    uint32_t time;              // Cycle counter, wraps every ~60s
+} MsgLogEntry;
+
+#endif
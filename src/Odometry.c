@@ -0,0 +1,135 @@
+/*******************************************************************************
+* Name: Odometry.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Differential drive dead reckoning. Each update turns the
+*              change in the signed tick counts into a distance and a heading
+*              change and moves the pose along the heading at the middle of
+*              the step. Everything is fixed point: positions in um, the
+*              heading as a binary angle that wraps for free, and sin/cos from
+*              a 5th order polynomial. There are no divisions per update.
+*******************************************************************************/
+
+#include "Odometry.h"
+#include "Encoder.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define Q30_ONE                 (1L << 30)
+
+// sin(z * pi/2) ~ z * (A - z^2 * (B - z^2 * C)), |z| <= 1, error < 5e-4
+#define ODOMETRY_SIN_A          1686629713L     // pi/2 in Q30
+#define ODOMETRY_SIN_B          688904866L      // pi - 5/2 in Q30
+#define ODOMETRY_SIN_C          76016977L       // pi/2 - 3/2 in Q30
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+volatile OdometryPose G_OdometryPose = {0, 0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static int64_t headingScale = 0;        // Heading units per um of wheel difference, Q16
+static int32_t lastTicks[2] = {0, 0};   // Tick counts at the last update
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Odometry_Init() - Start the pose at the origin with the default track width.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Odometry_Init(void) {
+    Odometry_SetTrackWidth(ODOMETRY_TRACK_UM);
+    Odometry_Reset();
+}
+
+/*******************************************************************************
+* Odometry_SetTrackWidth() - Set the distance between the wheels.
+* um        - Track width in um.
+* No return value.
+*******************************************************************************/
+void Odometry_SetTrackWidth(uint32_t um) {
+    // A wheel difference of one track width is a turn of 1/(2 pi)
+    uint64_t turnUm = ((uint64_t)um * 6283185UL) / 1000000UL;
+
+    if (turnUm != 0) {
+        headingScale = (int64_t)((1ULL << 48) / turnUm);
+    }
+}
+
+/*******************************************************************************
+* Odometry_Reset() - Move the pose back to the origin, facing +x.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Odometry_Reset(void) {
+    lastTicks[LEFT] = G_EncoderTicks[LEFT];
+    lastTicks[RIGHT] = G_EncoderTicks[RIGHT];
+
+    G_OdometryPose.x = 0;
+    G_OdometryPose.y = 0;
+    G_OdometryPose.heading = 0;
+}
+
+/*******************************************************************************
+* Odometry_Update() - Integrate the wheel travel since the last update. Call
+*                     from the control task after Encoder_Update().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Odometry_Update(void) {
+    int32_t left = G_EncoderTicks[LEFT];
+    int32_t right = G_EncoderTicks[RIGHT];
+    int32_t leftUm = (left - lastTicks[LEFT]) * UM_PER_VANE;
+    int32_t rightUm = (right - lastTicks[RIGHT]) * UM_PER_VANE;
+    int64_t sumUm = (int64_t)leftUm + rightUm;          // Twice the distance moved
+    int32_t turn = (int32_t)(((int64_t)(rightUm - leftUm) * headingScale) >> 16);
+    uint32_t middle = G_OdometryPose.heading + (uint32_t)(turn / 2);
+
+    lastTicks[LEFT] = left;
+    lastTicks[RIGHT] = right;
+
+    if ((leftUm == 0) && (rightUm == 0)) {
+        return;
+    }
+
+    // Rounded, a truncating shift would pull the pose towards -x and -y
+    G_OdometryPose.x += (int32_t)((sumUm * Odometry_Cos(middle) + Q30_ONE) >> 31);
+    G_OdometryPose.y += (int32_t)((sumUm * Odometry_Sin(middle) + Q30_ONE) >> 31);
+    G_OdometryPose.heading += (uint32_t)turn;
+}
+
+/*******************************************************************************
+* Odometry_Sin() - Fixed point sine.
+* angle     - Binary angle, 2^32 per turn.
+* Returns the sine in Q30.
+*******************************************************************************/
+int32_t Odometry_Sin(uint32_t angle) {
+    int32_t z = (int32_t)angle;
+    int64_t z2, r;
+
+    // Fold the 2nd and 3rd quadrants onto the 1st and 4th, sin(pi - a) = sin(a),
+    // leaving z in [-1, 1] quarter turns in Q30
+    if ((z ^ (int32_t)((uint32_t)z << 1)) < 0) {
+        z = (int32_t)(0x80000000UL - (uint32_t)z);
+    }
+
+    z2 = ((int64_t)z * z) >> 30;
+    r = ODOMETRY_SIN_B - ((z2 * ODOMETRY_SIN_C) >> 30);
+    r = ODOMETRY_SIN_A - ((z2 * r) >> 30);
+
+    return (int32_t)(((int64_t)z * r) >> 30);
+}
+
+/*******************************************************************************
+* Odometry_Cos() - Fixed point cosine.
+* angle     - Binary angle, 2^32 per turn.
+* Returns the cosine in Q30.
+*******************************************************************************/
+int32_t Odometry_Cos(uint32_t angle) {
+    return Odometry_Sin(angle + 0x40000000UL);
+}
@@ -0,0 +1,40 @@
+/*******************************************************************************
+* Name: Odometry.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Differential drive dead reckoning from the signed encoder
+*              tick counts.
+*******************************************************************************/
+
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define ODOMETRY_TRACK_UM       150000UL    // Distance between the wheel contact points
+
+typedef struct {
+    int32_t x;                  // um from the start, +x is the starting heading
+    int32_t y;                  // um, +y is to the left of the starting heading
+    uint32_t heading;           // 2^32 per turn, counter-clockwise from +x
+} OdometryPose;
+
+extern volatile OdometryPose G_OdometryPose;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Odometry_Init(void);
+void Odometry_SetTrackWidth(uint32_t um);
+void Odometry_Reset(void);
+void Odometry_Update(void);
+int32_t Odometry_Sin(uint32_t angle);
+int32_t Odometry_Cos(uint32_t angle);
+
+#endif
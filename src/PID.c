@@ -1,116 +1,253 @@
-/*******************************************************************************
-* Name: PID.c (implementation)
-* Author(s): Noah Grant, Wyatt Richard
-* Date: October 31, 2023
-* Description: PID control.
-*******************************************************************************/
-
-#include "PID.h"
-
-// Code based on: 
-// https://github.com/pms67/PID
-// https://github.com/curiores/ArduinoTutorials/blob/main/SpeedControl/SpeedControl/SpeedControl.ino
-
-/*******************************************************************************
-*                            CONSTANTS & DEFINES                               *
-*******************************************************************************/
-#define PID_PRIORITY 9
-
-#define PID_L_KP 10
-#define PID_L_KI 1
-#define PID_R_KP 10 
-#define PID_R_KI 1
-#define PID_LIM_MIN MIN_DUTY_CYCLE
-#define PID_LIM_MAX MAX_DUTY_CYCLE
-#define PID_LIM_MIN_INT MIN_DUTY_CYCLE
-#define PID_LIM_MAX_INT MAX_DUTY_CYCLE
-
-/*******************************************************************************
-*                               LOCAL VARIABLES                                *
-*******************************************************************************/
-static PIDController PIDLeftEncoder = {PID_L_KP, PID_L_KI, PID_LIM_MIN, PID_LIM_MAX,
-                                    PID_LIM_MIN_INT, PID_LIM_MAX_INT, 0, 0, 0, 0};
-
-static PIDController PIDRightEncoder = {PID_R_KP, PID_R_KI, PID_LIM_MIN, PID_LIM_MAX,
-                                    PID_LIM_MIN_INT, PID_LIM_MAX_INT, 0, 0, 0, 0};
-
-/*******************************************************************************
-*                               PUBLIC FUNCTIONS                               *
-*******************************************************************************/
-/*******************************************************************************
-* PID_Init() - Initialize time for PID control law.
-* No inputs.
-* No return value.
-*******************************************************************************/
-void PID_Init(void) {
-    // Configure TIM4 for PI control law
-    SET_BITS(RCC->APB1ENR, RCC_APB1ENR_TIM4EN);         // Turn on Timer 4
-    SET_BITS(TIM4->PSC, 71UL);                          // Set PSC so it counts in 1us
-    CLEAR_BITS(TIM4->CR1, TIM_CR1_DIR);                 // Set TIM4 counting direction to upcounting
-    FORCE_BITS(TIM4->ARR, 0xFFFFUL, 33332UL);           // Set ARR to 33333us
-    SET_BITS(TIM4->CR1, TIM_CR1_ARPE);                  // Enable ARR preload (ARPE) in CR1
-    CLEAR_BITS(TIM4->CR1, TIM_CR1_UDIS);                // Set update request source
-    CLEAR_BITS(TIM4->CR1, TIM_CR1_URS);                 // Enable update
-    SET_BITS(TIM4->DIER, TIM_DIER_UIE);                 // Enable timer overflow to trigger IRQ
-    NVIC_EnableIRQ(TIM4_IRQn);                          // Enable TIM4 IRQ (TIM4_IRQn) in NVIC
-    NVIC_SetPriority(TIM4_IRQn, PID_PRIORITY);          // Set NVIC priority
-    SET_BITS(TIM4->EGR, TIM_EGR_UG);                    // Force an update event to preload all the registers
-    SET_BITS(TIM4->CR1, TIM_CR1_CEN);                   // Enable TIM4 to start counting
-}
-
-/*******************************************************************************
-* PID_Update() - Update PID controller.
-* pid           - PID controller to update
-* setpoint      - desired output
-* measurement   - current output
-* deltaT        - time since last measurement
-* Returns the new output.
-*******************************************************************************/
-int PID_Update(PIDController *pid, int setpoint, int measurement, int deltaT) {
-    // Error
-    int error = setpoint - measurement;
-
-    
-    // Proportional
-    int proportional = error;
-
-    
-    // Integrator
-    pid->integrator = pid->integrator + (error * deltaT)/1000;
-
-    // Anti-wind-up via integrator clamping
-    if (pid->integrator > pid->limMaxInt) {
-        pid->integrator = pid->limMaxInt;
-    }
-    else if (pid->integrator < pid->limMinInt) {
-        pid->integrator = pid->limMinInt;
-    }
-
-
-    // Compute output and apply limits
-    pid->out = pid->Kp * proportional + pid->Ki * pid->integrator;
-
-    if (pid->out > pid->limMax) {
-        pid->out = pid->limMax;
-    }
-    else if (pid->out < pid->limMin) {
-        pid->out = pid->limMin;
-    }
-
-    
-    // Return controller output
-    return pid->out;
-}
-
-void TIM4_IRQHandler(void) {
-    // Update PWM outputs
-    PID_Update(&PIDLeftEncoder, G_leftEncoderSetpoint, G_leftEncoderSpeed, G_EncoderPeriod[LEFT]);
-    DCMotor_SetPWM(DCMOTOR_LEFT, abs(PIDLeftEncoder.out));
-
-    PID_Update(&PIDRightEncoder, G_rightEncoderSetpoint, G_rightEncoderSpeed, G_EncoderPeriod[RIGHT]);
-    DCMotor_SetPWM(DCMOTOR_RIGHT, abs(PIDRightEncoder.out));
-
-    // Clear interrupt flag
-    CLEAR_BITS(TIM4->SR, TIM_SR_UIF);
-}
-
+/*******************************************************************************
+* Name: PID.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 31, 2023
+* Description: PID control. Q16.16 fixed point wheel speed controllers run
+*              from the control task with the measured time between runs.
+*******************************************************************************/
+
+#include "PID.h"
+#include "Timebase.h"
+#include "Profile.h"
+
+// Code based on: 
+// https://github.com/pms67/PID
+// https://github.com/curiores/ArduinoTutorials/blob/main/SpeedControl/SpeedControl/SpeedControl.ino
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define PID_TAU         Q16(0.02)           // s, derivative filter
+#define PID_KT          Q16(10.0)           // 1/s, about 1/Ti
+#define PID_LIM_MIN     Q16_FROM_INT(MIN_DUTY_CYCLE)
+#define PID_LIM_MAX     Q16_FROM_INT(MAX_DUTY_CYCLE)
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+PIDStats G_PIDStats = {0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+// Defaults until the wheels are auto-tuned (see Tune.c). Softer at low
+// speed, where there are few encoder edges per estimate.
+#define PID_WHEEL_GAINS {                                                   \
+    /*  above           kp          ki          kd          kff         kaff */     \
+    {Q16(0.0),      Q16(1.5),   Q16(15.0),  Q16(0.01),  Q16(1.5),   Q16(0.12)},     \
+    {Q16(15.0),     Q16(2.0),   Q16(20.0),  Q16(0.01),  Q16(1.5),   Q16(0.12)},     \
+}
+#define PID_SCHEDULE_LEN    2
+
+static PIDGains PIDLeftGains[PID_SCHEDULE_LEN] = PID_WHEEL_GAINS;
+static PIDGains PIDRightGains[PID_SCHEDULE_LEN] = PID_WHEEL_GAINS;
+
+static PIDController PIDLeftEncoder = {PIDLeftGains, PID_SCHEDULE_LEN, PID_TAU, PID_KT, PID_LIM_MIN, PID_LIM_MAX,
+                                       NULL, 0, 0, 0, 0, 0};
+
+static PIDController PIDRightEncoder = {PIDRightGains, PID_SCHEDULE_LEN, PID_TAU, PID_KT, PID_LIM_MIN, PID_LIM_MAX,
+                                        NULL, 0, 0, 0, 0, 0};
+
+static uint32_t lastControlUs = 0;
+static uint8_t controlStarted = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* PID_Schedule() - Pick the gains for a setpoint.
+* pid           - PID controller.
+* setpoint      - Desired output.
+* Returns the gains.
+*******************************************************************************/
+static const PIDGains *PID_Schedule(const PIDController *pid, q16_t setpoint) {
+    const PIDGains *gains = &pid->schedule[0];
+    q16_t magnitude = (setpoint < 0) ? -setpoint : setpoint;
+
+    for (uint8_t i = 1; i < pid->scheduleLen; i++) {
+        if (magnitude >= pid->schedule[i].above) {
+            gains = &pid->schedule[i];
+        }
+    }
+
+    return gains;
+}
+
+/*******************************************************************************
+* PID_Wheel() - Run one wheel controller and drive its motor.
+* pid           - PID controller.
+* motor         - DCMOTOR_LEFT or DCMOTOR_RIGHT.
+* dtUs          - Time since the last run.
+* No return value.
+*******************************************************************************/
+static void PID_Wheel(PIDController *pid, uint8_t motor, uint32_t dtUs) {
+    // A stopped wheel starts over instead of winding up against 0 duty
+    if (Profile_GetDir(motor) == DCMOTOR_STOP) {
+        PID_Reset(pid);
+        DCMotor_SetPWM(motor, 0);
+        return;
+    }
+
+    PID_Update(pid, Profile_GetSpeed(motor), Profile_GetSpeedRate(motor), G_EncoderSpeedQ16[motor], dtUs);
+    DCMotor_SetPWM(motor, Q16_TO_INT(pid->out));
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* PID_Init() - Reset the wheel controllers. PID_Control() runs them.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void PID_Init(void) {
+    PID_Reset(&PIDLeftEncoder);
+    PID_Reset(&PIDRightEncoder);
+    controlStarted = 0;
+}
+
+/*******************************************************************************
+* PID_Reset() - Clear a controller's memory.
+* pid           - PID controller to reset.
+* No return value.
+*******************************************************************************/
+void PID_Reset(PIDController *pid) {
+    pid->gains = &pid->schedule[0];
+    pid->integrator = 0;
+    pid->derivative = 0;
+    pid->prevMeasurement = 0;
+    pid->started = 0;
+    pid->out = 0;
+}
+
+/*******************************************************************************
+* PID_Update() - Update PID controller.
+* pid           - PID controller to update
+* setpoint      - desired output
+* setpointRate  - rate of change of the setpoint, per s
+* measurement   - current output
+* dtUs          - time since the last update (us)
+* Returns the new output.
+*******************************************************************************/
+q16_t PID_Update(PIDController *pid, q16_t setpoint, q16_t setpointRate, q16_t measurement, uint32_t dtUs) {
+    q16_t dt, error, proportional, feedforward, unsaturated, twoTau;
+    int64_t derivative;
+
+    if (dtUs > TIMEBASE_MAX_STEP_US) {
+        dtUs = TIMEBASE_MAX_STEP_US;
+    }
+    dt = TIMEBASE_US_TO_Q16_S(dtUs);                    // s
+
+    // The integrator holds % duty, so switching gains doesn't bump the output
+    pid->gains = PID_Schedule(pid, setpoint);
+
+    if (!pid->started) {
+        pid->prevMeasurement = measurement;
+        pid->started = 1;
+    }
+
+    // Error
+    error = setpoint - measurement;
+
+    // Proportional
+    proportional = Q16_MUL(pid->gains->kp, error);
+
+    // Feedforward, the duty the setpoint needs with no load plus the extra
+    // the motor's time constant needs to follow a changing setpoint
+    feedforward = Q16_MUL(pid->gains->kff, setpoint) + Q16_MUL(pid->gains->kaff, setpointRate);
+
+    // Derivative on measurement so setpoint steps don't kick, through a first
+    // order low pass (Tustin): d = (-2 Kd dm + (2 tau - dt) d) / (2 tau + dt)
+    twoTau = 2 * pid->tau;
+    if ((pid->gains->kd != 0) && (twoTau + dt > 0)) {
+        derivative = -2 * (int64_t)Q16_MUL(pid->gains->kd, measurement - pid->prevMeasurement)
+                     + Q16_MUL(twoTau - dt, pid->derivative);
+        pid->derivative = (q16_t)((derivative * Q16_ONE) / (twoTau + dt));
+    }
+    else {
+        pid->derivative = 0;
+    }
+    pid->prevMeasurement = measurement;
+
+    // Compute output and apply limits
+    unsaturated = proportional + feedforward + pid->integrator + pid->derivative;
+    pid->out = unsaturated;
+
+    if (pid->out > pid->limMax) {
+        pid->out = pid->limMax;
+    }
+    else if (pid->out < pid->limMin) {
+        pid->out = pid->limMin;
+    }
+
+    // Integrator with back-calculation anti-windup: while the output is
+    // limited, the excess bleeds out of the integrator at the tracking rate
+    pid->integrator += Q16_MUL(Q16_MUL(pid->gains->ki, error) + Q16_MUL(pid->kt, pid->out - unsaturated), dt);
+
+    // Return controller output
+    return pid->out;
+}
+
+/*******************************************************************************
+* PID_Control() - Run the wheel controllers on the profiled setpoints. Call
+*                 from the control task after Encoder_Update() and
+*                 Profile_Update().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void PID_Control(void) {
+    uint32_t start = Timebase_Cycles();
+    uint32_t now = Timebase_Us();
+    uint32_t dtUs = controlStarted ? (now - lastControlUs) : (1000000UL / PID_RATE_HZ);
+    uint32_t cycles;
+
+    lastControlUs = now;
+    controlStarted = 1;
+
+    PID_Wheel(&PIDLeftEncoder, DCMOTOR_LEFT, dtUs);
+    PID_Wheel(&PIDRightEncoder, DCMOTOR_RIGHT, dtUs);
+
+    cycles = Timebase_Cycles() - start;
+    G_PIDStats.lastCycles = cycles;
+    if (cycles > G_PIDStats.maxCycles) {
+        G_PIDStats.maxCycles = cycles;
+    }
+}
+
+/*******************************************************************************
+* PID_GetOutput() - Get the last output of a wheel controller.
+* wheel         - LEFT or RIGHT.
+* Returns the controller output, rounded to a whole % duty.
+*******************************************************************************/
+int PID_GetOutput(uint8_t wheel) {
+    return Q16_TO_INT((wheel == LEFT) ? PIDLeftEncoder.out : PIDRightEncoder.out);
+}
+
+/*******************************************************************************
+* PID_GetGains() - Get the gains a wheel controller uses at a setpoint.
+* wheel         - LEFT or RIGHT.
+* setpoint      - Speed setpoint, cm/s.
+* Returns the gains.
+*******************************************************************************/
+const PIDGains *PID_GetGains(uint8_t wheel, q16_t setpoint) {
+    return PID_Schedule((wheel == LEFT) ? &PIDLeftEncoder : &PIDRightEncoder, setpoint);
+}
+
+/*******************************************************************************
+* PID_SetGains() - Replace the gains a wheel controller uses at a setpoint.
+*                  The rest of the schedule is kept.
+* wheel         - LEFT or RIGHT.
+* setpoint      - Speed setpoint, cm/s, picks the schedule entry.
+* gains         - New gains, the entry keeps its own above.
+* No return value.
+*******************************************************************************/
+void PID_SetGains(uint8_t wheel, q16_t setpoint, const PIDGains *gains) {
+    PIDController *pid = (wheel == LEFT) ? &PIDLeftEncoder : &PIDRightEncoder;
+    PIDGains *entry = (PIDGains *)PID_Schedule(pid, setpoint);
+
+    entry->kp = gains->kp;
+    entry->ki = gains->ki;
+    entry->kd = gains->kd;
+    entry->kff = gains->kff;
+    entry->kaff = gains->kaff;
+}
@@ -1,46 +1,83 @@
-/*******************************************************************************
-* Name: PID.h (interface)
-* Author(s): Noah Grant, Wyatt Richard
-* Date: October 31, 2023
-* Description: PID control.
-*******************************************************************************/
-
-#ifndef PID_H
-#define PID_H
-
-#include <stdlib.h>
-
-#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
-#include "Utility.h"
-#include "DCMotor.h"
-#include "Encoder.h"
-
-typedef struct {
-    // Controller gains
-    int Kp;
-    int Ki;
-
-    // Output limits
-    int limMin;
-    int limMax;
-
-    // Integrator limits
-    int limMinInt;
-    int limMaxInt;
-
-    // Time between encoder interrupts (deltaT)
-    int deltaT;
-
-    // Controller "memory"
-    int integrator;
-    int prevError;
-
-    // Controller output
-    int out;
-
-} PIDController;
-
-void PID_Init(void);
-int PID_Update(PIDController *pid, int setpoint, int measurement, int deltaT);
-
-#endif
+/*******************************************************************************
+* Name: PID.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 31, 2023
+* Description: PID control.
+*******************************************************************************/
+
+#ifndef PID_H
+#define PID_H
+
+#include <stdlib.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+#include "DCMotor.h"
+#include "Encoder.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define PID_RATE_HZ     200         // Wheel control rate, up to the 1kHz scheduler tick
+
+// Q16.16 fixed point
+typedef int32_t q16_t;
+
+#define Q16_ONE             (1L << 16)
+#define Q16(x)              ((q16_t)((x) * 65536.0 + (((x) >= 0) ? 0.5 : -0.5)))
+#define Q16_FROM_INT(x)     ((q16_t)(x) * Q16_ONE)
+#define Q16_TO_INT(x)       (((x) + Q16_ONE / 2) >> 16)
+#define Q16_MUL(a, b)       ((q16_t)(((int64_t)(a) * (b)) >> 16))
+#define Q16_ABS(x)          (((x) < 0) ? -(x) : (x))
+
+typedef struct {
+    q16_t above;                // Used from this |setpoint| up, cm/s
+    q16_t kp;                   // % duty per cm/s of error
+    q16_t ki;                   // % duty per cm of accumulated error
+    q16_t kd;                   // % duty per cm/s^2 of measurement change
+    q16_t kff;                  // % duty per cm/s of setpoint
+    q16_t kaff;                 // % duty per cm/s^2 of setpoint change
+} PIDGains;
+
+typedef struct {
+    // Gain schedule, sorted by above, the first entry's above is ignored
+    PIDGains *schedule;
+    uint8_t scheduleLen;
+
+    q16_t tau;                  // Derivative low pass time constant, s
+    q16_t kt;                   // Anti-windup tracking gain, 1/s
+
+    // Output limits
+    q16_t limMin;
+    q16_t limMax;
+
+    // Controller "memory"
+    const PIDGains *gains;      // Gains in use
+    q16_t integrator;           // % duty, so gain changes don't bump the output
+    q16_t derivative;           // % duty, filtered
+    q16_t prevMeasurement;
+    uint8_t started;
+
+    // Controller output
+    q16_t out;
+} PIDController;
+
+typedef struct {
+    uint32_t lastCycles;        // PID_Control() execution time, both wheels
+    uint32_t maxCycles;
+} PIDStats;
+
+extern PIDStats G_PIDStats;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void PID_Init(void);
+void PID_Reset(PIDController *pid);
+q16_t PID_Update(PIDController *pid, q16_t setpoint, q16_t setpointRate, q16_t measurement, uint32_t dtUs);
+void PID_Control(void);
+int PID_GetOutput(uint8_t wheel);
+const PIDGains *PID_GetGains(uint8_t wheel, q16_t setpoint);
+void PID_SetGains(uint8_t wheel, q16_t setpoint, const PIDGains *gains);
+
+#endif
@@ -0,0 +1,273 @@
+/*******************************************************************************
+* Name: Power.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Battery voltage and drive current monitoring. ADC2 converts
+*              the drive current sense (PC4, ADC2_IN5) and the battery
+*              divider (PA4, ADC2_IN1) once per PWM period, triggered by
+*              TIM8's TRGO in the middle of the PWM pulses (see DCMotor.c),
+*              and DMA2 channel 1 stores the results in a circular buffer.
+*              No CPU time is spent until half of the buffer is full, then
+*              the ISR averages the POWER_OVERSAMPLE conversions of each
+*              input into one reading. The F303's ADCs can't oversample in
+*              hardware, so this is the oversampler.
+*
+*              Power_Update() runs in the control task and acts on each new
+*              reading: the duty cycles are scaled by the nominal over the
+*              measured battery voltage, so the wheels get the same voltage
+*              for the same PID output as the battery runs down and sags. A
+*              wheel driven at POWER_STALL_DUTY or more that doesn't turn
+*              while the motors draw POWER_STALL_MA is cut off after
+*              POWER_STALL_MS, and over POWER_OVERCURRENT_MA every driven
+*              wheel is cut off at once. Both bridges return through the
+*              one sense resistor, so the current is the sum of both
+*              motors. A cut off wheel runs again once it is commanded to
+*              stop.
+*******************************************************************************/
+
+#include "Power.h"
+#include "DCMotor.h"
+#include "Encoder.h"
+#include "Profile.h"
+#include "PID.h"
+#include "Log.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define POWER_CHANNELS          2           // Conversions per trigger: drive current, battery
+#define POWER_BUFFER_LEN        (POWER_OVERSAMPLE * POWER_CHANNELS * 2)   // Half is averaged while the DMA fills the other
+#define POWER_READING_MS        (POWER_OVERSAMPLE * DCMOTOR_PERIOD_US / 1000)
+#define POWER_ADC_FULL_SCALE    4095UL
+#define POWER_VREF_MV           3300UL
+#define POWER_BATTERY_DIVIDER   3UL         // 20k over 10k
+#define POWER_SENSE_MV_PER_A    500UL       // 0.1 ohm low side resistor into a x5 amplifier, 6.6A full scale
+#define POWER_MAX_SCALE         (DCMOTOR_SCALE_ONE * 3 / 2)
+#define POWER_STALL_SPEED       Q16(1.0)    // cm/s, slower than this isn't turning
+
+#define POWER_SMP_61            5UL         // 61.5 ADC clock sample time
+#define POWER_SMP_181           6UL         // 181.5 ADC clock sample time, for the divider's impedance
+#define POWER_EXTSEL_TIM8_TRGO  7UL         // ADC12 regular trigger
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+volatile PowerState G_Power = {0, 0, 0, DCMOTOR_SCALE_ONE, {CUTOFF_NONE, CUTOFF_NONE}};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static volatile uint16_t powerBuffer[POWER_BUFFER_LEN];
+static uint32_t powerSeen = 0;                  // Readings acted on by Power_Update()
+static uint16_t powerStallMs[2] = {0, 0};
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Power_ToMv() - Convert a sum of POWER_OVERSAMPLE conversions to mV at the pin.
+* sum       - Sum of the conversions.
+* Returns the average voltage in mV.
+*******************************************************************************/
+static uint32_t Power_ToMv(uint32_t sum) {
+    const uint32_t divisor = POWER_ADC_FULL_SCALE * POWER_OVERSAMPLE;
+
+    return (sum * POWER_VREF_MV + divisor / 2) / divisor;
+}
+
+/*******************************************************************************
+* Power_Average() - Turn half of the DMA buffer into a reading.
+* block     - First conversion of the half.
+* No return value.
+*******************************************************************************/
+static void Power_Average(const volatile uint16_t *block) {
+    uint32_t current = 0;
+    uint32_t battery = 0;
+
+    for (uint8_t i = 0; i < POWER_OVERSAMPLE; i++) {
+        current += block[i * POWER_CHANNELS];
+        battery += block[i * POWER_CHANNELS + 1];
+    }
+
+    G_Power.currentMa = (uint16_t)(Power_ToMv(current) * 1000UL / POWER_SENSE_MV_PER_A);
+    G_Power.batteryMv = (uint16_t)(Power_ToMv(battery) * POWER_BATTERY_DIVIDER);
+    G_Power.readings++;
+}
+
+/*******************************************************************************
+* Power_Cutoff() - Cut off a wheel's motor.
+* wheel     - LEFT or RIGHT.
+* reason    - CUTOFF_x.
+* No return value.
+*******************************************************************************/
+static void Power_Cutoff(uint8_t wheel, uint8_t reason) {
+    G_Power.cutoff[wheel] = reason;
+    powerStallMs[wheel] = 0;
+    DCMotor_Cutoff(wheel, 1);
+    LOG("power: wheel %u cut off (%u), %umA at %u%% duty", wheel, reason, G_Power.currentMa,
+        DCMotor_GetPWM(wheel));
+}
+
+/*******************************************************************************
+* Power_Compensate() - Scale the duty cycles for the battery voltage.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Power_Compensate(void) {
+    uint32_t battery = G_Power.batteryMv;
+    uint32_t scale = DCMOTOR_SCALE_ONE;
+
+    if (battery >= POWER_MIN_MV) {
+        scale = ((uint32_t)POWER_NOMINAL_MV << 16) / battery;
+        if (scale > POWER_MAX_SCALE) {
+            scale = POWER_MAX_SCALE;
+        }
+    }
+
+    if (scale != G_Power.scale) {
+        G_Power.scale = scale;
+        DCMotor_SetScale(scale);
+    }
+}
+
+/*******************************************************************************
+* Power_Protect() - Check a wheel for a stall or over-current, or release it
+*                   once it is commanded to stop.
+* wheel     - LEFT or RIGHT.
+* elapsedMs - Time since the last reading acted on.
+* No return value.
+*******************************************************************************/
+static void Power_Protect(uint8_t wheel, uint16_t elapsedMs) {
+    uint16_t duty = DCMotor_GetPWM(wheel);
+    q16_t speed = Q16_ABS(G_EncoderSpeedQ16[wheel]);
+
+    if (G_Power.cutoff[wheel] != CUTOFF_NONE) {
+        if (Profile_GetDir(wheel) == DCMOTOR_STOP) {
+            G_Power.cutoff[wheel] = CUTOFF_NONE;
+            DCMotor_Cutoff(wheel, 0);
+        }
+        return;
+    }
+
+    if ((duty != 0) && (G_Power.currentMa >= POWER_OVERCURRENT_MA)) {
+        Power_Cutoff(wheel, CUTOFF_OVERCURRENT);
+    }
+    else if ((duty >= POWER_STALL_DUTY) && (speed < POWER_STALL_SPEED) && (G_Power.currentMa >= POWER_STALL_MA)) {
+        powerStallMs[wheel] += elapsedMs;
+        if (powerStallMs[wheel] >= POWER_STALL_MS) {
+            Power_Cutoff(wheel, CUTOFF_STALL);
+        }
+    }
+    else {
+        powerStallMs[wheel] = 0;
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Power_Init() - Start the ADC conversions on the PWM timer. Call after
+*                DCMotor_Init(), which sets up the trigger.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Power_Init(void) {
+    // Configure PA4 (battery divider) and PC4 (current sense amplifier) as analog inputs
+    ENABLE_GPIO_CLOCK(A);
+    ENABLE_GPIO_CLOCK(C);
+    GPIO_MODER_SET(A, 4, GPIO_MODE_ANLG);
+    GPIO_MODER_SET(C, 4, GPIO_MODE_ANLG);
+    GPIO_PUPDR_SET(A, 4, GPIO_PUPD_NO);
+    GPIO_PUPDR_SET(C, 4, GPIO_PUPD_NO);
+
+    // Clock ADC1/2 from HCLK (72MHz), synchronous with the trigger
+    SET_BITS(RCC->AHBENR, RCC_AHBENR_ADC12EN);
+    FORCE_BITS(ADC12_COMMON->CCR, ADC_CCR_CKMODE, ADC_CCR_CKMODE_0);
+
+    // Turn on the voltage regulator (10 -> 00 -> 01) and give it 10us to start
+    CLEAR_BITS(ADC2->CR, ADC_CR_ADVREGEN);
+    SET_BITS(ADC2->CR, ADC_CR_ADVREGEN_0);
+    Delay_us(10);
+
+    // Single ended calibration, then enable
+    CLEAR_BITS(ADC2->CR, ADC_CR_ADCALDIF);
+    SET_BITS(ADC2->CR, ADC_CR_ADCAL);
+    while (ADC2->CR & ADC_CR_ADCAL) SIM_YIELD();
+    Delay_us(1);                                    // 4 ADC clocks between ADCAL and ADEN
+    SET_BITS(ADC2->CR, ADC_CR_ADEN);
+    while (!(ADC2->ISR & ADC_ISR_ADRDY)) SIM_YIELD();
+
+    // Regular sequence: current first so it is closest to the middle of the pulses, then battery
+    FORCE_BITS(ADC2->SMPR1, ADC_SMPR1_SMP5, POWER_SMP_61 << ADC_SMPR1_SMP5_Pos);
+    FORCE_BITS(ADC2->SMPR1, ADC_SMPR1_SMP1, POWER_SMP_181 << ADC_SMPR1_SMP1_Pos);
+    ADC2->SQR1 = ((POWER_CHANNELS - 1) << ADC_SQR1_L_Pos)
+               | (5UL << ADC_SQR1_SQ1_Pos)
+               | (1UL << ADC_SQR1_SQ2_Pos);
+
+    // 12 bit right aligned, one sequence per rising edge of TIM8 TRGO, results
+    // by DMA in circular mode, a late DMA overwrites instead of stopping the ADC
+    ADC2->CFGR = ADC_CFGR_DMAEN
+               | ADC_CFGR_DMACFG
+               | ADC_CFGR_OVRMOD
+               | ADC_CFGR_EXTEN_0
+               | (POWER_EXTSEL_TIM8_TRGO << ADC_CFGR_EXTSEL_Pos);
+
+    // DMA2 channel 1 (ADC2) fills the buffer in circular mode, interrupting at each half
+    SET_BITS(RCC->AHBENR, RCC_AHBENR_DMA2EN);
+    CLEAR_BITS(DMA2_Channel1->CCR, DMA_CCR_EN);
+    DMA2_Channel1->CPAR = (uint32_t)&ADC2->DR;
+    DMA2_Channel1->CMAR = (uint32_t)powerBuffer;
+    DMA2_Channel1->CNDTR = POWER_BUFFER_LEN;
+    DMA2_Channel1->CCR = DMA_CCR_MINC           // Increment memory address, peripheral is fixed
+                       | DMA_CCR_CIRC           // Wrap around to the start of the buffer
+                       | DMA_CCR_PSIZE_0        // 16-bit peripheral and memory sizes
+                       | DMA_CCR_MSIZE_0
+                       | DMA_CCR_HTIE           // Interrupt when either half is full
+                       | DMA_CCR_TCIE;          // Read from peripheral, low priority
+    NVIC_SetPriority(DMA2_Channel1_IRQn, POWER_PRIORITY);
+    NVIC_EnableIRQ(DMA2_Channel1_IRQn);
+    SET_BITS(DMA2_Channel1->CCR, DMA_CCR_EN);
+
+    // Wait for the triggers
+    SET_BITS(ADC2->CR, ADC_CR_ADSTART);
+}
+
+/*******************************************************************************
+* Power_Update() - Act on a new reading: battery compensation and the motor
+*                  cutoff. Call from the control task before PID_Control().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Power_Update(void) {
+    uint32_t readings = G_Power.readings;
+    uint32_t elapsed = (readings - powerSeen) * POWER_READING_MS;
+
+    if (readings == powerSeen) {
+        return;
+    }
+    powerSeen = readings;
+
+    Power_Compensate();
+    Power_Protect(LEFT, (elapsed > 0xFFFF) ? 0xFFFF : (uint16_t)elapsed);
+    Power_Protect(RIGHT, (elapsed > 0xFFFF) ? 0xFFFF : (uint16_t)elapsed);
+}
+
+/*******************************************************************************
+*                            INTERRUPT HANDLERS                                *
+*******************************************************************************/
+/*******************************************************************************
+* DMA2_Channel1_IRQHandler() - Half of the buffer is full, average it while the
+*                              DMA fills the other half.
+*******************************************************************************/
+void DMA2_Channel1_IRQHandler(void) {
+    uint32_t isr = DMA2->ISR;
+
+    DMA2->IFCR = DMA_IFCR_CGIF1;
+    if (isr & DMA_ISR_TCIF1) {
+        Power_Average(&powerBuffer[POWER_BUFFER_LEN / 2]);
+    }
+    else if (isr & DMA_ISR_HTIF1) {
+        Power_Average(powerBuffer);
+    }
+}
@@ -0,0 +1,47 @@
+/*******************************************************************************
+* Name: Power.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Battery voltage and drive current monitoring, battery
+*              compensation of the PWM duty cycles and the motor
+*              over-current/stall cutoff.
+*******************************************************************************/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+#include "Messages.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define POWER_PRIORITY          11
+#define POWER_OVERSAMPLE        16          // PWM periods averaged into each reading
+#define POWER_NOMINAL_MV        7200        // Battery voltage the duty cycles (and PID gains) are for
+#define POWER_MIN_MV            5000        // Below this there is no battery (USB power), no compensation
+#define POWER_OVERCURRENT_MA    5000        // Drive current that cuts off the driven motors
+#define POWER_STALL_MA          500         // Drive current that confirms a stall
+#define POWER_STALL_DUTY        30          // % duty from which a wheel that doesn't turn is stalled
+#define POWER_STALL_MS          300         // Time stalled before the cutoff
+
+typedef struct {
+    uint16_t batteryMv;         // 0 until the first reading
+    uint16_t currentMa;         // Both motors, in the middle of the PWM pulses
+    uint32_t readings;          // Readings since reset, one per POWER_OVERSAMPLE PWM periods
+    uint32_t scale;             // Q16 duty cycle scale applied, POWER_NOMINAL_MV / batteryMv
+    uint8_t cutoff[2];          // CUTOFF_x per wheel
+} PowerState;
+
+extern volatile PowerState G_Power;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Power_Init(void);
+void Power_Update(void);
+
+#endif
@@ -0,0 +1,213 @@
+/*******************************************************************************
+* Name: Profile.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Wheel velocity profiles. Each control step the profiled velocity
+*              of each wheel moves toward its Kinematics target with its
+*              acceleration and jerk limited, so speed changes are S-curves
+*              (trapezoids with no jerk limit) and reversals pass smoothly
+*              through zero. The wheel directions and controller setpoints
+*              come from the profiled velocity.
+*******************************************************************************/
+
+#include "Profile.h"
+#include "Timebase.h"
+#include "Kinematics.h"
+#include "Collision.h"
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    q16_t velocity;             // cm/s, negative is backwards
+    q16_t accel;                // cm/s^2
+} ProfileWheel;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static ProfileWheel profileWheels[2];
+static q16_t profileAccel = PROFILE_ACCEL;
+static q16_t profileJerk = PROFILE_JERK;
+static uint32_t lastUs = 0;
+static uint8_t started = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Profile_Step() - Move one wheel's velocity toward its target.
+* wheel     - Wheel profile.
+* target    - Target velocity, cm/s.
+* dt        - Step, s.
+* No return value.
+*******************************************************************************/
+static void Profile_Step(ProfileWheel *wheel, q16_t target, q16_t dt) {
+    q16_t error = target - wheel->velocity;
+    q16_t desired, step;
+
+    if (profileJerk == 0) {
+        // Trapezoidal, full acceleration straight away
+        step = Q16_MUL(profileAccel, dt);
+        if (error > step) {
+            wheel->velocity += step;
+            wheel->accel = profileAccel;
+        }
+        else if (error < -step) {
+            wheel->velocity -= step;
+            wheel->accel = -profileAccel;
+        }
+        else {
+            wheel->velocity = target;
+            wheel->accel = 0;
+        }
+        return;
+    }
+
+    // Land on the target once within a step of it, instead of dithering
+    step = Q16_MUL(profileJerk, dt);
+    if ((Q16_ABS(error) <= Q16_MUL(step, dt)) && (Q16_ABS(wheel->accel) <= step)) {
+        wheel->velocity = target;
+        wheel->accel = 0;
+        return;
+    }
+
+    // Velocity the current acceleration still adds while the jerk limit
+    // brings it back to zero. Start easing off once that covers the error.
+    {
+        q16_t coast = (q16_t)(((int64_t)wheel->accel * Q16_ABS(wheel->accel)) / (2 * (int64_t)profileJerk));
+
+        desired = (error - coast > 0) ? profileAccel : -profileAccel;
+    }
+
+    // Change the acceleration by at most the jerk limit
+    if (desired - wheel->accel > step) {
+        wheel->accel += step;
+    }
+    else if (desired - wheel->accel < -step) {
+        wheel->accel -= step;
+    }
+    else {
+        wheel->accel = desired;
+    }
+
+    wheel->velocity += Q16_MUL(wheel->accel, dt);
+
+    // Don't overshoot it
+    if (((error >= 0) && (wheel->velocity >= target)) || ((error <= 0) && (wheel->velocity <= target))) {
+        wheel->velocity = target;
+        wheel->accel = 0;
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Profile_Init() - Start both wheels at rest with the default limits.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Profile_Init(void) {
+    for (uint8_t i = 0; i < 2; i++) {
+        profileWheels[i].velocity = 0;
+        profileWheels[i].accel = 0;
+    }
+    Profile_SetLimits(PROFILE_ACCEL, PROFILE_JERK);
+    started = 0;
+}
+
+/*******************************************************************************
+* Profile_SetLimits() - Set the profile limits.
+* accel     - Acceleration limit, cm/s^2, must be above 0.
+* jerk      - Jerk limit, cm/s^3, 0 for trapezoidal profiles.
+* No return value.
+*******************************************************************************/
+void Profile_SetLimits(q16_t accel, q16_t jerk) {
+    if (accel > 0) {
+        profileAccel = accel;
+    }
+    profileJerk = (jerk > 0) ? jerk : 0;
+}
+
+/*******************************************************************************
+* Profile_Update() - Step the profiles toward the commanded wheel velocities.
+*                    Call from the control task before PID_Control().
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Profile_Update(void) {
+    uint32_t now = Timebase_Us();
+    uint32_t dtUs = started ? (now - lastUs) : 0;
+    q16_t dt, left, right;
+
+    lastUs = now;
+    started = 1;
+    if (dtUs > TIMEBASE_MAX_STEP_US) {
+        dtUs = TIMEBASE_MAX_STEP_US;
+    }
+    dt = TIMEBASE_US_TO_Q16_S(dtUs);
+
+    left = Kinematics_GetTarget(LEFT);
+    right = Kinematics_GetTarget(RIGHT);
+    Collision_Limit(&left, &right);
+
+    Profile_Step(&profileWheels[LEFT], left, dt);
+    Profile_Step(&profileWheels[RIGHT], right, dt);
+}
+
+/*******************************************************************************
+* Profile_GetVelocity() - Get the profiled velocity of a wheel.
+* wheel     - LEFT or RIGHT.
+* Returns the velocity in cm/s, negative is backwards.
+*******************************************************************************/
+q16_t Profile_GetVelocity(uint8_t wheel) {
+    return (wheel <= RIGHT) ? profileWheels[wheel].velocity : 0;
+}
+
+/*******************************************************************************
+* Profile_GetSpeed() - Get the profiled speed of a wheel, the controller
+*                      setpoint.
+* wheel     - LEFT or RIGHT.
+* Returns the speed in cm/s.
+*******************************************************************************/
+q16_t Profile_GetSpeed(uint8_t wheel) {
+    q16_t velocity = Profile_GetVelocity(wheel);
+
+    return (velocity < 0) ? -velocity : velocity;
+}
+
+/*******************************************************************************
+* Profile_GetSpeedRate() - Get the rate of change of a wheel's profiled speed,
+*                          the controller setpoint.
+* wheel     - LEFT or RIGHT.
+* Returns the rate in cm/s^2, negative while slowing down.
+*******************************************************************************/
+q16_t Profile_GetSpeedRate(uint8_t wheel) {
+    const ProfileWheel *profile;
+
+    if (wheel > RIGHT) {
+        return 0;
+    }
+
+    profile = &profileWheels[wheel];
+    return (profile->velocity < 0) ? -profile->accel : profile->accel;
+}
+
+/*******************************************************************************
+* Profile_GetDir() - Get the direction a wheel should be driven in.
+* wheel     - LEFT or RIGHT.
+* Returns DCMOTOR_FWD, DCMOTOR_BWD, or DCMOTOR_STOP at zero velocity.
+*******************************************************************************/
+uint8_t Profile_GetDir(uint8_t wheel) {
+    q16_t velocity = Profile_GetVelocity(wheel);
+
+    if (velocity > 0) {
+        return DCMOTOR_FWD;
+    }
+    else if (velocity < 0) {
+        return DCMOTOR_BWD;
+    }
+
+    return DCMOTOR_STOP;
+}
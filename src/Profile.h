@@ -0,0 +1,34 @@
+/*******************************************************************************
+* Name: Profile.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Jerk and acceleration limited wheel velocity profiles between
+*              the drive commands and the wheel controllers.
+*******************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "PID.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define PROFILE_ACCEL       Q16(150.0)      // cm/s^2, 0 to DCMOTOR_SPEED_BASE in ~0.2s
+#define PROFILE_JERK        Q16(1500.0)     // cm/s^3, 0 for a trapezoidal profile
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Profile_Init(void);
+void Profile_SetLimits(q16_t accel, q16_t jerk);
+void Profile_Update(void);
+q16_t Profile_GetVelocity(uint8_t wheel);
+q16_t Profile_GetSpeed(uint8_t wheel);
+q16_t Profile_GetSpeedRate(uint8_t wheel);
+uint8_t Profile_GetDir(uint8_t wheel);
+
+#endif
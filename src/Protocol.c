@@ -0,0 +1,165 @@
+/*******************************************************************************
+* Name: Protocol.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: COBS framed, CRC checked binary protocol over USART3. The CRC
+*              is computed by the CRC calculation unit, so frames must only be
+*              sent and received from the main loop.
+*******************************************************************************/
+
+#include "Protocol.h"
+#include "COBS.h"
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+ProtocolStats G_ProtocolStats = {0, 0, 0, 0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint8_t rxEncoded[PROTOCOL_MAX_ENCODED];     // Encoded frame being received
+static uint16_t rxEncodedLen = 0;
+static uint8_t rxOverflow = 0;                      // Discard bytes until the next delimiter
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Protocol_Decode() - Decode and check a received frame.
+* frame     - Frame to fill in.
+* Returns 1 if the frame is valid, otherwise 0.
+*******************************************************************************/
+static uint8_t Protocol_Decode(ProtocolFrame *frame) {
+    uint8_t raw[PROTOCOL_MAX_ENCODED];
+    int16_t rawLen = COBS_Decode(rxEncoded, rxEncodedLen, raw);
+
+    // Need at least a type and a CRC
+    if ((rawLen < 3) || (rawLen > PROTOCOL_MAX_RAW)) {
+        G_ProtocolStats.rxFramingErrors++;
+        return 0;
+    }
+
+    uint16_t crc = raw[rawLen - 2] | (raw[rawLen - 1] << 8);
+    if (Protocol_CRC16(raw, rawLen - 2) != crc) {
+        G_ProtocolStats.rxCrcErrors++;
+        return 0;
+    }
+
+    frame->type = raw[0];
+    frame->len = rawLen - 3;
+    for (uint8_t i = 0; i < frame->len; i++) {
+        frame->payload[i] = raw[i + 1];
+    }
+
+    G_ProtocolStats.rxFrames++;
+    return 1;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Protocol_Init() - Configure the CRC calculation unit for CRC-16/CCITT-FALSE.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Protocol_Init(void) {
+    SET_BITS(RCC->AHBENR, RCC_AHBENR_CRCEN);                        // Turn on the CRC unit
+    FORCE_BITS(CRC->CR, CRC_CR_POLYSIZE, CRC_CR_POLYSIZE_0);        // 16-bit polynomial
+    CLEAR_BITS(CRC->CR, CRC_CR_REV_IN | CRC_CR_REV_OUT);            // No bit reversal
+    CRC->POL = PROTOCOL_CRC_POLY;
+    CRC->INIT = PROTOCOL_CRC_INIT;
+}
+
+/*******************************************************************************
+* Protocol_CRC16() - Compute the frame CRC with the CRC calculation unit.
+* data      - Data to check.
+* len       - Length of data.
+* Returns the CRC.
+*******************************************************************************/
+uint16_t Protocol_CRC16(const uint8_t *data, uint16_t len) {
+    SET_BITS(CRC->CR, CRC_CR_RESET);                // Load INIT into the data register
+
+    // Byte writes so only 8 bits are shifted in per write
+    for (uint16_t i = 0; i < len; i++) {
+        *(__IO uint8_t *)&CRC->DR = data[i];
+    }
+
+    return (uint16_t)(CRC->DR & 0xFFFFUL);
+}
+
+/*******************************************************************************
+* Protocol_Send() - Frame and queue a message for transmission (non-blocking).
+* type      - Message type (MSG_x).
+* payload   - Message payload.
+* len       - Length of payload.
+* Returns 1 if the frame was queued, otherwise 0.
+*******************************************************************************/
+uint8_t Protocol_Send(uint8_t type, const void *payload, uint8_t len) {
+    uint8_t raw[PROTOCOL_MAX_RAW];
+    uint8_t encoded[PROTOCOL_MAX_ENCODED];
+    uint16_t crc;
+    uint16_t encodedLen;
+
+    if (len > PROTOCOL_MAX_PAYLOAD) {
+        G_ProtocolStats.txDropped++;
+        return 0;
+    }
+
+    raw[0] = type;
+    for (uint8_t i = 0; i < len; i++) {
+        raw[i + 1] = ((const uint8_t *)payload)[i];
+    }
+    crc = Protocol_CRC16(raw, len + 1);
+    raw[len + 1] = crc & 0xFF;
+    raw[len + 2] = crc >> 8;
+
+    encodedLen = COBS_Encode(raw, len + 3, encoded);
+    encoded[encodedLen++] = PROTOCOL_DELIMITER;
+
+    if (UART_Write(&G_USART3, encoded, encodedLen) == 0) {
+        G_ProtocolStats.txDropped++;
+        return 0;
+    }
+
+    G_ProtocolStats.txFrames++;
+    return 1;
+}
+
+/*******************************************************************************
+* Protocol_Receive() - Process received characters until a frame is complete.
+* frame     - Frame to fill in.
+* Returns 1 if a valid frame was received, 0 if there is nothing more to read.
+*******************************************************************************/
+uint8_t Protocol_Receive(ProtocolFrame *frame) {
+    uint8_t c;
+
+    while (UART_Read(&G_USART3, &c, 1) != 0) {
+        if (c == PROTOCOL_DELIMITER) {
+            uint8_t valid = 0;
+
+            if (rxOverflow) {
+                G_ProtocolStats.rxFramingErrors++;
+            }
+            else if (rxEncodedLen != 0) {
+                valid = Protocol_Decode(frame);
+            }
+
+            rxEncodedLen = 0;
+            rxOverflow = 0;
+
+            if (valid) {
+                return 1;
+            }
+        }
+        else if (rxEncodedLen < PROTOCOL_MAX_ENCODED) {
+            rxEncoded[rxEncodedLen++] = c;
+        }
+        else {
+            rxOverflow = 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************
+* Name: Protocol.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: COBS framed, CRC checked binary protocol over USART3.
+*******************************************************************************/
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+#include "UART.h"
+#include "Messages.h"
+
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+} ProtocolFrame;
+
+typedef struct {
+    uint32_t rxFrames;          // Valid frames received
+    uint32_t rxCrcErrors;       // Frames dropped because of a bad CRC
+    uint32_t rxFramingErrors;   // Frames dropped because of bad COBS or length
+    uint32_t txFrames;          // Frames queued for transmission
+    uint32_t txDropped;         // Frames dropped because the transmit buffer was full
+} ProtocolStats;
+
+extern ProtocolStats G_ProtocolStats;
+
+void Protocol_Init(void);
+uint16_t Protocol_CRC16(const uint8_t *data, uint16_t len);
+uint8_t Protocol_Send(uint8_t type, const void *payload, uint8_t len);
+uint8_t Protocol_Receive(ProtocolFrame *frame);
+
+#endif
@@ -0,0 +1,140 @@
+/*******************************************************************************
+* Name: Queue.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Lock-free single-producer/single-consumer byte queue. The
+*              producer only writes head and the consumer only writes tail, and
+*              each publishes its index after touching the data, so one ISR and
+*              the main loop can share a queue without disabling interrupts.
+*              One slot is kept empty to tell a full queue from an empty one.
+*******************************************************************************/
+
+#include "Queue.h"
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Queue_Init() - Initialize an empty queue.
+* queue     - Queue to initialize.
+* buff      - Storage for the queue.
+* size      - Size of buff, must be a power of 2.
+* No return value.
+*******************************************************************************/
+void Queue_Init(Queue *queue, volatile uint8_t *buff, uint16_t size) {
+    queue->buff = buff;
+    queue->mask = size - 1;
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+/*******************************************************************************
+* Queue_Count() - Number of bytes waiting in the queue.
+* queue     - Queue to check.
+* Returns the number of bytes.
+*******************************************************************************/
+uint16_t Queue_Count(const Queue *queue) {
+    return (queue->head - queue->tail) & queue->mask;
+}
+
+/*******************************************************************************
+* Queue_Space() - Number of bytes that can be pushed.
+* queue     - Queue to check.
+* Returns the number of bytes.
+*******************************************************************************/
+uint16_t Queue_Space(const Queue *queue) {
+    return queue->mask - Queue_Count(queue);
+}
+
+/*******************************************************************************
+* Queue_Push() - Push data onto the queue (producer only).
+* queue     - Queue to push onto.
+* data      - Data to push.
+* len       - Length of data.
+* Returns len if the data was pushed, or 0 if it does not fit (nothing pushed).
+*******************************************************************************/
+uint16_t Queue_Push(Queue *queue, const uint8_t *data, uint16_t len) {
+    uint16_t head = queue->head;
+
+    if (len > Queue_Space(queue)) {
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < len; i++) {
+        queue->buff[head] = data[i];
+        head = (head + 1) & queue->mask;
+    }
+
+    // Publish after the data is written
+    queue->head = head;
+    return len;
+}
+
+/*******************************************************************************
+* Queue_Publish() - Publish data written directly into the buffer, e.g. by a
+*                   DMA (producer only).
+* queue     - Queue to publish.
+* head      - New head position.
+* No return value.
+*******************************************************************************/
+void Queue_Publish(Queue *queue, uint16_t head) {
+    queue->head = head & queue->mask;
+}
+
+/*******************************************************************************
+* Queue_Pop() - Pop data off the queue (consumer only).
+* queue     - Queue to pop from.
+* data      - Buffer for the data.
+* len       - Size of data.
+* Returns the number of bytes popped.
+*******************************************************************************/
+uint16_t Queue_Pop(Queue *queue, uint8_t *data, uint16_t len) {
+    uint16_t head = queue->head;
+    uint16_t tail = queue->tail;
+    uint16_t count = 0;
+
+    while ((tail != head) && (count < len)) {
+        data[count++] = queue->buff[tail];
+        tail = (tail + 1) & queue->mask;
+    }
+
+    // Release after the data is read
+    queue->tail = tail;
+    return count;
+}
+
+/*******************************************************************************
+* Queue_Contiguous() - Number of bytes that can be read from the tail without
+*                      wrapping, e.g. for a DMA transfer (consumer only).
+* queue     - Queue to check.
+* Returns the number of bytes starting at &buff[tail].
+*******************************************************************************/
+uint16_t Queue_Contiguous(const Queue *queue) {
+    uint16_t head = queue->head;
+    uint16_t tail = queue->tail;
+
+    if (head >= tail) {
+        return head - tail;
+    }
+
+    return (queue->mask + 1) - tail;
+}
+
+/*******************************************************************************
+* Queue_Release() - Release bytes read directly from the buffer (consumer only).
+* queue     - Queue to release from.
+* len       - Number of bytes to release.
+* No return value.
+*******************************************************************************/
+void Queue_Release(Queue *queue, uint16_t len) {
+    queue->tail = (queue->tail + len) & queue->mask;
+}
+
+/*******************************************************************************
+* Queue_Flush() - Drop everything waiting in the queue (consumer only).
+* queue     - Queue to flush.
+* No return value.
+*******************************************************************************/
+void Queue_Flush(Queue *queue) {
+    queue->tail = queue->head;
+}
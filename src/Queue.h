@@ -0,0 +1,35 @@
+/*******************************************************************************
+* Name: Queue.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Lock-free single-producer/single-consumer byte queue. Only
+*              depends on standard C headers so it can be built on the host.
+*******************************************************************************/
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint8_t *buff;
+    uint16_t mask;              // Size - 1, size must be a power of 2
+    volatile uint16_t head;     // Next slot to write, only written by the producer
+    volatile uint16_t tail;     // Next slot to read, only written by the consumer
+} Queue;
+
+void Queue_Init(Queue *queue, volatile uint8_t *buff, uint16_t size);
+uint16_t Queue_Count(const Queue *queue);
+uint16_t Queue_Space(const Queue *queue);
+
+// Producer side
+uint16_t Queue_Push(Queue *queue, const uint8_t *data, uint16_t len);
+void Queue_Publish(Queue *queue, uint16_t head);
+
+// Consumer side
+uint16_t Queue_Pop(Queue *queue, uint8_t *data, uint16_t len);
+uint16_t Queue_Contiguous(const Queue *queue);
+void Queue_Release(Queue *queue, uint16_t len);
+void Queue_Flush(Queue *queue);
+
+#endif
@@ -0,0 +1,242 @@
+/*******************************************************************************
+* Name: Scan.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Range scanner. While it runs the stepper sweeps the sensor back
+*              and forth between its limit switches, in place of the stepper
+*              commands, and the sensor ranges at the fastest rate it allows.
+*              The stepper turns in half steps at the rate that puts the
+*              readings the chosen spacing apart, the fastest sweep that
+*              doesn't leave gaps. Each reading already carries the pan it
+*              was taken at, so the sweep never stops for one. Readings are
+*              sent in frames of up to SCAN_FRAME_POINTS with the pose the
+*              robot had when the frame was sent, so the host can place them
+*              while it drives. While the link is busy the readings wait in
+*              the ultrasonic ring, a sweep that ends meanwhile loses the rest
+*              of its readings.
+*******************************************************************************/
+
+#include "Scan.h"
+#include "Ultrasonic.h"
+#include "Stepper.h"
+#include "Odometry.h"
+#include "Timebase.h"
+#include "Link.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define SCAN_CYCLE_US           (1000000UL / ULTRA_MAX_RATE_HZ)   // Between readings
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    int16_t pan;
+    uint16_t range;
+    uint32_t time;              // Timebase_Us() at the reflection
+} ScanReading;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint8_t scanActive = 0;
+static int16_t scanRate = 0;            // Half steps/s
+static int16_t scanLimit = 0;           // Turn around this far either side of centre
+static int8_t scanDir = 1;              // 1 is clockwise
+static uint32_t scanSeen = 0;           // Ultrasonic samples looked at
+static uint16_t scanSweep = 0;
+static uint8_t scanIndex = 0;           // Point number in the sweep of readings[0]
+static ScanReading scanReadings[SCAN_FRAME_POINTS];
+static uint8_t scanCount = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Scan_Send() - Send the buffered readings as a scan frame.
+* last      - 1 if the sweep is over.
+* Returns 1 if the readings were sent, 0 if they are held.
+*******************************************************************************/
+static uint8_t Scan_Send(uint8_t last) {
+    MsgScan msg;
+    uint32_t nowUs = Timebase_Us();
+
+    if ((scanCount == 0) && !last) {
+        return 1;
+    }
+
+    // The next sweep can't wait for the end of this one, so its readings are
+    // dropped
+    if (!Link_CanSend(PROTOCOL_MAX_ENCODED)) {
+        if (last) {
+            scanIndex += scanCount;
+            scanCount = 0;
+        }
+        return 0;
+    }
+
+    msg.sweep = scanSweep;
+    msg.index = scanIndex;
+    msg.count = scanCount;
+    msg.flags = ((scanDir > 0) ? SCAN_CLOCKWISE : 0) | (last ? SCAN_LAST : 0);
+    msg.time = Timebase_Ms();
+    msg.poseX = G_OdometryPose.x / 1000;
+    msg.poseY = G_OdometryPose.y / 1000;
+    msg.poseHeading = G_OdometryPose.heading >> 16;
+    for (uint8_t i = 0; i < scanCount; i++) {
+        msg.points[i].pan = scanReadings[i].pan;
+        msg.points[i].range = scanReadings[i].range;
+        msg.points[i].dt = (int16_t)((int32_t)(scanReadings[i].time - nowUs) / 1000);
+    }
+
+    // Only the points that are used
+    Protocol_Send(MSG_SCAN, &msg, sizeof(msg) - sizeof(msg.points) + scanCount * sizeof(ScanPoint));
+
+    scanIndex += scanCount;
+    scanCount = 0;
+    return 1;
+}
+
+/*******************************************************************************
+* Scan_Read() - Buffer the new ultrasonic readings.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Scan_Read(void) {
+    uint32_t count = Ultra_GetCount();
+    UltraSample sample;
+
+    if (count - scanSeen > ULTRA_RING_SIZE) {
+        scanSeen = count - ULTRA_RING_SIZE;
+    }
+    for (; scanSeen != count; scanSeen++) {
+        // A held frame keeps the rest in the ultrasonic ring
+        if ((scanCount == SCAN_FRAME_POINTS) && !Scan_Send(0)) {
+            return;
+        }
+        if (!Ultra_GetSample(scanSeen, &sample)) {
+            continue;
+        }
+
+        // Each reading on its own, the median would mix in other bearings
+        scanReadings[scanCount].pan = sample.pan;
+        scanReadings[scanCount].range = (sample.status == ULTRA_OK) ? (sample.echo / ULTRA_US_PER_CM) : ULTRA_NO_RANGE;
+        scanReadings[scanCount].time = sample.time;
+        scanCount++;
+        if (scanCount == SCAN_FRAME_POINTS) {
+            Scan_Send(0);
+        }
+    }
+}
+
+/*******************************************************************************
+* Scan_Turn() - Check whether the sweep has reached its end.
+* No inputs.
+* Returns 1 if the sweep has to turn around.
+*******************************************************************************/
+static uint8_t Scan_Turn(void) {
+    if (scanDir > 0) {
+        return (G_StepperPosition >= scanLimit) || !LimitSwitch_PressCheck(RIGHT);
+    }
+
+    return (G_StepperPosition <= -scanLimit) || !LimitSwitch_PressCheck(LEFT);
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Scan_Start() - Start sweeping, first clockwise.
+* spacing   - Half steps between readings, 0 for SCAN_DEFAULT_SPACING.
+* No return value.
+*******************************************************************************/
+void Scan_Start(uint8_t spacing) {
+    int16_t travel = Stepper_GetTravel();
+
+    if (spacing == 0) {
+        spacing = SCAN_DEFAULT_SPACING;
+    }
+    if (spacing < SCAN_MIN_SPACING) {
+        spacing = SCAN_MIN_SPACING;
+    }
+    scanRate = (int16_t)(spacing * 1000000UL / SCAN_CYCLE_US);
+
+    // Not ranged yet, turn around at the limit switches only
+    scanLimit = (travel > 2 * SCAN_MARGIN) ? (travel / 2 - SCAN_MARGIN) : INT16_MAX;
+    scanDir = 1;
+    scanSeen = Ultra_GetCount();
+    scanIndex = 0;
+    scanCount = 0;
+    scanActive = 1;
+
+    Ultra_SetRate(ULTRA_MAX_RATE_HZ);
+    Stepper_SetStepMode(STEPPER_MODE_HALF);
+    Stepper_SetVelocity(scanRate);
+}
+
+/*******************************************************************************
+* Scan_Stop() - Stop sweeping, send what is left of the sweep and centre the
+*               sensor again.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Scan_Stop(void) {
+    if (!scanActive) {
+        return;
+    }
+
+    scanActive = 0;
+    Scan_Read();
+    Scan_Send(1);
+    scanSweep++;
+
+    Ultra_SetRate(ULTRA_DEFAULT_RATE_HZ);
+    Stepper_SetStepMode(STEPPER_MODE_FULL);
+    Stepper_MoveTo(0);
+}
+
+/*******************************************************************************
+* Scan_Update() - Collect the readings and turn the sweep around at its
+*                 ends.
+* No inputs.
+* Returns 1 while scanning, otherwise 0.
+*******************************************************************************/
+uint8_t Scan_Update(void) {
+    if (!scanActive) {
+        return 0;
+    }
+
+    Scan_Read();
+
+    if (Scan_Turn()) {
+        Scan_Send(1);
+        scanSweep++;
+        scanIndex = 0;
+        scanDir = -scanDir;
+        Stepper_SetVelocity(scanDir * scanRate);
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+* Scan_Receive() - Handle a scan message.
+* frame     - Received frame.
+* Returns 1 if the frame was a scan message, otherwise 0.
+*******************************************************************************/
+uint8_t Scan_Receive(const ProtocolFrame *frame) {
+    if ((frame->type == MSG_SCAN_CONTROL) && (frame->len == sizeof(MsgScanControl))) {
+        const MsgScanControl *control = (const MsgScanControl *)frame->payload;
+
+        if (control->spacing != 0) {
+            Scan_Start(control->spacing);
+        }
+        else {
+            Scan_Stop();
+        }
+        return 1;
+    }
+
+    return 0;
+}
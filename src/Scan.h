@@ -0,0 +1,31 @@
+/*******************************************************************************
+* Name: Scan.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Range scanner, the stepper sweeps the ultrasonic sensor and
+*              the readings are sent as polar scans.
+*******************************************************************************/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Protocol.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define SCAN_MARGIN             4       // Half steps short of the limit switches to turn around
+#define SCAN_MIN_SPACING        2       // Half steps
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Scan_Start(uint8_t spacing);
+void Scan_Stop(void);
+uint8_t Scan_Update(void);
+uint8_t Scan_Receive(const ProtocolFrame *frame);
+
+#endif
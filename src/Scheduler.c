@@ -0,0 +1,280 @@
+/*******************************************************************************
+* Name: Scheduler.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Fixed-rate cooperative task scheduler on the Timebase ms tick.
+*              Scheduler_Run() runs the highest priority task that has been
+*              released, sleeping until the next tick when none has.
+*              Tasks run to completion, so a task that blocks delays all the
+*              others and shows up in their jitter and overrun counts.
+*              Execution times are measured with the DWT cycle counter.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "Scheduler.h"
+#include "Timebase.h"
+#include "Link.h"
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    const char *name;
+    TaskFunction run;
+    uint16_t period;            // Ticks between releases
+    uint16_t offset;            // Ticks to the first release
+    uint16_t deadline;          // Ticks after a release the run must finish by
+    uint8_t priority;           // 0 is the highest
+    uint32_t release;           // Tick of the next release
+    TaskStats stats;
+} Task;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t taskCount = 0;
+static uint8_t statusPending = 0;       // Bit per task whose status is waiting for the link
+static uint8_t statusReset = 0;         // Bit per task to clear once its status is sent
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Scheduler_CyclesToUs() - Convert a cycle count to a saturated us count.
+* cycles    - Cycle count.
+* Returns the time in us.
+*******************************************************************************/
+static uint16_t Scheduler_CyclesToUs(uint32_t cycles) {
+    uint32_t us = cycles / (SystemCoreClock / 1000000UL);
+
+    return (us > 0xFFFF) ? 0xFFFF : us;
+}
+
+/*******************************************************************************
+* Scheduler_NextReady() - Pick the task to run next.
+* now       - Current tick.
+* Returns the released task with the highest priority (earliest release
+* between equals), or NULL if none has been released.
+*******************************************************************************/
+static Task *Scheduler_NextReady(uint32_t now) {
+    Task *next = NULL;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task *task = &tasks[i];
+
+        if ((int32_t)(now - task->release) < 0) {
+            continue;
+        }
+
+        if ((next == NULL) || (task->priority < next->priority)
+            || ((task->priority == next->priority) && ((int32_t)(task->release - next->release) < 0))) {
+            next = task;
+        }
+    }
+
+    return next;
+}
+
+/*******************************************************************************
+* Scheduler_Dispatch() - Run a released task and schedule its next release.
+* task      - Task to run.
+* now       - Current tick.
+* nowCycles - Cycle count at the start of the current tick.
+* No return value.
+*******************************************************************************/
+static void Scheduler_Dispatch(Task *task, uint32_t now, uint32_t nowCycles) {
+    uint32_t cyclesPerTick = SystemCoreClock / TIMEBASE_TICK_HZ;
+    uint32_t releaseCycles = nowCycles - (now - task->release) * cyclesPerTick;
+    uint32_t start = Timebase_Cycles();
+    uint32_t end, late;
+
+    task->run();
+
+    end = Timebase_Cycles();
+    task->stats.runs++;
+    task->stats.lastCycles = end - start;
+    if (task->stats.lastCycles > task->stats.wcetCycles) {
+        task->stats.wcetCycles = task->stats.lastCycles;
+    }
+    if (start - releaseCycles > task->stats.jitterCycles) {
+        task->stats.jitterCycles = start - releaseCycles;
+    }
+    if (end - releaseCycles > task->deadline * cyclesPerTick) {
+        task->stats.overruns++;
+    }
+
+    // Drop the releases that are already a whole period late instead of
+    // running the task back to back to catch up
+    task->release += task->period;
+    late = Timebase_Ms() - task->release;
+    if (((int32_t)late > 0) && (late >= task->period)) {
+        task->stats.skipped += late / task->period;
+        task->release += (late / task->period) * task->period;
+    }
+}
+
+/*******************************************************************************
+* Scheduler_SendStatus() - Report the timing statistics of a task.
+* id        - Task id.
+* Returns 1 if the report was queued, otherwise 0.
+*******************************************************************************/
+static uint8_t Scheduler_SendStatus(uint8_t id) {
+    const Task *task = &tasks[id];
+    const char *name = task->name;
+    MsgTaskStatus status;
+
+    status.id = id;
+    status.count = taskCount;
+    for (uint8_t i = 0; i < TASK_NAME_LEN; i++) {
+        status.name[i] = *name;
+        if (*name != '\0') {
+            name++;
+        }
+    }
+    status.priority = task->priority;
+    status.period = task->period;
+    status.deadline = task->deadline;
+    status.runs = task->stats.runs;
+    status.overruns = task->stats.overruns;
+    status.skipped = task->stats.skipped;
+    status.lastUs = Scheduler_CyclesToUs(task->stats.lastCycles);
+    status.wcetUs = Scheduler_CyclesToUs(task->stats.wcetCycles);
+    status.jitterUs = Scheduler_CyclesToUs(task->stats.jitterCycles);
+    status.time = Timebase_Ms();
+
+    return Protocol_Send(MSG_TASK_STATUS, &status, sizeof(status));
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Scheduler_AddTask() - Add a periodic task. Tasks are added before
+*                       Scheduler_Run(), after Timebase_Init().
+* name      - Short name for the status reports.
+* run       - Function to call at each release.
+* period    - Ticks (ms) between releases.
+* offset    - Ticks from the start of Scheduler_Run() to the first release,
+*             used to spread tasks with the same period over different ticks.
+* deadline  - Ticks after each release the run must finish by, 0 for the
+*             period.
+* priority  - 0 is the highest. Released tasks run in priority order.
+* Returns the task id, or SCHEDULER_NO_TASK if the table is full.
+*******************************************************************************/
+uint8_t Scheduler_AddTask(const char *name, TaskFunction run, uint16_t period,
+                          uint16_t offset, uint16_t deadline, uint8_t priority) {
+    Task *task;
+
+    if ((taskCount >= SCHEDULER_MAX_TASKS) || (period == 0)) {
+        return SCHEDULER_NO_TASK;
+    }
+
+    task = &tasks[taskCount];
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->run = run;
+    task->period = period;
+    task->offset = offset;
+    task->deadline = (deadline != 0) ? deadline : period;
+    task->priority = priority;
+
+    return taskCount++;
+}
+
+/*******************************************************************************
+* Scheduler_Run() - Run the tasks forever.
+* No inputs.
+* Does not return.
+*******************************************************************************/
+__NO_RETURN void Scheduler_Run(void) {
+    uint32_t cycles;
+    uint32_t start = Timebase_Tick(&cycles);
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        tasks[i].release = start + tasks[i].offset;
+    }
+
+    while (1) {
+        uint32_t now = Timebase_Tick(&cycles);
+        Task *task = Scheduler_NextReady(now);
+
+        if (task != NULL) {
+            Scheduler_Dispatch(task, now, cycles);
+            continue;
+        }
+
+        // Sleep until the next tick. Interrupts are off between the check and
+        // the WFI so a tick in between can't be missed, a pending interrupt
+        // still wakes the core.
+        __disable_irq();
+        if (Scheduler_NextReady(Timebase_Ms()) == NULL) {
+            __WFI();
+        }
+        __enable_irq();
+    }
+}
+
+/*******************************************************************************
+* Scheduler_GetStats() - Get the timing statistics of a task.
+* id        - Task id from Scheduler_AddTask().
+* Returns the statistics, or NULL if there is no such task.
+*******************************************************************************/
+const TaskStats *Scheduler_GetStats(uint8_t id) {
+    return (id < taskCount) ? &tasks[id].stats : NULL;
+}
+
+/*******************************************************************************
+* Scheduler_ResetStats() - Clear the timing statistics of every task.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Scheduler_ResetStats(void) {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        memset(&tasks[i].stats, 0, sizeof(tasks[i].stats));
+    }
+}
+
+/*******************************************************************************
+* Scheduler_Update() - Send the task reports waiting for the link. A task's
+*                      statistics are only cleared once its report is queued.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Scheduler_Update(void) {
+    for (uint8_t i = 0; (i < taskCount) && (statusPending != 0); i++) {
+        if (!IS_BIT_SET(statusPending, 1 << i)) {
+            continue;
+        }
+        if (!Link_CanSend(PROTOCOL_MAX_ENCODED) || !Scheduler_SendStatus(i)) {
+            return;
+        }
+
+        CLEAR_BITS(statusPending, 1 << i);
+        if (IS_BIT_SET(statusReset, 1 << i)) {
+            CLEAR_BITS(statusReset, 1 << i);
+            memset(&tasks[i].stats, 0, sizeof(tasks[i].stats));
+        }
+    }
+}
+
+/*******************************************************************************
+* Scheduler_Receive() - Handle a scheduler message.
+* frame     - Received frame.
+* Returns 1 if the frame was a scheduler message, otherwise 0.
+*******************************************************************************/
+uint8_t Scheduler_Receive(const ProtocolFrame *frame) {
+    if ((frame->type == MSG_TASK_QUERY) && (frame->len == sizeof(MsgTaskQuery))) {
+        uint8_t all = (uint8_t)((1U << taskCount) - 1);
+
+        // Sent by Scheduler_Update() as the link allows
+        SET_BITS(statusPending, all);
+        if (((const MsgTaskQuery *)frame->payload)->reset) {
+            SET_BITS(statusReset, all);
+        }
+        return 1;
+    }
+
+    return 0;
+}
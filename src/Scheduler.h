@@ -0,0 +1,46 @@
+/*******************************************************************************
+* Name: Scheduler.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Fixed-rate cooperative task scheduler driven by the Timebase
+*              ms tick.
+*******************************************************************************/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+#include "Protocol.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define SCHEDULER_MAX_TASKS     8
+#define SCHEDULER_NO_TASK       0xFF
+
+typedef void (*TaskFunction)(void);
+
+typedef struct {
+    uint32_t runs;
+    uint32_t overruns;          // Runs that finished after their deadline
+    uint32_t skipped;           // Releases dropped because the task was still late
+    uint32_t lastCycles;        // Execution time of the last run
+    uint32_t wcetCycles;        // Longest execution time
+    uint32_t jitterCycles;      // Longest delay from release to start
+} TaskStats;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+uint8_t Scheduler_AddTask(const char *name, TaskFunction run, uint16_t period,
+                          uint16_t offset, uint16_t deadline, uint8_t priority);
+__NO_RETURN void Scheduler_Run(void);
+const TaskStats *Scheduler_GetStats(uint8_t id);
+void Scheduler_ResetStats(void);
+void Scheduler_Update(void);
+uint8_t Scheduler_Receive(const ProtocolFrame *frame);
+
+#endif
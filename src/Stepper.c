@@ -2,20 +2,57 @@
 * Name: Stepper.c (implementation)
 * Author(s): Noah Grant, Wyatt Richard
 * Date: February 3, 2023
-* Description: Stepper motor control.
+* Description: Stepper motor control. TIM6 paces the steps: its update
+*              interrupt takes a step and sets the time to the next one, so
+*              the stepper runs at a steady rate whatever the tasks are
+*              doing. Moves start and stop at STEPPER_START_RATE and ramp
+*              between it and their top rate at STEPPER_ACCEL, a move to a
+*              position starts slowing down once it is within its stopping
+*              distance. The position is counted in half steps from the
+*              centre in both full and half step mode. A step is never taken
+*              into a pressed limit switch, and the limit switch interrupt
+*              stops the stepper at once when it runs into one. Ranging runs
+*              as a state machine from the stepper task, so the other tasks
+*              keep running while it finds the limit switches.
 *******************************************************************************/
 
 #include "Stepper.h"
 
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define STEPPER_RATE_SHIFT      8           // Rates are kept in half steps/s, Q8
+#define STEPPER_RATE(rate)      ((uint32_t)(rate) << STEPPER_RATE_SHIFT)
+
+// Stepper_Update(), the ranging stage
+#define STEPPER_RANGE_IDLE      0
+#define STEPPER_RANGE_RIGHT     1           // Turning onto the right limit switch
+#define STEPPER_RANGE_LEFT      2           // Counting the half steps to the left one
+#define STEPPER_RANGE_CENTRE    3           // Moving back to the middle
+
 /*******************************************************************************
 *                             GLOBAL VARIABLES                                 *
 *******************************************************************************/
 volatile uint8_t G_StepperStep = STEPPER_STOP;
+volatile int16_t G_StepperPosition = 0;     // Half steps from centre (CW is positive)
 
 /*******************************************************************************
 *                       LOCAL CONSTANTS AND VARIABLES                          *
 *******************************************************************************/
+static const uint8_t stepPatterns[] = {0x8, 0xA, 0x2, 0x6, 0x4, 0x5, 0x1, 0x9};     // The different possible binary step patterns
 static uint8_t stepCounter = 0xFF;      // Stepper motor pattern counter (only care about the 3 LSBs)
+static uint8_t stepperMode = STEPPER_MODE_FULL;
+static int16_t stepperTravel = 0;       // Half steps between the limit switches, 0 until ranged
+static uint8_t stepperRange = STEPPER_RANGE_IDLE;
+static int16_t stepperRight = 0;        // Position of the right limit switch while ranging
+
+// Motion, shared with the ISRs and only changed with interrupts masked
+static volatile uint8_t stepperSeek = 0;        // Moving to stepperTarget, otherwise at stepperVelocity
+static volatile int16_t stepperTarget = 0;      // Half steps from centre
+static volatile int16_t stepperVelocity = 0;    // Half steps/s, CW is positive
+static volatile int8_t stepperDir = 0;          // Direction being stepped, 0 when stopped (TIM6 off)
+static volatile uint32_t stepperRate = 0;       // Half steps/s, Q8
+static volatile uint32_t stepperInterval = 0;   // us between the last step and the next
 
 /*******************************************************************************
 *                               PRIVATE FUNCTIONS                              *
@@ -56,6 +93,147 @@ static void Stepper_Ouput(uint8_t stepPattern){
     }
 }
 
+/*******************************************************************************
+* Stepper_Halt() - Stop stepping at once and drop the move.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Stepper_Halt(void){
+    CLEAR_BITS(TIM6->CR1, TIM_CR1_CEN);
+    CLEAR_BITS(TIM6->SR, TIM_SR_UIF);
+    stepperSeek = 0;
+    stepperVelocity = 0;
+    stepperDir = 0;
+    stepperRate = 0;
+    G_StepperStep = STEPPER_STOP;
+}
+
+/*******************************************************************************
+* Stepper_StopDistance() - Half steps it takes to slow from the current rate to
+*                          the start rate.
+* No inputs.
+* Returns the distance in half steps.
+*******************************************************************************/
+static uint32_t Stepper_StopDistance(void){
+    uint32_t rate = stepperRate >> STEPPER_RATE_SHIFT;
+
+    if(rate <= STEPPER_START_RATE){
+        return 0;
+    }
+
+    // v^2 = u^2 + 2as
+    return (rate * rate - (uint32_t)STEPPER_START_RATE * STEPPER_START_RATE) / (2UL * STEPPER_ACCEL);
+}
+
+/*******************************************************************************
+* Stepper_Ramp() - Move a rate one step toward a goal. Rates up to the start
+*                  rate are reached at once, faster ones at STEPPER_ACCEL.
+* rate      - Current rate (Q8).
+* goal      - Rate to reach (Q8), 0 to stop.
+* accel     - Change in rate over one step (Q8).
+* Returns the new rate (Q8).
+*******************************************************************************/
+static uint32_t Stepper_Ramp(uint32_t rate, uint32_t goal, uint32_t accel){
+    if(goal > rate){
+        rate = (rate < STEPPER_RATE(STEPPER_START_RATE)) ? STEPPER_RATE(STEPPER_START_RATE) : rate + accel;
+        return (rate > goal) ? goal : rate;
+    }
+
+    if((rate - goal <= accel) || (rate <= STEPPER_RATE(STEPPER_START_RATE) + accel)){
+        return goal;
+    }
+    return rate - accel;
+}
+
+/*******************************************************************************
+* Stepper_Next() - Take the next step of the move. Called with interrupts
+*                  masked, from the TIM6 ISR or to start a move.
+* No inputs.
+* Returns the us until the step after, 0 if the stepper stopped.
+*******************************************************************************/
+static uint32_t Stepper_Next(void){
+    uint32_t accel = STEPPER_RATE(STEPPER_ACCEL * stepperInterval / 1000UL) / 1000UL;
+    uint32_t start;
+    uint32_t goal;
+    int16_t remaining = 0;
+    int8_t dir;
+    uint8_t size;
+
+    // Which way and how fast the move wants to go
+    if(stepperSeek){
+        remaining = stepperTarget - G_StepperPosition;
+        dir = (remaining > 0) - (remaining < 0);
+        goal = STEPPER_RATE(STEPPER_MAX_RATE);
+        if((dir == stepperDir) && ((uint32_t)((remaining < 0) ? -remaining : remaining) <= Stepper_StopDistance() + 2)){
+            goal = STEPPER_RATE(STEPPER_START_RATE);
+        }
+    }
+    else{
+        dir = (stepperVelocity > 0) - (stepperVelocity < 0);
+        goal = STEPPER_RATE((stepperVelocity < 0) ? -stepperVelocity : stepperVelocity);
+    }
+    start = (goal < STEPPER_RATE(STEPPER_START_RATE)) ? goal : STEPPER_RATE(STEPPER_START_RATE);
+
+    if(stepperDir == 0){
+        stepperDir = dir;
+        stepperRate = start;
+    }
+    else if(dir != stepperDir){
+        // Slow to the start rate before stopping or turning around
+        stepperRate = Stepper_Ramp(stepperRate, 0, accel);
+        if(stepperRate == 0){
+            stepperDir = dir;
+            stepperRate = start;
+        }
+    }
+    else{
+        stepperRate = Stepper_Ramp(stepperRate, goal, accel);
+    }
+
+    // Arrived, stopped, or about to step into a limit switch
+    if((stepperDir == 0) || !LimitSwitch_PressCheck((stepperDir > 0) ? RIGHT : LEFT)){
+        Stepper_Halt();
+        return 0;
+    }
+
+    // Half step onto a target an odd number of half steps away
+    size = ((stepperMode == STEPPER_MODE_HALF) || (remaining == stepperDir)) ? 1 : 2;
+    stepCounter += (uint8_t)(stepperDir * size);
+    G_StepperPosition += stepperDir * size;
+    Stepper_Ouput(stepPatterns[0x7 & stepCounter]);     // & with 0x7 because we just want the lower 3 bits
+
+    if(size == 2){
+        G_StepperStep = (stepperDir > 0) ? STEPPER_CW_FULL_STEP : STEPPER_CCW_FULL_STEP;
+    }
+    else{
+        G_StepperStep = (stepperDir > 0) ? STEPPER_CW_HALF_STEP : STEPPER_CCW_HALF_STEP;
+    }
+
+    stepperInterval = STEPPER_RATE(size * 1000000UL) / stepperRate;
+    return stepperInterval;
+}
+
+/*******************************************************************************
+* Stepper_Start() - Start TIM6 on a new move, a move already running picks up
+*                   the change at its next step. Called with interrupts masked.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Stepper_Start(void){
+    uint32_t interval;
+
+    if(stepperDir != 0){
+        return;
+    }
+
+    interval = Stepper_Next();
+    if(interval != 0){
+        TIM6->CNT = 0;
+        FORCE_BITS(TIM6->ARR, 0xFFFFUL, interval - 1);
+        SET_BITS(TIM6->CR1, TIM_CR1_CEN);
+    }
+}
+
 
 /*******************************************************************************
 *                               PUBLIC FUNCTIONS                               *
@@ -89,84 +267,183 @@ void Stepper_Init(void){
         // 5. Initialize to OFF (0)
         GPIOC->ODR &= ~(1UL << (1*PCx));
     }
+
+    // TIM6 paces the steps, one update per step
+    SET_BITS(RCC->APB1ENR, RCC_APB1ENR_TIM6EN);     // Turn on TIM6
+    FORCE_BITS(TIM6->PSC, 0xFFFFUL, 71UL);          // Set PSC so it counts in 1us
+    CLEAR_BITS(TIM6->CR1, TIM_CR1_ARPE);            // No ARR preload, the ISR sets the next period just after the update
+    SET_BITS(TIM6->CR1, TIM_CR1_URS);               // Only overflows interrupt
+    SET_BITS(TIM6->EGR, TIM_EGR_UG);                // Load PSC
+    SET_BITS(TIM6->DIER, TIM_DIER_UIE);
+    NVIC_SetPriority(TIM6_DAC_IRQn, STEPPER_PRIORITY);
+    NVIC_EnableIRQ(TIM6_DAC_IRQn);
+}
+
+/*******************************************************************************
+* Stepper_SetStepMode() - Choose full or half steps, from the next step.
+* mode          - STEPPER_MODE_FULL or STEPPER_MODE_HALF.
+* No return value.
+*******************************************************************************/
+void Stepper_SetStepMode(uint8_t mode){
+    stepperMode = mode;
+}
+
+/*******************************************************************************
+* Stepper_MoveTo() - Start moving to an absolute position at up to
+*                    STEPPER_MAX_RATE. The move stops at the target or at a
+*                    limit switch. Ends any ranging.
+* position      - Target position in half steps from centre (CW is positive).
+* No return value.
+*******************************************************************************/
+void Stepper_MoveTo(int16_t position){
+    stepperRange = STEPPER_RANGE_IDLE;
+
+    CRITICAL_ENTER();
+    stepperTarget = position;
+    stepperSeek = 1;
+    Stepper_Start();
+    CRITICAL_EXIT();
+}
+
+/*******************************************************************************
+* Stepper_SetVelocity() - Start turning at a steady rate, until the rate is
+*                         changed or a limit switch is reached. Ends any
+*                         ranging.
+* rate          - Half steps/s (CW is positive), 0 to stop. Limited to
+*                 STEPPER_MIN_RATE to STEPPER_MAX_RATE.
+* No return value.
+*******************************************************************************/
+void Stepper_SetVelocity(int16_t rate){
+    int16_t speed = (rate < 0) ? -rate : rate;
+
+    if(speed > STEPPER_MAX_RATE){
+        speed = STEPPER_MAX_RATE;
+    }
+    else if((speed != 0) && (speed < STEPPER_MIN_RATE)){
+        speed = STEPPER_MIN_RATE;
+    }
+
+    stepperRange = STEPPER_RANGE_IDLE;
+
+    CRITICAL_ENTER();
+    stepperVelocity = (rate < 0) ? -speed : speed;
+    stepperSeek = 0;
+    Stepper_Start();
+    CRITICAL_EXIT();
 }
 
 /*******************************************************************************
-* stepper_step() - Updates stepCount based on stepType and passes binary output pattern to stepper_output().
-* stepType      - The type of step (FS-CW, FS-CCW, HS-CW, HS-CCW) to take.
+* Stepper_Stop() - Slow down and stop.
+* No inputs.
 * No return value.
 *******************************************************************************/
-void Stepper_Step(uint8_t stepType){
-    uint8_t stepPatterns[] = {0x8, 0xA, 0x2, 0x6, 0x4, 0x5, 0x1, 0x9};      // The different possible binary step patterns
+void Stepper_Stop(void){
+    Stepper_SetVelocity(0);
+}
 
-    switch(stepType){
-        case STEPPER_STOP: {
-            break;
-        }
-        case STEPPER_CW_FULL_STEP:{
-            stepCounter += 2;
-            break;
-        }
-        case STEPPER_CCW_FULL_STEP:{
-            stepCounter -= 2;
+/*******************************************************************************
+* Stepper_Range() - Start finding the range of travel between the limit
+*                   switches, Stepper_Update() carries it on and centres the
+*                   stepper, which becomes position 0. Another stepper command
+*                   ends it early, keeping the range found before.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Stepper_Range(void) {
+    // Onto the right limit switch first
+    Stepper_SetVelocity(STEPPER_START_RATE);
+    stepperRange = STEPPER_RANGE_RIGHT;
+}
+
+/*******************************************************************************
+* Stepper_Update() - Move ranging on to its next stage once the stepper has
+*                    stopped. Call periodically.
+* No inputs.
+* Returns 1 while ranging, otherwise 0.
+*******************************************************************************/
+uint8_t Stepper_Update(void) {
+    if ((stepperRange == STEPPER_RANGE_IDLE) || (G_StepperStep != STEPPER_STOP)) {
+        return (stepperRange != STEPPER_RANGE_IDLE) ? 1 : 0;
+    }
+
+    switch (stepperRange) {
+        // Count the half steps to the left limit switch
+        case STEPPER_RANGE_RIGHT: {
+            stepperRight = G_StepperPosition;
+            Stepper_SetVelocity(-STEPPER_START_RATE);
+            stepperRange = STEPPER_RANGE_LEFT;
             break;
         }
-        case STEPPER_CW_HALF_STEP:{
-            stepCounter++;
+        case STEPPER_RANGE_LEFT: {
+            stepperTravel = stepperRight - G_StepperPosition;
+            Stepper_MoveTo(G_StepperPosition + stepperTravel / 2);
+            stepperRange = STEPPER_RANGE_CENTRE;
             break;
         }
-        case STEPPER_CCW_HALF_STEP:{
-            stepCounter--;
+        default: {
+            G_StepperPosition = 0;
+            stepperRange = STEPPER_RANGE_IDLE;
             break;
         }
-        default:{
-            return;
-        }
     }
 
-    Stepper_Ouput(stepPatterns[0x7 & stepCounter]);     // & with 0x7 because we just want the lower 3 bits
+    return 1;
 }
 
-uint8_t Stepper_Range(void) {
-    uint8_t rangeCount = 0;
+/*******************************************************************************
+* Stepper_GetTravel() - Get the travel found by Stepper_Range().
+* No inputs.
+* Returns the half steps between the limit switches, 0 if not ranged yet.
+*******************************************************************************/
+int16_t Stepper_GetTravel(void) {
+    return stepperTravel;
+}
 
-    G_StepperStep = STEPPER_CW_FULL_STEP;
-    if(LimitSwitch_PressCheck(RIGHT)){
-        while(G_StepperStep != 0){
-            Stepper_Step(STEPPER_CW_FULL_STEP);
-            Delay_ms(5);
-        }
-    }
+/*******************************************************************************
+*                               INTERRUPT HANDLERS                             *
+*******************************************************************************/
+/*******************************************************************************
+* TIM6_DAC_IRQHandler() - Time for the next step.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void TIM6_DAC_IRQHandler(void) {
+    uint32_t interval;
 
-    G_StepperStep = STEPPER_CCW_FULL_STEP;
-    while(G_StepperStep != 0){
-        rangeCount++;
-        Stepper_Step(STEPPER_CCW_FULL_STEP);
-        Delay_ms(5);
-    }
-    
-    G_StepperStep = STEPPER_STOP;
-    for(int i = 0; i < rangeCount/2; i++){
-        Stepper_Step(STEPPER_CW_FULL_STEP);
-        Delay_ms(5);
+    if (IS_BIT_SET(TIM6->SR, TIM_SR_UIF)) {
+        // Masked so a limit switch can't stop the stepper halfway through a step
+        CRITICAL_ENTER();
+        CLEAR_BITS(TIM6->SR, TIM_SR_UIF);
+        interval = Stepper_Next();
+        if (interval != 0) {
+            FORCE_BITS(TIM6->ARR, 0xFFFFUL, interval - 1);
+        }
+        CRITICAL_EXIT();
     }
-    
-    return rangeCount;
 }
 
+/*******************************************************************************
+* EXTI9_5_IRQHandler() - A limit switch was pressed, stop if the stepper is
+*                        turning into it.
+* No inputs.
+* No return value.
+*******************************************************************************/
 void EXTI9_5_IRQHandler(void) {
     // Left limit switch
     if ((EXTI->PR & EXTI_PR_PIF5) != 0) {
-        G_StepperStep = 0;
+        if (stepperDir < 0) {
+            Stepper_Halt();
+        }
         // Cleared flag by writing 1
         EXTI->PR |= EXTI_PR_PIF5;
     }
-    
+
     // Right limit switch
     else if ((EXTI->PR & EXTI_PR_PIF6) != 0) {
-        G_StepperStep = 0;
+        if (stepperDir > 0) {
+            Stepper_Halt();
+        }
         // Cleared flag by writing 1
         EXTI->PR |= EXTI_PR_PIF6;
     }
 }
-
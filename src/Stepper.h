@@ -14,16 +14,33 @@
 #include "LimitSwitch.h"
 #include "Ultrasonic.h"
 
+// G_StepperStep, the step being taken, STEPPER_STOP when stopped
 #define STEPPER_STOP 0
 #define STEPPER_CW_FULL_STEP 1
 #define STEPPER_CCW_FULL_STEP 2
 #define STEPPER_CW_HALF_STEP 3
 #define STEPPER_CCW_HALF_STEP 4
 
+// Stepper_SetStepMode()
+#define STEPPER_MODE_FULL 0
+#define STEPPER_MODE_HALF 1
+
+#define STEPPER_PRIORITY        10
+#define STEPPER_START_RATE      400         // Half steps/s, started, stopped and turned around at without a ramp
+#define STEPPER_MAX_RATE        1200        // Half steps/s
+#define STEPPER_MIN_RATE        32          // Half steps/s, slower full steps don't fit a TIM6 period
+#define STEPPER_ACCEL           4000        // Half steps/s^2
+
 extern volatile uint8_t G_StepperStep;
+extern volatile int16_t G_StepperPosition;
 
 void Stepper_Init(void);
-void Stepper_Step(uint8_t stepType);
-uint8_t Stepper_Range(void);
+void Stepper_SetStepMode(uint8_t mode);
+void Stepper_MoveTo(int16_t position);
+void Stepper_SetVelocity(int16_t rate);
+void Stepper_Stop(void);
+void Stepper_Range(void);
+uint8_t Stepper_Update(void);
+int16_t Stepper_GetTravel(void);
 
 #endif
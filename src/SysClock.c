@@ -1,4 +1,5 @@
 #include "SysClock.h"
+#include "Utility.h"
 
 
 /*******************************************************************************
@@ -25,11 +26,11 @@ void System_Clock_Init(void){
 
     // Enable the External High Speed oscillator (HSE)
     RCC->CR |= RCC_CR_HSEON;
-    while((RCC->CR & RCC_CR_HSERDY) == 0);
+    while((RCC->CR & RCC_CR_HSERDY) == 0) SIM_YIELD();
 
     // Turn PLL off (might already be on)
     RCC->CR    &= ~RCC_CR_PLLON;
-    while((RCC->CR & RCC_CR_PLLRDY) == RCC_CR_PLLRDY);
+    while((RCC->CR & RCC_CR_PLLRDY) == RCC_CR_PLLRDY) SIM_YIELD();
 
     // Select HSE as clock source to PLL
     RCC->CFGR &= ~RCC_CFGR_PLLSRC_Msk;
@@ -41,14 +42,14 @@ void System_Clock_Init(void){
 
     // Turn PLL on and wait for it to be stable
     RCC->CR   |= RCC_CR_PLLON;
-    while((RCC->CR & RCC_CR_PLLRDY) == 0);
+    while((RCC->CR & RCC_CR_PLLRDY) == 0) SIM_YIELD();
 
     // Configure System Clock to use PLL
     RCC->CFGR &= ~RCC_CFGR_SW;
     RCC->CFGR |= RCC_CFGR_SW_PLL; // 00: MSI, 01:HSI, 10: HSE, 11: PLL
 
     // Wait until the System Clock has switched over to the PLL
-    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL) SIM_YIELD();
 
     // Configure the peripheral clocks
     RCC->CFGR &= ~RCC_CFGR_HPRE;        // AHB (GPIO) set to 72 MHz - System Clock  (clear all bits = no prescaler)
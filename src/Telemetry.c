@@ -0,0 +1,205 @@
+/*******************************************************************************
+* Name: Telemetry.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Periodic binary telemetry frames over the robot link. Time is
+*              measured with the Timebase, so the rate does not depend on how
+*              often Telemetry_Update() runs. Frames are only queued when
+*              they fit in the transmit buffer, so publishing never waits on
+*              the link and never pushes out other messages.
+*******************************************************************************/
+
+#include "Telemetry.h"
+#include "Link.h"
+#include "Encoder.h"
+#include "Odometry.h"
+#include "Profile.h"
+#include "Collision.h"
+#include "Map.h"
+#include "PID.h"
+#include "DCMotor.h"
+#include "Power.h"
+#include "Ultrasonic.h"
+#include "RCServo.h"
+#include "Stepper.h"
+#include "Timebase.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define TELEMETRY_FRAME_SIZE    (sizeof(MsgTelemetry) + 5)      // Type, CRC, COBS and delimiter
+#define TELEMETRY_BITS_PER_BYTE 10                              // Start and stop bits
+
+/*******************************************************************************
+*                               GLOBAL VARIABLES                               *
+*******************************************************************************/
+TelemetryStats G_TelemetryStats = {0, 0};
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static uint16_t telemetryRate = TELEMETRY_DEFAULT_RATE;
+static uint16_t telemetrySeq = 0;
+
+static uint32_t lastCycles = 0;         // Cycle count at the last Telemetry_Update()
+static uint32_t frameCycles = 0;        // Cycles since the last frame
+
+static uint32_t loopCycles = 0;         // Main loop cycles since the last frame
+static uint32_t loopMaxCycles = 0;
+static uint16_t loopCount = 0;
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Telemetry_CyclesToUs() - Convert a cycle count to a saturated us count.
+* cycles    - Cycle count.
+* Returns the time in us.
+*******************************************************************************/
+static uint16_t Telemetry_CyclesToUs(uint32_t cycles) {
+    uint32_t us = cycles / (SystemCoreClock / 1000000UL);
+
+    return (us > 0xFFFF) ? 0xFFFF : us;
+}
+
+/*******************************************************************************
+* Telemetry_Period() - Cycles between frames at the current rate, limited to
+*                      half of the link bandwidth.
+* No inputs.
+* Returns the period in cycles, or 0 if telemetry is off.
+*******************************************************************************/
+static uint32_t Telemetry_Period(void) {
+    uint32_t maxRate = G_USART3.baud / (TELEMETRY_BITS_PER_BYTE * TELEMETRY_FRAME_SIZE * 2);
+    uint32_t rate = telemetryRate;
+
+    if (rate > maxRate) {
+        rate = maxRate;
+    }
+
+    return (rate != 0) ? (SystemCoreClock / rate) : 0;
+}
+
+/*******************************************************************************
+* Telemetry_Send() - Take a snapshot of the robot state and queue it.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Telemetry_Send(void) {
+    MsgTelemetry msg;
+    int64_t limit = ((int64_t)Collision_GetSpeedLimit() * 10) >> 16;
+    int64_t ttc = ((int64_t)Collision_GetTTC() * 1000) >> 16;
+
+    if (!Link_CanSend(TELEMETRY_FRAME_SIZE)) {
+        G_TelemetryStats.skipped++;
+        return;
+    }
+
+    msg.seq = telemetrySeq++;
+    msg.time = Timebase_Ms();
+    msg.leftSpeed = G_leftEncoderSpeed;
+    msg.rightSpeed = G_rightEncoderSpeed;
+    msg.leftSetpoint = G_leftEncoderSetpoint;
+    msg.rightSetpoint = G_rightEncoderSetpoint;
+    msg.leftPeriod = G_EncoderPeriod[LEFT];
+    msg.rightPeriod = G_EncoderPeriod[RIGHT];
+    msg.leftOutput = PID_GetOutput(LEFT);
+    msg.rightOutput = PID_GetOutput(RIGHT);
+    msg.leftDir = G_DCMotorLeftDir;
+    msg.rightDir = G_DCMotorRightDir;
+    msg.range = (uint16_t)Ultra_ReadSensor();
+    msg.servoAngle = G_RCServoAngle;
+    msg.stepperStep = G_StepperStep;
+    msg.stepperPosition = G_StepperPosition;
+    msg.loopPeriod = Telemetry_CyclesToUs((loopCount != 0) ? (loopCycles / loopCount) : 0);
+    msg.loopMax = Telemetry_CyclesToUs(loopMaxCycles);
+    msg.leftReversal = DCMotor_GetReversalUs(DCMOTOR_LEFT);
+    msg.rightReversal = DCMotor_GetReversalUs(DCMOTOR_RIGHT);
+    msg.encoderIsrMax = (G_EncoderStats.isrMaxCycles > 0xFFFF) ? 0xFFFF : G_EncoderStats.isrMaxCycles;
+    msg.poseX = G_OdometryPose.x / 1000;
+    msg.poseY = G_OdometryPose.y / 1000;
+    msg.poseHeading = G_OdometryPose.heading >> 16;
+    msg.pidMax = (G_PIDStats.maxCycles > 0xFFFF) ? 0xFFFF : G_PIDStats.maxCycles;
+    msg.leftProfile = (int16_t)((Profile_GetVelocity(LEFT) * 10) >> 16);
+    msg.rightProfile = (int16_t)((Profile_GetVelocity(RIGHT) * 10) >> 16);
+    msg.speedLimit = (limit < 0xFFFF) ? (uint16_t)limit : 0xFFFF;
+    msg.ttc = (ttc < 0xFFFF) ? (uint16_t)ttc : 0xFFFF;
+    msg.mapMax = Telemetry_CyclesToUs(G_MapStats.maxCycles);
+    msg.batteryMv = G_Power.batteryMv;
+    msg.driveCurrent = G_Power.currentMa;
+    msg.pwmScale = (uint16_t)((G_Power.scale * 1000 + DCMOTOR_SCALE_ONE / 2) >> 16);
+    msg.leftCutoff = G_Power.cutoff[LEFT];
+    msg.rightCutoff = G_Power.cutoff[RIGHT];
+
+    if (Protocol_Send(MSG_TELEMETRY, &msg, sizeof(msg))) {
+        G_TelemetryStats.sent++;
+    }
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Telemetry_Init() - Start measuring the update period.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Telemetry_Init(void) {
+    lastCycles = Timebase_Cycles();
+}
+
+/*******************************************************************************
+* Telemetry_Update() - Measure the calling task's period and send a frame
+*                      when one is due. Call periodically.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Telemetry_Update(void) {
+    uint32_t now = Timebase_Cycles();
+    uint32_t elapsed = now - lastCycles;        // Wraps after ~59s, updates are much closer
+    uint32_t period;
+
+    lastCycles = now;
+
+    loopCycles += elapsed;
+    loopCount++;
+    if (elapsed > loopMaxCycles) {
+        loopMaxCycles = elapsed;
+    }
+
+    period = Telemetry_Period();
+    frameCycles += elapsed;
+    if ((period == 0) || (frameCycles < period)) {
+        return;
+    }
+    frameCycles = (frameCycles - period < period) ? (frameCycles - period) : 0;
+
+    Telemetry_Send();
+
+    loopCycles = 0;
+    loopMaxCycles = 0;
+    loopCount = 0;
+}
+
+/*******************************************************************************
+* Telemetry_Receive() - Handle a telemetry message.
+* frame     - Received frame.
+* Returns 1 if the frame was a telemetry message, otherwise 0.
+*******************************************************************************/
+uint8_t Telemetry_Receive(const ProtocolFrame *frame) {
+    if ((frame->type == MSG_TELEMETRY_RATE) && (frame->len == sizeof(MsgTelemetryRate))) {
+        Telemetry_SetRate(((const MsgTelemetryRate *)frame->payload)->rate);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+* Telemetry_SetRate() - Set the telemetry rate.
+* rate      - Frames per second (up to TELEMETRY_MAX_RATE), 0 turns it off.
+* No return value.
+*******************************************************************************/
+void Telemetry_SetRate(uint16_t rate) {
+    telemetryRate = (rate > TELEMETRY_MAX_RATE) ? TELEMETRY_MAX_RATE : rate;
+    frameCycles = 0;
+}
@@ -0,0 +1,28 @@
+/*******************************************************************************
+* Name: Telemetry.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Periodic binary telemetry frames over the robot link.
+*******************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Protocol.h"
+
+typedef struct {
+    uint32_t sent;              // Frames queued for transmission
+    uint32_t skipped;           // Frames not sent because the link or transmit buffer was busy
+} TelemetryStats;
+
+extern TelemetryStats G_TelemetryStats;
+
+void Telemetry_Init(void);
+void Telemetry_Update(void);
+uint8_t Telemetry_Receive(const ProtocolFrame *frame);
+void Telemetry_SetRate(uint16_t rate);
+
+#endif
@@ -0,0 +1,147 @@
+/*******************************************************************************
+* Name: Timebase.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Monotonic uptime. SysTick interrupts every ms and the handler
+*              advances the ms count from the DWT cycle counter, so a tick
+*              delayed by a critical section is caught up instead of lost and
+*              the us time never steps backwards. The ms count wraps after
+*              ~49 days and the us count after ~71 minutes, compare them with
+*              the deadline helpers (or by subtracting) to stay wrap safe.
+*              Timebase_Init() must run before anything that waits.
+*******************************************************************************/
+
+#include "Timebase.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define TIMEBASE_PRIORITY       1           // Above everything but the ultrasonic echo
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static volatile uint32_t tickMs = 0;
+static volatile uint32_t tickCycles = 0;    // Cycle count at the start of tick tickMs
+static uint32_t cyclesPerTick = 72000;
+static uint32_t cyclesPerUs = 72;
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Timebase_Init() - Start the DWT cycle counter and the SysTick ms tick. Call
+*                   after the system clock is set up.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void Timebase_Init(void) {
+    cyclesPerTick = SystemCoreClock / TIMEBASE_TICK_HZ;
+    cyclesPerUs = SystemCoreClock / 1000000UL;
+
+    SET_BITS(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);    // Enable the DWT
+    SET_BITS(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);               // Start the cycle counter
+
+    // SysTick from the processor clock, interrupt at the tick rate
+    SysTick->CTRL = 0;
+    SysTick->LOAD = cyclesPerTick - 1;
+    SysTick->VAL = 0;
+    NVIC_SetPriority(SysTick_IRQn, TIMEBASE_PRIORITY);
+
+    tickCycles = DWT->CYCCNT;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/*******************************************************************************
+* Timebase_Ms() - Milliseconds since Timebase_Init().
+* No inputs.
+* Returns the time in ms.
+*******************************************************************************/
+uint32_t Timebase_Ms(void) {
+    return tickMs;
+}
+
+/*******************************************************************************
+* Timebase_Us() - Microseconds since Timebase_Init().
+* No inputs.
+* Returns the time in us.
+*******************************************************************************/
+uint32_t Timebase_Us(void) {
+    uint32_t cycles;
+    uint32_t ms = Timebase_Tick(&cycles);
+
+    return (ms * 1000UL) + ((DWT->CYCCNT - cycles) / cyclesPerUs);
+}
+
+/*******************************************************************************
+* Timebase_Cycles() - Raw cycle count, for timing short intervals. Wraps every
+*                     ~59s.
+* No inputs.
+* Returns the cycle count.
+*******************************************************************************/
+uint32_t Timebase_Cycles(void) {
+    return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+* Timebase_Tick() - Read the ms count and the cycle count it started at
+*                   together.
+* cycles    - Cycle count at the start of the current ms.
+* Returns the time in ms.
+*******************************************************************************/
+uint32_t Timebase_Tick(uint32_t *cycles) {
+    uint32_t ms;
+
+    CRITICAL_ENTER();
+    ms = tickMs;
+    *cycles = tickCycles;
+    CRITICAL_EXIT();
+
+    return ms;
+}
+
+/*******************************************************************************
+* Timebase_DeadlineMs() - Make a deadline for Timebase_ExpiredMs().
+* ms        - Time from now, up to ~24 days.
+* Returns the deadline.
+*******************************************************************************/
+uint32_t Timebase_DeadlineMs(uint32_t ms) {
+    return Timebase_Ms() + ms;
+}
+
+/*******************************************************************************
+* Timebase_ExpiredMs() - Check a deadline from Timebase_DeadlineMs().
+* deadline  - Deadline to check.
+* Returns 1 once the deadline has passed, otherwise 0.
+*******************************************************************************/
+uint8_t Timebase_ExpiredMs(uint32_t deadline) {
+    return ((int32_t)(Timebase_Ms() - deadline) >= 0) ? 1 : 0;
+}
+
+/*******************************************************************************
+* Timebase_DeadlineUs() - Make a deadline for Timebase_ExpiredUs().
+* us        - Time from now, up to ~35 minutes.
+* Returns the deadline.
+*******************************************************************************/
+uint32_t Timebase_DeadlineUs(uint32_t us) {
+    return Timebase_Us() + us;
+}
+
+/*******************************************************************************
+* Timebase_ExpiredUs() - Check a deadline from Timebase_DeadlineUs().
+* deadline  - Deadline to check.
+* Returns 1 once the deadline has passed, otherwise 0.
+*******************************************************************************/
+uint8_t Timebase_ExpiredUs(uint32_t deadline) {
+    return ((int32_t)(Timebase_Us() - deadline) >= 0) ? 1 : 0;
+}
+
+void SysTick_Handler(void) {
+    uint32_t cycles = DWT->CYCCNT;
+
+    // Count every ms that has passed, more than one if the tick was held off
+    while (cycles - tickCycles >= cyclesPerTick) {
+        tickCycles += cyclesPerTick;
+        tickMs++;
+    }
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+* Name: Timebase.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Monotonic uptime from a SysTick ms tick and the DWT cycle
+*              counter, with deadline helpers.
+*******************************************************************************/
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Utility.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define TIMEBASE_TICK_HZ        1000UL
+#define TIMEBASE_MAX_STEP_US    100000UL    // Longer gaps between control steps are a restart, not a step
+
+// us to Q16.16 s. 4295 is 2^32 / 10^6, ~8ppm high. 64-bit so gaps of seconds
+// don't overflow.
+#define TIMEBASE_US_TO_Q16_S(us) ((int32_t)(((uint64_t)(us) * 4295U) >> 16))
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Timebase_Init(void);
+uint32_t Timebase_Ms(void);
+uint32_t Timebase_Us(void);
+uint32_t Timebase_Cycles(void);
+uint32_t Timebase_Tick(uint32_t *cycles);
+
+uint32_t Timebase_DeadlineMs(uint32_t ms);
+uint8_t Timebase_ExpiredMs(uint32_t deadline);
+uint32_t Timebase_DeadlineUs(uint32_t us);
+uint8_t Timebase_ExpiredUs(uint32_t deadline);
+
+#endif
@@ -0,0 +1,312 @@
+/*******************************************************************************
+* Name: Tune.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Relay feedback (Astrom-Hagglund) auto-tuning of the wheel PID
+*              controllers. Both wheels drive forward with their duty cycle
+*              switched between bias + d and bias - d each time the speed
+*              crosses the setpoint, which settles into a limit cycle at the
+*              wheel's ultimate period Tu. The speed amplitude a gives the
+*              ultimate gain Ku = 4d / (pi a), from which the PID gains
+*              follow. The mean duty over mean speed gives the feedforward.
+*              Tune_Update() runs in place of the controllers while a tune
+*              is in progress.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "Tune.h"
+#include "PID.h"
+#include "Timebase.h"
+#include "Kinematics.h"
+#include "Link.h"
+
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+#define TUNE_SKIP_CYCLES    2               // Relay cycles to settle before measuring
+#define TUNE_CYCLES         4               // Relay cycles averaged
+#define TUNE_TIMEOUT_MS     5000UL
+#define TUNE_HYSTERESIS     Q16(0.5)        // cm/s either side of the setpoint, small next to the amplitude
+#define TUNE_PI             Q16(3.14159265)
+
+// PID rule from Ku and Tu. Tyreus-Luyben: Kp = Ku/2.2, Ti = 2.2Tu, Td = Tu/6.3.
+// Ziegler-Nichols settles sooner but overshoots by half on top of the
+// feedforward.
+#define TUNE_KP_FACTOR      Q16(0.45)
+#define TUNE_TI_FACTOR      Q16(2.2)
+#define TUNE_TD_FACTOR      Q16(0.16)
+
+/*******************************************************************************
+*                               LOCAL TYPES                                    *
+*******************************************************************************/
+typedef struct {
+    uint8_t status;             // TUNE_x, TUNE_OK until the wheel fails
+    uint8_t done;
+    uint8_t high;               // Relay output is bias + d
+    uint8_t cycles;             // Rising setpoint crossings so far
+    uint32_t riseUs;            // Time of the last rising crossing
+    uint32_t periodUs;          // Sum of the measured periods
+    q16_t max;                  // Speed extremes in the current cycle
+    q16_t min;
+    int64_t amplitude;          // Sum of the measured amplitudes
+    int64_t dutySum;            // Over the measured cycles, for the feedforward
+    int64_t speedSum;
+    q16_t bias;
+} TuneWheel;
+
+/*******************************************************************************
+*                               LOCAL VARIABLES                                *
+*******************************************************************************/
+static TuneWheel tuneWheels[2];
+static uint8_t tuneActive = 0;
+static uint8_t tuneSetpoint = 0;
+static q16_t tuneAmplitude = 0;         // Relay d, % duty
+static uint32_t tuneDeadline = 0;
+static MsgTuneResult tuneResults[2];    // Results waiting for the link
+static uint8_t tunePending = 0;         // Bit per wheel with a result to send
+
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Tune_Report() - Work out the gains of one wheel, apply them if the tune
+*                 succeeded and queue the result for Tune_Send().
+* wheel     - LEFT or RIGHT.
+* No return value.
+*******************************************************************************/
+static void Tune_Report(uint8_t wheel) {
+    TuneWheel *tune = &tuneWheels[wheel];
+    uint8_t measured = (tune->cycles > TUNE_SKIP_CYCLES + 1) ? (tune->cycles - TUNE_SKIP_CYCLES - 1) : 0;
+    MsgTuneResult *msg = &tuneResults[wheel];
+
+    memset(msg, 0, sizeof(*msg));
+    msg->wheel = wheel;
+    msg->status = tune->status;
+    msg->setpoint = tuneSetpoint;
+    msg->cycles = measured;
+    msg->time = Timebase_Ms();
+
+    if ((tune->status == TUNE_OK) && (measured != 0) && (tune->amplitude > 0) && (tune->speedSum > 0)) {
+        PIDGains gains;
+        q16_t amplitude = (q16_t)(tune->amplitude / measured);
+        q16_t tu = (q16_t)(((uint64_t)(tune->periodUs / measured) << 16) / 1000000UL);    // s
+        q16_t ti = Q16_MUL(TUNE_TI_FACTOR, tu);
+
+        msg->amplitude = amplitude;
+        msg->tuUs = tune->periodUs / measured;
+        msg->ku = (q16_t)(((int64_t)4 * tuneAmplitude * Q16_ONE) / Q16_MUL(TUNE_PI, amplitude));
+
+        gains.kp = Q16_MUL(TUNE_KP_FACTOR, msg->ku);
+        gains.ki = (ti > 0) ? (q16_t)(((int64_t)gains.kp * Q16_ONE) / ti) : 0;
+        gains.kd = Q16_MUL(gains.kp, Q16_MUL(TUNE_TD_FACTOR, tu));
+        gains.kff = (q16_t)((tune->dutySum * Q16_ONE) / tune->speedSum);
+        gains.kaff = PID_GetGains(wheel, Q16_FROM_INT(tuneSetpoint))->kaff;    // The relay can't tell it apart
+
+        msg->kp = gains.kp;
+        msg->ki = gains.ki;
+        msg->kd = gains.kd;
+        msg->kff = gains.kff;
+        PID_SetGains(wheel, Q16_FROM_INT(tuneSetpoint), &gains);
+    }
+    else if (msg->status == TUNE_OK) {
+        msg->status = TUNE_TIMEOUT;
+    }
+
+    SET_BITS(tunePending, 1 << wheel);
+}
+
+/*******************************************************************************
+* Tune_Send() - Send the results waiting for the link.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Tune_Send(void) {
+    for (uint8_t i = 0; (i < 2) && (tunePending != 0); i++) {
+        if (!Link_CanSend(PROTOCOL_MAX_ENCODED)) {
+            return;
+        }
+
+        if (IS_BIT_SET(tunePending, 1 << i)
+            && Protocol_Send(MSG_TUNE_RESULT, &tuneResults[i], sizeof(tuneResults[i]))) {
+            CLEAR_BITS(tunePending, 1 << i);
+        }
+    }
+}
+
+/*******************************************************************************
+* Tune_Finish() - End the tune and report both wheels. The robot stops unless
+*                 another command took over.
+* status    - TUNE_x for the wheels that haven't finished.
+* No return value.
+*******************************************************************************/
+static void Tune_Finish(uint8_t status) {
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!tuneWheels[i].done) {
+            tuneWheels[i].status = status;
+        }
+        Tune_Report(i);
+    }
+
+    tuneActive = 0;
+    if (status != TUNE_ABORTED) {
+        G_DCMotorLeftDir = DCMOTOR_STOP;
+        G_DCMotorRightDir = DCMOTOR_STOP;
+    }
+    PID_Init();
+}
+
+/*******************************************************************************
+* Tune_Wheel() - Run one relay step for one wheel.
+* tune      - Wheel tune state.
+* motor     - DCMOTOR_LEFT or DCMOTOR_RIGHT.
+* now       - Timebase us.
+* No return value.
+*******************************************************************************/
+static void Tune_Wheel(TuneWheel *tune, uint8_t motor, uint32_t now) {
+    q16_t speed = G_EncoderSpeedQ16[motor];
+    q16_t setpoint = Q16_FROM_INT(tuneSetpoint);
+    q16_t duty;
+
+    if (tune->done) {
+        return;
+    }
+
+    if (speed > tune->max) {
+        tune->max = speed;
+    }
+    if (speed < tune->min) {
+        tune->min = speed;
+    }
+
+    if (tune->high && (speed > setpoint + TUNE_HYSTERESIS)) {
+        // A rising crossing ends a cycle
+        tune->high = 0;
+        if (tune->cycles > TUNE_SKIP_CYCLES) {
+            tune->periodUs += now - tune->riseUs;
+            tune->amplitude += (tune->max - tune->min) / 2;
+        }
+        tune->cycles++;
+        tune->riseUs = now;
+        tune->max = speed;
+        tune->min = speed;
+
+        if (tune->cycles > TUNE_SKIP_CYCLES + TUNE_CYCLES) {
+            tune->done = 1;
+            DCMotor_SetPWM(motor, 0);
+            return;
+        }
+    }
+    else if (!tune->high && (speed < setpoint - TUNE_HYSTERESIS)) {
+        tune->high = 1;
+    }
+
+    duty = tune->high ? (tune->bias + tuneAmplitude) : (tune->bias - tuneAmplitude);
+    if (duty < Q16_FROM_INT(MIN_DUTY_CYCLE)) {
+        duty = Q16_FROM_INT(MIN_DUTY_CYCLE);
+    }
+    else if (duty > Q16_FROM_INT(MAX_DUTY_CYCLE)) {
+        duty = Q16_FROM_INT(MAX_DUTY_CYCLE);
+    }
+
+    if (tune->cycles > TUNE_SKIP_CYCLES) {
+        tune->dutySum += duty;
+        tune->speedSum += speed;
+    }
+
+    DCMotor_SetPWM(motor, Q16_TO_INT(duty));
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Tune_Start() - Start auto-tuning both wheels. The robot drives forward
+*                until the tune is done, up to TUNE_TIMEOUT_MS.
+* setpoint  - Speed to tune at, cm/s.
+* amplitude - Relay amplitude, % duty either side of the bias.
+* No return value.
+*******************************************************************************/
+void Tune_Start(uint8_t setpoint, uint8_t amplitude) {
+    if (setpoint > DCMOTOR_SPEED_MAX) {
+        setpoint = DCMOTOR_SPEED_MAX;
+    }
+
+    tuneSetpoint = setpoint;
+    tuneAmplitude = Q16_FROM_INT(amplitude);
+    tuneDeadline = Timebase_DeadlineMs(TUNE_TIMEOUT_MS);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        TuneWheel *tune = &tuneWheels[i];
+
+        memset(tune, 0, sizeof(*tune));
+        tune->status = TUNE_OK;
+        tune->high = 1;
+        tune->min = Q16_FROM_INT(DCMOTOR_SPEED_MAX * 2);
+
+        // Centre the relay on the duty the current feedforward expects
+        tune->bias = Q16_MUL(PID_GetGains(i, Q16_FROM_INT(setpoint))->kff, Q16_FROM_INT(setpoint));
+    }
+
+    Kinematics_Release();
+    G_leftEncoderSetpoint = setpoint;
+    G_rightEncoderSetpoint = setpoint;
+    G_DCMotorLeftDir = DCMOTOR_FWD;
+    G_DCMotorRightDir = DCMOTOR_FWD;
+    tuneActive = 1;
+}
+
+/*******************************************************************************
+* Tune_Update() - Run the relay experiment and send its results once the
+*                 link is free. Call from the control task after
+*                 Encoder_Update(), in place of PID_Control() while it
+*                 returns 1.
+* No inputs.
+* Returns 1 while a tune is in progress, otherwise 0.
+*******************************************************************************/
+uint8_t Tune_Update(void) {
+    uint32_t now = Timebase_Us();
+
+    Tune_Send();
+    if (!tuneActive) {
+        return 0;
+    }
+
+    // Any other drive command takes the wheels back
+    if ((G_DCMotorLeftDir != DCMOTOR_FWD) || (G_DCMotorRightDir != DCMOTOR_FWD)
+        || (G_leftEncoderSetpoint != tuneSetpoint) || (G_rightEncoderSetpoint != tuneSetpoint)) {
+        Tune_Finish(TUNE_ABORTED);
+        return 0;
+    }
+
+    if (Timebase_ExpiredMs(tuneDeadline)) {
+        Tune_Finish(TUNE_TIMEOUT);
+        return 0;
+    }
+
+    Tune_Wheel(&tuneWheels[LEFT], DCMOTOR_LEFT, now);
+    Tune_Wheel(&tuneWheels[RIGHT], DCMOTOR_RIGHT, now);
+
+    if (tuneWheels[LEFT].done && tuneWheels[RIGHT].done) {
+        Tune_Finish(TUNE_OK);
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+* Tune_Receive() - Handle an auto-tune message.
+* frame     - Received frame.
+* Returns 1 if the frame was an auto-tune message, otherwise 0.
+*******************************************************************************/
+uint8_t Tune_Receive(const ProtocolFrame *frame) {
+    if ((frame->type == MSG_TUNE_START) && (frame->len == sizeof(MsgTuneStart))) {
+        const MsgTuneStart *start = (const MsgTuneStart *)frame->payload;
+
+        Tune_Start((start->setpoint != 0) ? start->setpoint : TUNE_DEFAULT_SETPOINT,
+                   (start->amplitude != 0) ? start->amplitude : TUNE_DEFAULT_AMPLITUDE);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+/*******************************************************************************
+* Name: Tune.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Relay feedback auto-tuning of the wheel PID controllers.
+*******************************************************************************/
+
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdint.h>
+
+#include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Protocol.h"
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+void Tune_Start(uint8_t setpoint, uint8_t amplitude);
+uint8_t Tune_Update(void);
+uint8_t Tune_Receive(const ProtocolFrame *frame);
+
+#endif
@@ -7,9 +7,10 @@
 
 #include <stdarg.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <string.h>
 
 #include "UART.h"
+#include "Format.h"
 #include "Utility.h"
 
 /*******************************************************************************
@@ -17,90 +18,356 @@
 *******************************************************************************/
 
 #define BAUD_RATE 9600
-#define UART_MAX_BUFF_SIZE 100
-#define RX_BUFF_SIZE 256
-
-volatile uint8_t USART3RxBuff[RX_BUFF_SIZE];
-volatile uint8_t Rx3Counter = 0;
-volatile uint8_t Rx3NextChar = 0;
+#define USART2_RX_BUFF_SIZE 256     // Buffer sizes must be a power of 2
+#define USART2_TX_BUFF_SIZE 256
+#define USART3_RX_BUFF_SIZE 1024    // Holds more than one main loop pass at 1Mbaud
+#define USART3_TX_BUFF_SIZE 512
+#define USART_PRIORITY 10
+#define USART_DMA_PRIORITY 10
+
+// DMA1 interrupt flags for a channel (1-7)
+#define DMA_TCIF(channel)   (DMA_ISR_TCIF1 << (4 * ((channel) - 1)))
+#define DMA_CGIF(channel)   (DMA_IFCR_CGIF1 << (4 * ((channel) - 1)))
+
+static volatile uint8_t USART2RxBuff[USART2_RX_BUFF_SIZE];
+static volatile uint8_t USART2TxBuff[USART2_TX_BUFF_SIZE];
+static volatile uint8_t USART3RxBuff[USART3_RX_BUFF_SIZE];
+static volatile uint8_t USART3TxBuff[USART3_TX_BUFF_SIZE];
+
+UART_Port G_USART2 = {.regs = USART2, .txDMA = DMA1_Channel7, .rxDMA = DMA1_Channel6,
+                      .txChannel = 7, .rxChannel = 6, .baud = BAUD_RATE};
+UART_Port G_USART3 = {.regs = USART3, .txDMA = DMA1_Channel2, .rxDMA = DMA1_Channel3,
+                      .txChannel = 2, .rxChannel = 3, .baud = BAUD_RATE};
+
+// UART_FormatWrite() context, one per formatted message
+typedef struct {
+    UART_Port *port;
+    uint8_t full;           // A run was dropped, drop the rest of the message
+} UART_FormatOutput;
 
 /*******************************************************************************
 *                            PRIVATE FUNCTIONS                                 *
 *******************************************************************************/
 
 /*******************************************************************************
-* USART2_config() - Configure USART2 message settings.
-* No inputs.
+* UART_Config() - Configure USART message settings.
+* port      - Port to configure.
 * No return value.
 *******************************************************************************/
-static void USART2_Config(void) {
-    // 1. Disable USART2 (set UE on CR1 to 0)
-    // USART2 -> CR1, clear UE bit
-    CLEAR_BITS(USART2->CR1, USART_CR1_UE);
+static void UART_Config(UART_Port *port) {
+    USART_TypeDef *USARTx = port->regs;
 
-    // 2. Set the baud rate register (ie. clock division regsiter) (BRR) to hit 9600 baud
-    // USART2 -> BRR = System Clock Rate / Baud Rate
-    USART2->BRR = SystemCoreClock / BAUD_RATE;
+    // 1. Disable USART (set UE on CR1 to 0)
+    CLEAR_BITS(USARTx->CR1, USART_CR1_UE);
+
+    // 2. Set the baud rate register (BRR). The USART is clocked from SYSCLK.
+    // USARTx -> BRR = System Clock Rate / Baud Rate (rounded)
+    USARTx->BRR = (SystemCoreClock + port->baud / 2) / port->baud;
 
     // 3. Configure data size (8bit), start bit (1), stop bit (1/2/1.5), parity bit (no parity, even / odd parity)
-    // USART2 -> CR1, use M mask OR focus on bit 12 and 28.  They are M0 amd M1
-    // Set to 00 to make data frame size 8-bit
-    CLEAR_BITS(USART2->CR1, USART_CR1_M);
+    // M0 and M1 set to 00 to make data frame size 8-bit
+    CLEAR_BITS(USARTx->CR1, USART_CR1_M);
 
     // OVER8 setup (stick with 16x)
-    // USART2 -> CR1, bit OVER8 set to 0
-    CLEAR_BITS(USART2->CR1, USART_CR1_OVER8);
+    CLEAR_BITS(USARTx->CR1, USART_CR1_OVER8);
 
-    // USART2 -> CR2, STOP set to 00 (1 bit), 01 (0.5 bit), 10 (2 bits), 11 (1.5 bit)
-    CLEAR_BITS(USART2->CR2, USART_CR2_STOP);
+    // STOP set to 00 (1 bit), 01 (0.5 bit), 10 (2 bits), 11 (1.5 bit)
+    CLEAR_BITS(USARTx->CR2, USART_CR2_STOP);
 
     // 4. Enable transmit and receive block (TE and RE)
-    // USART2 -> CR1, set TE and RE
-    SET_BITS(USART2->CR1, USART_CR1_TE);    // Enable transmitter
-    SET_BITS(USART2->CR1, USART_CR1_RE);    // Enable receiver
+    SET_BITS(USARTx->CR1, USART_CR1_TE);    // Enable transmitter
+    SET_BITS(USARTx->CR1, USART_CR1_RE);    // Enable receiver
 
-    // 5. Enable USART2 (set UE and CR1 to 1)
-    // USART2 -> CR1, set CR1
-    SET_BITS(USART2->CR1, USART_CR1_UE);
+    // 5. Enable USART (set UE and CR1 to 1)
+    SET_BITS(USARTx->CR1, USART_CR1_UE);
 
-    // 6. Wait for the USART2 clock to boot up and get ready
-    while ((USART2->ISR & USART_ISR_TEACK) == 0);   // Wait till Transmitter is ready to go
-    while ((USART2->ISR & USART_ISR_REACK) == 0);   // Wait till Receiver is ready to go
+    // 6. Wait for the USART clock to boot up and get ready
+    while ((USARTx->ISR & USART_ISR_TEACK) == 0) SIM_YIELD();  // Wait till Transmitter is ready to go
+    while ((USARTx->ISR & USART_ISR_REACK) == 0) SIM_YIELD();  // Wait till Receiver is ready to go
 }
 
 /*******************************************************************************
-* USART3_config() - Configure USART3 message settings.
-* No inputs.
+* UART_Start() - Configure the DMA channels, interrupts and queues of a port
+*                and start the USART.
+* port      - Port to start.
+* txBuff    - Transmit queue storage.
+* txSize    - Size of txBuff (power of 2).
+* rxBuff    - Receive DMA storage.
+* rxSize    - Size of rxBuff (power of 2).
+* irq       - USART interrupt.
+* txIrq     - Transmit DMA channel interrupt.
+* rxIrq     - Receive DMA channel interrupt.
+* No return value.
+*******************************************************************************/
+static void UART_Start(UART_Port *port, volatile uint8_t *txBuff, uint16_t txSize,
+                       volatile uint8_t *rxBuff, uint16_t rxSize,
+                       IRQn_Type irq, IRQn_Type txIrq, IRQn_Type rxIrq) {
+    USART_TypeDef *USARTx = port->regs;
+
+    Queue_Init(&port->tx, txBuff, txSize);
+    Queue_Init(&port->rx, rxBuff, rxSize);
+    port->txDMALen = 0;
+
+    // Enable the idle line interrupt to mark the end of each received burst
+    // and the error interrupt for framing, noise and overrun errors
+    SET_BITS(USARTx->CR1, USART_CR1_IDLEIE);
+    SET_BITS(USARTx->CR3, USART_CR3_EIE);
+    NVIC_SetPriority(irq, USART_PRIORITY);
+    NVIC_EnableIRQ(irq);
+
+    SET_BITS(RCC->AHBENR, RCC_AHBENR_DMA1EN);
+
+    // Receive DMA fills the receive buffer in circular mode
+    CLEAR_BITS(port->rxDMA->CCR, DMA_CCR_EN);
+    port->rxDMA->CPAR = (uint32_t)&USARTx->RDR;
+    port->rxDMA->CMAR = (uint32_t)rxBuff;
+    port->rxDMA->CNDTR = rxSize;
+    port->rxDMA->CCR = DMA_CCR_MINC         // Increment memory address, peripheral is fixed
+                     | DMA_CCR_CIRC         // Wrap around to the start of the buffer
+                     | DMA_CCR_HTIE         // Interrupt at half and full buffer so long
+                     | DMA_CCR_TCIE;        // bursts are published before the line goes idle
+                                            // Read from peripheral, 8-bit sizes, low priority
+    NVIC_SetPriority(rxIrq, USART_DMA_PRIORITY);
+    NVIC_EnableIRQ(rxIrq);
+    SET_BITS(USARTx->CR3, USART_CR3_DMAR);
+    SET_BITS(port->rxDMA->CCR, DMA_CCR_EN);
+
+    // Transmit DMA drains the transmit queue one contiguous block at a time
+    CLEAR_BITS(port->txDMA->CCR, DMA_CCR_EN);
+    port->txDMA->CPAR = (uint32_t)&USARTx->TDR;
+    port->txDMA->CCR = DMA_CCR_MINC         // Increment memory address, peripheral is fixed
+                     | DMA_CCR_DIR          // Read from memory, write to peripheral
+                     | DMA_CCR_TCIE;        // Interrupt when the block has been sent
+                                            // 8-bit memory and peripheral size, low priority
+    NVIC_SetPriority(txIrq, USART_DMA_PRIORITY);
+    NVIC_EnableIRQ(txIrq);
+    SET_BITS(USARTx->CR3, USART_CR3_DMAT);
+
+    UART_Config(port);
+}
+
+/*******************************************************************************
+* UART_StartTx() - Start a DMA transfer of the next contiguous block of the
+*                  transmit queue. Must be called with interrupts disabled.
+* port      - Port to transmit on.
+* No return value.
+*******************************************************************************/
+static void UART_StartTx(UART_Port *port) {
+    // DMA busy or nothing to send
+    if ((port->txDMALen != 0) || (Queue_Count(&port->tx) == 0)) {
+        return;
+    }
+
+    // Only send up to the end of the buffer, the rest is sent on the next transfer
+    port->txDMALen = Queue_Contiguous(&port->tx);
+
+    CLEAR_BITS(port->txDMA->CCR, DMA_CCR_EN);
+    port->txDMA->CMAR = (uint32_t)&port->tx.buff[port->tx.tail];
+    port->txDMA->CNDTR = port->txDMALen;
+    SET_BITS(port->txDMA->CCR, DMA_CCR_EN);
+}
+
+/*******************************************************************************
+* UART_RxUpdate() - Publish the receive DMA write position to the consumer.
+*                   The circular DMA never stops for a full buffer, so if more
+*                   was written since the last update than there was free
+*                   space it has overwritten unread characters. The half and
+*                   full buffer interrupts keep each update under one lap.
+* port      - Port to update.
+* No return value.
+*******************************************************************************/
+static void UART_RxUpdate(UART_Port *port) {
+    uint16_t head = ((port->rx.mask + 1) - port->rxDMA->CNDTR) & port->rx.mask;
+    uint16_t written = (head - port->rx.head) & port->rx.mask;
+
+    // UART_Read drops the damaged data, the tail belongs to the consumer
+    if (written > Queue_Space(&port->rx)) {
+        port->rxErrors.overflow++;
+    }
+
+    Queue_Publish(&port->rx, head);
+}
+
+/*******************************************************************************
+* UART_IRQHandler() - USART interrupt handler. Fires once per received burst
+*                     when the line goes idle, and on receive errors.
+* port      - Port that interrupted.
+* No return value.
+*******************************************************************************/
+static void UART_IRQHandler(UART_Port *port) {
+    USART_TypeDef *USARTx = port->regs;
+
+    if (USARTx->ISR & USART_ISR_IDLE) {
+        USARTx->ICR = USART_ICR_IDLECF;
+        UART_RxUpdate(port);
+        port->rxBursts++;
+    }
+
+    // Overrun stops the DMA requests until it is cleared
+    if (USARTx->ISR & USART_ISR_ORE) {
+        USARTx->ICR = USART_ICR_ORECF;
+        port->rxErrors.overrun++;
+    }
+
+    if (USARTx->ISR & USART_ISR_FE) {
+        USARTx->ICR = USART_ICR_FECF;
+        port->rxErrors.framing++;
+    }
+
+    if (USARTx->ISR & USART_ISR_NE) {
+        USARTx->ICR = USART_ICR_NCF;
+        port->rxErrors.noise++;
+    }
+}
+
+/*******************************************************************************
+* UART_TxDMAHandler() - Transmit DMA interrupt handler.
+* port      - Port that interrupted.
+* No return value.
+*******************************************************************************/
+static void UART_TxDMAHandler(UART_Port *port) {
+    if (DMA1->ISR & DMA_TCIF(port->txChannel)) {
+        DMA1->IFCR = DMA_CGIF(port->txChannel);
+
+        // Release the block that was just sent and start on the next one
+        Queue_Release(&port->tx, port->txDMALen);
+        port->txStats.sent += port->txDMALen;
+        port->txDMALen = 0;
+
+        UART_StartTx(port);
+    }
+}
+
+/*******************************************************************************
+* UART_RxDMAHandler() - Receive DMA interrupt handler. Fires when the buffer is
+*                       half full and full.
+* port      - Port that interrupted.
 * No return value.
 *******************************************************************************/
-static void USART3_Config(void) {
-    // Disable USART3 (set UE on CR1 to 0)
-    CLEAR_BITS(USART3->CR1, USART_CR1_UE);
+static void UART_RxDMAHandler(UART_Port *port) {
+    DMA1->IFCR = DMA_CGIF(port->rxChannel);
+    UART_RxUpdate(port);
+}
 
-    // Set the baud rate to 9600
-    USART3->BRR = SystemCoreClock / BAUD_RATE;
+/*******************************************************************************
+* UART_getc() - Get char from a port (blocking).
+* port      - Port to read.
+* Returns a char.
+*******************************************************************************/
+static char UART_getc(UART_Port *port) {
+    uint8_t c;
 
-    // Configure data size (8bit), start bit (1), stop bit (1/2/1.5), parity bit (no parity, even / odd parity)
-    CLEAR_BITS(USART3->CR1, USART_CR1_M);
-    CLEAR_BITS(USART3->CR1, USART_CR1_OVER8);
-    CLEAR_BITS(USART3->CR2, USART_CR2_STOP);
+    // Received characters are moved into the buffer by the DMA
+    while (UART_Read(port, &c, 1) == 0) SIM_YIELD();
 
-    // Enable transmit and receive block (TE and RE)
-    SET_BITS(USART3->CR1, USART_CR1_TE);
-    SET_BITS(USART3->CR1, USART_CR1_RE);
+    return ((char)c);
+}
 
-    // Enable USART3 (set UE and CR1 to 1)
-    SET_BITS(USART3->CR1, USART_CR1_UE);
+/*******************************************************************************
+* UART_getcNB() - Get char from a port (non-blocking).
+* port      - Port to read.
+* Returns a char, or '\0' if nothing has been received.
+*******************************************************************************/
+static char UART_getcNB(UART_Port *port) {
+    uint8_t c = '\0';
 
-    // Wait for the USART3 clock to boot up and get ready
-    while ((USART3->ISR & USART_ISR_TEACK) == 0);
-    while ((USART3->ISR & USART_ISR_REACK) == 0);
+    UART_Read(port, &c, 1);
+    return ((char)c);
+}
+
+/*******************************************************************************
+* UART_FormatWrite() - Formatter output function, queues the formatted text.
+*                      The formatter writes a message in several runs, once one
+*                      does not fit the rest are dropped too, so a message that
+*                      fills the queue loses its tail rather than its middle.
+* ctx       - UART_FormatOutput for the message.
+* data      - Formatted characters.
+* len       - Number of characters.
+* No return value.
+*******************************************************************************/
+static void UART_FormatWrite(void *ctx, const char *data, uint16_t len) {
+    UART_FormatOutput *out = (UART_FormatOutput *)ctx;
+
+    if (out->full) {
+        CRITICAL_ENTER();
+        out->port->txStats.dropped += len;
+        CRITICAL_EXIT();
+    }
+    else if (UART_Write(out->port, (const uint8_t *)data, len) == 0) {
+        out->full = 1;
+    }
 }
 
 /*******************************************************************************
 *                            PUBLIC FUNCTIONS                                  *
 *******************************************************************************/
 
+/*******************************************************************************
+* UART_SetBaud() - Change the baud rate of a port. Anything still in the
+*                  transmit shift register is lost, so check UART_TxIdle() first.
+* port      - Port to change.
+* baud      - New baud rate. The USARTs run from SYSCLK so up to SYSCLK/16.
+* No return value.
+*******************************************************************************/
+void UART_SetBaud(UART_Port *port, uint32_t baud) {
+    port->baud = baud;
+    UART_Config(port);
+}
+
+/*******************************************************************************
+* UART_Write() - Queue data for transmission (non-blocking).
+*                Safe to call from the main loop and from ISRs.
+* port      - Port to transmit on.
+* data      - Data to transmit.
+* len       - Number of bytes to transmit.
+* Returns the number of bytes queued. The data is dropped if it does not fit.
+*******************************************************************************/
+uint16_t UART_Write(UART_Port *port, const uint8_t *data, uint16_t len) {
+    // Serialize producers so the transmit queue stays single-producer
+    CRITICAL_ENTER();
+
+    if (Queue_Push(&port->tx, data, len) == 0) {
+        port->txStats.dropped += len;
+        CRITICAL_EXIT();
+        return 0;
+    }
+    port->txStats.queued += len;
+
+    UART_StartTx(port);
+
+    CRITICAL_EXIT();
+    return len;
+}
+
+/*******************************************************************************
+* UART_Read() - Read pending characters (main loop only).
+* port      - Port to read.
+* buff      - Buffer to copy the characters into.
+* len       - Size of buff.
+* Returns the number of characters read.
+*******************************************************************************/
+uint16_t UART_Read(UART_Port *port, uint8_t *buff, uint16_t len) {
+    // Resync after an overflow, the unread characters were partly overwritten
+    // and head no longer tells how many are left. The protocol decoder picks
+    // up again at the next frame delimiter.
+    if (port->rxResyncs != port->rxErrors.overflow) {
+        port->rxResyncs = port->rxErrors.overflow;
+        Queue_Flush(&port->rx);
+    }
+
+    return Queue_Pop(&port->rx, buff, len);
+}
+
+/*******************************************************************************
+* UART_TxIdle() - Check if all queued data has been sent.
+* port      - Port to check.
+* Returns 1 if the transmit queue is empty and the last frame has left the
+* shift register, otherwise 0.
+*******************************************************************************/
+uint8_t UART_TxIdle(UART_Port *port) {
+    return ((Queue_Count(&port->tx) == 0) && (port->regs->ISR & USART_ISR_TC)) ? 1 : 0;
+}
+
 /*******************************************************************************
 * USART2_Init() - Initialize USART2 setting.
 * No inputs.
@@ -148,34 +415,28 @@ void USART2_Init(void) {
     GPIO_OTYPER_SET(A, 2, GPIO_OTYPE_PP);
     GPIO_OTYPER_SET(A, 3, GPIO_OTYPE_PP);
 
-    // Configure USART2
-    USART2_Config();
+    // Configure USART2 (USART2_TX on DMA1 channel 7, USART2_RX on DMA1 channel 6)
+    UART_Start(&G_USART2, USART2TxBuff, USART2_TX_BUFF_SIZE, USART2RxBuff, USART2_RX_BUFF_SIZE,
+               USART2_IRQn, DMA1_Channel7_IRQn, DMA1_Channel6_IRQn);
 }
 
 /*******************************************************************************
-* USART2_putc() - Write a char to transmit data register.
+* USART2_putc() - Queue a char for transmission (non-blocking).
 * c    - Char to transmit.
 * No return value.
 *******************************************************************************/
 void USART2_putc(char c) {
-    // Wait TXE (TX empty) is set
-    while ((USART2->ISR & USART_ISR_TXE) == 0);
-
-    // Write char to the trasmit data register
-    // Writing USART_TDR automatically clears the TXE flag
-    USART2->TDR = (uint8_t)c;
+    UART_Write(&G_USART2, (uint8_t *)&c, 1);
 }
 
 /*******************************************************************************
-* USART2_puts() - Write string to transmit data register.
+* USART2_puts() - Queue a string for transmission (non-blocking).
 * str    - String to transmit.
 * No return value.
 *******************************************************************************/
 void USART2_puts(char *str) {
     // Don't send trailing NULL char
-    while (*str) {
-        USART2_putc(*str++);
-    }
+    UART_Write(&G_USART2, (uint8_t *)str, strlen(str));
 }
 
 /*******************************************************************************
@@ -184,12 +445,7 @@ void USART2_puts(char *str) {
 * Returns a char.
 *******************************************************************************/
 char USART2_getc(void) {
-    // Wait until RXNE flag is set
-    while ((USART2->ISR & USART_ISR_RXNE) == 0);
-
-    // Read char from the receive data regsiter
-    // Reading USART_RDR automatically clears the RXNE flag
-    return ((char)USART2->RDR);
+    return UART_getc(&G_USART2);
 }
 
 /*******************************************************************************
@@ -198,15 +454,7 @@ char USART2_getc(void) {
 * Returns a char.
 *******************************************************************************/
 char USART2_getcNB(void) {
-    // If RXNE flag is set
-    if (USART2->ISR & USART_ISR_RXNE) {
-        // Read char from the receive data regsiter
-        // Reading USART_RDR automatically clears the RXNE flag
-        return ((char)USART2->RDR);
-    }
-    else {
-        return ('\0');
-    }
+    return UART_getcNB(&G_USART2);
 }
 
 /*******************************************************************************
@@ -215,15 +463,11 @@ char USART2_getcNB(void) {
 * No return value.
 *******************************************************************************/
 void USART2_printf(char* fmt, ...) {
-    char buff[UART_MAX_BUFF_SIZE];
-
+    UART_FormatOutput out = {&G_USART2, 0};
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buff, UART_MAX_BUFF_SIZE, fmt, args);
+    Format_vprintf(UART_FormatWrite, &out, fmt, args);
     va_end(args);
-
-    // Transmit UART buff
-    USART2_puts(buff);
 }
 
 /*******************************************************************************
@@ -274,37 +518,28 @@ void USART3_Init(void) {
     GPIO_OTYPER_SET(B, 13, GPIO_OTYPE_PP);
     GPIO_OTYPER_SET(B, 14, GPIO_OTYPE_PP);
 
-    // Enable USART3 interrupts
-    SET_BITS(USART3->CR1, USART_CR1_RXNEIE);
-    NVIC_SetPriority(USART3_IRQn, 0);
-    NVIC_EnableIRQ(USART3_IRQn);
-
-    USART3_Config();
+    // Configure USART3 (USART3_TX on DMA1 channel 2, USART3_RX on DMA1 channel 3)
+    UART_Start(&G_USART3, USART3TxBuff, USART3_TX_BUFF_SIZE, USART3RxBuff, USART3_RX_BUFF_SIZE,
+               USART3_IRQn, DMA1_Channel2_IRQn, DMA1_Channel3_IRQn);
 }
 
 /*******************************************************************************
-* USART3_putc() - Write a char to transmit data register.
+* USART3_putc() - Queue a char for transmission (non-blocking).
 * c - Char to transmit.
 * No return value.
 *******************************************************************************/
 void USART3_putc(char c) {
-    while ((USART3->ISR & USART_ISR_TXE) == 0);
-
-    // Write char to the trasmit data register
-    // Writing USART_TDR automatically clears the TXE flag
-    USART3->TDR = (uint8_t)c;
+    UART_Write(&G_USART3, (uint8_t *)&c, 1);
 }
 
 /*******************************************************************************
-* USART3_puts() - Write string to transmit data register.
+* USART3_puts() - Queue a string for transmission (non-blocking).
 * str       - String to transmit.
 * No return value.
 *******************************************************************************/
 void USART3_puts(char *str) {
     // Don't send trailing NULL char
-    while (*str) {
-        USART3_putc(*str++);
-    }
+    UART_Write(&G_USART3, (uint8_t *)str, strlen(str));
 }
 
 /*******************************************************************************
@@ -313,11 +548,7 @@ void USART3_puts(char *str) {
 * Returns a char.
 *******************************************************************************/
 char USART3_getc(void) {
-    while ((USART3->ISR & USART_ISR_RXNE) == 0);
-
-    // Read char from the receive data regsiter
-    // Reading USART_RDR automatically clears the RXNE flag
-    return ((char)USART3->RDR);
+    return UART_getc(&G_USART3);
 }
 
 /*******************************************************************************
@@ -326,14 +557,7 @@ char USART3_getc(void) {
 * Returns a char.
 *******************************************************************************/
 char USART3_getcNB(void) {
-    if (USART3->ISR & USART_ISR_RXNE) {
-        // Read char from the receive data regsiter
-        // Reading USART_RDR automatically clears the RXNE flag
-        return ((char)USART3->RDR);
-    }
-    else {
-        return ('\0');
-    }
+    return UART_getcNB(&G_USART3);
 }
 
 /*******************************************************************************
@@ -342,53 +566,46 @@ char USART3_getcNB(void) {
 * No return value.
 *******************************************************************************/
 void USART3_printf(char* fmt, ...) {
-    char buff[UART_MAX_BUFF_SIZE];
-
+    UART_FormatOutput out = {&G_USART3, 0};
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buff, UART_MAX_BUFF_SIZE, fmt, args);
+    Format_vprintf(UART_FormatWrite, &out, fmt, args);
     va_end(args);
-    USART3_puts(buff);
 }
 
 /*******************************************************************************
-* USART_IRQHandler() - Interrupt request handler for USART.
-* USARTx        - USART to check.
-* buff          - Buffer to store recieved character.
-* pRxCounter    - Index to store next character into buffer.
-* No return value.
+* USART3_dequeue() - Dequeues the next character in the USART3 buffer.
+* No inputs.
+* Returns a uint8_t.
 *******************************************************************************/
-void USART_IRQHandler(USART_TypeDef* USARTx, volatile uint8_t* buff, volatile uint8_t* pRxCounter) {
-    if (USARTx->ISR & USART_ISR_RXNE) {
-        if ((*pRxCounter + 1) % RX_BUFF_SIZE != Rx3NextChar) {
-            buff[*pRxCounter] = USARTx->RDR;
-            *pRxCounter = (*pRxCounter + 1) % RX_BUFF_SIZE;
-        }
-    }
+uint8_t USART3_dequeue(void) {
+    return (uint8_t)UART_getcNB(&G_USART3);
 }
 
 /*******************************************************************************
-* USART3_IRQHandler() - USART3 interrupt handler.
-* No inputs.
-* No return value.
+*                            INTERRUPT HANDLERS                                *
 *******************************************************************************/
-void USART3_IRQHandler(void) {
-    USART_IRQHandler(USART3, USART3RxBuff, &Rx3Counter);
+
+void USART2_IRQHandler(void) {
+    UART_IRQHandler(&G_USART2);
 }
 
-/*******************************************************************************
-* USART3_dequeue() - Dequeues the next character in the USART3 buffer.
-* No inputs.
-* Returns a uint8_t.
-*******************************************************************************/
-uint8_t USART3_dequeue(void) {
-    uint8_t dequeue = '\0';
+void DMA1_Channel7_IRQHandler(void) {
+    UART_TxDMAHandler(&G_USART2);
+}
 
-    if (Rx3NextChar != Rx3Counter) {
-        dequeue = USART3RxBuff[Rx3NextChar];
-        Rx3NextChar = (Rx3NextChar + 1) % RX_BUFF_SIZE;
-    }
+void DMA1_Channel6_IRQHandler(void) {
+    UART_RxDMAHandler(&G_USART2);
+}
 
-    return (dequeue);
+void USART3_IRQHandler(void) {
+    UART_IRQHandler(&G_USART3);
 }
 
+void DMA1_Channel2_IRQHandler(void) {
+    UART_TxDMAHandler(&G_USART3);
+}
+
+void DMA1_Channel3_IRQHandler(void) {
+    UART_RxDMAHandler(&G_USART3);
+}
@@ -9,6 +9,51 @@
 #define __UART_H
 
 #include "../stm32-base/CMSIS/inc/stm32f303xe.h"
+#include "Queue.h"
+
+typedef struct {
+    uint32_t queued;        // Bytes accepted into the transmit buffer
+    uint32_t sent;          // Bytes handed to the USART by the DMA
+    uint32_t dropped;       // Bytes rejected because the buffer was full
+} USART_TxStats;
+
+typedef struct {
+    uint32_t overrun;       // Characters lost because the receiver was not emptied
+    uint32_t framing;       // Characters without a valid stop bit
+    uint32_t noise;         // Characters with noise detected during sampling
+    uint32_t overflow;      // Times the receive DMA overwrote unread characters
+} USART_RxErrors;
+
+// Per-port driver state. Both queues are single-producer/single-consumer:
+//  - tx: produced by UART_Write (callers are serialized with a critical section)
+//        and consumed by the transmit DMA interrupt
+//  - rx: produced by the receive DMA (published from the idle line and DMA
+//        interrupts) and consumed by the main loop
+typedef struct {
+    USART_TypeDef *regs;
+    DMA_Channel_TypeDef *txDMA;
+    DMA_Channel_TypeDef *rxDMA;
+    uint8_t txChannel;              // DMA1 channel numbers, for the ISR/IFCR flags
+    uint8_t rxChannel;
+    uint32_t baud;
+
+    Queue tx;
+    Queue rx;
+    volatile uint16_t txDMALen;     // Bytes the transmit DMA is currently sending
+
+    volatile USART_TxStats txStats;
+    volatile USART_RxErrors rxErrors;
+    volatile uint32_t rxBursts;     // Idle line events
+    uint32_t rxResyncs;             // Overflows already handled by UART_Read
+} UART_Port;
+
+extern UART_Port G_USART2;
+extern UART_Port G_USART3;
+
+void UART_SetBaud(UART_Port *port, uint32_t baud);
+uint16_t UART_Write(UART_Port *port, const uint8_t *data, uint16_t len);
+uint16_t UART_Read(UART_Port *port, uint8_t *buff, uint16_t len);
+uint8_t UART_TxIdle(UART_Port *port);
 
 void USART2_Init(void);
 void USART2_putc(char c);
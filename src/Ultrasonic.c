@@ -2,22 +2,47 @@
 * Name: Ultrasonic.c (implementation)
 * Author(s): Noah Grant, Wyatt Richard
 * Date: March 17, 2023
-* Description: Ultrasonic sensor functions. Ultrasonic sensor is in polling mode.
+* Description: Ultrasonic sensor functions. TIM16 triggers the sensor in PWM
+*              mode at the ranging rate and TIM3 measures each echo pulse, so
+*              no task has to pace it. The ISRs turn each trigger into one
+*              timestamped sample: an echo, an echo longer than the timeout
+*              (nothing in range) or no echo at all by the next trigger,
+*              tagged with where the stepper was pointing the sensor. The
+*              distance of each sample is the median of the last few so
+*              single bad echoes are dropped. Samples go into a ring that is
+*              only written by the ISRs, readers check afterwards that the
+*              sample they copied wasn't overwritten instead of masking the
+*              interrupts.
 *******************************************************************************/
 
 #include "Ultrasonic.h"
-#include "DCMotor.h"
+#include "Timebase.h"
+#include "Stepper.h"
 
 /*******************************************************************************
-*                               STATIC VARIABLES                                *
+*                            CONSTANTS & DEFINES                               *
 *******************************************************************************/
-
-uint32_t G_UltraEcho = 0;
+#define ULTRA_RING_MASK     (ULTRA_RING_SIZE - 1)
+#define ULTRA_TICK_US       10UL        // TIM16 count, sets the slowest rate
+#define ULTRA_TRIGGER_TICKS 2UL         // 20us trigger pulse, the sensor needs 10us
+#define ULTRA_MIN_RATE_HZ   ((1000000UL / ULTRA_TICK_US + 0xFFFFUL) / 0x10000UL)
 
 /*******************************************************************************
-*                               PUBLIC FUNCTIONS                                *
+*                               LOCAL VARIABLES                                *
 *******************************************************************************/
+static volatile UltraSample ultraRing[ULTRA_RING_SIZE];
+static volatile uint32_t ultraCount = 0;       // Samples pushed, only written by the ISRs
+static uint16_t ultraEchoes[ULTRA_MEDIAN];     // Last pulse widths, a timeout counts as the longest
+static uint8_t ultraEchoCount = 0;
+static uint8_t ultraEchoNext = 0;
+static uint8_t ultraPending = 0;                // Triggered and waiting for the echo
+static uint32_t ultraTriggerUs = 0;             // Timebase of the last trigger
+static int16_t ultraTriggerPan = 0;             // Stepper position at the last trigger
+static uint32_t ultraTimeoutUs = ULTRA_ECHO_TIMEOUT_US;
 
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
 /*******************************************************************************
 * Ultra_InitTrigger() - Initialize ultrasonic trigger timer.
 * No inputs.
@@ -33,26 +58,26 @@ static void Ultra_InitTrigger(void){
 
     // Configure TIM16 CH1
     SET_BITS(RCC->APB2ENR, RCC_APB2ENR_TIM16EN);    // Turn on TIM16
-    SET_BITS(TIM16->PSC, 71UL);                     // Set PSC so it counts in 1us (1-10us)
+    FORCE_BITS(TIM16->PSC, 0xFFFFUL, 719UL);        // Set PSC so it counts in 10us
         // Timer Period = (Prescaler + 1) / SystemClockFreq
-        // 1us = (Prescaler + 1) / 72MHz
-        // (Prescaler + 1) = 72
-        // Prescaler = 71
-    FORCE_BITS(TIM16->ARR, 0xFFFFUL, 99999UL);      // Set ARR to 100ms (100-500ms)
-        // ARR = Repeating Counter Period - 1
-    SET_BITS(TIM16->CR1, TIM_CR1_ARPE);             // Enable ARR preload (ARPE) in CR1
+        // 10us = (Prescaler + 1) / 72MHz
+        // (Prescaler + 1) = 720
+        // Prescaler = 719
+    SET_BITS(TIM16->CR1, TIM_CR1_ARPE);             // Enable ARR preload (ARPE) in CR1, rate changes start on the next trigger
+    CLEAR_BITS(TIM16->CR1, TIM_CR1_OPM);            // Repeat, one trigger per period
     SET_BITS(TIM16->BDTR, TIM_BDTR_MOE);            // Set main output enabled (MOE) in BDTR
 
-    // Configure TIM16 CH1 for OCM with PWM
-    SET_BITS(TIM16->CCMR1, TIM_CCMR1_OC1M);         // Set TIM16 to PWM mode
+    // Configure TIM16 CH1 for PWM mode 1, high for the trigger pulse at the start of each period
+    FORCE_BITS(TIM16->CCMR1, TIM_CCMR1_OC1M, TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1);
     SET_BITS(TIM16->CCMR1, TIM_CCMR1_OC1PE);        // Enable Output Compare Preload (OC1PE)
     SET_BITS(TIM16->CCER, TIM_CCER_CC1E);           // Enable Regular Output Channel for CH1
     CLEAR_BITS(TIM16->CCER, TIM_CCER_CC1P);         // Make CH1 active HI
-    FORCE_BITS(TIM16->CCR1, 0xFFFFUL, 10UL);        // Set CH1 CCR1 initial output waveform on-time to 10us PWM pulse width
+    FORCE_BITS(TIM16->CCR1, 0xFFFFUL, ULTRA_TRIGGER_TICKS);
 
-    // Configure TIM16 CH1 for PWM (repeating mode)
-    SET_BITS(TIM16->CR1, TIM_CR1_OPM);              // Set TIM16 to one-shot mode
-    SET_BITS(TIM16->EGR, TIM_EGR_UG);               // Force an update event to prelaod all the registers
+    // Interrupt at each trigger to check the last one was answered
+    SET_BITS(TIM16->DIER, TIM_DIER_UIE);
+    NVIC_SetPriority(TIM1_UP_TIM16_IRQn, ULTRA_PRIORITY);
+    NVIC_EnableIRQ(TIM1_UP_TIM16_IRQn);
 }
 
 /*******************************************************************************
@@ -91,55 +116,201 @@ static void Ultra_InitEcho(void){
     SET_BITS(TIM3->CCER, TIM_CCER_CC1E);
     SET_BITS(TIM3->CR1, TIM_CR1_CEN);               // Enable TIM3 main counter
 
-    // Configure interrupts for Echo pin
+    // Configure interrupts for Echo pin, same priority as the trigger so
+    // they never interrupt each other
     SET_BITS(TIM3->DIER, TIM_DIER_CC1IE); // Enable interrupt
-    NVIC_SetPriority(TIM3_IRQn, 0);
+    NVIC_SetPriority(TIM3_IRQn, ULTRA_PRIORITY);
     NVIC_EnableIRQ(TIM3_IRQn);
 }
 
 /*******************************************************************************
-*                                   PUBLIC FUNCTIONS                           *
+* Ultra_Median() - Median of the last few pulse widths.
+* No inputs.
+* Returns the median pulse width in us.
 *******************************************************************************/
+static uint16_t Ultra_Median(void) {
+    uint16_t sorted[ULTRA_MEDIAN];
+    uint16_t echo;
+    uint8_t i, j;
+
+    // Insertion sort, there are only a few
+    for (i = 0; i < ultraEchoCount; i++) {
+        echo = ultraEchoes[i];
+        for (j = i; (j > 0) && (sorted[j - 1] > echo); j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = echo;
+    }
+
+    return sorted[ultraEchoCount / 2];
+}
+
 /*******************************************************************************
-* Ultra_Init() - Call the ultrasonic trigger and echo initialization functions.
+* Ultra_Push() - Filter a reading and add it to the ring. Only call from the
+*                ultrasonic ISRs.
+* echo      - Pulse width in us, 0 if there was no echo.
+* status    - ULTRA_x reading status.
+* No return value.
+*******************************************************************************/
+static void Ultra_Push(uint16_t echo, uint8_t status) {
+    volatile UltraSample *sample = &ultraRing[ultraCount & ULTRA_RING_MASK];
+    int16_t pan = G_StepperPosition;
+    uint16_t median;
+
+    ultraEchoes[ultraEchoNext] = (status == ULTRA_OK) ? echo : 0xFFFF;
+    ultraEchoNext = (ultraEchoNext + 1) % ULTRA_MEDIAN;
+    if (ultraEchoCount < ULTRA_MEDIAN) {
+        ultraEchoCount++;
+    }
+    median = Ultra_Median();
+
+    // Timed at the reflection, half way through the flight
+    sample->time = ultraTriggerUs + echo / 2;
+    sample->echo = echo;
+    sample->distance = (median == 0xFFFF) ? ULTRA_NO_RANGE : (median / ULTRA_US_PER_CM);
+    sample->pan = (status == ULTRA_MISSED) ? ultraTriggerPan : (int16_t)((ultraTriggerPan + pan) / 2);
+    sample->status = status;
+    ultraCount++;
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+/*******************************************************************************
+* Ultra_Init() - Call the ultrasonic trigger and echo initialization functions
+*                and start ranging at ULTRA_DEFAULT_RATE_HZ.
 * No inputs.
 * No return value.
 *******************************************************************************/
 void Ultra_Init(void){
     Ultra_InitTrigger();
     Ultra_InitEcho();
+    Ultra_SetRate(ULTRA_DEFAULT_RATE_HZ);
 }
 
 /*******************************************************************************
-* Ultra_StartTrigger() - Starts the trigger timer.
-* No inputs.
+* Ultra_SetRate() - Set the ranging rate. Limited to what the sensor can do
+*                   (ULTRA_MIN_CYCLE_MS) and the slowest the trigger timer can
+*                   count.
+* hz        - Readings per second, 0 to stop ranging.
+* No return value.
+*******************************************************************************/
+void Ultra_SetRate(uint16_t hz) {
+    if (hz == 0) {
+        CLEAR_BITS(TIM16->CR1, TIM_CR1_CEN);
+        return;
+    }
+
+    if (hz < ULTRA_MIN_RATE_HZ) {
+        hz = ULTRA_MIN_RATE_HZ;
+    }
+    else if (hz > ULTRA_MAX_RATE_HZ) {
+        hz = ULTRA_MAX_RATE_HZ;
+    }
+
+    FORCE_BITS(TIM16->ARR, 0xFFFFUL, (1000000UL / ULTRA_TICK_US) / hz - 1);
+    if (!IS_BIT_SET(TIM16->CR1, TIM_CR1_CEN)) {
+        SET_BITS(TIM16->EGR, TIM_EGR_UG);           // Load ARR and CCR1 before the first trigger
+        CLEAR_BITS(TIM16->SR, TIM_SR_UIF);
+        SET_BITS(TIM16->CR1, TIM_CR1_CEN);
+    }
+}
+
+/*******************************************************************************
+* Ultra_SetEchoTimeout() - Set the longest echo that counts as a reading.
+* us        - Echo timeout, 58us per cm of range.
 * No return value.
 *******************************************************************************/
-void Ultra_StartTrigger(void){
-    SET_BITS(TIM16->CR1, TIM_CR1_CEN);  // Enable TIM16
+void Ultra_SetEchoTimeout(uint32_t us) {
+    ultraTimeoutUs = (us > 0) ? us : ULTRA_ECHO_TIMEOUT_US;
 }
 
 /*******************************************************************************
-* Ultra_ReadSensor() - Calculates the distance to the object infront of the sensor.
+* Ultra_GetCount() - Number of samples taken, the newest is count - 1.
 * No inputs.
-* Returns the distance in cm to the object infront of the sensor.
+* Returns the sample count.
+*******************************************************************************/
+uint32_t Ultra_GetCount(void) {
+    return ultraCount;
+}
+
+/*******************************************************************************
+* Ultra_GetSample() - Copy a sample out of the ring.
+* index     - Sample number, from 0 to Ultra_GetCount() - 1.
+* sample    - Sample to fill.
+* Returns 1 if it was copied, 0 if it hasn't been taken yet or was overwritten.
+*******************************************************************************/
+uint8_t Ultra_GetSample(uint32_t index, UltraSample *sample) {
+    if (ultraCount - index - 1 >= ULTRA_RING_SIZE) {
+        return 0;
+    }
+
+    *sample = ultraRing[index & ULTRA_RING_MASK];
+
+    // Overwritten if sample index + size was pushed while copying
+    return (ultraCount - index - 1 < ULTRA_RING_SIZE) ? 1 : 0;
+}
+
+/*******************************************************************************
+* Ultra_GetLatest() - Copy the newest sample.
+* sample    - Sample to fill.
+* Returns 1 if there is one, otherwise 0.
+*******************************************************************************/
+uint8_t Ultra_GetLatest(UltraSample *sample) {
+    uint32_t count = ultraCount;
+
+    return (count != 0) ? Ultra_GetSample(count - 1, sample) : 0;
+}
+
+/*******************************************************************************
+* Ultra_ReadSensor() - Filtered distance to the object infront of the sensor.
+* No inputs.
+* Returns the distance in cm, ULTRA_NO_RANGE if nothing is in range.
 *******************************************************************************/
 uint32_t Ultra_ReadSensor(void){
-    NVIC_DisableIRQ(TIM3_IRQn);
-    int distance = G_UltraEcho / 59; // distance in cm - Equation from ESS W7 slides (#6)
-    NVIC_EnableIRQ(TIM3_IRQn);
-    return(distance);
+    UltraSample sample;
+
+    return Ultra_GetLatest(&sample) ? sample.distance : ULTRA_NO_RANGE;
 }
 
+/*******************************************************************************
+* TIM1_UP_TIM16_IRQHandler() - Trigger started. Record a missed reading if the
+*                              last trigger never got an echo.
+* No inputs.
+* No return value.
+*******************************************************************************/
+void TIM1_UP_TIM16_IRQHandler(void) {
+    if (IS_BIT_SET(TIM16->SR, TIM_SR_UIF)) {
+        CLEAR_BITS(TIM16->SR, TIM_SR_UIF);
+
+        if (ultraPending) {
+            Ultra_Push(0, ULTRA_MISSED);
+        }
+        ultraPending = 1;
+        ultraTriggerUs = Timebase_Us();
+        ultraTriggerPan = G_StepperPosition;
+    }
+}
+
+/*******************************************************************************
+* TIM3_IRQHandler() - End of an echo pulse. Reading CCR1 clears its flag.
+* No inputs.
+* No return value.
+*******************************************************************************/
 void TIM3_IRQHandler(void) {
     if(IS_BIT_SET(TIM3->SR, TIM_SR_CC1IF)){
-        G_UltraEcho = TIM3->CCR1;
+        uint16_t echo = TIM3->CCR1;
+
+        // Stray pulse without a trigger
+        if (!ultraPending) {
+            return;
+        }
+        ultraPending = 0;
 
-        if (G_UltraEcho / 59 < MIN_DISTANCE) {
-            if ((G_DCMotorLeftDir == DCMOTOR_FWD) | (G_DCMotorRightDir == DCMOTOR_FWD)) {
-                G_DCMotorLeftDir = DCMOTOR_STOP;
-                G_DCMotorRightDir = DCMOTOR_STOP;
-            }
+        if (echo > ultraTimeoutUs) {
+            Ultra_Push(echo, ULTRA_NO_ECHO);
+            return;
         }
+        Ultra_Push(echo, ULTRA_OK);
     }
 }
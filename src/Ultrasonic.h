@@ -14,13 +14,35 @@
 #include "Utility.h"
 #include "DCMotor.h"
 
-#define MIN_DISTANCE 8
+#define ULTRA_PRIORITY          0
+#define ULTRA_MIN_CYCLE_MS      60          // Shortest time between triggers the sensor allows
+#define ULTRA_MAX_RATE_HZ       (1000 / ULTRA_MIN_CYCLE_MS)
+#define ULTRA_DEFAULT_RATE_HZ   10
+#define ULTRA_ECHO_TIMEOUT_US   25000UL     // Longer echoes are nothing in range (~4.3m)
+#define ULTRA_US_PER_CM         59          // Echo pulse width per cm, ESS W7 slides (#6)
+#define ULTRA_MEDIAN            3           // Readings in the median filter, odd
+#define ULTRA_RING_SIZE         16          // Must be a power of 2
+#define ULTRA_NO_RANGE          0xFFFF      // Distance when the median is nothing in range
 
-extern uint32_t G_UltraEcho;
+// Reading status
+#define ULTRA_OK                0
+#define ULTRA_NO_ECHO           1           // Echo longer than the timeout
+#define ULTRA_MISSED            2           // No echo before the next trigger
+
+typedef struct {
+    uint32_t time;              // Timebase_Us() at the reflection
+    uint16_t echo;              // Pulse width (us) of this reading, 0 if missed
+    uint16_t distance;          // Median filtered, cm
+    int16_t pan;                // Stepper position (half steps) at the reflection
+    uint8_t status;             // ULTRA_x of this reading
+} UltraSample;
 
 void Ultra_Init(void);
-void Ultra_StartTrigger(void);
-uint8_t Ultra_EchoRx(void);
+void Ultra_SetRate(uint16_t hz);
+void Ultra_SetEchoTimeout(uint32_t us);
+uint32_t Ultra_GetCount(void);
+uint8_t Ultra_GetSample(uint32_t index, UltraSample *sample);
+uint8_t Ultra_GetLatest(UltraSample *sample);
 uint32_t Ultra_ReadSensor(void);
 
 #endif
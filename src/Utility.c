@@ -6,30 +6,55 @@
 *******************************************************************************/
 
 #include "Utility.h"
+#include "Timebase.h"
 
 /*******************************************************************************
-*                               PUBLIC FUNCTIONS                                *
+*                               PRIVATE FUNCTIONS                               *
 *******************************************************************************/
 
 /*******************************************************************************
-* UART2_init() - Initialize UART2 setting.
-* No inputs.
+* Delay_Cycles() - Wait a number of time units on the cycle counter. Waits in
+*                  steps shorter than the counter wrap so any length works.
+* count     - Number of units to wait.
+* unit      - Cycles per unit.
 * No return value.
 *******************************************************************************/
-void Delay_ms(uint32_t msec){
-    // Stop SysTick
-    SysTick->CTRL = 0;
+static void Delay_Cycles(uint32_t count, uint32_t unit){
+    uint32_t step = 0x40000000UL / unit;    // Units per step, well inside the wrap
+    uint32_t end = Timebase_Cycles();
 
-    // Write appropriate RELOAD value to SysTick LOAD
-    SysTick->LOAD = ((SystemCoreClock / 8) / 1000UL) * msec;
+    while (count > 0) {
+        uint32_t units = (count < step) ? count : step;
 
-    // !! Check if loaded value exceeds max allowable value
+        end += units * unit;
+        count -= units;
 
-    // Reset SysTick and prepare for reload
-    SysTick->VAL = 0;
-    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+        while ((int32_t)(Timebase_Cycles() - end) < 0) SIM_YIELD();
+    }
+}
 
-    while(!(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk));
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                                *
+*******************************************************************************/
 
-    SysTick->CTRL = 0;
+/*******************************************************************************
+* Delay_us() - Busy-wait on the cycle counter. Interrupts keep running and no
+*              peripheral is touched, but the caller blocks, so keep it to
+*              short init-time waits and out of ISRs and tasks. To wait
+*              without blocking, poll Timebase_DeadlineUs() and
+*              Timebase_ExpiredUs() instead.
+* usec      - Time to wait in us.
+* No return value.
+*******************************************************************************/
+void Delay_us(uint32_t usec){
+    Delay_Cycles(usec, SystemCoreClock / 1000000UL);
+}
+
+/*******************************************************************************
+* Delay_ms() - Wait on the cycle counter, see Delay_us().
+* msec      - Time to wait in ms.
+* No return value.
+*******************************************************************************/
+void Delay_ms(uint32_t msec){
+    Delay_Cycles(msec, SystemCoreClock / 1000UL);
 }
@@ -62,10 +62,25 @@
 
 #define LEFT 0
 #define RIGHT 1
+
+// Critical Section Macros
+// Saves and restores PRIMASK so they nest and are safe to use from ISRs
+#define CRITICAL_ENTER()    uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define CRITICAL_EXIT()     __set_PRIMASK(primask)
+
+// Busy-wait hook for the host simulator (sim/), lets virtual time move on
+#ifdef SIM
+void Sim_Yield(void);
+#define SIM_YIELD()         Sim_Yield()
+#else
+#define SIM_YIELD()         ((void)0)
+#endif
+
 /*******************************************************************************
 *                               PUBLIC FUNCTIONS                               *
 *******************************************************************************/
 
+void Delay_us(uint32_t usec);
 void Delay_ms(uint32_t msec);
 
 #endif
@@ -14,189 +14,414 @@
 #include "KeyPad.h"
 #include "Ultrasonic.h"
 #include "DCMotor.h"
+#include "Power.h"
 #include "LCD.h"
 #include "Encoder.h"
+#include "Odometry.h"
+#include "Tune.h"
+#include "Profile.h"
+#include "Kinematics.h"
+#include "Collision.h"
+#include "Scan.h"
+#include "Map.h"
 #include "LimitSwitch.h"
 #include "PID.h"
+#include "Protocol.h"
+#include "Link.h"
+#include "Telemetry.h"
+#include "Log.h"
+#include "Timebase.h"
+#include "Scheduler.h"
 
-int main(void) {
-    // INITIALIZE
-    System_Clock_Init();
-    SystemCoreClockUpdate();
+/*******************************************************************************
+*                            CONSTANTS & DEFINES                               *
+*******************************************************************************/
+// Task periods (ms)
+#define COMMAND_TASK_MS     5
+#define DRIVE_TASK_MS       1       // Direction changes finish within a tick of the dead time
+#define CONTROL_TASK_MS     (1000 / PID_RATE_HZ)    // Speed estimates, wheel PID and odometry
+#define STEPPER_TASK_MS     5       // Scan turnarounds, TIM6 paces the steps
+#define SERVO_TASK_MS       5       // Servo sweep speed, one degree per run
+#define COMMS_TASK_MS       5
+#define MAP_TASK_MS         20      // A sensor cycle is 60ms at the fastest
 
-    USART3_Init();
-    Stepper_Init();
-    RCServo_Init();
-    LED_Init();
-    KeyPad_Init();
-    Ultra_Init();
-    DCMotor_Init();
-    LCD_Init();
-    Encoder_Init();
-    LimitSwitch_Init();
-    PID_Init();
+/*******************************************************************************
+*                               PRIVATE FUNCTIONS                              *
+*******************************************************************************/
+/*******************************************************************************
+* Main_SetWheel() - Set the direction and speed setpoint of one wheel.
+* dir       - Wheel direction to set.
+* setpoint  - Wheel speed setpoint to set.
+* speed     - Signed speed in cm/s, negative is backwards.
+* No return value.
+*******************************************************************************/
+static void Main_SetWheel(uint8_t *dir, int *setpoint, int16_t speed) {
+    if (speed > 0) {
+        *dir = DCMOTOR_FWD;
+    }
+    else if (speed < 0) {
+        *dir = DCMOTOR_BWD;
+        speed = -speed;
+    }
+    else {
+        *dir = DCMOTOR_STOP;
+    }
 
-    Stepper_Range();
-    RCServo_SetAngle(SERVO_HOME);
+    if (speed > DCMOTOR_SPEED_MAX) {
+        speed = DCMOTOR_SPEED_MAX;
+    }
 
-    // PROGRAM LOOP
-    while (1) {
-        Ultra_StartTrigger();
-        
-        switch (USART3_dequeue()) {
-            // Stop robot
-            case 'S': {
-                G_StepperStep = STEPPER_STOP;
-                G_DCMotorLeftDir = DCMOTOR_STOP;
-                G_DCMotorRightDir = DCMOTOR_STOP;
-                G_leftEncoderSetpoint = DCMOTOR_SPEED_BASE;
-                G_rightEncoderSetpoint = DCMOTOR_SPEED_BASE;
-                break;
-            }
+    // Keep the last setpoint when stopped so direction commands still move the robot
+    if (speed != 0) {
+        *setpoint = speed;
+    }
+}
 
-            // DC motors
-            case '0': {
-                G_DCMotorLeftDir = DCMOTOR_FWD;
-                G_DCMotorRightDir = DCMOTOR_FWD;
-                break;
-            }
-            case '1': {
-                G_DCMotorLeftDir = DCMOTOR_STOP;
-                G_DCMotorRightDir = DCMOTOR_FWD;
-                break;
-            }
-            case '2': {
-                G_DCMotorLeftDir = DCMOTOR_FWD;
-                G_DCMotorRightDir = DCMOTOR_STOP;
-                break;
-            }
-            case '3': {
-                G_DCMotorLeftDir = DCMOTOR_BWD;
-                G_DCMotorRightDir = DCMOTOR_FWD;
-                break;
-            }
-            case '4': {
-                G_DCMotorLeftDir = DCMOTOR_FWD;
-                G_DCMotorRightDir = DCMOTOR_BWD;
-                break;
-            }
-            case '5': {
-                G_DCMotorLeftDir = DCMOTOR_BWD;
-                G_DCMotorRightDir = DCMOTOR_BWD;
-                break;
-            }
-            case '6': {
-                G_DCMotorLeftDir = DCMOTOR_STOP;
-                G_DCMotorRightDir = DCMOTOR_BWD;
-                break;
-            }
-            case '7': {
-                G_DCMotorLeftDir = DCMOTOR_BWD;
-                G_DCMotorRightDir = DCMOTOR_STOP;
-                break;
-            }
-            case 'A':{
-                G_DCMotorLeftDir = DCMOTOR_STOP;
-                G_DCMotorRightDir = DCMOTOR_STOP;
-                G_leftEncoderSetpoint = DCMOTOR_SPEED_BASE;
-                G_rightEncoderSetpoint = DCMOTOR_SPEED_BASE;
-                break;
-            }
+/*******************************************************************************
+* Main_Drive() - Execute a drive message.
+* drive     - Drive message to execute.
+* No return value.
+*******************************************************************************/
+static void Main_Drive(const MsgDrive *drive) {
+    if (drive->flags & DRIVE_SET_WHEELS) {
+        Kinematics_Release();
+        Main_SetWheel(&G_DCMotorLeftDir, &G_leftEncoderSetpoint, drive->leftSpeed);
+        Main_SetWheel(&G_DCMotorRightDir, &G_rightEncoderSetpoint, drive->rightSpeed);
+    }
 
-            // Speed
-            case '8': {
-                G_leftEncoderSetpoint += DCMOTOR_SPEED_INC;
-                G_rightEncoderSetpoint += DCMOTOR_SPEED_INC;
+    if (drive->flags & DRIVE_SET_SERVO) {
+        G_RCServoModifier = SERVO_STOP;
+        G_RCServoAngle = drive->servoAngle;
+    }
 
-                if (G_leftEncoderSetpoint > DCMOTOR_SPEED_MAX) {
-                    G_leftEncoderSetpoint = DCMOTOR_SPEED_MAX;
-                }
-                
-                if (G_rightEncoderSetpoint > DCMOTOR_SPEED_MAX) {
-                    G_rightEncoderSetpoint = DCMOTOR_SPEED_MAX;
-                }
+    if (drive->flags & DRIVE_SET_STEPPER) {
+        Scan_Stop();
+        Stepper_MoveTo(drive->stepperTarget);
+    }
+}
 
-                break;
-            }
-            case '9': {
-                G_leftEncoderSetpoint -= DCMOTOR_SPEED_DEC;
-                G_rightEncoderSetpoint -= DCMOTOR_SPEED_DEC;
-                
-                if (G_leftEncoderSetpoint < DCMOTOR_SPEED_MIN) {
-                    G_leftEncoderSetpoint = DCMOTOR_SPEED_MIN;
-                }
-                
-                if (G_rightEncoderSetpoint < DCMOTOR_SPEED_MIN) {
-                    G_rightEncoderSetpoint = DCMOTOR_SPEED_MIN;
-                }
-
-                break;
-            }
+/*******************************************************************************
+* Main_Velocity() - Execute a velocity message.
+* velocity  - Velocity message to execute.
+* No return value.
+*******************************************************************************/
+static void Main_Velocity(const MsgVelocity *velocity) {
+    // mm/s to cm/s and mrad/s to rad/s
+    Kinematics_SetVelocity((q16_t)(((int32_t)velocity->linear * Q16_ONE) / 10),
+                           (q16_t)(((int32_t)velocity->angular * Q16_ONE) / 1000));
+}
 
-            // Servo
-            case 'B': {
-                G_RCServoAngle = SERVO_HOME;
-                Stepper_Range();
-                break;
-            }
-            case 'C': {
-                G_RCServoModifier = SERVO_INCREASE;
-                break;
-            }
-            case 'D': {
-                G_RCServoModifier = SERVO_DECREASE;
-                break;
-            }
+/*******************************************************************************
+* Main_Receive() - Execute received frames up to the next one character command.
+* frame     - Frame buffer.
+* Returns the one character command to execute, or '\0' if there is none.
+*******************************************************************************/
+static uint8_t Main_Receive(ProtocolFrame *frame) {
+    while (Protocol_Receive(frame)) {
+        if ((frame->type == MSG_COMMAND) && (frame->len == sizeof(MsgCommand))) {
+            return ((MsgCommand *)frame->payload)->cmd;
+        }
+        else if ((frame->type == MSG_DRIVE) && (frame->len == sizeof(MsgDrive))) {
+            Main_Drive((MsgDrive *)frame->payload);
+        }
+        else if ((frame->type == MSG_VELOCITY) && (frame->len == sizeof(MsgVelocity))) {
+            Main_Velocity((MsgVelocity *)frame->payload);
+        }
+        else if (!Link_Receive(frame) && !Scheduler_Receive(frame) && !Tune_Receive(frame)
+                 && !Scan_Receive(frame) && !Map_Receive(frame)) {
+            Telemetry_Receive(frame);
+        }
+    }
 
-            // Stepper
-            case 'E': {
-                if (LimitSwitch_PressCheck(RIGHT)) {
-                    G_StepperStep = STEPPER_CW_FULL_STEP;
-                }
+    return '\0';
+}
 
-                break;
-            }
-            case 'F': {
-                if (LimitSwitch_PressCheck(LEFT)) {
-                    G_StepperStep = STEPPER_CCW_FULL_STEP;
-                }
+/*******************************************************************************
+* Main_CommandTask() - Execute received frames and one character commands.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_CommandTask(void) {
+    ProtocolFrame frame;
+    uint8_t cmd = Main_Receive(&frame);
 
-                break;
+    // Wheel commands take the wheels back from the velocity commands
+    if (((cmd >= '0') && (cmd <= '9')) || (cmd == 'S') || (cmd == 'A')) {
+        Kinematics_Release();
+    }
+
+    switch (cmd) {
+        // Stop robot
+        case 'S': {
+            Scan_Stop();
+            Stepper_Stop();
+            G_DCMotorLeftDir = DCMOTOR_STOP;
+            G_DCMotorRightDir = DCMOTOR_STOP;
+            G_leftEncoderSetpoint = DCMOTOR_SPEED_BASE;
+            G_rightEncoderSetpoint = DCMOTOR_SPEED_BASE;
+            break;
+        }
+
+        // DC motors
+        case '0': {
+            G_DCMotorLeftDir = DCMOTOR_FWD;
+            G_DCMotorRightDir = DCMOTOR_FWD;
+            break;
+        }
+        case '1': {
+            G_DCMotorLeftDir = DCMOTOR_STOP;
+            G_DCMotorRightDir = DCMOTOR_FWD;
+            break;
+        }
+        case '2': {
+            G_DCMotorLeftDir = DCMOTOR_FWD;
+            G_DCMotorRightDir = DCMOTOR_STOP;
+            break;
+        }
+        case '3': {
+            G_DCMotorLeftDir = DCMOTOR_BWD;
+            G_DCMotorRightDir = DCMOTOR_FWD;
+            break;
+        }
+        case '4': {
+            G_DCMotorLeftDir = DCMOTOR_FWD;
+            G_DCMotorRightDir = DCMOTOR_BWD;
+            break;
+        }
+        case '5': {
+            G_DCMotorLeftDir = DCMOTOR_BWD;
+            G_DCMotorRightDir = DCMOTOR_BWD;
+            break;
+        }
+        case '6': {
+            G_DCMotorLeftDir = DCMOTOR_STOP;
+            G_DCMotorRightDir = DCMOTOR_BWD;
+            break;
+        }
+        case '7': {
+            G_DCMotorLeftDir = DCMOTOR_BWD;
+            G_DCMotorRightDir = DCMOTOR_STOP;
+            break;
+        }
+        case 'A':{
+            G_DCMotorLeftDir = DCMOTOR_STOP;
+            G_DCMotorRightDir = DCMOTOR_STOP;
+            G_leftEncoderSetpoint = DCMOTOR_SPEED_BASE;
+            G_rightEncoderSetpoint = DCMOTOR_SPEED_BASE;
+            break;
+        }
+
+        // Speed
+        case '8': {
+            G_leftEncoderSetpoint += DCMOTOR_SPEED_INC;
+            G_rightEncoderSetpoint += DCMOTOR_SPEED_INC;
+
+            if (G_leftEncoderSetpoint > DCMOTOR_SPEED_MAX) {
+                G_leftEncoderSetpoint = DCMOTOR_SPEED_MAX;
             }
-            case 'G': {
-                G_RCServoModifier = SERVO_STOP;
-                break;
+            
+            if (G_rightEncoderSetpoint > DCMOTOR_SPEED_MAX) {
+                G_rightEncoderSetpoint = DCMOTOR_SPEED_MAX;
             }
-            case 'H': {
-                G_StepperStep = STEPPER_STOP;
-                break;
+
+            break;
+        }
+        case '9': {
+            G_leftEncoderSetpoint -= DCMOTOR_SPEED_DEC;
+            G_rightEncoderSetpoint -= DCMOTOR_SPEED_DEC;
+            
+            if (G_leftEncoderSetpoint < DCMOTOR_SPEED_MIN) {
+                G_leftEncoderSetpoint = DCMOTOR_SPEED_MIN;
+            }
+            
+            if (G_rightEncoderSetpoint < DCMOTOR_SPEED_MIN) {
+                G_rightEncoderSetpoint = DCMOTOR_SPEED_MIN;
             }
 
+            break;
+        }
 
-            // Ultrasonic
-            case 'I': {
-                USART3_printf("\nUltrasonic: %dcm", Ultra_ReadSensor());
-                break;
+        // Servo
+        case 'B': {
+            // The stepper task carries the ranging on
+            G_RCServoAngle = SERVO_HOME;
+            Scan_Stop();
+            Stepper_Range();
+            break;
+        }
+        case 'C': {
+            G_RCServoModifier = SERVO_INCREASE;
+            break;
+        }
+        case 'D': {
+            G_RCServoModifier = SERVO_DECREASE;
+            break;
+        }
+
+        // Stepper
+        case 'E': {
+            Scan_Stop();
+            if (LimitSwitch_PressCheck(RIGHT)) {
+                Stepper_SetVelocity(STEPPER_MAX_RATE);
             }
-    
-            // Invalid command
-            default: {
-                break;
+
+            break;
+        }
+        case 'F': {
+            Scan_Stop();
+            if (LimitSwitch_PressCheck(LEFT)) {
+                Stepper_SetVelocity(-STEPPER_MAX_RATE);
             }
+
+            break;
+        }
+        case 'G': {
+            G_RCServoModifier = SERVO_STOP;
+            break;
+        }
+        case 'H': {
+            Scan_Stop();
+            Stepper_Stop();
+            break;
         }
 
-        G_RCServoAngle += G_RCServoModifier;
-        if (G_RCServoAngle < SERVO_MIN) {
-            G_RCServoAngle = SERVO_MIN;
+
+        // Ultrasonic
+        case 'I': {
+            MsgRange range = {(uint16_t)Ultra_ReadSensor()};
+            Protocol_Send(MSG_RANGE, &range, sizeof(range));
+            break;
         }
-        else if (G_RCServoAngle > SERVO_MAX) {
-            G_RCServoAngle = SERVO_MAX;
+
+        // Invalid command
+        default: {
+            break;
         }
+    }
+}
 
-        DCMotor_SetDirs(G_DCMotorLeftDir, G_DCMotorRightDir);
-        Stepper_Step(G_StepperStep);
-        RCServo_SetAngle(G_RCServoAngle);
-        Delay_ms(5);
+/*******************************************************************************
+* Main_DriveTask() - Apply the profiled wheel directions.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_DriveTask(void) {
+    DCMotor_SetDirs(Profile_GetDir(LEFT), Profile_GetDir(RIGHT));
+    DCMotor_Update();
+}
+
+/*******************************************************************************
+* Main_ControlTask() - Estimate the wheel speeds, compensate for the battery
+*                      and cut off stalled motors, time out velocity
+*                      commands, limit the speed for obstacles ahead, profile
+*                      the setpoints, run the wheel controllers (or the
+*                      auto-tune in their place) and estimate the pose.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_ControlTask(void) {
+    Encoder_Update();
+    Power_Update();
+    Kinematics_Update();
+    Collision_Update();
+    Profile_Update();
+    if (!Tune_Update()) {
+        PID_Control();
     }
+    Odometry_Update();
+}
+
+/*******************************************************************************
+* Main_StepperTask() - Run the ranging and the scan's sweep, the steps
+*                      themselves are taken by the TIM6 ISR.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_StepperTask(void) {
+    Stepper_Update();
+    Scan_Update();
 }
 
+/*******************************************************************************
+* Main_ServoTask() - Sweep the servo and apply its angle.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_ServoTask(void) {
+    G_RCServoAngle += G_RCServoModifier;
+    if (G_RCServoAngle < SERVO_MIN) {
+        G_RCServoAngle = SERVO_MIN;
+    }
+    else if (G_RCServoAngle > SERVO_MAX) {
+        G_RCServoAngle = SERVO_MAX;
+    }
+
+    RCServo_SetAngle(G_RCServoAngle);
+}
+
+/*******************************************************************************
+* Main_CommsTask() - Run the link, telemetry, log and task report updates.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_CommsTask(void) {
+    Link_Update();
+    Telemetry_Update();
+    Log_Update();
+    Scheduler_Update();
+}
+
+/*******************************************************************************
+* Main_MapTask() - Add the new ultrasonic samples to the occupancy grid.
+* No inputs.
+* No return value.
+*******************************************************************************/
+static void Main_MapTask(void) {
+    Map_Update();
+}
+
+/*******************************************************************************
+*                               PUBLIC FUNCTIONS                               *
+*******************************************************************************/
+int main(void) {
+    // INITIALIZE
+    System_Clock_Init();
+    SystemCoreClockUpdate();
+    Timebase_Init();
+
+    USART3_Init();
+    Protocol_Init();
+    Telemetry_Init();
+    Stepper_Init();
+    RCServo_Init();
+    LED_Init();
+    KeyPad_Init();
+    Ultra_Init();
+    DCMotor_Init();
+    Power_Init();
+    LCD_Init();
+    Encoder_Init();
+    Odometry_Init();
+    LimitSwitch_Init();
+    PID_Init();
+    Profile_Init();
+    Collision_Init();
+    Map_Init();
+
+    Stepper_Range();
+    RCServo_SetAngle(SERVO_HOME);
+
+    // TASKS
+    // Offsets spread the 5ms tasks over different ticks, a deadline of 0 is the period
+    //                name          function            period (ms)         offset  deadline    priority
+    Scheduler_AddTask("command",    Main_CommandTask,   COMMAND_TASK_MS,    0,      0,          2);
+    Scheduler_AddTask("drive",      Main_DriveTask,     DRIVE_TASK_MS,      0,      0,          0);
+    Scheduler_AddTask("control",    Main_ControlTask,   CONTROL_TASK_MS,    1,      0,          1);
+    Scheduler_AddTask("stepper",    Main_StepperTask,   STEPPER_TASK_MS,    2,      0,          3);
+    Scheduler_AddTask("servo",      Main_ServoTask,     SERVO_TASK_MS,      3,      0,          4);
+    Scheduler_AddTask("comms",      Main_CommsTask,     COMMS_TASK_MS,      4,      0,          5);
+    Scheduler_AddTask("map",        Main_MapTask,       MAP_TASK_MS,        2,      0,          6);
+
+    // PROGRAM LOOP
+    Scheduler_Run();
+}
@@ -3,8 +3,11 @@
 * Author(s): Noah Grant & Wyatt Richard
 * Date: October 30, 2023
 * Description: joystick/gamepad events and displays them.
-* Run: ./client 127.0.0.1 5000 /dev/input/jsX
+* Run: ./client 127.0.0.1 5000 [/dev/input/jsX] [-v]
 * 127.0.0.1 ip address is used to refer to the current computer
+* -v drives with continuous linear and angular velocities from the left stick
+* (forward/back and turn) instead of the eight fixed directions. They are
+* repeated while the stick is held since the robot stops without them.
 *******************************************************************************/
 
 #include <stdio.h>
@@ -18,6 +21,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
+#include <time.h>
 
 // for Joystick:
 #include <fcntl.h>
@@ -25,8 +30,64 @@
 #include <math.h>
 #include "joystick.h"
 
+#define STICK_MAX           32767
+#define STICK_DEADZONE      3000
+#define MOVE_MAX_LINEAR     40.0    // cm/s, the robot's top wheel speed
+#define MOVE_MAX_ANGULAR    4.0     // rad/s
+#define MOVE_MIN_MS         50      // Fastest rate a moving stick is sent at
+#define MOVE_REPEAT_MS      100     // Keeps the robot moving, it stops after 500ms
+
 char buffer[BUFSIZ];
 
+struct move_state {
+    double linear, angular;         // cm/s, rad/s counter-clockwise
+    int changed;
+    long lastMs;                    // When it was last sent
+};
+
+long now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+double stick_scale(short value) {
+    if (value > -STICK_DEADZONE && value < STICK_DEADZONE) {
+        return 0.0;
+    }
+    return (double)value / STICK_MAX;
+}
+
+// Left stick up is forwards, right turns clockwise
+void stick_velocity(const struct axis_state *stick, struct move_state *move) {
+    double linear = -stick_scale(stick->y) * MOVE_MAX_LINEAR;
+    double angular = -stick_scale(stick->x) * MOVE_MAX_ANGULAR;
+
+    if (linear != move->linear || angular != move->angular) {
+        move->linear = linear;
+        move->angular = angular;
+        move->changed = 1;
+    }
+}
+
+// Send the velocity when it changes (rate limited, stopping is sent straight
+// away) and repeat it while moving
+void send_move(int client_socket, struct move_state *move) {
+    long now = now_ms();
+    int moving = (move->linear != 0.0 || move->angular != 0.0);
+
+    if (move->changed ? (moving && now - move->lastMs < MOVE_MIN_MS)
+                      : (!moving || now - move->lastMs < MOVE_REPEAT_MS)) {
+        return;
+    }
+
+    snprintf(buffer, sizeof(buffer), "move %.1f %.2f", move->linear, move->angular);
+    write(client_socket, buffer, strlen(buffer));
+    move->changed = 0;
+    move->lastMs = now;
+}
+
 int main (int argc, char *argv[]) {
     int client_socket;
     struct sockaddr_in server_addr;
@@ -36,23 +97,30 @@ int main (int argc, char *argv[]) {
     const char *device; // path to controller file
     int js;
     int angle;
-    int prevAxisState[2] = {0};
+    int prevAxisState[3] = {0};
     struct js_event event;
     struct axis_state axes[3] = {0};
     size_t axis;
+    int velocityMode = 0;
+    struct move_state move = {0};
+    struct pollfd pfd;
+    int i, ready;
 
     // ensure port and IP were entered
     if (argc < 3) {
-        printf ("usage: ./client IP_ADDRESS PORT_NUMBER\n");
+        printf ("usage: ./client IP_ADDRESS PORT_NUMBER [DEVICE] [-v]\n");
         return 1;
     }
 
-    // check if controller file was specified
-    if (argc > 3){
-        device = argv[1];
-    }
-    else{
-        device = "/dev/input/js2";
+    // check if controller file or velocity mode was specified
+    device = "/dev/input/js2";
+    for (i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            velocityMode = 1;
+        }
+        else {
+            device = argv[i];
+        }
     }
 
     // Open Joystick
@@ -96,11 +164,30 @@ int main (int argc, char *argv[]) {
      * now that we have a connection, get a commandline from
      * the user, and fire it off to the server
      */
-    while (read_event(js, &event) == 0) {
+    pfd.fd = js;
+    pfd.events = POLLIN;
+    while (1) {
+        if (velocityMode) {
+            send_move(client_socket, &move);
+            ready = poll(&pfd, 1, MOVE_MIN_MS);
+            if (ready < 0) {
+                break;
+            }
+            else if (ready == 0) {
+                continue;
+            }
+        }
+        if (read_event(js, &event) != 0) {
+            break;
+        }
+
         if(event.type==JS_EVENT_AXIS){
             axis = get_axis_state(&event, axes);
 
-            if(axis == 0) { // left Joystick
+            if(axis == 0 && velocityMode) { // left Joystick, continuous
+                stick_velocity(&axes[axis], &move);
+            }
+            else if(axis == 0) { // left Joystick
                 if(axes[axis].x == 0 && axes[axis].y == 0){
                     printf("Stop moving\n"); // max value of 32767
                     strcpy(buffer, "A");
@@ -0,0 +1,155 @@
+/*******************************************************************************
+* Name: link.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link baud rate negotiation for the server. Must match
+*              src/Link.c, see src/Messages.h for the handshake.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "link.h"
+#include "serial.h"
+
+#define ACK_TIMEOUT_MS      500
+#define RESULT_TIMEOUT_MS   1500        // Robot gives up on the burst after ~1s
+#define STATUS_TIMEOUT_MS   1000
+#define REVERT_WAIT_US      1500000     // Robot falls back within ~1s of a failed test
+#define SWITCH_WAIT_US      20000       // Robot switches a few main loop passes after the ack
+#define TEST_GAP_US         2000        // Pace the burst so the robot keeps up at 1Mbaud
+
+// Fastest first
+static const unsigned long rates[] = {1000000, 921600, 460800, 230400, 115200};
+
+static long elapsedMs(const struct timeval *start) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_usec - start->tv_usec) / 1000;
+}
+
+static void sendFrame(int serial_port, uint8_t type, const void *payload, size_t len) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    size_t n = Protocol_Encode(type, payload, len, frame);
+    Serial_Send(serial_port, frame, n);
+}
+
+// Wait for a frame of the given type, other frames are dropped.
+// Returns 1 if the frame arrived before the timeout, otherwise 0.
+int Link_WaitFrame(int serial_port, ProtocolDecoder *decoder, uint8_t type, int timeoutMs, ProtocolFrame *frame) {
+    struct timeval start, timeout;
+    uint8_t rx[256];
+    fd_set fds;
+    long left;
+    ssize_t n;
+
+    gettimeofday(&start, NULL);
+
+    while ((left = timeoutMs - elapsedMs(&start)) > 0) {
+        FD_ZERO(&fds);
+        FD_SET(serial_port, &fds);
+        timeout.tv_sec = left / 1000;
+        timeout.tv_usec = (left % 1000) * 1000;
+
+        if (select(serial_port + 1, &fds, NULL, NULL, &timeout) <= 0) {
+            continue;
+        }
+
+        n = read(serial_port, rx, sizeof(rx));
+        for (ssize_t i = 0; i < n; i++) {
+            if (Protocol_Feed(decoder, rx[i], frame) && frame->type == type) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Try one baud rate. Returns 1 if both ends are now running at it.
+static int tryRate(int serial_port, unsigned long baud) {
+    ProtocolDecoder decoder;
+    ProtocolFrame frame;
+    MsgBaud propose;
+    MsgBaudTest test;
+    const MsgBaudResult *result;
+    unsigned long hostErrors;
+
+    Protocol_DecoderInit(&decoder);
+
+    propose.baud = baud;
+    sendFrame(serial_port, MSG_BAUD_PROPOSE, &propose, sizeof(propose));
+    if (!Link_WaitFrame(serial_port, &decoder, MSG_BAUD_ACK, ACK_TIMEOUT_MS, &frame)) {
+        printf("[Link] No ack for %lu baud...\n", baud);
+        return 0;
+    }
+    if (((const MsgBaud *)frame.payload)->baud != baud) {
+        printf("[Link] Robot rejected %lu baud...\n", baud);
+        return 0;
+    }
+
+    // Switch and send the verification burst
+    tcdrain(serial_port);
+    if (Serial_SetBaud(serial_port, baud) != 0) {
+        return 0;
+    }
+    usleep(SWITCH_WAIT_US);
+    tcflush(serial_port, TCIFLUSH);
+    Protocol_DecoderInit(&decoder);
+
+    for (uint16_t seq = 0; seq < LINK_TEST_FRAMES; seq++) {
+        test.seq = seq;
+        for (int i = 0; i < LINK_TEST_LEN; i++) {
+            test.pattern[i] = LINK_TEST_BYTE(seq, i);
+        }
+        sendFrame(serial_port, MSG_BAUD_TEST, &test, sizeof(test));
+        usleep(TEST_GAP_US);
+    }
+
+    if (Link_WaitFrame(serial_port, &decoder, MSG_BAUD_RESULT, RESULT_TIMEOUT_MS, &frame)) {
+        result = (const MsgBaudResult *)frame.payload;
+        hostErrors = decoder.crcErrors + decoder.framingErrors;
+        printf("[Link] %lu baud: %u/%d good, %u robot errors, %lu host errors\n",
+               baud, result->good, LINK_TEST_FRAMES, result->errors, hostErrors);
+
+        if (result->pass && hostErrors <= LINK_TEST_MAX_ERRORS) {
+            sendFrame(serial_port, MSG_BAUD_COMMIT, NULL, 0);
+            if (Link_WaitFrame(serial_port, &decoder, MSG_LINK_STATUS, STATUS_TIMEOUT_MS, &frame)) {
+                Link_PrintStatus((const MsgLinkStatus *)frame.payload);
+                return 1;
+            }
+        }
+    }
+    else {
+        printf("[Link] No result at %lu baud...\n", baud);
+    }
+
+    // Fall back and give the robot time to do the same
+    Serial_SetBaud(serial_port, LINK_DEFAULT_BAUD);
+    usleep(REVERT_WAIT_US);
+    tcflush(serial_port, TCIFLUSH);
+    return 0;
+}
+
+// Negotiate the fastest reliable baud rate, both ends must be at the default.
+// Returns the baud rate in use.
+unsigned long Link_Negotiate(int serial_port) {
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (tryRate(serial_port, rates[i])) {
+            return rates[i];
+        }
+    }
+
+    return LINK_DEFAULT_BAUD;
+}
+
+void Link_PrintStatus(const MsgLinkStatus *status) {
+    printf("[Link] Robot at %u baud: %u frames, %u crc errors, %u framing errors, %u bytes dropped\n",
+           status->baud, status->rxFrames, status->rxCrcErrors, status->rxFramingErrors, status->txDropped);
+    printf("[Link] Robot UART errors: %u overrun, %u framing, %u noise, %u overflow\n",
+           status->uartOverrun, status->uartFraming, status->uartNoise, status->uartOverflow);
+}
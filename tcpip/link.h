@@ -0,0 +1,17 @@
+/*******************************************************************************
+* Name: link.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link baud rate negotiation for the server.
+*******************************************************************************/
+
+#ifndef LINK_H
+#define LINK_H
+
+#include "protocol.h"
+
+int Link_WaitFrame(int serial_port, ProtocolDecoder *decoder, uint8_t type, int timeoutMs, ProtocolFrame *frame);
+unsigned long Link_Negotiate(int serial_port);
+void Link_PrintStatus(const MsgLinkStatus *status);
+
+#endif
@@ -0,0 +1,189 @@
+/*******************************************************************************
+* Name: log.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot tokenized log decoder for the server. Must match
+*              src/Log.c. The format strings come from the logstr section of
+*              the firmware ELF, which the firmware Makefile extracts to
+*              bin/log_strings.bin.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+#define LOG_LINE_SIZE   256
+#define LOG_Q_BITS      16      // Must match FORMAT_Q_BITS in src/Format.h
+#define LOG_Q_DECIMALS  3       // Must match FORMAT_Q_DECIMALS in src/Format.h
+
+// Format one entry the same way src/Format.c would have on the robot
+static void formatEntry(const char *fmt, const uint32_t *args, uint8_t nargs, char *out, size_t size) {
+    size_t len = 0;
+    uint8_t arg = 0;
+
+    while ((*fmt != '\0') && (len + 1 < size)) {
+        char spec[16];
+        size_t specLen = 0;
+        int precision = -1;
+        uint32_t value;
+
+        if (*fmt != '%') {
+            out[len++] = *fmt++;
+            continue;
+        }
+
+        // Copy the flags, width and precision, dropping any length modifier
+        spec[specLen++] = *fmt++;
+        while ((*fmt != '\0') && (strchr("-0123456789.", *fmt) != NULL) && (specLen < sizeof(spec) - 5)) {
+            if (*fmt == '.') {
+                precision = atoi(fmt + 1);
+            }
+            spec[specLen++] = *fmt++;
+        }
+        if (*fmt == 'l') {
+            fmt++;
+        }
+
+        if (*fmt == '%') {
+            out[len++] = '%';
+            fmt++;
+            continue;
+        }
+        if (*fmt == '\0') {
+            break;
+        }
+
+        value = (arg < nargs) ? args[arg] : 0;
+        arg++;
+
+        switch (*fmt) {
+            case 'q': {
+                int bits = 0;
+
+                // Optional number of fractional bits
+                if ((fmt[1] >= '0') && (fmt[1] <= '9')) {
+                    while ((fmt[1] >= '0') && (fmt[1] <= '9')) {
+                        bits = bits * 10 + (*++fmt - '0');
+                    }
+                }
+                else {
+                    bits = LOG_Q_BITS;
+                }
+
+                if (precision < 0) {
+                    specLen += snprintf(&spec[specLen], sizeof(spec) - specLen, ".%d", LOG_Q_DECIMALS);
+                }
+                spec[specLen++] = 'f';
+                spec[specLen] = '\0';
+                len += snprintf(&out[len], size - len, spec, (int32_t)value / (double)(1ULL << bits));
+                break;
+            }
+            case 'd':
+            case 'i':
+            case 'c':
+                spec[specLen++] = *fmt;
+                spec[specLen] = '\0';
+                len += snprintf(&out[len], size - len, spec, (int32_t)value);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                spec[specLen++] = *fmt;
+                spec[specLen] = '\0';
+                len += snprintf(&out[len], size - len, spec, value);
+                break;
+            default:
+                // Strings can't be logged, show the raw value
+                len += snprintf(&out[len], size - len, "<%%%c 0x%08X>", *fmt, value);
+                break;
+        }
+        fmt++;
+
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+
+    out[len] = '\0';
+}
+
+// Load the format string table. Returns 0 if it could not be read, the
+// decoder then prints the raw log IDs.
+int Log_DecoderInit(LogDecoder *decoder, const char *tablePath) {
+    FILE *file;
+    long size;
+
+    memset(decoder, 0, sizeof(*decoder));
+
+    file = fopen(tablePath, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    decoder->strings = malloc(size + 1);
+    if ((decoder->strings == NULL) || (fread(decoder->strings, 1, size, file) != (size_t)size)) {
+        free(decoder->strings);
+        decoder->strings = NULL;
+        fclose(file);
+        return 0;
+    }
+    decoder->strings[size] = '\0';      // In case the last string is cut off
+    decoder->size = size;
+
+    fclose(file);
+    return 1;
+}
+
+void Log_DecoderFree(LogDecoder *decoder) {
+    free(decoder->strings);
+    decoder->strings = NULL;
+}
+
+void Log_PrintFrame(LogDecoder *decoder, const ProtocolFrame *frame) {
+    MsgLogHeader header;
+    MsgLogEntry entry;
+    uint32_t args[LOG_MAX_ARGS];
+    char line[LOG_LINE_SIZE];
+    size_t offset = sizeof(header);
+
+    if (frame->len < sizeof(header)) {
+        return;
+    }
+
+    memcpy(&header, frame->payload, sizeof(header));
+    if (header.dropped != 0) {
+        decoder->dropped += header.dropped;
+        printf("[Log] %u entries dropped by the robot\n", header.dropped);
+    }
+
+    while (offset + sizeof(entry) <= frame->len) {
+        memcpy(&entry, &frame->payload[offset], sizeof(entry));
+        offset += sizeof(entry);
+
+        if ((entry.nargs > LOG_MAX_ARGS) || (offset + entry.nargs * 4 > frame->len)) {
+            printf("[Log] Bad entry...\n");
+            return;
+        }
+        memcpy(args, &frame->payload[offset], entry.nargs * 4);
+        offset += entry.nargs * 4;
+
+        decoder->cycles += (uint32_t)(entry.time - decoder->lastCycles);
+        decoder->lastCycles = entry.time;
+        decoder->entries++;
+
+        if ((decoder->strings != NULL) && (entry.id < decoder->size)) {
+            formatEntry(&decoder->strings[entry.id], args, entry.nargs, line, sizeof(line));
+        }
+        else {
+            snprintf(line, sizeof(line), "<id %u, %u args>", entry.id, entry.nargs);
+        }
+
+        printf("[Log] %10.6f %s\n", (double)decoder->cycles / LOG_CLOCK_HZ, line);
+    }
+}
@@ -0,0 +1,28 @@
+/*******************************************************************************
+* Name: log.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot tokenized log decoder for the server.
+*******************************************************************************/
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "protocol.h"
+
+#define LOG_DEFAULT_TABLE   "../bin/log_strings.bin"
+
+typedef struct {
+    char *strings;              // Contents of the logstr section, NULL if not loaded
+    size_t size;
+    uint32_t lastCycles;        // Unwraps the robot cycle counter
+    uint64_t cycles;
+    unsigned long entries;
+    unsigned long dropped;
+} LogDecoder;
+
+int Log_DecoderInit(LogDecoder *decoder, const char *tablePath);
+void Log_DecoderFree(LogDecoder *decoder);
+void Log_PrintFrame(LogDecoder *decoder, const ProtocolFrame *frame);
+
+#endif
@@ -0,0 +1,106 @@
+/*******************************************************************************
+* Name: map.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot occupancy grid download for the server. Must match
+*              src/Map.c, see src/Messages.h for the frame layout. Tiles are
+*              kept by where they are in the odometry frame, so the map
+*              outlasts the robot's own grid as it moves on.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "map.h"
+
+// Log-odds of a cell, 0 is unknown
+static int cellValue(const MapTile *tile, int x, int y) {
+    int index = y * MAP_TILE_CELLS + x;
+    int nibble = (tile->cells[index / 2] >> ((index & 1) ? 4 : 0)) & 0x0F;
+
+    return (nibble & 0x08) ? (nibble - 16) : nibble;
+}
+
+static const MapTile *findTile(const MapDecoder *decoder, int tileX, int tileY) {
+    for (unsigned long i = 0; i < decoder->count; i++) {
+        if ((decoder->tiles[i].tileX == tileX) && (decoder->tiles[i].tileY == tileY)) {
+            return &decoder->tiles[i];
+        }
+    }
+    return NULL;
+}
+
+void Map_DecoderInit(MapDecoder *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+// Keep a MSG_MAP_TILE.
+// Returns 1 if it was the last tile of a query.
+int Map_Decode(MapDecoder *decoder, const ProtocolFrame *frame) {
+    const MsgMapTile *msg = (const MsgMapTile *)frame->payload;
+    MapTile *tile = (MapTile *)findTile(decoder, msg->tileX, msg->tileY);
+
+    if ((frame->type != MSG_MAP_TILE) || (frame->len != sizeof(MsgMapTile))) {
+        return 0;
+    }
+
+    if (tile == NULL) {
+        if (decoder->count == MAP_HOST_TILES) {
+            printf("[Map] Tile (%d, %d) dropped, %d tiles kept already\n", msg->tileX, msg->tileY, MAP_HOST_TILES);
+            return msg->remaining == 0;
+        }
+        tile = &decoder->tiles[decoder->count++];
+        tile->tileX = msg->tileX;
+        tile->tileY = msg->tileY;
+    }
+    memcpy(tile->cells, msg->cells, sizeof(tile->cells));
+    decoder->received++;
+
+    return msg->remaining == 0;
+}
+
+// Print the map with +y up, '#' occupied, '.' free, ' ' unknown
+void Map_Print(MapDecoder *decoder) {
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    const MapTile *tile;
+    int value;
+
+    if (decoder->count == 0) {
+        printf("[Map] Empty\n");
+        return;
+    }
+
+    minX = maxX = decoder->tiles[0].tileX;
+    minY = maxY = decoder->tiles[0].tileY;
+    for (unsigned long i = 1; i < decoder->count; i++) {
+        minX = (decoder->tiles[i].tileX < minX) ? decoder->tiles[i].tileX : minX;
+        maxX = (decoder->tiles[i].tileX > maxX) ? decoder->tiles[i].tileX : maxX;
+        minY = (decoder->tiles[i].tileY < minY) ? decoder->tiles[i].tileY : minY;
+        maxY = (decoder->tiles[i].tileY > maxY) ? decoder->tiles[i].tileY : maxY;
+    }
+
+    printf("[Map] %lu tiles updated, %lu kept, x %.2f to %.2f m, y %.2f to %.2f m, origin 'o'\n",
+           decoder->received, decoder->count,
+           minX * MAP_TILE_CELLS * MAP_CELL_MM / 1000.0, (maxX + 1) * MAP_TILE_CELLS * MAP_CELL_MM / 1000.0,
+           minY * MAP_TILE_CELLS * MAP_CELL_MM / 1000.0, (maxY + 1) * MAP_TILE_CELLS * MAP_CELL_MM / 1000.0);
+    decoder->received = 0;
+
+    for (int y = (maxY + 1) * MAP_TILE_CELLS - 1; y >= minY * MAP_TILE_CELLS; y--) {
+        printf("[Map] ");
+        for (int x = minX * MAP_TILE_CELLS; x < (maxX + 1) * MAP_TILE_CELLS; x++) {
+            // Floored tile and cell in the tile
+            int tileX = (x >= 0) ? (x / MAP_TILE_CELLS) : -((MAP_TILE_CELLS - 1 - x) / MAP_TILE_CELLS);
+            int tileY = (y >= 0) ? (y / MAP_TILE_CELLS) : -((MAP_TILE_CELLS - 1 - y) / MAP_TILE_CELLS);
+
+            tile = findTile(decoder, tileX, tileY);
+            value = (tile != NULL) ? cellValue(tile, x - tileX * MAP_TILE_CELLS, y - tileY * MAP_TILE_CELLS) : 0;
+            if ((x == 0) && (y == 0)) {
+                putchar('o');
+            }
+            else {
+                putchar((value > 0) ? '#' : ((value < 0) ? '.' : ' '));
+            }
+        }
+        putchar('\n');
+    }
+}
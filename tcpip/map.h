@@ -0,0 +1,31 @@
+/*******************************************************************************
+* Name: map.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot occupancy grid download for the server.
+*******************************************************************************/
+
+#ifndef MAP_H
+#define MAP_H
+
+#include "protocol.h"
+
+#define MAP_HOST_TILES  1024        // Tiles kept, the robot's grid is 256
+
+typedef struct {
+    int16_t tileX;
+    int16_t tileY;
+    uint8_t cells[MAP_TILE_CELLS * MAP_TILE_CELLS / 2];
+} MapTile;
+
+typedef struct {
+    MapTile tiles[MAP_HOST_TILES];
+    unsigned long count;        // Tiles kept
+    unsigned long received;     // Tiles received since the last printout
+} MapDecoder;
+
+void Map_DecoderInit(MapDecoder *decoder);
+int Map_Decode(MapDecoder *decoder, const ProtocolFrame *frame);
+void Map_Print(MapDecoder *decoder);
+
+#endif
@@ -0,0 +1,154 @@
+/*******************************************************************************
+* Name: protocol.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link framing (COBS + CRC-16) for the server. Must match
+*              src/Protocol.c, see src/Messages.h for the frame format.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "protocol.h"
+
+// COBS encode src into dst (no delimiter), returns the encoded length
+static size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t read = 0;
+    size_t write = 1;
+    size_t codeIndex = 0;
+    uint8_t code = 1;
+
+    while (read < len) {
+        if (src[read] == 0) {
+            dst[codeIndex] = code;
+            code = 1;
+            codeIndex = write++;
+            read++;
+        }
+        else {
+            dst[write++] = src[read++];
+            code++;
+
+            if (code == 0xFF) {
+                dst[codeIndex] = code;
+                code = 1;
+                codeIndex = write++;
+            }
+        }
+    }
+    dst[codeIndex] = code;
+
+    return write;
+}
+
+// COBS decode src (no delimiter) into dst, returns the decoded length or -1
+static long cobs_decode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t read = 0;
+    size_t write = 0;
+
+    while (read < len) {
+        uint8_t code = src[read++];
+
+        if (code == 0 || read + code - 1 > len) {
+            return -1;
+        }
+
+        for (uint8_t i = 1; i < code; i++) {
+            dst[write++] = src[read++];
+        }
+
+        if (code != 0xFF && read < len) {
+            dst[write++] = 0;
+        }
+    }
+
+    return (long)write;
+}
+
+// CRC-16/CCITT-FALSE, same result as the robot's CRC calculation unit
+uint16_t Protocol_CRC16(const uint8_t *data, size_t len) {
+    uint16_t crc = PROTOCOL_CRC_INIT;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            if (crc & 0x8000) {
+                crc = (crc << 1) ^ PROTOCOL_CRC_POLY;
+            }
+            else {
+                crc <<= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+// Frame a message into out (at least PROTOCOL_MAX_ENCODED bytes), returns the
+// number of bytes to send or 0 if the payload is too long
+size_t Protocol_Encode(uint8_t type, const void *payload, size_t len, uint8_t *out) {
+    uint8_t raw[PROTOCOL_MAX_RAW];
+    uint16_t crc;
+    size_t n;
+
+    if (len > PROTOCOL_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    raw[0] = type;
+    memcpy(&raw[1], payload, len);
+    crc = Protocol_CRC16(raw, len + 1);
+    raw[len + 1] = crc & 0xFF;
+    raw[len + 2] = crc >> 8;
+
+    n = cobs_encode(raw, len + 3, out);
+    out[n++] = PROTOCOL_DELIMITER;
+
+    return n;
+}
+
+void Protocol_DecoderInit(ProtocolDecoder *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+// Feed one received byte, returns 1 when a valid frame has been decoded
+int Protocol_Feed(ProtocolDecoder *decoder, uint8_t c, ProtocolFrame *frame) {
+    uint8_t raw[PROTOCOL_MAX_ENCODED];
+    long rawLen;
+    uint16_t crc;
+
+    if (c != PROTOCOL_DELIMITER) {
+        if (decoder->len < sizeof(decoder->encoded)) {
+            decoder->encoded[decoder->len++] = c;
+        }
+        else {
+            decoder->overflow = 1;
+        }
+        return 0;
+    }
+
+    if (decoder->len == 0) {
+        return 0;
+    }
+
+    rawLen = decoder->overflow ? -1 : cobs_decode(decoder->encoded, decoder->len, raw);
+    decoder->len = 0;
+    decoder->overflow = 0;
+
+    if (rawLen < 3 || rawLen > PROTOCOL_MAX_RAW) {
+        decoder->framingErrors++;
+        return 0;
+    }
+
+    crc = raw[rawLen - 2] | (raw[rawLen - 1] << 8);
+    if (Protocol_CRC16(raw, rawLen - 2) != crc) {
+        decoder->crcErrors++;
+        return 0;
+    }
+
+    frame->type = raw[0];
+    frame->len = rawLen - 3;
+    memcpy(frame->payload, &raw[1], frame->len);
+    decoder->frames++;
+
+    return 1;
+}
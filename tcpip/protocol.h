@@ -0,0 +1,36 @@
+/*******************************************************************************
+* Name: protocol.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot link framing (COBS + CRC-16) for the server.
+*******************************************************************************/
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../src/Messages.h"
+
+typedef struct {
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+} ProtocolFrame;
+
+typedef struct {
+    uint8_t encoded[PROTOCOL_MAX_ENCODED];
+    size_t len;
+    int overflow;
+    unsigned long frames;
+    unsigned long crcErrors;
+    unsigned long framingErrors;
+} ProtocolDecoder;
+
+uint16_t Protocol_CRC16(const uint8_t *data, size_t len);
+size_t Protocol_Encode(uint8_t type, const void *payload, size_t len, uint8_t *out);
+void Protocol_DecoderInit(ProtocolDecoder *decoder);
+int Protocol_Feed(ProtocolDecoder *decoder, uint8_t c, ProtocolFrame *frame);
+
+#endif
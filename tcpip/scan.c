@@ -0,0 +1,49 @@
+/*******************************************************************************
+* Name: scan.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot range scans for the server. Must match src/Scan.c, see
+*              src/Messages.h for the frame layout. Each point is printed as a
+*              bearing and range from the robot and placed in the odometry
+*              frame with the pose of the scan frame.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "scan.h"
+
+// Print one MSG_SCAN
+void Scan_PrintFrame(const ProtocolFrame *frame) {
+    const MsgScan *scan = (const MsgScan *)frame->payload;
+    double heading, bearing, x, y;
+
+    if ((frame->len < offsetof(MsgScan, points)) || (scan->count > SCAN_FRAME_POINTS)
+        || (frame->len != offsetof(MsgScan, points) + scan->count * sizeof(ScanPoint))) {
+        printf("[Scan] Bad frame, %u bytes\n", frame->len);
+        return;
+    }
+
+    heading = scan->poseHeading * 2.0 * M_PI / 65536.0;
+    printf("[Scan] sweep %u %s, points %u-%u at t=%ums from (%.1f, %.1f) cm heading %.1f deg%s\n",
+           scan->sweep, (scan->flags & SCAN_CLOCKWISE) ? "cw" : "ccw", scan->index, scan->index + scan->count,
+           scan->time, scan->poseX / 10.0, scan->poseY / 10.0, heading * 180.0 / M_PI,
+           (scan->flags & SCAN_LAST) ? ", end of sweep" : "");
+
+    for (uint8_t i = 0; i < scan->count; i++) {
+        const ScanPoint *point = &scan->points[i];
+
+        // Clockwise pans look to the right, bearings are counter-clockwise
+        bearing = -point->pan * SCAN_MDEG_PER_HALF_STEP * M_PI / 180000.0;
+        if (point->range == 0xFFFF) {
+            printf("[Scan]   %+6.1f deg  nothing in range  (%+dms)\n", bearing * 180.0 / M_PI, point->dt);
+            continue;
+        }
+
+        x = scan->poseX / 10.0 + point->range * cos(heading + bearing);
+        y = scan->poseY / 10.0 + point->range * sin(heading + bearing);
+        printf("[Scan]   %+6.1f deg  %4ucm  at (%.1f, %.1f) cm  (%+dms)\n",
+               bearing * 180.0 / M_PI, point->range, x, y, point->dt);
+    }
+}
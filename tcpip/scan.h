@@ -0,0 +1,15 @@
+/*******************************************************************************
+* Name: scan.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot range scans for the server.
+*******************************************************************************/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "protocol.h"
+
+void Scan_PrintFrame(const ProtocolFrame *frame);
+
+#endif
@@ -108,12 +108,53 @@ int Serial_Open(void) {
     return serial_port;
 }
 
+int Serial_SetBaud(int serial_port, unsigned long baud) {
+    struct termios tty;
+    speed_t speed;
+
+    switch (baud) {
+      case 9600:    speed = B9600;    break;
+      case 115200:  speed = B115200;  break;
+      case 230400:  speed = B230400;  break;
+      case 460800:  speed = B460800;  break;
+      case 921600:  speed = B921600;  break;
+      case 1000000: speed = B1000000; break;
+      default:
+        printf("Unsupported baud rate %lu\n", baud);
+        return -1;
+    }
+
+    if (tcgetattr(serial_port, &tty) != 0) {
+      printf("Error %i from tcgetattr: %s\n", errno, strerror(errno));
+      return -1;
+    }
+
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+
+    // Let anything already written go out at the old rate
+    if (tcsetattr(serial_port, TCSADRAIN, &tty) != 0) {
+      printf("Error %i from tcsetattr: %s\n", errno, strerror(errno));
+      return -1;
+    }
+
+    return 0;
+}
+
 int Serial_Write(int serial_port, char* buf) {
 
     write(serial_port, buf, sizeof(buf));
     return 0;
 }
 
+int Serial_Send(int serial_port, const uint8_t* data, size_t len) {
+    if (write(serial_port, data, len) != (ssize_t)len) {
+      printf("Error writing: %s\n", strerror(errno));
+      return -1;
+    }
+    return 0;
+}
+
 int Serial_Read(int serial_port, char* buf) {
     // Normally you wouldn't do this memset() call, but since we will just receive
     // ASCII data for this example, we'll set everything to 0 so we can
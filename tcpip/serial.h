@@ -3,8 +3,13 @@
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 int Serial_Open(void);
+int Serial_SetBaud(int serial_port, unsigned long baud);
 int Serial_Write(int serial_port, char* buf);
+int Serial_Send(int serial_port, const uint8_t* data, size_t len);
 int Serial_Read(int serial_port, char* read_buf);
 int Serial_Close(int serial_port);
 
@@ -8,19 +8,41 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include "serial.h"
+#include "protocol.h"
+#include "link.h"
+#include "telemetry.h"
+#include "log.h"
+#include "tasks.h"
+#include "tune.h"
+#include "scan.h"
+#include "map.h"
 
 #define ROBOT_STOP "S"
+#define TELEMETRY_PRINT_MS 1000
 
 void communicate(int clientID, int serialID);
+void sendCommands(int serialID, const char *cmds);
+void sendDrive(int serialID, const char *args);
+void sendTelemetryRate(int serialID, const char *args);
+void sendTaskQuery(int serialID, const char *args);
+void sendTuneStart(int serialID, const char *args);
+void sendScanControl(int serialID, const char *args);
+void sendMapQuery(int serialID, const char *args);
+void sendVelocity(int serialID, const char *args);
+void handleRobotFrame(const ProtocolFrame *frame);
 void sigCatcher(int n);
 
 int quit;
+TelemetryDecoder telemetry;
+LogDecoder logDecoder;
+MapDecoder mapDecoder;
 
 int main(int argc, char* argv[]) {
     int serverSocket, clientSocket;
@@ -29,11 +51,16 @@ int main(int argc, char* argv[]) {
     int serialPort;
     quit = 0;
 
-    if (argc != 2) {
-        printf("Usage: ./server PORT\n");
+    if ((argc != 2) && (argc != 3)) {
+        printf("Usage: ./server PORT [LOG_TABLE]\n");
         return -1;
     }
 
+    // Format strings for the robot log messages
+    if (!Log_DecoderInit(&logDecoder, (argc == 3) ? argv[2] : LOG_DEFAULT_TABLE)) {
+        printf("[Server] No log table, log messages will show their IDs...\n");
+    }
+
     // Send when child terminates
 //    signal(SIGCHLD, sigCatcher);
 
@@ -73,6 +100,9 @@ int main(int argc, char* argv[]) {
         printf("[Server] Serial port opened...\n");
     }
 
+    // Agree on the fastest reliable baud rate with the robot
+    printf("[Server] Link running at %lu baud...\n", Link_Negotiate(serialPort));
+
     // Listen for client connection
     if ((listen(serverSocket, 5)) != 0) {
         printf("[Server] Server listen failed...\n");
@@ -106,6 +136,7 @@ int main(int argc, char* argv[]) {
     // Close the server
     close(serverSocket);
     Serial_Close(serialPort);
+    Log_DecoderFree(&logDecoder);
 
     printf("[Server] Closed successfully...\n");
     return 0;
@@ -113,11 +144,47 @@ int main(int argc, char* argv[]) {
 
 void communicate(int clientID, int serialID) {
     char buf[BUFSIZ];
-    FILE *p;
-    
+    uint8_t rx[256];
+    fd_set fds;
+    int maxID = (clientID > serialID) ? clientID : serialID;
+    ssize_t n;
+    ProtocolDecoder decoder;
+    ProtocolFrame frame;
+
+    Protocol_DecoderInit(&decoder);
+    Telemetry_DecoderInit(&telemetry);
+    Map_DecoderInit(&mapDecoder);
+
     while (1) {
+        FD_ZERO(&fds);
+        FD_SET(clientID, &fds);
+        FD_SET(serialID, &fds);
+
+        if (select(maxID + 1, &fds, NULL, NULL, NULL) < 0) {
+            printf("[Server] Select failed...\n");
+            break;
+        }
+
+        // Decode frames from the robot
+        if (FD_ISSET(serialID, &fds)) {
+            n = read(serialID, rx, sizeof(rx));
+            for (ssize_t i = 0; i < n; i++) {
+                if (Protocol_Feed(&decoder, rx[i], &frame)) {
+                    handleRobotFrame(&frame);
+                }
+            }
+        }
+
+        if (!FD_ISSET(clientID, &fds)) {
+            continue;
+        }
+
         memset(buf, 0, sizeof(buf));
-        read(clientID, buf, sizeof(buf));
+        if (read(clientID, buf, sizeof(buf) - 1) <= 0) {
+            printf("[Server] Client disconnected...\n");
+            sendCommands(serialID, ROBOT_STOP);
+            break;
+        }
 
         // Execute command from client
         if (strncmp("Q", buf, 4) == 0) {
@@ -125,7 +192,7 @@ void communicate(int clientID, int serialID) {
             strcpy(buf, "Q");
             write(clientID, buf, strlen(buf));
             printf("[Server] Closing connection...\n");
-            Serial_Write(serialID, ROBOT_STOP);
+            sendCommands(serialID, ROBOT_STOP);
             break;
         }
         else if (strncmp("shutdown", buf, 8) == 0) {
@@ -133,13 +200,220 @@ void communicate(int clientID, int serialID) {
             strcpy(buf, "shutdown");
             write(clientID, buf, strlen(buf));
             printf("[Server] Shutting down...\n");
-            Serial_Write(serialID, ROBOT_STOP);
+            sendCommands(serialID, ROBOT_STOP);
             quit = 1;
             break;
         }
+        else if (strncmp("link", buf, 4) == 0) {
+            uint8_t frame[PROTOCOL_MAX_ENCODED];
+            Serial_Send(serialID, frame, Protocol_Encode(MSG_LINK_QUERY, NULL, 0, frame));
+        }
+        else if (strncmp("tasks", buf, 5) == 0) {
+            sendTaskQuery(serialID, &buf[5]);
+        }
+        else if (strncmp("tune", buf, 4) == 0) {
+            sendTuneStart(serialID, &buf[4]);
+        }
+        else if (strncmp("scan", buf, 4) == 0) {
+            sendScanControl(serialID, &buf[4]);
+        }
+        else if (strncmp("map", buf, 3) == 0) {
+            sendMapQuery(serialID, &buf[3]);
+        }
+        else if (strncmp("telemetry ", buf, 10) == 0) {
+            sendTelemetryRate(serialID, &buf[10]);
+        }
+        else if (strncmp("move ", buf, 5) == 0) {
+            // Sent continuously, only the newest of any reads that ran together counts
+            char *last = buf, *next;
+            while ((next = strstr(last + 1, "move ")) != NULL) {
+                last = next;
+            }
+            sendVelocity(serialID, &last[5]);
+        }
+        else if (strncmp("drive ", buf, 6) == 0) {
+            printf("[Server] drive: %s\n", &buf[6]);
+            sendDrive(serialID, &buf[6]);
+        }
         else {
             printf("[Server] cmd: %s\n", buf);
-            Serial_Write(serialID, buf);
+            sendCommands(serialID, buf);
+        }
+    }
+}
+
+// Send each character of cmds to the robot as a command frame
+void sendCommands(int serialID, const char *cmds) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgCommand msg;
+    size_t len;
+
+    for (; *cmds != '\0'; cmds++) {
+        msg.cmd = (uint8_t)*cmds;
+        len = Protocol_Encode(MSG_COMMAND, &msg, sizeof(msg), frame);
+        Serial_Send(serialID, frame, len);
+    }
+}
+
+// Send "LEFT RIGHT SERVO STEPPER" (cm/s, cm/s, degrees, half steps) as a drive frame
+void sendDrive(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgDrive msg;
+    int left, right, servo, stepper;
+    size_t len;
+
+    if (sscanf(args, "%d %d %d %d", &left, &right, &servo, &stepper) != 4) {
+        printf("[Server] Usage: drive LEFT RIGHT SERVO STEPPER\n");
+        return;
+    }
+
+    msg.flags = DRIVE_SET_WHEELS | DRIVE_SET_SERVO | DRIVE_SET_STEPPER;
+    msg.leftSpeed = (int16_t)left;
+    msg.rightSpeed = (int16_t)right;
+    msg.servoAngle = (int8_t)servo;
+    msg.stepperTarget = (int16_t)stepper;
+
+    len = Protocol_Encode(MSG_DRIVE, &msg, sizeof(msg), frame);
+    Serial_Send(serialID, frame, len);
+}
+
+// Send "RATE" (Hz, 0 is off) as a telemetry rate frame
+void sendTelemetryRate(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgTelemetryRate msg;
+    int rate;
+
+    if ((sscanf(args, "%d", &rate) != 1) || (rate < 0) || (rate > TELEMETRY_MAX_RATE)) {
+        printf("[Server] Usage: telemetry RATE (0-%d Hz)\n", TELEMETRY_MAX_RATE);
+        return;
+    }
+
+    msg.rate = (uint16_t)rate;
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_TELEMETRY_RATE, &msg, sizeof(msg), frame));
+}
+
+// Ask for the scheduler task statistics, "reset" clears them once they are sent
+void sendTaskQuery(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgTaskQuery msg;
+
+    msg.reset = (strstr(args, "reset") != NULL) ? 1 : 0;
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_TASK_QUERY, &msg, sizeof(msg), frame));
+}
+
+// Start a wheel auto-tune, "[SETPOINT [AMPLITUDE]]" (cm/s, % duty), 0 or missing for the defaults
+void sendTuneStart(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgTuneStart msg;
+    int setpoint = 0, amplitude = 0;
+
+    sscanf(args, "%d %d", &setpoint, &amplitude);
+    if ((setpoint < 0) || (setpoint > 255) || (amplitude < 0) || (amplitude > 100)) {
+        printf("[Server] Usage: tune [SETPOINT [AMPLITUDE]]\n");
+        return;
+    }
+
+    msg.setpoint = (uint8_t)setpoint;
+    msg.amplitude = (uint8_t)amplitude;
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_TUNE_START, &msg, sizeof(msg), frame));
+}
+
+// Start the range scanner, "[SPACING]" half steps between readings (0 or
+// missing for the default), or stop it with "off"
+void sendScanControl(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgScanControl msg = {SCAN_DEFAULT_SPACING};
+    int spacing = 0;
+
+    if (strstr(args, "off") != NULL) {
+        msg.spacing = 0;
+    }
+    else if (sscanf(args, "%d", &spacing) == 1) {
+        if ((spacing < 0) || (spacing > 255)) {
+            printf("[Server] Usage: scan [SPACING|off]\n");
+            return;
+        }
+        msg.spacing = (spacing != 0) ? (uint8_t)spacing : SCAN_DEFAULT_SPACING;
+    }
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_SCAN_CONTROL, &msg, sizeof(msg), frame));
+}
+
+// Download the map tiles changed since the last query, or all of them with "all"
+void sendMapQuery(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgMapQuery msg;
+
+    msg.all = (strstr(args, "all") != NULL) ? 1 : 0;
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_MAP_QUERY, &msg, sizeof(msg), frame));
+}
+
+// Send "LINEAR ANGULAR" (cm/s, rad/s counter-clockwise) as a velocity frame,
+// the robot stops unless it is repeated at least every 500ms
+void sendVelocity(int serialID, const char *args) {
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    MsgVelocity msg;
+    float linear, angular;
+
+    if ((sscanf(args, "%f %f", &linear, &angular) != 2) ||
+        (linear < -3000.0f) || (linear > 3000.0f) || (angular < -30.0f) || (angular > 30.0f)) {
+        printf("[Server] Usage: move LINEAR ANGULAR (cm/s, rad/s)\n");
+        return;
+    }
+
+    msg.linear = (int16_t)(linear * 10.0f);
+    msg.angular = (int16_t)(angular * 1000.0f);
+    Serial_Send(serialID, frame, Protocol_Encode(MSG_VELOCITY, &msg, sizeof(msg), frame));
+}
+
+void handleRobotFrame(const ProtocolFrame *frame) {
+    switch (frame->type) {
+        case MSG_RANGE: {
+            const MsgRange *range = (const MsgRange *)frame->payload;
+            printf("[Server] Ultrasonic: %dcm\n", range->distance);
+            break;
+        }
+        case MSG_LINK_STATUS: {
+            Link_PrintStatus((const MsgLinkStatus *)frame->payload);
+            break;
+        }
+        case MSG_LOG: {
+            Log_PrintFrame(&logDecoder, frame);
+            break;
+        }
+        case MSG_TASK_STATUS: {
+            if (frame->len == sizeof(MsgTaskStatus)) {
+                Tasks_PrintStatus((const MsgTaskStatus *)frame->payload);
+            }
+            break;
+        }
+        case MSG_TUNE_RESULT: {
+            if (frame->len == sizeof(MsgTuneResult)) {
+                Tune_PrintResult((const MsgTuneResult *)frame->payload);
+            }
+            break;
+        }
+        case MSG_SCAN: {
+            Scan_PrintFrame(frame);
+            break;
+        }
+        case MSG_MAP_TILE: {
+            if (Map_Decode(&mapDecoder, frame)) {
+                Map_Print(&mapDecoder);
+            }
+            break;
+        }
+        case MSG_TELEMETRY: {
+            // Decode every frame to count losses, but only print once in a while
+            if (Telemetry_Decode(&telemetry, frame)
+                && (telemetry.last.time - telemetry.lastPrint >= TELEMETRY_PRINT_MS)) {
+                telemetry.lastPrint = telemetry.last.time;
+                Telemetry_Print(&telemetry);
+            }
+            break;
+        }
+        default: {
+            printf("[Server] Unknown frame type 0x%02X...\n", frame->type);
+            break;
         }
     }
 }
@@ -0,0 +1,24 @@
+/*******************************************************************************
+* Name: tasks.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot scheduler task statistics for the server. Must match
+*              src/Scheduler.c, see src/Messages.h for the frame layout.
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tasks.h"
+
+// Print one MSG_TASK_STATUS, the first of a report also prints a header
+void Tasks_PrintStatus(const MsgTaskStatus *status) {
+    if (status->id == 0) {
+        printf("[Tasks] %u tasks at t=%ums\n", status->count, status->time);
+        printf("[Tasks]   %-8s %4s %6s %8s %10s %8s %8s %7s %7s %7s\n", "name", "prio", "period", "deadline",
+               "runs", "overruns", "skipped", "last", "wcet", "jitter");
+    }
+
+    printf("[Tasks]   %-8.*s %4u %4ums %6ums %10u %8u %8u %5uus %5uus %5uus\n",
+           TASK_NAME_LEN, status->name, status->priority, status->period, status->deadline,
+           status->runs, status->overruns, status->skipped, status->lastUs, status->wcetUs, status->jitterUs);
+}
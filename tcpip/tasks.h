@@ -0,0 +1,15 @@
+/*******************************************************************************
+* Name: tasks.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot scheduler task statistics for the server.
+*******************************************************************************/
+
+#ifndef TASKS_H
+#define TASKS_H
+
+#include "protocol.h"
+
+void Tasks_PrintStatus(const MsgTaskStatus *status);
+
+#endif
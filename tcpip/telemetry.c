@@ -0,0 +1,78 @@
+/*******************************************************************************
+* Name: telemetry.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot telemetry decoder for the server. Must match
+*              src/Telemetry.c, see src/Messages.h for the frame layout.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+static const char *dirNames[] = {"stop", "fwd", "bwd"};
+
+static const char *cutoffNames[] = {"none", "over-current", "stall"};
+
+static const char *dirName(uint8_t dir) {
+    return (dir < sizeof(dirNames) / sizeof(dirNames[0])) ? dirNames[dir] : "?";
+}
+
+static const char *cutoffName(uint8_t cutoff) {
+    return (cutoff < sizeof(cutoffNames) / sizeof(cutoffNames[0])) ? cutoffNames[cutoff] : "?";
+}
+
+void Telemetry_DecoderInit(TelemetryDecoder *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+// Check a MSG_TELEMETRY frame and track lost frames.
+// Returns 1 if decoder->last was updated.
+int Telemetry_Decode(TelemetryDecoder *decoder, const ProtocolFrame *frame) {
+    if ((frame->type != MSG_TELEMETRY) || (frame->len != sizeof(MsgTelemetry))) {
+        decoder->bad++;
+        return 0;
+    }
+
+    memcpy(&decoder->last, frame->payload, sizeof(MsgTelemetry));
+
+    if (decoder->started) {
+        decoder->lost += (uint16_t)(decoder->last.seq - decoder->nextSeq);
+    }
+    decoder->started = 1;
+    decoder->nextSeq = decoder->last.seq + 1;
+    decoder->frames++;
+
+    return 1;
+}
+
+void Telemetry_Print(const TelemetryDecoder *decoder) {
+    const MsgTelemetry *t = &decoder->last;
+
+    printf("[Telemetry] #%u t=%ums (%lu frames, %lu lost)\n", t->seq, t->time, decoder->frames, decoder->lost);
+    printf("[Telemetry]   left:  %s %u/%d cm/s (profile %.1f), period %uus, output %d%%, reversal %uus\n",
+           dirName(t->leftDir), t->leftSpeed, t->leftSetpoint, t->leftProfile / 10.0, t->leftPeriod, t->leftOutput,
+           t->leftReversal);
+    printf("[Telemetry]   right: %s %u/%d cm/s (profile %.1f), period %uus, output %d%%, reversal %uus\n",
+           dirName(t->rightDir), t->rightSpeed, t->rightSetpoint, t->rightProfile / 10.0, t->rightPeriod, t->rightOutput,
+           t->rightReversal);
+    printf("[Telemetry]   range %ucm, servo %d deg, stepper %u at %d, loop %uus (max %uus), encoder ISR max %u cycles\n",
+           t->range, t->servoAngle, t->stepperStep, t->stepperPosition, t->loopPeriod, t->loopMax, t->encoderIsrMax);
+    printf("[Telemetry]   pose (%.1f, %.1f) cm, heading %.1f deg, PID max %u cycles, map max %uus\n",
+           t->poseX / 10.0, t->poseY / 10.0, t->poseHeading * 360.0 / 65536.0, t->pidMax, t->mapMax);
+    printf("[Telemetry]   battery %.2fV, duty x%.3f, drive current %umA\n",
+           t->batteryMv / 1000.0, t->pwmScale / 1000.0, t->driveCurrent);
+    if ((t->leftCutoff != CUTOFF_NONE) || (t->rightCutoff != CUTOFF_NONE)) {
+        printf("[Telemetry]   motor cutoff: left %s, right %s\n", cutoffName(t->leftCutoff), cutoffName(t->rightCutoff));
+    }
+    if (t->speedLimit != 0xFFFF) {
+        printf("[Telemetry]   obstacle ahead: limit %.1f cm/s, ", t->speedLimit / 10.0);
+        if (t->ttc != 0xFFFF) {
+            printf("%ums to collision\n", t->ttc);
+        }
+        else {
+            printf("not closing\n");
+        }
+    }
+}
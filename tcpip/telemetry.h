@@ -0,0 +1,27 @@
+/*******************************************************************************
+* Name: telemetry.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot telemetry decoder for the server.
+*******************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "protocol.h"
+
+typedef struct {
+    int started;
+    uint16_t nextSeq;
+    unsigned long frames;       // Valid telemetry frames
+    unsigned long lost;         // Frames missing from the sequence
+    unsigned long bad;          // Frames with the wrong length
+    uint32_t lastPrint;         // Robot time of the last printout (ms)
+    MsgTelemetry last;
+} TelemetryDecoder;
+
+void Telemetry_DecoderInit(TelemetryDecoder *decoder);
+int Telemetry_Decode(TelemetryDecoder *decoder, const ProtocolFrame *frame);
+void Telemetry_Print(const TelemetryDecoder *decoder);
+
+#endif
@@ -0,0 +1,37 @@
+/*******************************************************************************
+* Name: tune.c (implementation)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot wheel controller auto-tune results for the server. Must
+*              match src/Tune.c, see src/Messages.h for the frame layout.
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tune.h"
+
+static const char *statusName(uint8_t status) {
+    switch (status) {
+        case TUNE_OK:       return "ok";
+        case TUNE_TIMEOUT:  return "timed out";
+        case TUNE_ABORTED:  return "aborted";
+        default:            return "?";
+    }
+}
+
+static double q16(int32_t value) {
+    return value / 65536.0;
+}
+
+// Print one MSG_TUNE_RESULT
+void Tune_PrintResult(const MsgTuneResult *result) {
+    printf("[Tune] %s wheel at %ucm/s: %s at t=%ums\n", (result->wheel == 0) ? "left" : "right",
+           result->setpoint, statusName(result->status), result->time);
+
+    if (result->status == TUNE_OK) {
+        printf("[Tune]   %u cycles, amplitude %.2fcm/s, Ku %.3f, Tu %.1fms\n",
+               result->cycles, q16(result->amplitude), q16(result->ku), result->tuUs / 1000.0);
+        printf("[Tune]   applied kp %.3f, ki %.3f, kd %.4f, kff %.3f\n",
+               q16(result->kp), q16(result->ki), q16(result->kd), q16(result->kff));
+    }
+}
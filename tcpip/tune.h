@@ -0,0 +1,15 @@
+/*******************************************************************************
+* Name: tune.h (interface)
+* Author(s): Noah Grant, Wyatt Richard
+* Date: October 17, 2026
+* Description: Robot wheel controller auto-tune results for the server.
+*******************************************************************************/
+
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "protocol.h"
+
+void Tune_PrintResult(const MsgTuneResult *result);
+
+#endif